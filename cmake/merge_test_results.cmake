@@ -0,0 +1,38 @@
+# -*- mode:cmake -*-
+
+# Copyright 2021 The Foedag team
+
+# GPL License
+
+# Copyright (c) 2021 The Open-Source FPGA Foundation
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Collects the <test>.json files written by run_sandboxed.cmake into one
+# JSON array.
+#
+#   cmake -DRESULTS=<dir> -DOUTPUT=<file> -P merge_test_results.cmake
+
+file(GLOB results ${RESULTS}/*.json)
+list(SORT results)
+set(json "[\n")
+set(separator "")
+foreach(result ${results})
+  file(READ ${result} entry)
+  string(STRIP "${entry}" entry)
+  string(APPEND json "${separator}  ${entry}")
+  set(separator ",\n")
+endforeach()
+string(APPEND json "\n]\n")
+file(WRITE ${OUTPUT} "${json}")
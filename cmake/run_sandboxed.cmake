@@ -0,0 +1,98 @@
+# -*- mode:cmake -*-
+
+# Copyright 2021 The Foedag team
+
+# GPL License
+
+# Copyright (c) 2021 The Open-Source FPGA Foundation
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Runs one test command in a fresh sandbox directory, see
+# register_script_test in the top CMakeLists.txt.
+#
+#   cmake -DNAME=<test> -DSOURCE_DIR=<repo> -DSANDBOX=<dir> -DRESULTS=<dir>
+#         -DTIMEOUT=<seconds> [-DWILL_FAIL=ON] -P run_sandboxed.cmake
+#         -- <command> <args>...
+#
+# The sandbox links the repository tests/ and device.xml, so the scripts
+# find their relative paths while cmd.log and the compiler outputs stay
+# private. The output goes to <SANDBOX>/output.log, the outcome to
+# <RESULTS>/<NAME>.json. Arguments cannot contain ';', CMake would split
+# them.
+
+set(command)
+set(collect OFF)
+math(EXPR last "${CMAKE_ARGC} - 1")
+foreach(i RANGE ${last})
+  if (collect)
+    list(APPEND command "${CMAKE_ARGV${i}}")
+  elseif ("${CMAKE_ARGV${i}}" STREQUAL "--")
+    set(collect ON)
+  endif()
+endforeach()
+list(LENGTH command length)
+if (length EQUAL 0)
+  message(FATAL_ERROR "run_sandboxed.cmake: no command after --")
+endif()
+
+file(REMOVE_RECURSE ${SANDBOX})
+file(MAKE_DIRECTORY ${SANDBOX} ${RESULTS})
+foreach(item tests device.xml)
+  file(CREATE_LINK ${SOURCE_DIR}/${item} ${SANDBOX}/${item}
+       COPY_ON_ERROR SYMBOLIC)
+endforeach()
+
+set(log ${SANDBOX}/output.log)
+string(TIMESTAMP start "%s" UTC)
+execute_process(COMMAND ${command}
+  WORKING_DIRECTORY ${SANDBOX}
+  TIMEOUT ${TIMEOUT}
+  RESULT_VARIABLE result
+  OUTPUT_FILE ${log}
+  ERROR_FILE ${log})
+string(TIMESTAMP end "%s" UTC)
+math(EXPR seconds "${end} - ${start}")
+
+# result is the exit code, or a message when the process did not exit:
+# the timeout or the signal that killed it
+if (result STREQUAL "Process terminated due to timeout")
+  set(status "timeout")
+  set(exit_code -1)
+elseif (NOT result MATCHES "^-?[0-9]+$")
+  set(status "crashed")
+  set(exit_code -1)
+else()
+  set(exit_code ${result})
+  set(status "passed")
+  if (WILL_FAIL AND exit_code EQUAL 0)
+    set(status "failed")
+  elseif (NOT WILL_FAIL AND NOT exit_code EQUAL 0)
+    set(status "failed")
+  endif()
+endif()
+
+# Windows paths carry backslashes, JSON strings need them escaped
+foreach(field NAME log)
+  string(REPLACE "\\" "\\\\" json_${field} "${${field}}")
+  string(REPLACE "\"" "\\\"" json_${field} "${json_${field}}")
+endforeach()
+file(WRITE ${RESULTS}/${NAME}.json
+"{\"name\": \"${json_NAME}\", \"status\": \"${status}\", \"exit_code\": ${exit_code}, \"seconds\": ${seconds}, \"log\": \"${json_log}\"}\n")
+
+file(READ ${log} output)
+message("${output}")
+if (NOT status STREQUAL "passed")
+  message(FATAL_ERROR "${NAME} ${status} (${result}), sandbox ${SANDBOX}")
+endif()
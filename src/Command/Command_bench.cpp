@@ -0,0 +1,73 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <string>
+
+#include "Command/CommandStack.h"
+#include "Tcl/TclInterpreter.h"
+#include "benchmark/benchmark.h"
+
+namespace FOEDAG {
+namespace {
+int noop(void* clientData, Tcl_Interp* interp, int argc, const char* argv[]) {
+  return TCL_OK;
+}
+
+// Cost of going through Tcl to reach a registered C++ command, the way every
+// GUI and batch command is dispatched
+void BM_DispatchRegisteredCmd(benchmark::State& state) {
+  TclInterpreter interpreter;
+  interpreter.registerCmd("bench_noop", noop, nullptr, 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interpreter.evalCmd("bench_noop a b c"));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DispatchRegisteredCmd);
+
+void BM_DispatchTclProc(benchmark::State& state) {
+  TclInterpreter interpreter;
+  interpreter.evalCmd("proc bench_noop {args} {}");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interpreter.evalCmd("bench_noop a b c"));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DispatchTclProc);
+
+// Adds the command log and the undo stack on top of the dispatch
+void BM_CommandStackPushExec(benchmark::State& state) {
+  TclInterpreter interpreter;
+  interpreter.registerCmd("bench_noop", noop, nullptr, 0);
+  CommandStack cmds(&interpreter);
+  Command cmd("bench_noop", "bench_noop");
+  for (auto _ : state) {
+    cmds.push_and_exec(&cmd);
+    cmds.pop_and_undo();
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+  std::remove("cmd.log");
+}
+BENCHMARK(BM_CommandStackPushExec);
+
+}  // namespace
+}  // namespace FOEDAG
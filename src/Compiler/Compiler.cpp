@@ -24,14 +24,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #else
 #include <unistd.h>
 #endif
-#include <QDebug>
 #include <chrono>
+#include <ctime>
 #include <filesystem>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
 #include <thread>
 
 #include "Compiler/Compiler.h"
+#include "Compiler/DependencyGraph.h"
+#include "Compiler/MetricsStore.h"
 #include "Compiler/TclInterpreterHandler.h"
 #include "Compiler/WorkerThread.h"
+#ifndef FOEDAG_BATCH
+#include "Compiler/TaskManager.h"
+#endif
 
 using namespace FOEDAG;
 
@@ -44,7 +53,35 @@ Compiler::Compiler(TclInterpreter* interp, Design* design, std::ostream& out,
   if (m_tclInterpreterHandler) m_tclInterpreterHandler->setCompiler(this);
 }
 
-Compiler::~Compiler() { delete m_taskManager; }
+Compiler::~Compiler() {
+#ifndef FOEDAG_BATCH
+  delete m_taskManager;
+#endif
+}
+
+// launch_runs sets run_name in its job scripts
+// Compilers of one process working in the same directory share the object
+// kept for each of its files, so their writes go through one lock. The
+// object is loaded before any other compiler can see it.
+template <class T, class Load>
+static std::shared_ptr<T> sharedFileState(const std::string& file,
+                                          Load load) {
+  static std::mutex mutex;
+  static std::map<std::string, std::weak_ptr<T>> states;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<T> state = states[file].lock();
+  if (!state) {
+    state = std::make_shared<T>(file);
+    load(*state);
+    states[file] = state;
+  }
+  return state;
+}
+
+static std::string runName(Tcl_Interp* interp) {
+  const char* name = Tcl_GetVar(interp, "run_name", TCL_GLOBAL_ONLY);
+  return name ? name : "";
+}
 
 static std::string TclInterpCloneScript() {
   std::string script = R"(
@@ -115,7 +152,8 @@ bool Compiler::RegisterCommands(TclInterpreter* interp, bool batchMode) {
     auto synthesize = [](void* clientData, Tcl_Interp* interp, int argc,
                          const char* argv[]) -> int {
       Compiler* compiler = (Compiler*)clientData;
-      compiler->Synthesize();
+      compiler->RunName(runName(interp));
+      compiler->Compile(Action::Synthesis);
       return 0;
     };
     interp->registerCmd("synthesize", synthesize, this, 0);
@@ -124,7 +162,8 @@ bool Compiler::RegisterCommands(TclInterpreter* interp, bool batchMode) {
     auto globalplacement = [](void* clientData, Tcl_Interp* interp, int argc,
                               const char* argv[]) -> int {
       Compiler* compiler = (Compiler*)clientData;
-      compiler->GlobalPlacement();
+      compiler->RunName(runName(interp));
+      compiler->Compile(Action::Global);
       return 0;
     };
     interp->registerCmd("global_placement", globalplacement, this, 0);
@@ -132,10 +171,9 @@ bool Compiler::RegisterCommands(TclInterpreter* interp, bool batchMode) {
 
     auto stop = [](void* clientData, Tcl_Interp* interp, int argc,
                    const char* argv[]) -> int {
-      for (auto th : ThreadPool::threads) {
+      for (auto th : ThreadPool::TakeThreads()) {
         th->stop();
       }
-      ThreadPool::threads.clear();
       return 0;
     };
     interp->registerCmd("stop", stop, 0, 0);
@@ -144,10 +182,14 @@ bool Compiler::RegisterCommands(TclInterpreter* interp, bool batchMode) {
     auto synthesize = [](void* clientData, Tcl_Interp* interp, int argc,
                          const char* argv[]) -> int {
       Compiler* compiler = (Compiler*)clientData;
+      compiler->RunName(runName(interp));
       WorkerThread* wthread =
           new WorkerThread("synth_th", Action::Synthesis, compiler);
       wthread->start();
-      return 0;
+      // Task id for wait_for_task
+      Tcl_AppendResult(interp, std::to_string(wthread->Id()).c_str(),
+                       (char*)NULL);
+      return TCL_OK;
     };
     interp->registerCmd("synthesize", synthesize, this, 0);
     interp->registerCmd("synth", synthesize, this, 0);
@@ -155,20 +197,23 @@ bool Compiler::RegisterCommands(TclInterpreter* interp, bool batchMode) {
     auto globalplacement = [](void* clientData, Tcl_Interp* interp, int argc,
                               const char* argv[]) -> int {
       Compiler* compiler = (Compiler*)clientData;
+      compiler->RunName(runName(interp));
       WorkerThread* wthread =
           new WorkerThread("glob_th", Action::Global, compiler);
       wthread->start();
-      return 0;
+      // Task id for wait_for_task
+      Tcl_AppendResult(interp, std::to_string(wthread->Id()).c_str(),
+                       (char*)NULL);
+      return TCL_OK;
     };
     interp->registerCmd("global_placement", globalplacement, this, 0);
     interp->registerCmd("globp", globalplacement, this, 0);
 
     auto stop = [](void* clientData, Tcl_Interp* interp, int argc,
                    const char* argv[]) -> int {
-      for (auto th : ThreadPool::threads) {
+      for (auto th : ThreadPool::TakeThreads()) {
         th->stop();
       }
-      ThreadPool::threads.clear();
       return 0;
     };
     interp->registerCmd("stop", stop, 0, 0);
@@ -196,7 +241,11 @@ bool Compiler::RegisterCommands(TclInterpreter* interp, bool batchMode) {
       WorkerThread* wthread =
           new WorkerThread("batch_th", Action::Batch, compiler);
       wthread->start();
-      return 0;
+      // Task id for wait_for_task
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp, std::to_string(wthread->Id()).c_str(),
+                       (char*)NULL);
+      return TCL_OK;
     };
     interp->registerCmd("batch", batch, this, 0);
 
@@ -214,11 +263,205 @@ bool Compiler::RegisterCommands(TclInterpreter* interp, bool batchMode) {
     };
     interp->registerCmd("update_result", update_result, this, 0);
   }
+  // Scripts waiting on tasks run in both modes, batch mode starts none
+  ThreadPool::RegisterCommands(interp);
+
+  auto add_design_file = [](void* clientData, Tcl_Interp* interp, int argc,
+                            const char* argv[]) -> int {
+    Compiler* compiler = (Compiler*)clientData;
+    if (argc < 2) {
+      Tcl_AppendResult(interp, "Usage: add_design_file <file>...",
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+    for (int i = 1; i < argc; i++) {
+      std::string file = argv[i];
+      std::string ext = std::filesystem::path(file).extension().string();
+      Design::Language language = Design::Language::VERILOG_2001;
+      if (ext == ".vhd" || ext == ".vhdl") {
+        language = Design::Language::VHDL_2008;
+      } else if (ext == ".sv" || ext == ".svh") {
+        language = Design::Language::SYSTEMVERILOG_2017;
+      }
+      compiler->GetDesign()->AddFile(language, file);
+    }
+    return TCL_OK;
+  };
+  interp->registerCmd("add_design_file", add_design_file, this, 0);
+
+  auto get_dependents = [](void* clientData, Tcl_Interp* interp, int argc,
+                           const char* argv[]) -> int {
+    Compiler* compiler = (Compiler*)clientData;
+    if (argc != 2) {
+      Tcl_AppendResult(interp, "Usage: get_dependents <file>", (char*)NULL);
+      return TCL_ERROR;
+    }
+    for (const auto& file :
+         compiler->UpdateDependencyGraph()->Dependents(argv[1])) {
+      Tcl_AppendElement(interp, file.c_str());
+    }
+    return TCL_OK;
+  };
+  interp->registerCmd("get_dependents", get_dependents, this, 0);
+
+  // estimate_runtime <stage>: seconds from the runtime history, -1 if the
+  // stage never ran
+  auto estimate_runtime = [](void* clientData, Tcl_Interp* interp, int argc,
+                             const char* argv[]) -> int {
+    Compiler* compiler = (Compiler*)clientData;
+    std::string stage = argc == 2 ? argv[1] : "";
+    if (stage != StageName(Action::Synthesis) &&
+        stage != StageName(Action::Global)) {
+      Tcl_AppendResult(interp,
+                       "Usage: estimate_runtime synthesis|global_placement",
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+    std::shared_ptr<RuntimeHistory> history = compiler->GetRuntimeHistory();
+    double estimate = history->Predict(stage, compiler->RuntimeFeatures());
+    std::ostringstream result;
+    result << std::fixed << std::setprecision(1) << estimate;
+    Tcl_AppendResult(interp, estimate < 0 ? "-1" : result.str().c_str(),
+                     (char*)NULL);
+    return TCL_OK;
+  };
+  interp->registerCmd("estimate_runtime", estimate_runtime, this, 0);
+
+  MetricsStore::RegisterCommands(interp,
+                                 [this]() { return ProjectDirectory(); });
   return true;
 }
 
+std::string Compiler::ProjectDirectory() const {
+  std::string directory = m_projectDirectory ? m_projectDirectory() : "";
+  return directory.empty() ? std::filesystem::current_path().string()
+                           : directory;
+}
+
+std::shared_ptr<DependencyGraph> Compiler::GetDependencyGraph() {
+  std::string cache =
+      (std::filesystem::path(ProjectDirectory()) / (m_design->Name() + ".deps"))
+          .string();
+  std::lock_guard<std::mutex> lock(m_graphMutex);
+  // Another project was opened
+  if (!m_dependencyGraph || m_dependencyGraph->CacheFile() != cache) {
+    m_dependencyGraph = sharedFileState<DependencyGraph>(
+        cache, [](DependencyGraph& graph) { graph.Load(); });
+  }
+  return m_dependencyGraph;
+}
+
+std::shared_ptr<DependencyGraph> Compiler::UpdateDependencyGraph() {
+  std::vector<std::string> files;
+  for (const auto& [language, file] : m_design->FileList()) {
+    files.push_back(file);
+  }
+  std::shared_ptr<DependencyGraph> graph = GetDependencyGraph();
+  graph->Update(files);
+  return graph;
+}
+
+std::shared_ptr<RuntimeHistory> Compiler::GetRuntimeHistory() {
+  std::string file =
+      (std::filesystem::path(ProjectDirectory()) / "runtimes.history").string();
+  std::shared_ptr<RuntimeHistory> history;
+  {
+    std::lock_guard<std::mutex> lock(m_historyMutex);
+    if (!m_runtimeHistory || m_runtimeHistory->File() != file) {
+      m_runtimeHistory = sharedFileState<RuntimeHistory>(
+          file, [](RuntimeHistory&) {});
+    }
+    history = m_runtimeHistory;
+  }
+  history->Refresh();
+  return history;
+}
+
+RuntimeHistory::Features Compiler::RuntimeFeatures() {
+  RuntimeHistory::Features features;
+  features.design = m_design->Name();
+  // The compiler has no device yet, the top module is its only option
+  features.options = m_design->TopLevel();
+  for (const auto& [language, file] : m_design->FileList()) {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(file, ec);
+    if (!ec) features.bytes += size;
+    features.files++;
+  }
+  return features;
+}
+
+const char* Compiler::StageName(Action action) {
+  switch (action) {
+    case Action::Synthesis:
+      return "synthesis";
+    case Action::Global:
+      return "global_placement";
+    default:
+      return nullptr;
+  }
+}
+
+int Compiler::TaskId(Action action) {
+  switch (action) {
+    case Action::Synthesis:
+      return SYNTH_TASK;
+    case Action::Global:
+    case Action::Detailed:
+    case Action::Routing:
+      return PLACE_AND_ROUTE_TASK;
+    default:
+      return -1;
+  }
+}
+
 bool Compiler::Compile(Action action) {
-  m_stop = false;
+  // A worker thread reset it in start, a Stop since then is kept
+  if (m_taskAction == Action::NoAction) m_stop = false;
+  const char* stage = StageName(action);
+  if (stage == nullptr) return run(action);
+
+  RuntimeHistory::Features features = RuntimeFeatures();
+  std::shared_ptr<RuntimeHistory> history = GetRuntimeHistory();
+  double estimate = history->Predict(stage, features);
+  if (estimate >= 0) {
+    m_out << "Estimated runtime: " << std::fixed << std::setprecision(1)
+          << estimate << " s" << std::defaultfloat << std::endl;
+  }
+#ifndef FOEDAG_BATCH
+  int task = TaskId(action);
+  if (m_taskManager && estimate >= 0 && task >= 0)
+    m_taskManager->setTaskEstimate(task, int(estimate + 0.5));
+#endif
+  m_upToDate = false;
+  auto start = std::chrono::steady_clock::now();
+  // The peak of the process would include the runs before this one
+  ResidentPeakProbe memory;
+  bool result = run(action);
+  std::chrono::duration<double> seconds =
+      std::chrono::steady_clock::now() - start;
+  if (m_stop) return result;
+  // Failed runs say nothing about the next one, neither do skipped ones
+  if (result && !m_upToDate) {
+    history->Record(stage, features, seconds.count());
+  }
+  MetricsStore::Row row{
+      {"run", MetricsStore::Value::Of(m_runName.empty() ? m_design->Name()
+                                                        : m_runName)},
+      {"stage", MetricsStore::Value::Of(std::string(stage))},
+      {"time", MetricsStore::Value::Of(int64_t(std::time(nullptr)))},
+      {"status", MetricsStore::Value::Of(
+                     std::string(result ? "success" : "failed"))},
+      {"runtime", MetricsStore::Value::Of(seconds.count())},
+      {"peak_memory",
+       MetricsStore::Value::Of(memory.PeakGrowthBytes())},
+      {"files", MetricsStore::Value::Of(int64_t(features.files))}};
+  MetricsStore::Open(MetricsStore::DefaultFile(ProjectDirectory()))
+      .Append({row});
+  return result;
+}
+
+bool Compiler::run(Action action) {
   switch (action) {
     case Action::Synthesis:
       return Synthesize();
@@ -233,27 +476,48 @@ bool Compiler::Compile(Action action) {
 }
 
 void Compiler::Stop() {
+  // finish reports the task as not run
   m_stop = true;
-  if (m_taskManager)
-    m_taskManager->tasks().at(SYNTH_TASK)->setStatus(TaskStatus::None);
 }
 
 bool Compiler::Synthesize() {
   m_out << "Synthesizing design: " << m_design->Name() << "..." << std::endl;
-  auto currentPath = std::filesystem::current_path();
-  auto it = std::filesystem::directory_iterator{currentPath};
+  std::shared_ptr<DependencyGraph> graph = UpdateDependencyGraph();
+  // Only the changed files and the ones including or importing them
+  std::set<std::string> affected = graph->FilesToCompile();
+  m_out << "Files to compile: " << affected.size() << "/"
+        << m_design->FileList().size() << std::endl;
+  std::vector<std::string> files(affected.begin(), affected.end());
+  if (m_design->FileList().empty()) {
+    // Fake design, show the current directory
+    for (const auto& entry : std::filesystem::directory_iterator{
+             std::filesystem::current_path()}) {
+      files.push_back(entry.path().string());
+    }
+  } else if (affected.empty()) {
+    m_upToDate = true;
+    m_state = State::Synthesized;
+    m_out << "Design " << m_design->Name() << " is up to date" << std::endl;
+    return true;
+  }
+  auto it = files.begin();
   for (int i = 0; i < 100; i = i + 10) {
     m_out << std::setw(2) << i << "%";
-    if (it != std::filesystem::end(it)) {
-      m_out << " File: " << (*it).path().filename().c_str() << " just for test";
+    if (it != files.end()) {
+      m_out << " File: " << std::filesystem::path(*it).filename().string();
       it++;
     }
     m_out << std::endl;
+#ifndef FOEDAG_BATCH
+    if (m_taskManager)
+      m_taskManager->setTaskProgress(TaskId(Action::Synthesis), i);
+#endif
     std::chrono::milliseconds dura(1000);
     std::this_thread::sleep_for(dura);
     if (m_stop) return false;
   }
   m_state = State::Synthesized;
+  if (!m_design->FileList().empty()) graph->CommitBaseline();
   m_out << "Design " << m_design->Name() << " is synthesized!" << std::endl;
   return true;
 }
@@ -267,6 +531,10 @@ bool Compiler::GlobalPlacement() {
         << std::endl;
   for (int i = 0; i < 100; i = i + 10) {
     m_out << i << "%" << std::endl;
+#ifndef FOEDAG_BATCH
+    if (m_taskManager)
+      m_taskManager->setTaskProgress(TaskId(Action::Global), i);
+#endif
     std::chrono::milliseconds dura(1000);
     std::this_thread::sleep_for(dura);
     if (m_stop) return false;
@@ -278,7 +546,9 @@ bool Compiler::GlobalPlacement() {
 
 bool Compiler::RunBatch() {
   m_out << "Running batch..." << std::endl;
-  TclInterpreter* batchInterp = new TclInterpreter("batchInterp");
+  // Deleted with the batch, it also leaves the Tcl sampler
+  auto batch = std::make_unique<TclInterpreter>("batchInterp");
+  TclInterpreter* batchInterp = batch.get();
   if (m_tclInterpreterHandler)
     m_tclInterpreterHandler->initIterpreter(batchInterp);
   RegisterCommands(batchInterp, true);
@@ -292,23 +562,37 @@ bool Compiler::RunBatch() {
   return true;
 }
 
-void Compiler::start() {
+void Compiler::start(Action action) {
+  m_stop = false;
+  m_taskAction = action;
   if (m_tclInterpreterHandler) m_tclInterpreterHandler->notifyStart();
-  if (m_taskManager)
-    m_taskManager->tasks().at(SYNTH_TASK)->setStatus(TaskStatus::InProgress);
+#ifndef FOEDAG_BATCH
+  int task = TaskId(action);
+  if (m_taskManager && task >= 0)
+    m_taskManager->setTaskStatus(task, TaskStatus::InProgress);
+#endif
 }
 
-void Compiler::finish() {
+void Compiler::finish(bool success) {
   if (m_tclInterpreterHandler) m_tclInterpreterHandler->notifyFinish();
-  if (m_taskManager)
-    m_taskManager->tasks().at(SYNTH_TASK)->setStatus(TaskStatus::Success);
+#ifndef FOEDAG_BATCH
+  int task = TaskId(m_taskAction);
+  if (m_taskManager && task >= 0) {
+    TaskStatus status = success ? TaskStatus::Success : TaskStatus::Fail;
+    m_taskManager->setTaskStatus(task, m_stop ? TaskStatus::None : status);
+  }
+#endif
+  m_taskAction = Action::NoAction;
 }
 
+// The task view is Qt based, foedag-batch has none
+#ifndef FOEDAG_BATCH
 void Compiler::setTaskManager(TaskManager* newTaskManager) {
   m_taskManager = newTaskManager;
   QObject::connect(m_taskManager->tasks().at(SYNTH_TASK), &Task::taskTriggered,
                    [this]() { Tcl_Eval(m_interp->getInterp(), "synth"); });
 }
+#endif
 
 bool Compiler::Placement() { return true; }
 
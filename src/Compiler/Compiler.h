@@ -20,16 +20,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "Command/Command.h"
 #include "Command/CommandStack.h"
 #include "Compiler/Design.h"
+#include "Compiler/RuntimeHistory.h"
 #include "Main/CommandLine.h"
-#include "TaskManager.h"
 #include "Tcl/TclInterpreter.h"
+#include "Utils/MemoryTracker.h"
 
 #ifndef COMPILER_H
 #define COMPILER_H
@@ -37,7 +41,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace FOEDAG {
 
 class TclInterpreterHandler;
-class Compiler {
+class DependencyGraph;
+class TaskManager;
+class Compiler : public MemoryTracked<MemoryTracker::Compiler, Compiler> {
  public:
   enum Action {
     NoAction,
@@ -64,11 +70,30 @@ class Compiler {
 
   ~Compiler();
   void BatchScript(const std::string& script) { m_batchScript = script; }
+  // Run the metrics are recorded under, the design name if empty
+  void RunName(const std::string& name) { m_runName = name; }
+  // Where the files kept per project (metrics...) go, the current directory
+  // when not set or empty
+  void ProjectDirectory(const std::function<std::string()>& directory) {
+    m_projectDirectory = directory;
+  }
+  std::string ProjectDirectory() const;
   State CompilerState() { return m_state; }
   bool Compile(Action action);
   void Stop();
   TclInterpreter* TclInterp() { return m_interp; }
   Design* GetDesign() { return m_design; }
+  // Include/package dependencies of the design files, kept in the project
+  // directory and loaded on first use. Safe from any thread.
+  std::shared_ptr<DependencyGraph> GetDependencyGraph();
+  // Rescans the design files, returns the graph
+  std::shared_ptr<DependencyGraph> UpdateDependencyGraph();
+  // Runtimes of the past stages, shared by the designs of the project
+  // directory. Read again only when the file changed. Safe from any thread.
+  std::shared_ptr<RuntimeHistory> GetRuntimeHistory();
+  RuntimeHistory::Features RuntimeFeatures();
+  // Name the stage is recorded under, nullptr if its runtime is not kept
+  static const char* StageName(Action action);
   bool RegisterCommands(TclInterpreter* interp, bool batchMode);
   bool Clear();
   bool Synthesize();
@@ -78,10 +103,13 @@ class Compiler {
   bool TimingAnalysis();
   bool GenerateBitstream();
   bool RunBatch();
-  void start();
-  void finish();
+  // The task of the action is in progress until finish reports it done,
+  // failed or, after Stop, not run
+  void start(Action action);
+  void finish(bool success);
 
   std::string& getResult() { return m_result; }
+  std::ostream& Out() { return m_out; }
 
   void setTaskManager(TaskManager* newTaskManager);
 
@@ -89,14 +117,32 @@ class Compiler {
   TclInterpreter* m_interp = nullptr;
   Design* m_design = nullptr;
   bool m_stop = false;
+  // Action between start and finish
+  Action m_taskAction = Action::NoAction;
+  // The stage found nothing to do
+  bool m_upToDate = false;
   State m_state = None;
   std::ostream& m_out;
   std::string m_batchScript;
+  std::string m_runName;
+  std::function<std::string()> m_projectDirectory;
   std::string m_result;
   TclInterpreterHandler* m_tclInterpreterHandler;
   TaskManager* m_taskManager{nullptr};
+  // Guard the lazily opened graph and history, used by the compile thread
+  // and the Tcl commands
+  std::mutex m_graphMutex;
+  std::shared_ptr<DependencyGraph> m_dependencyGraph;
+  std::mutex m_historyMutex;
+  std::shared_ptr<RuntimeHistory> m_runtimeHistory;
 
-  static constexpr uint SYNTH_TASK{0};
+  bool run(Action action);
+
+  // Task of the action in the task manager, -1 if it has none
+  static int TaskId(Action action);
+
+  static constexpr unsigned int SYNTH_TASK{0};
+  static constexpr unsigned int PLACE_AND_ROUTE_TASK{1};
 };
 
 }  // namespace FOEDAG
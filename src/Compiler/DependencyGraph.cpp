@@ -0,0 +1,231 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/DependencyGraph.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+using namespace FOEDAG;
+
+namespace {
+
+std::string toLower(std::string str) {
+  std::transform(str.begin(), str.end(), str.begin(),
+                 [](unsigned char ch) { return std::tolower(ch); });
+  return str;
+}
+
+}  // namespace
+
+DependencyGraph::DependencyGraph(const std::string& cacheFile)
+    : m_cacheFile(cacheFile) {}
+
+void DependencyGraph::Update(const std::vector<std::string>& files,
+                             const std::vector<std::string>& includeDirs) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  namespace fs = std::filesystem;
+
+  std::vector<std::string> scanned = files;
+  std::set<std::string> known(files.begin(), files.end());
+  std::unordered_map<std::string, std::string> byName;
+  for (const auto& file : files) {
+    byName.emplace(fs::path(file).filename().string(), file);
+  }
+
+  // Resolves against the including file, the include directories and at last
+  // any design file with the same name
+  auto resolveInclude = [&](const std::string& file,
+                            const std::string& include) -> std::string {
+    std::error_code ec;
+    fs::path candidate = fs::path(file).parent_path() / include;
+    if (fs::exists(candidate, ec)) return candidate.lexically_normal().string();
+    for (const auto& dir : includeDirs) {
+      candidate = fs::path(dir) / include;
+      if (fs::exists(candidate, ec))
+        return candidate.lexically_normal().string();
+    }
+    auto itr = byName.find(fs::path(include).filename().string());
+    return itr != byName.end() ? itr->second : std::string();
+  };
+
+  // Headers pull in other headers, scan until no new file shows up. Files
+  // already scanned are only stat'ed again.
+  std::map<std::string, std::set<std::string>> includes;
+  size_t first = 0;
+  while (first < scanned.size()) {
+    m_scanner.Scan(scanned);
+    size_t last = scanned.size();
+    for (size_t i = first; i < last; i++) {
+      const HdlFileInfo* info = m_scanner.FileInfo(scanned[i]);
+      if (info == nullptr) continue;
+      for (const auto& include : info->includes) {
+        std::string path = resolveInclude(scanned[i], include);
+        if (path.empty()) continue;
+        includes[scanned[i]].insert(path);
+        if (known.insert(path).second) scanned.push_back(path);
+      }
+    }
+    first = last;
+  }
+  m_files = scanned;
+
+  std::unordered_map<std::string, std::string> packages;
+  for (const auto& file : m_files) {
+    const HdlFileInfo* info = m_scanner.FileInfo(file);
+    if (info == nullptr) continue;
+    for (const auto& package : info->packages) {
+      packages.emplace(package, file);
+      packages.emplace(toLower(package), file);
+    }
+  }
+
+  m_dependencies.clear();
+  m_dependents.clear();
+  for (const auto& file : m_files) {
+    const HdlFileInfo* info = m_scanner.FileInfo(file);
+    if (info == nullptr) continue;
+    std::set<std::string>& deps = m_dependencies[file];
+    deps = includes[file];
+    for (const auto& import : info->imports) {
+      auto itr = packages.find(import);
+      if (itr == packages.end()) itr = packages.find(toLower(import));
+      // Unknown packages come from libraries (ieee, std...)
+      if (itr != packages.end() && itr->second != file)
+        deps.insert(itr->second);
+    }
+    for (const auto& dep : deps) m_dependents[dep].insert(file);
+  }
+}
+
+std::set<std::string> DependencyGraph::Dependencies(
+    const std::string& file) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto itr = m_dependencies.find(file);
+  if (itr == m_dependencies.end()) return {};
+  return itr->second;
+}
+
+std::set<std::string> DependencyGraph::Dependents(
+    const std::string& file) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return dependents(file);
+}
+
+std::set<std::string> DependencyGraph::dependents(
+    const std::string& file) const {
+  std::set<std::string> result;
+  std::vector<std::string> stack{file};
+  while (!stack.empty()) {
+    std::string current = stack.back();
+    stack.pop_back();
+    auto itr = m_dependents.find(current);
+    if (itr == m_dependents.end()) continue;
+    for (const auto& dependent : itr->second) {
+      if (result.insert(dependent).second) stack.push_back(dependent);
+    }
+  }
+  result.erase(file);
+  return result;
+}
+
+std::set<std::string> DependencyGraph::AffectedClosure(
+    const std::vector<std::string>& changed) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::set<std::string> result(changed.begin(), changed.end());
+  for (const auto& file : changed) {
+    std::set<std::string> deps = dependents(file);
+    result.insert(deps.begin(), deps.end());
+  }
+  return result;
+}
+
+std::vector<std::string> DependencyGraph::ChangedFiles() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<std::string> changed;
+  for (const auto& file : m_files) {
+    auto itr = m_baseline.find(file);
+    if (itr == m_baseline.end() || itr->second != m_scanner.FileHash(file)) {
+      changed.push_back(file);
+    }
+  }
+  return changed;
+}
+
+std::set<std::string> DependencyGraph::FilesToCompile() const {
+  return AffectedClosure(ChangedFiles());
+}
+
+void DependencyGraph::CommitBaseline() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_baseline.clear();
+    for (const auto& file : m_files) {
+      m_baseline[file] = m_scanner.FileHash(file);
+    }
+  }
+  Save();
+}
+
+// The scanner records followed by the baseline, one "B <hash> <path>" line
+// per file
+bool DependencyGraph::Save() const {
+  if (m_cacheFile.empty()) return false;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::string tmpFile = m_cacheFile + ".tmp";
+  {
+    std::ofstream out(tmpFile, std::ios::trunc);
+    if (!out.is_open()) return false;
+    out << "foedag-dependencies 1\n";
+    for (const auto& [file, hash] : m_baseline) {
+      out << "B " << hash << " " << file << "\n";
+    }
+    m_scanner.Save(out);
+    if (!out.good()) return false;
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmpFile, m_cacheFile, ec);
+  return !ec;
+}
+
+bool DependencyGraph::Load() {
+  if (m_cacheFile.empty()) return false;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::ifstream in(m_cacheFile);
+  std::string line;
+  if (!std::getline(in, line) || line != "foedag-dependencies 1") {
+    return false;
+  }
+  m_baseline.clear();
+  while (in.peek() == 'B') {
+    std::getline(in, line);
+    std::istringstream fields(line.substr(2));
+    uint64_t hash = 0;
+    std::string file;
+    fields >> hash;
+    std::getline(fields >> std::ws, file);
+    m_baseline[file] = hash;
+  }
+  return m_scanner.Load(in);
+}
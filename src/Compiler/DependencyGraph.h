@@ -0,0 +1,82 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Compiler/HdlScanner.h"
+
+#ifndef DEPENDENCY_GRAPH_H
+#define DEPENDENCY_GRAPH_H
+
+namespace FOEDAG {
+
+// File level dependencies of the design: `include directives, SystemVerilog
+// package imports and VHDL use clauses. The graph and the content hash of
+// every file at the last successful compilation are persisted, so the set of
+// files to recompile survives between sessions.
+class DependencyGraph {
+ public:
+  // cacheFile empty: nothing is persisted
+  explicit DependencyGraph(const std::string& cacheFile = std::string());
+
+  // Rescans the changed files and rebuilds the edges. Included files found on
+  // disk are tracked as well even when they are not part of the design.
+  void Update(const std::vector<std::string>& files,
+              const std::vector<std::string>& includeDirs = {});
+
+  // Files the given file depends on directly
+  std::set<std::string> Dependencies(const std::string& file) const;
+  // Files depending on the given file, directly or not
+  std::set<std::string> Dependents(const std::string& file) const;
+  // The given files and all their dependents
+  std::set<std::string> AffectedClosure(
+      const std::vector<std::string>& changed) const;
+
+  // Files whose content differs from the last CommitBaseline()
+  std::vector<std::string> ChangedFiles() const;
+  // What a compile stage has to process: AffectedClosure(ChangedFiles())
+  std::set<std::string> FilesToCompile() const;
+  // To be called once a compilation succeeded
+  void CommitBaseline();
+
+  bool Save() const;
+  bool Load();
+  const std::string& CacheFile() const { return m_cacheFile; }
+
+ private:
+  std::string m_cacheFile;
+  HdlScanner m_scanner;
+  std::vector<std::string> m_files;
+  std::map<std::string, std::set<std::string>> m_dependencies;
+  std::map<std::string, std::set<std::string>> m_dependents;
+  std::map<std::string, uint64_t> m_baseline;
+  mutable std::mutex m_mutex;
+
+  std::set<std::string> dependents(const std::string& file) const;
+};
+
+}  // namespace FOEDAG
+
+#endif
@@ -0,0 +1,107 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/DependencyGraph.h"
+
+#include <string>
+
+#include "Utils/TestDirectory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+namespace FOEDAG {
+namespace {
+class DependencyGraphTest : public TestDirectory {
+ protected:
+  void SetUp() override {
+    TestDirectory::SetUp();
+    m_defs = WriteFile("defs.svh", "`define WIDTH 8\n");
+    m_types = WriteFile("types.svh", "`include \"defs.svh\"\n");
+    m_pkg = WriteFile("pkg.sv", "package pkg; endpackage\n");
+    m_top = WriteFile("top.sv",
+                      "`include \"types.svh\"\n"
+                      "module top; import pkg::*; sub u0(); endmodule\n");
+    m_sub = WriteFile("sub.sv", "module sub; endmodule\n");
+    m_vpkg = WriteFile("vpkg.vhd", "package vpkg is end package;\n");
+    m_ent = WriteFile("ent.vhd",
+                      "library work; use work.vpkg.all;\n"
+                      "entity ent is end entity;\n");
+  }
+  // The headers are found through the includes
+  std::vector<std::string> files() const {
+    return {m_pkg, m_top, m_sub, m_vpkg, m_ent};
+  }
+
+  std::string m_defs, m_types, m_pkg, m_top, m_sub, m_vpkg, m_ent;
+};
+
+TEST_F(DependencyGraphTest, Closure) {
+  DependencyGraph graph;
+  graph.Update(files());
+  EXPECT_THAT(graph.Dependencies(m_top), UnorderedElementsAre(m_types, m_pkg));
+  EXPECT_THAT(graph.Dependencies(m_types), ElementsAre(m_defs));
+  EXPECT_THAT(graph.Dependencies(m_ent), ElementsAre(m_vpkg));
+  // Instances are not file dependencies
+  EXPECT_THAT(graph.Dependents(m_sub), IsEmpty());
+  EXPECT_THAT(graph.Dependents(m_defs), UnorderedElementsAre(m_types, m_top));
+  EXPECT_THAT(graph.AffectedClosure({m_defs, m_vpkg}),
+              UnorderedElementsAre(m_defs, m_types, m_top, m_vpkg, m_ent));
+  EXPECT_THAT(graph.AffectedClosure({m_sub}), ElementsAre(m_sub));
+}
+
+TEST_F(DependencyGraphTest, Invalidation) {
+  std::string cache = Path("design.deps");
+  DependencyGraph graph(cache);
+  graph.Update(files());
+  // Nothing compiled yet
+  EXPECT_EQ(graph.FilesToCompile().size(), 7u);
+  graph.CommitBaseline();
+  EXPECT_THAT(graph.FilesToCompile(), IsEmpty());
+
+  WriteFile("defs.svh", "`define WIDTH 16 // wider\n");
+  graph.Update(files());
+  EXPECT_THAT(graph.ChangedFiles(), ElementsAre(m_defs));
+  EXPECT_THAT(graph.FilesToCompile(),
+              UnorderedElementsAre(m_defs, m_types, m_top));
+
+  // The baseline survives the session, the change is still pending
+  DependencyGraph reloaded(cache);
+  ASSERT_TRUE(reloaded.Load());
+  reloaded.Update(files());
+  EXPECT_THAT(reloaded.FilesToCompile(),
+              UnorderedElementsAre(m_defs, m_types, m_top));
+  reloaded.CommitBaseline();
+
+  // Dropping the import removes the edge
+  WriteFile("top.sv",
+            "`include \"types.svh\"\nmodule top; sub u0(); endmodule\n");
+  reloaded.Update(files());
+  EXPECT_THAT(reloaded.Dependencies(m_top), ElementsAre(m_types));
+  EXPECT_THAT(reloaded.FilesToCompile(), ElementsAre(m_top));
+  EXPECT_THAT(reloaded.AffectedClosure({m_pkg}), ElementsAre(m_pkg));
+}
+
+}  // namespace
+}  // namespace FOEDAG
@@ -28,13 +28,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Command/CommandStack.h"
 #include "Main/CommandLine.h"
 #include "Tcl/TclInterpreter.h"
+#include "Utils/MemoryTracker.h"
 
 #ifndef DESIGN_H
 #define DESIGN_H
 
 namespace FOEDAG {
 
-class Design {
+class Design : public MemoryTracked<MemoryTracker::Compiler, Design> {
  public:
   enum Language {
     VHDL_1987,
@@ -0,0 +1,636 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/HdlScanner.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <string_view>
+#include <unordered_set>
+
+#include "Utils/HdlLexer.h"
+#include "Utils/ParallelFor.h"
+
+using namespace FOEDAG;
+
+namespace {
+
+enum class TokenKind { Ident, Keyword, Directive, String, Punct, Other };
+
+struct Token {
+  TokenKind kind;
+  std::string text;
+};
+
+// Words that can never be a module type in the instantiation pattern
+const std::unordered_set<std::string_view> verilogKeywords = {
+    "alias",        "always",       "always_comb",   "always_ff",
+    "always_latch", "and",          "assert",        "assign",
+    "assume",       "automatic",    "before",        "begin",
+    "bind",         "bins",         "binsof",        "bit",
+    "break",        "buf",          "bufif0",        "bufif1",
+    "byte",         "case",         "casex",         "casez",
+    "cell",         "chandle",      "checker",       "class",
+    "clocking",     "cmos",         "config",        "const",
+    "constraint",   "context",      "continue",      "cover",
+    "covergroup",   "coverpoint",   "cross",         "deassign",
+    "default",      "defparam",     "design",        "disable",
+    "dist",         "do",           "edge",          "else",
+    "end",          "endcase",      "endchecker",    "endclass",
+    "endclocking",  "endconfig",    "endfunction",   "endgenerate",
+    "endgroup",     "endinterface", "endmodule",     "endpackage",
+    "endprimitive", "endprogram",   "endproperty",   "endspecify",
+    "endsequence",  "endtable",     "endtask",       "enum",
+    "event",        "eventually",   "expect",        "export",
+    "extends",      "extern",       "final",         "first_match",
+    "for",          "force",        "foreach",       "forever",
+    "fork",         "forkjoin",     "function",      "generate",
+    "genvar",       "global",       "highz0",        "highz1",
+    "if",           "iff",          "ifnone",        "ignore_bins",
+    "illegal_bins", "implements",   "implies",       "import",
+    "incdir",       "include",      "initial",       "inout",
+    "input",        "inside",       "instance",      "int",
+    "integer",      "interconnect", "interface",     "intersect",
+    "join",         "join_any",     "join_none",     "large",
+    "let",          "liblist",      "library",       "local",
+    "localparam",   "logic",        "longint",       "macromodule",
+    "matches",      "medium",       "modport",       "module",
+    "nand",         "negedge",      "nettype",       "new",
+    "nexttime",     "nmos",         "nor",           "noshowcancelled",
+    "not",          "notif0",       "notif1",        "null",
+    "or",           "output",       "package",       "packed",
+    "parameter",    "pmos",         "posedge",       "primitive",
+    "priority",     "program",      "property",      "protected",
+    "pull0",        "pull1",        "pulldown",      "pullup",
+    "pure",         "rand",         "randc",         "randcase",
+    "randsequence", "rcmos",        "real",          "realtime",
+    "ref",          "reg",          "reject_on",     "release",
+    "repeat",       "restrict",     "return",        "rnmos",
+    "rpmos",        "rtran",        "rtranif0",      "rtranif1",
+    "s_always",     "s_eventually", "s_nexttime",    "s_until",
+    "s_until_with", "scalared",     "sequence",      "shortint",
+    "shortreal",    "showcancelled", "signed",       "small",
+    "soft",         "solve",        "specify",       "specparam",
+    "static",       "string",       "strong",        "strong0",
+    "strong1",      "struct",       "super",         "supply0",
+    "supply1",      "sync_accept_on", "sync_reject_on", "table",
+    "tagged",       "task",         "this",          "throughout",
+    "time",         "timeprecision", "timeunit",     "tran",
+    "tranif0",      "tranif1",      "tri",           "tri0",
+    "tri1",         "triand",       "trior",         "trireg",
+    "type",         "typedef",      "union",         "unique",
+    "unique0",      "unsigned",     "until",         "until_with",
+    "untyped",      "use",          "uwire",         "var",
+    "vectored",     "virtual",      "void",          "wait",
+    "wait_order",   "wand",         "weak",          "weak0",
+    "weak1",        "while",        "wildcard",      "wire",
+    "with",         "within",       "wor",           "xnor",
+    "xor"};
+
+// Keywords after which a new statement (and so an instantiation) can start
+const std::unordered_set<std::string_view> verilogStatementStart = {
+    "begin",       "end",     "generate", "endgenerate", "else",
+    "endfunction", "endtask", "endcase",  "endclass",    "join",
+    "join_any",    "join_none"};
+
+// Keywords and the rest of the token kinds the scanners look at
+std::vector<Token> tokenize(const char* data, size_t size, bool vhdl) {
+  std::vector<Token> tokens;
+  for (auto& token : HdlLexer::Tokenize(data, size, vhdl)) {
+    switch (token.kind) {
+      case HdlToken::Kind::Identifier:
+        if (vhdl) {
+          std::transform(token.text.begin(), token.text.end(),
+                         token.text.begin(),
+                         [](unsigned char ch) { return std::tolower(ch); });
+          tokens.push_back({TokenKind::Ident, std::move(token.text)});
+        } else {
+          TokenKind kind = verilogKeywords.count(token.text)
+                               ? TokenKind::Keyword
+                               : TokenKind::Ident;
+          tokens.push_back({kind, std::move(token.text)});
+        }
+        break;
+      case HdlToken::Kind::Directive:
+        tokens.push_back({TokenKind::Directive, std::move(token.text)});
+        break;
+      case HdlToken::Kind::String:
+        tokens.push_back({TokenKind::String, std::move(token.text)});
+        break;
+      case HdlToken::Kind::Literal:
+        tokens.push_back({TokenKind::Other, std::string()});
+        break;
+      case HdlToken::Kind::Punct:
+        tokens.push_back({TokenKind::Punct, std::move(token.text)});
+        break;
+    }
+  }
+  return tokens;
+}
+
+bool isPunct(const std::vector<Token>& tokens, size_t i, char c) {
+  return i < tokens.size() && tokens[i].kind == TokenKind::Punct &&
+         tokens[i].text[0] == c;
+}
+
+bool isKeyword(const std::vector<Token>& tokens, size_t i,
+               const char* keyword) {
+  return i < tokens.size() && tokens[i].kind == TokenKind::Keyword &&
+         tokens[i].text == keyword;
+}
+
+// Index after the group opened at i, i must be an open bracket
+size_t skipBalanced(const std::vector<Token>& tokens, size_t i, char open,
+                    char close) {
+  int depth = 0;
+  for (; i < tokens.size(); i++) {
+    if (isPunct(tokens, i, open)) {
+      depth++;
+    } else if (isPunct(tokens, i, close)) {
+      if (--depth == 0) return i + 1;
+    }
+  }
+  return i;
+}
+
+bool isVerilogStatementStart(const std::vector<Token>& tokens, size_t i) {
+  if (i == 0) return true;
+  const Token& prev = tokens[i - 1];
+  if (prev.kind == TokenKind::Punct) {
+    char c = prev.text[0];
+    return c == ';' || c == ')' || c == ':';
+  }
+  if (prev.kind == TokenKind::Keyword) {
+    return verilogStatementStart.count(prev.text) != 0;
+  }
+  // Named block: begin : label
+  return prev.kind == TokenKind::Ident && isPunct(tokens, i - 2, ':');
+}
+
+void scanVerilog(const char* data, size_t size, HdlFileInfo& info) {
+  const std::vector<Token> tokens = tokenize(data, size, false);
+  std::string current;
+  for (size_t i = 0; i < tokens.size(); i++) {
+    const Token& tok = tokens[i];
+    if (tok.kind == TokenKind::Directive) {
+      if (tok.text == "include" && i + 1 < tokens.size() &&
+          tokens[i + 1].kind == TokenKind::String) {
+        info.includes.push_back(tokens[++i].text);
+      }
+      continue;
+    }
+    if (tok.kind == TokenKind::Keyword) {
+      const std::string& kw = tok.text;
+      if (kw == "module" || kw == "macromodule" || kw == "program" ||
+          kw == "interface" || kw == "package") {
+        size_t j = i + 1;
+        while (isKeyword(tokens, j, "automatic") ||
+               isKeyword(tokens, j, "static"))
+          j++;
+        // interface class is not a design unit
+        if (j < tokens.size() && tokens[j].kind == TokenKind::Ident) {
+          if (kw == "package") {
+            info.packages.push_back(tokens[j].text);
+          } else if (kw == "interface") {
+            info.interfaces.push_back(tokens[j].text);
+            current = tokens[j].text;
+          } else {
+            info.modules.push_back(tokens[j].text);
+            current = tokens[j].text;
+            // module tb; or module tb #(...) ();
+            size_t k = j + 1;
+            if (isPunct(tokens, k, '#') && isPunct(tokens, k + 1, '(')) {
+              k = skipBalanced(tokens, k + 1, '(', ')');
+            }
+            if (isPunct(tokens, k, ';') ||
+                (isPunct(tokens, k, '(') && isPunct(tokens, k + 1, ')'))) {
+              info.testbenches.push_back(current);
+            }
+          }
+          i = j;
+        }
+      } else if (kw == "endmodule" || kw == "endprogram" ||
+                 kw == "endinterface") {
+        current.clear();
+      } else if (kw == "import") {
+        // import a::*, b::c;
+        size_t j = i + 1;
+        for (; j < tokens.size() && !isPunct(tokens, j, ';'); j++) {
+          if (tokens[j].kind == TokenKind::Ident && isPunct(tokens, j + 1, ':') &&
+              isPunct(tokens, j + 2, ':')) {
+            info.imports.push_back(tokens[j].text);
+          }
+        }
+        i = j;
+      }
+      continue;
+    }
+    if (tok.kind != TokenKind::Ident || current.empty() ||
+        !isVerilogStatementStart(tokens, i)) {
+      continue;
+    }
+    // <type> [#(params) | #value] <name> [range] (
+    size_t j = i + 1;
+    if (isPunct(tokens, j, '#')) {
+      j = isPunct(tokens, j + 1, '(') ? skipBalanced(tokens, j + 1, '(', ')')
+                                      : j + 2;
+    }
+    if (j >= tokens.size() || tokens[j].kind != TokenKind::Ident) {
+      continue;
+    }
+    j++;
+    if (isPunct(tokens, j, '[')) {
+      j = skipBalanced(tokens, j, '[', ']');
+    }
+    if (isPunct(tokens, j, '(')) {
+      info.instances.emplace_back(current, tok.text);
+    }
+  }
+}
+
+bool isWord(const std::vector<Token>& tokens, size_t i, const char* word) {
+  return i < tokens.size() && tokens[i].kind == TokenKind::Ident &&
+         tokens[i].text == word;
+}
+
+void scanVhdl(const char* data, size_t size, HdlFileInfo& info) {
+  const std::vector<Token> tokens = tokenize(data, size, true);
+  std::string current;
+  for (size_t i = 0; i < tokens.size(); i++) {
+    const Token& tok = tokens[i];
+    if (tok.kind != TokenKind::Ident) {
+      continue;
+    }
+    bool afterEnd = i > 0 && isWord(tokens, i - 1, "end");
+    if (tok.text == "entity" && !afterEnd && !isPunct(tokens, i - 1, ':') &&
+        isWord(tokens, i + 2, "is")) {
+      info.modules.push_back(tokens[i + 1].text);
+      // An entity without a port clause
+      size_t j = i + 3;
+      while (j < tokens.size() && !isWord(tokens, j, "port") &&
+             !isWord(tokens, j, "end") && !isWord(tokens, j, "begin")) {
+        j++;
+      }
+      if (!isWord(tokens, j, "port")) {
+        info.testbenches.push_back(tokens[i + 1].text);
+      }
+      i += 2;
+    } else if (tok.text == "architecture" && !afterEnd &&
+               isWord(tokens, i + 2, "of") && i + 3 < tokens.size()) {
+      current = tokens[i + 3].text;
+      i += 3;
+    } else if (tok.text == "package" && !afterEnd &&
+               !isWord(tokens, i + 1, "body") && isWord(tokens, i + 2, "is")) {
+      info.packages.push_back(tokens[i + 1].text);
+      i += 2;
+    } else if (tok.text == "use") {
+      // use lib.pkg.all; records pkg
+      if (isPunct(tokens, i + 2, '.') && i + 3 < tokens.size() &&
+          tokens[i + 3].kind == TokenKind::Ident) {
+        info.imports.push_back(tokens[i + 3].text);
+      }
+    } else if (!current.empty() && isPunct(tokens, i + 1, ':') &&
+               !isPunct(tokens, i + 2, '=')) {
+      // label : entity lib.name [(arch)] | label : [component] name ... map
+      size_t j = i + 2;
+      if (isWord(tokens, j, "entity")) {
+        j++;
+        while (isPunct(tokens, j + 1, '.')) j += 2;
+        if (j < tokens.size() && tokens[j].kind == TokenKind::Ident) {
+          info.instances.emplace_back(current, tokens[j].text);
+        }
+      } else {
+        if (isWord(tokens, j, "component")) j++;
+        if (j < tokens.size() && tokens[j].kind == TokenKind::Ident &&
+            (isWord(tokens, j + 1, "port") ||
+             isWord(tokens, j + 1, "generic")) &&
+            isWord(tokens, j + 2, "map")) {
+          info.instances.emplace_back(current, tokens[j].text);
+        }
+      }
+    }
+  }
+}
+
+std::string toLower(std::string str) {
+  std::transform(str.begin(), str.end(), str.begin(),
+                 [](unsigned char ch) { return std::tolower(ch); });
+  return str;
+}
+
+}  // namespace
+
+HdlScanner::HdlScanner(unsigned int threads)
+    : m_threads(ParallelFor::Threads(threads)) {}
+
+HdlScanner::Language HdlScanner::LanguageOf(const std::string& file) {
+  std::string ext = toLower(std::filesystem::path(file).extension().string());
+  if (ext == ".v" || ext == ".sv" || ext == ".vh" || ext == ".svh" ||
+      ext == ".verilog") {
+    return Language::Verilog;
+  }
+  if (ext == ".vhd" || ext == ".vhdl") {
+    return Language::Vhdl;
+  }
+  return Language::Unknown;
+}
+
+uint64_t HdlScanner::ContentHash(const char* data, size_t size) {
+  // FNV-1a, stable across runs so it can be persisted
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+HdlFileInfo HdlScanner::ScanBuffer(const char* data, size_t size,
+                                   Language language) {
+  HdlFileInfo info;
+  if (language == Language::Verilog) {
+    scanVerilog(data, size, info);
+  } else if (language == Language::Vhdl) {
+    scanVhdl(data, size, info);
+  }
+  return info;
+}
+
+const HdlFileInfo* HdlScanner::FileInfo(const std::string& file) const {
+  auto itr = m_files.find(file);
+  if (itr == m_files.end()) return nullptr;
+  return &itr->second.info;
+}
+
+uint64_t HdlScanner::FileHash(const std::string& file) const {
+  auto itr = m_files.find(file);
+  if (itr == m_files.end()) return 0;
+  return itr->second.hash;
+}
+
+// One record per line, the file path and the include names come last as they
+// may contain spaces:
+//   F <mtime> <size> <hash> <path>
+//   M|T|N|P|U <name>, I <include>, X <parent> <child>
+void HdlScanner::Save(std::ostream& out) const {
+  for (const auto& [file, entry] : m_files) {
+    out << "F " << entry.mtime << " " << entry.size << " " << entry.hash << " "
+        << file << "\n";
+    const HdlFileInfo& info = entry.info;
+    for (const auto& name : info.modules) out << "M " << name << "\n";
+    for (const auto& name : info.testbenches) out << "T " << name << "\n";
+    for (const auto& name : info.interfaces) out << "N " << name << "\n";
+    for (const auto& name : info.packages) out << "P " << name << "\n";
+    for (const auto& name : info.imports) out << "U " << name << "\n";
+    for (const auto& name : info.includes) out << "I " << name << "\n";
+    for (const auto& [parent, child] : info.instances)
+      out << "X " << parent << " " << child << "\n";
+  }
+}
+
+bool HdlScanner::Load(std::istream& in) {
+  m_files.clear();
+  m_contentCache.clear();
+  FileEntry* entry = nullptr;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.size() < 2 || line[1] != ' ') continue;
+    std::string value = line.substr(2);
+    if (line[0] == 'F') {
+      std::istringstream fields(value);
+      FileEntry fileEntry;
+      fields >> fileEntry.mtime >> fileEntry.size >> fileEntry.hash;
+      std::string file;
+      std::getline(fields >> std::ws, file);
+      if (fields.fail() || file.empty()) return false;
+      entry = &(m_files[file] = std::move(fileEntry));
+      continue;
+    }
+    if (entry == nullptr) return false;
+    HdlFileInfo& info = entry->info;
+    switch (line[0]) {
+      case 'M':
+        info.modules.push_back(value);
+        break;
+      case 'T':
+        info.testbenches.push_back(value);
+        break;
+      case 'N':
+        info.interfaces.push_back(value);
+        break;
+      case 'P':
+        info.packages.push_back(value);
+        break;
+      case 'U':
+        info.imports.push_back(value);
+        break;
+      case 'I':
+        info.includes.push_back(value);
+        break;
+      case 'X': {
+        size_t space = value.find(' ');
+        if (space == std::string::npos) return false;
+        info.instances.emplace_back(value.substr(0, space),
+                                    value.substr(space + 1));
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  for (const auto& [file, fileEntry] : m_files) {
+    m_contentCache[fileEntry.hash] = fileEntry.info;
+  }
+  buildHierarchy();
+  return true;
+}
+
+void HdlScanner::Scan(const std::vector<std::string>& files) {
+  struct Result {
+    bool exists = false;
+    bool parsed = false;
+    FileEntry entry;
+  };
+  std::vector<Result> results(files.size());
+
+  // Workers only read the caches, they are updated once all are joined
+  ParallelFor::Run(files.size(), m_threads, [&](size_t i) {
+    const std::string& file = files[i];
+    Result& result = results[i];
+    std::error_code ec;
+    auto size = std::filesystem::file_size(file, ec);
+    if (ec) return true;
+    auto mtime = std::filesystem::last_write_time(file, ec);
+    if (ec) return true;
+    result.exists = true;
+    result.entry.size = size;
+    result.entry.mtime = mtime.time_since_epoch().count();
+
+    auto known = m_files.find(file);
+    if (known != m_files.end() && known->second.size == result.entry.size &&
+        known->second.mtime == result.entry.mtime) {
+      result.entry = known->second;
+      return true;
+    }
+
+    std::string content;
+    if (!HdlLexer::ReadFile(file, content)) {
+      result.exists = false;
+      return true;
+    }
+    result.entry.hash = ContentHash(content.data(), content.size());
+    auto cached = m_contentCache.find(result.entry.hash);
+    if (cached != m_contentCache.end()) {
+      result.entry.info = cached->second;
+    } else {
+      result.entry.info =
+          ScanBuffer(content.data(), content.size(), LanguageOf(file));
+      result.parsed = true;
+    }
+    return true;
+  });
+
+  m_filesParsed = 0;
+  m_files.clear();
+  for (size_t i = 0; i < files.size(); i++) {
+    Result& result = results[i];
+    if (!result.exists) continue;
+    if (result.parsed) {
+      m_filesParsed++;
+      m_contentCache[result.entry.hash] = result.entry.info;
+    }
+    m_files[files[i]] = std::move(result.entry);
+  }
+
+  // Keep the content cache bounded by what the project can still use
+  if (m_contentCache.size() > 2 * m_files.size() + 1024) {
+    std::unordered_set<uint64_t> used;
+    for (const auto& [file, entry] : m_files) used.insert(entry.hash);
+    for (auto itr = m_contentCache.begin(); itr != m_contentCache.end();) {
+      itr = used.count(itr->first) ? std::next(itr) : m_contentCache.erase(itr);
+    }
+  }
+
+  buildHierarchy();
+}
+
+void HdlScanner::buildHierarchy() {
+  m_definitions.clear();
+  m_hierarchy.clear();
+  m_topCandidates.clear();
+  m_testbenches.clear();
+
+  // Sorted traversal so the first definition wins deterministically
+  std::map<std::string, const HdlFileInfo*> sortedFiles;
+  for (const auto& [file, entry] : m_files) sortedFiles[file] = &entry.info;
+
+  std::unordered_map<std::string, std::string> lowerNames;
+  for (const auto& [file, info] : sortedFiles) {
+    for (const auto& module : info->modules) {
+      if (m_definitions.emplace(module, file).second) {
+        lowerNames.emplace(toLower(module), module);
+        m_hierarchy[module];
+      }
+    }
+  }
+  for (const auto& [file, info] : sortedFiles) {
+    for (const auto& module : info->testbenches) {
+      auto def = m_definitions.find(module);
+      if (def != m_definitions.end() && def->second == file) {
+        m_testbenches.insert(module);
+      }
+    }
+  }
+
+  // VHDL is case insensitive, try the exact name first
+  auto resolve = [&](const std::string& name) -> const std::string* {
+    auto itr = m_definitions.find(name);
+    if (itr != m_definitions.end()) return &itr->first;
+    auto lower = lowerNames.find(toLower(name));
+    if (lower != lowerNames.end()) return &lower->second;
+    return nullptr;
+  };
+
+  std::set<std::string> instantiated;
+  for (const auto& [file, info] : sortedFiles) {
+    for (const auto& [parent, child] : info->instances) {
+      const std::string* parentName = resolve(parent);
+      const std::string* childName = resolve(child);
+      if (parentName && childName && *parentName != *childName) {
+        m_hierarchy[*parentName].insert(*childName);
+        instantiated.insert(*childName);
+      }
+    }
+  }
+
+  // Modules under a candidate, the visited set stops instantiation cycles
+  std::set<std::string> reached;
+  auto treeSize = [&](const std::string& module) {
+    std::set<std::string> visited;
+    std::vector<const std::string*> stack{&module};
+    while (!stack.empty()) {
+      const std::string* name = stack.back();
+      stack.pop_back();
+      for (const auto& child : m_hierarchy[*name]) {
+        if (visited.insert(child).second) stack.push_back(&child);
+      }
+    }
+    reached.insert(visited.begin(), visited.end());
+    return visited.size();
+  };
+
+  // The deepest tree is the most likely top, test benches come last
+  struct Candidate {
+    bool testbench;
+    size_t size;
+    std::string module;
+  };
+  std::vector<Candidate> ranked;
+  for (const auto& [module, file] : m_definitions) {
+    if (instantiated.count(module)) continue;
+    ranked.push_back({m_testbenches.count(module) != 0, treeSize(module),
+                      module});
+  }
+  // A cycle nothing instantiates has no root, its first module stands for it
+  for (const auto& [module, file] : m_definitions) {
+    if (reached.count(module) || instantiated.count(module) == 0) continue;
+    reached.insert(module);
+    ranked.push_back({m_testbenches.count(module) != 0, treeSize(module),
+                      module});
+  }
+  std::sort(ranked.begin(), ranked.end(),
+            [](const Candidate& a, const Candidate& b) {
+              if (a.testbench != b.testbench) return b.testbench;
+              if (a.size != b.size) return a.size > b.size;
+              return a.module < b.module;
+            });
+  for (auto& candidate : ranked) m_topCandidates.push_back(candidate.module);
+}
+
+std::string HdlScanner::ProposedTop() const {
+  for (const auto& module : m_topCandidates) {
+    if (!m_testbenches.count(module)) return module;
+  }
+  return std::string();
+}
@@ -0,0 +1,125 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef HDL_SCANNER_H
+#define HDL_SCANNER_H
+
+namespace FOEDAG {
+
+// Declarations found in one HDL file. This is not a parser: only the
+// constructs needed to build the design hierarchy and the file dependencies
+// are recognized.
+struct HdlFileInfo {
+  // Modules (Verilog/SystemVerilog) and entities (VHDL) defined in the file
+  std::vector<std::string> modules;
+  // Modules and entities without ports, taken for test benches
+  std::vector<std::string> testbenches;
+  std::vector<std::string> interfaces;
+  std::vector<std::string> packages;
+  // (parent module, instantiated module)
+  std::vector<std::pair<std::string, std::string>> instances;
+  // `include "file" directives
+  std::vector<std::string> includes;
+  // SystemVerilog import pkg::*, VHDL use lib.pkg.all
+  std::vector<std::string> imports;
+};
+
+class HdlScanner {
+ public:
+  enum class Language { Unknown, Verilog, Vhdl };
+
+  // threads == 0 uses ResourceGovernor::MaxThreads()
+  explicit HdlScanner(unsigned int threads = 0);
+
+  // Scans the files on a thread pool. Unchanged files (same size and
+  // modification time) are not read again, changed files whose content hash
+  // is known reuse the cached declarations. Files not in the list are
+  // forgotten.
+  void Scan(const std::vector<std::string>& files);
+
+  // nullptr if the file was not scanned
+  const HdlFileInfo* FileInfo(const std::string& file) const;
+  // 0 if the file was not scanned
+  uint64_t FileHash(const std::string& file) const;
+
+  // Persist the per file results so a new session only reads changed files
+  void Save(std::ostream& out) const;
+  bool Load(std::istream& in);
+
+  // Module -> file defining it
+  const std::map<std::string, std::string>& Definitions() const {
+    return m_definitions;
+  }
+  // Module -> modules it instantiates (only the ones defined in the project)
+  const std::map<std::string, std::set<std::string>>& Hierarchy() const {
+    return m_hierarchy;
+  }
+  // Defined modules never instantiated, best top candidate first and test
+  // benches last. A cycle of instantiations no other module instantiates is
+  // represented by one of its modules.
+  const std::vector<std::string>& TopCandidates() const {
+    return m_topCandidates;
+  }
+  // Best candidate that is not a test bench, empty if there is none
+  std::string ProposedTop() const;
+
+  // Number of files read from disk and tokenized during the last Scan
+  size_t FilesParsed() const { return m_filesParsed; }
+
+  static Language LanguageOf(const std::string& file);
+  static HdlFileInfo ScanBuffer(const char* data, size_t size,
+                                Language language);
+  static uint64_t ContentHash(const char* data, size_t size);
+
+ private:
+  struct FileEntry {
+    int64_t mtime = 0;
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    HdlFileInfo info;
+  };
+
+  unsigned int m_threads;
+  size_t m_filesParsed = 0;
+  std::unordered_map<std::string, FileEntry> m_files;
+  // Content hash -> declarations, survives files being renamed or reverted
+  std::unordered_map<uint64_t, HdlFileInfo> m_contentCache;
+
+  std::map<std::string, std::string> m_definitions;
+  std::map<std::string, std::set<std::string>> m_hierarchy;
+  std::vector<std::string> m_topCandidates;
+  std::set<std::string> m_testbenches;
+
+  void buildHierarchy();
+};
+
+}  // namespace FOEDAG
+
+#endif
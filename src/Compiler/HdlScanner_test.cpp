@@ -0,0 +1,152 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/HdlScanner.h"
+
+#include <sstream>
+#include <string>
+
+#include "Utils/TestDirectory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+namespace FOEDAG {
+namespace {
+HdlFileInfo scan(const std::string& text, HdlScanner::Language language) {
+  return HdlScanner::ScanBuffer(text.data(), text.size(), language);
+}
+
+TEST(HdlScanner, VerilogDeclarations) {
+  HdlFileInfo info = scan(
+      "`include \"defs.vh\"\n"
+      "package pkg; endpackage\n"
+      "module top #(parameter W = 8) (input clk);\n"
+      "  import pkg::*;\n"
+      "  // sub commented (out);\n"
+      "  (* keep *) sub #(.W(W)) u_sub (.clk(clk));\n"
+      "  generate begin : g\n"
+      "    leaf u_leaf[1:0] (clk);\n"
+      "  end endgenerate\n"
+      "  function my_t f(int a); endfunction\n"
+      "endmodule\n",
+      HdlScanner::Language::Verilog);
+
+  EXPECT_THAT(info.modules, ElementsAre("top"));
+  EXPECT_THAT(info.packages, ElementsAre("pkg"));
+  EXPECT_THAT(info.includes, ElementsAre("defs.vh"));
+  EXPECT_THAT(info.imports, ElementsAre("pkg"));
+  EXPECT_THAT(info.instances,
+              ElementsAre(Pair("top", "sub"), Pair("top", "leaf")));
+}
+
+TEST(HdlScanner, VhdlDeclarations) {
+  HdlFileInfo info = scan(
+      "library ieee; use ieee.std_logic_1164.all;\n"
+      "ENTITY Top is port(clk : in std_logic); end entity;\n"
+      "architecture rtl of top is\n"
+      "  signal s : std_logic;\n"
+      "begin\n"
+      "  u1 : entity work.Leaf port map(c => clk);\n"
+      "  u2 : sub port map(a => s);\n"
+      "end architecture;\n",
+      HdlScanner::Language::Vhdl);
+
+  EXPECT_THAT(info.modules, ElementsAre("top"));
+  EXPECT_THAT(info.imports, ElementsAre("std_logic_1164"));
+  EXPECT_THAT(info.instances,
+              ElementsAre(Pair("top", "leaf"), Pair("top", "sub")));
+}
+
+// Scans the files written in a directory of its own
+class HdlScannerHierarchy : public TestDirectory {
+ protected:
+  void write(const std::string& name, const std::string& text) {
+    m_files.push_back(WriteFile(name, text));
+  }
+
+  std::vector<std::string> m_files;
+  HdlScanner m_scanner{2};
+};
+
+TEST_F(HdlScannerHierarchy, MultipleTops) {
+  write("a.v",
+        "module little(input a); leaf u (a); endmodule\n"
+        "module big(input a); mid u (a); endmodule\n");
+  write("b.v",
+        "module mid(input a); leaf u0 (a); leaf2 u1 (a); endmodule\n"
+        "module leaf(input a); endmodule\n"
+        "module leaf2(input a); endmodule\n");
+  m_scanner.Scan(m_files);
+
+  EXPECT_THAT(m_scanner.TopCandidates(), ElementsAre("big", "little"));
+  EXPECT_EQ(m_scanner.ProposedTop(), "big");
+  EXPECT_EQ(m_scanner.Definitions().at("leaf"), m_files[1]);
+}
+
+TEST_F(HdlScannerHierarchy, InstantiationCycle) {
+  write("a.v",
+        "module ping(input a); pong u (a); endmodule\n"
+        "module pong(input a); ping u (a); endmodule\n"
+        "module alone(input a); endmodule\n");
+  m_scanner.Scan(m_files);
+
+  EXPECT_THAT(m_scanner.Hierarchy().at("ping"), ElementsAre("pong"));
+  EXPECT_THAT(m_scanner.Hierarchy().at("pong"), ElementsAre("ping"));
+  // Nothing outside the cycle instantiates it, one of its modules stands
+  // for it
+  EXPECT_THAT(m_scanner.TopCandidates(), ElementsAre("ping", "alone"));
+}
+
+TEST_F(HdlScannerHierarchy, TestbenchIsNotProposed) {
+  write("top.v",
+        "module top(input clk); sub u (clk); endmodule\n"
+        "module sub(input clk); endmodule\n");
+  write("tb.v", "module tb; reg clk; top dut (clk); endmodule\n");
+  write("tb.vhd",
+        "entity tb_vhdl is end entity;\n"
+        "architecture sim of tb_vhdl is begin end architecture;\n");
+  m_scanner.Scan(m_files);
+
+  EXPECT_THAT(m_scanner.FileInfo(m_files[1])->testbenches, ElementsAre("tb"));
+  EXPECT_THAT(m_scanner.TopCandidates(), ElementsAre("tb", "tb_vhdl"));
+  EXPECT_EQ(m_scanner.ProposedTop(), "");
+
+  // Without the test bench instantiating it, top is proposed before them
+  write("other_tb.v", "module other_tb(); endmodule\n");
+  m_files.erase(m_files.begin() + 1);
+  m_scanner.Scan(m_files);
+  EXPECT_THAT(m_scanner.TopCandidates(),
+              ElementsAre("top", "other_tb", "tb_vhdl"));
+  EXPECT_EQ(m_scanner.ProposedTop(), "top");
+
+  // The test benches survive the cache
+  std::stringstream cache;
+  m_scanner.Save(cache);
+  HdlScanner loaded(1);
+  ASSERT_TRUE(loaded.Load(cache));
+  EXPECT_EQ(loaded.TopCandidates(), m_scanner.TopCandidates());
+}
+
+}  // namespace
+}  // namespace FOEDAG
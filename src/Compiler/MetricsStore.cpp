@@ -0,0 +1,922 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/MetricsStore.h"
+
+extern "C" {
+#include <tcl.h>
+}
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#include "Tcl/TclInterpreter.h"
+#include "Utils/FilterParser.h"
+
+using namespace FOEDAG;
+
+namespace {
+
+// File: magic, generation (changes when the file is rewritten), blocks.
+// Block: magic, payload size, compressed size, crc32 of the compressed
+// bytes, compressed payload.
+const char FILE_MAGIC[8] = {'F', 'O', 'E', 'D', 'A', 'G', 'M', '1'};
+const char BLOCK_MAGIC[4] = {'M', 'B', 'L', 'K'};
+constexpr size_t FILE_HEADER_SIZE = 16;
+constexpr size_t BLOCK_HEADER_SIZE = 16;
+
+template <typename T>
+void put(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+class Reader {
+ public:
+  explicit Reader(const std::string& data) : m_data(data) {}
+  template <typename T>
+  bool get(T& value) {
+    if (m_pos + sizeof(T) > m_data.size()) return false;
+    std::memcpy(&value, m_data.data() + m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return true;
+  }
+  bool get(std::string& value, size_t size) {
+    if (m_pos + size > m_data.size()) return false;
+    value.assign(m_data, m_pos, size);
+    m_pos += size;
+    return true;
+  }
+
+ private:
+  const std::string& m_data;
+  size_t m_pos = 0;
+};
+
+std::string fileHeader() {
+  std::string header(FILE_MAGIC, sizeof(FILE_MAGIC));
+  std::random_device random;
+  uint64_t generation = (uint64_t(random()) << 32) ^ random() ^
+                        uint64_t(std::chrono::steady_clock::now()
+                                     .time_since_epoch()
+                                     .count());
+  put(header, generation);
+  return header;
+}
+
+// Empty if the payload cannot be compressed
+std::string block(const std::string& payload) {
+  uLongf size = compressBound(payload.size());
+  std::string compressed(size, '\0');
+  if (compress2(reinterpret_cast<Bytef*>(&compressed[0]), &size,
+                reinterpret_cast<const Bytef*>(payload.data()),
+                payload.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+    return std::string();
+  }
+  compressed.resize(size);
+  std::string data(BLOCK_MAGIC, sizeof(BLOCK_MAGIC));
+  put(data, uint32_t(payload.size()));
+  put(data, uint32_t(compressed.size()));
+  put(data, uint32_t(crc32(0, reinterpret_cast<const Bytef*>(compressed.data()),
+                           compressed.size())));
+  return data + compressed;
+}
+
+// One write, appends of other processes do not interleave with it
+bool appendFile(const std::string& file, const std::string& data,
+                bool header) {
+  // The threads of a process append one after the other, only the first
+  // append to an empty file writes its header
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  FILE* out = std::fopen(file.c_str(), "ab");
+  if (!out) return false;
+  std::setvbuf(out, nullptr, _IONBF, 0);
+  std::fseek(out, 0, SEEK_END);
+  std::string content =
+      (header && std::ftell(out) == 0) ? fileHeader() + data : data;
+  bool ok = std::fwrite(content.data(), 1, content.size(), out) ==
+            content.size();
+  return std::fclose(out) == 0 && ok;
+}
+
+bool parseNumber(const std::string& text, double& number) {
+  if (text.empty()) return false;
+  char* end = nullptr;
+  number = std::strtod(text.c_str(), &end);
+  return *end == '\0';
+}
+
+// Numbers numerically, text otherwise, nulls last
+bool less(const MetricsStore::Value& a, const MetricsStore::Value& b) {
+  if (a.null || b.null) return !a.null && b.null;
+  if (a.type != MetricsStore::Type::Text &&
+      b.type != MetricsStore::Type::Text) {
+    return a.Number() < b.Number();
+  }
+  return a.ToString() < b.ToString();
+}
+
+std::string lower(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return text;
+}
+
+}  // namespace
+
+MetricsStore::Value MetricsStore::Value::Of(int64_t integer) {
+  Value value;
+  value.type = Type::Integer;
+  value.null = false;
+  value.integer = integer;
+  return value;
+}
+
+MetricsStore::Value MetricsStore::Value::Of(double real) {
+  Value value;
+  value.type = Type::Real;
+  value.null = false;
+  value.real = real;
+  return value;
+}
+
+MetricsStore::Value MetricsStore::Value::Of(const std::string& text) {
+  Value value;
+  value.type = Type::Text;
+  value.null = false;
+  value.text = text;
+  return value;
+}
+
+std::string MetricsStore::Value::ToString() const {
+  if (null) return std::string();
+  switch (type) {
+    case Type::Integer:
+      return std::to_string(integer);
+    case Type::Real: {
+      std::ostringstream out;
+      out.precision(15);
+      out << real;
+      return out.str();
+    }
+    default:
+      return text;
+  }
+}
+
+double MetricsStore::Value::Number() const {
+  if (null) return NAN;
+  switch (type) {
+    case Type::Integer:
+      return double(integer);
+    case Type::Real:
+      return real;
+    default:
+      return NAN;
+  }
+}
+
+MetricsStore::Value MetricsStore::Column::Get(size_t row) const {
+  if (!valid[row]) return Value();
+  switch (type) {
+    case Type::Integer:
+      return Value::Of(integers[row]);
+    case Type::Real:
+      return Value::Of(reals[row]);
+    default:
+      return Value::Of(dictionary[texts[row]]);
+  }
+}
+
+void MetricsStore::Column::Add(const Value& value) {
+  if (!value.null && value.type > type) Promote(value.type);
+  valid.push_back(!value.null);
+  switch (type) {
+    case Type::Integer:
+      integers.push_back(value.null ? 0 : value.integer);
+      break;
+    case Type::Real:
+      reals.push_back(value.null ? 0 : value.Number());
+      break;
+    case Type::Text: {
+      std::string text = value.ToString();
+      auto it = lookup.find(text);
+      if (it == lookup.end()) {
+        it = lookup.emplace(text, uint32_t(dictionary.size())).first;
+        dictionary.push_back(text);
+      }
+      texts.push_back(it->second);
+      break;
+    }
+  }
+}
+
+void MetricsStore::Column::Promote(Type newType) {
+  std::vector<Value> values;
+  for (size_t row = 0; row < valid.size(); row++) values.push_back(Get(row));
+  valid.clear();
+  integers.clear();
+  reals.clear();
+  texts.clear();
+  dictionary.clear();
+  lookup.clear();
+  type = newType;
+  for (const Value& value : values) Add(value);
+}
+
+void MetricsStore::reset() {
+  m_offset = 0;
+  m_rows = 0;
+  m_blocks = 0;
+  m_columns.clear();
+  m_byName.clear();
+}
+
+// rows, columns, then per column: name, type, validity bitmap and values
+std::string MetricsStore::encode(const std::vector<Row>& rows) {
+  std::vector<Column> columns;
+  std::unordered_map<std::string, size_t> byName;
+  for (size_t row = 0; row < rows.size(); row++) {
+    for (const auto& [name, value] : rows[row]) {
+      auto it = byName.find(name);
+      if (it == byName.end()) {
+        it = byName.emplace(name, columns.size()).first;
+        columns.emplace_back();
+        columns.back().name = name;
+      }
+      Column& column = columns[it->second];
+      while (column.valid.size() < row) column.Add(Value());
+      if (column.valid.size() == row) column.Add(value);
+    }
+  }
+  std::string payload;
+  put(payload, uint32_t(rows.size()));
+  put(payload, uint32_t(columns.size()));
+  for (Column& column : columns) {
+    while (column.valid.size() < rows.size()) column.Add(Value());
+    put(payload, uint16_t(column.name.size()));
+    payload += column.name;
+    put(payload, uint8_t(column.type));
+    std::string bitmap((rows.size() + 7) / 8, '\0');
+    for (size_t row = 0; row < rows.size(); row++) {
+      if (column.valid[row]) bitmap[row / 8] |= char(1 << (row % 8));
+    }
+    payload += bitmap;
+    switch (column.type) {
+      case Type::Integer:
+        for (int64_t value : column.integers) put(payload, value);
+        break;
+      case Type::Real:
+        for (double value : column.reals) put(payload, value);
+        break;
+      case Type::Text:
+        put(payload, uint32_t(column.dictionary.size()));
+        for (const auto& text : column.dictionary) {
+          put(payload, uint32_t(text.size()));
+          payload += text;
+        }
+        for (uint32_t index : column.texts) put(payload, index);
+        break;
+    }
+  }
+  return payload;
+}
+
+bool MetricsStore::readBlock(const std::string& payload) {
+  Reader reader(payload);
+  uint32_t rows = 0;
+  uint32_t count = 0;
+  if (!reader.get(rows) || !reader.get(count)) return false;
+  std::vector<std::pair<std::string, std::vector<Value>>> columns(count);
+  for (auto& [name, values] : columns) {
+    uint16_t size = 0;
+    uint8_t type = 0;
+    std::string bitmap;
+    if (!reader.get(size) || !reader.get(name, size) || !reader.get(type) ||
+        type > uint8_t(Type::Text) || !reader.get(bitmap, (rows + 7) / 8)) {
+      return false;
+    }
+    std::vector<std::string> dictionary;
+    if (Type(type) == Type::Text) {
+      uint32_t entries = 0;
+      if (!reader.get(entries)) return false;
+      dictionary.resize(entries);
+      for (auto& text : dictionary) {
+        uint32_t length = 0;
+        if (!reader.get(length) || !reader.get(text, length)) return false;
+      }
+    }
+    for (uint32_t row = 0; row < rows; row++) {
+      Value value;
+      bool ok = true;
+      if (Type(type) == Type::Integer) {
+        int64_t integer = 0;
+        ok = reader.get(integer);
+        value = Value::Of(integer);
+      } else if (Type(type) == Type::Real) {
+        double real = 0;
+        ok = reader.get(real);
+        value = Value::Of(real);
+      } else {
+        uint32_t index = 0;
+        ok = reader.get(index) && index < dictionary.size();
+        if (ok) value = Value::Of(dictionary[index]);
+      }
+      if (!ok) return false;
+      if (!(bitmap[row / 8] & (1 << (row % 8)))) value = Value();
+      values.push_back(value);
+    }
+  }
+  // Parsed whole before anything changes
+  for (const auto& [name, values] : columns) {
+    auto it = m_byName.find(name);
+    if (it == m_byName.end()) {
+      it = m_byName.emplace(name, m_columns.size()).first;
+      m_columns.emplace_back();
+      m_columns.back().name = name;
+      for (size_t row = 0; row < m_rows; row++) m_columns.back().Add(Value());
+    }
+    for (const Value& value : values) m_columns[it->second].Add(value);
+  }
+  m_rows += rows;
+  for (Column& column : m_columns) {
+    while (column.valid.size() < m_rows) column.Add(Value());
+  }
+  return true;
+}
+
+int MetricsStore::Load() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::ifstream in(m_file, std::ios::binary);
+  if (!in.is_open()) {
+    reset();
+    return 0;
+  }
+  std::string header(FILE_HEADER_SIZE, '\0');
+  if (!in.read(&header[0], FILE_HEADER_SIZE)) {
+    reset();
+    return in.gcount() == 0 ? 0 : -1;
+  }
+  if (header.compare(0, sizeof(FILE_MAGIC), FILE_MAGIC, sizeof(FILE_MAGIC))) {
+    reset();
+    return -1;
+  }
+  // Compacted by someone else, read again from the start
+  if (m_offset == 0 || header != m_header) {
+    reset();
+    m_header = header;
+    m_offset = FILE_HEADER_SIZE;
+  }
+  in.seekg(m_offset);
+  std::string data{std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>()};
+  const std::string blockMagic(BLOCK_MAGIC, sizeof(BLOCK_MAGIC));
+  size_t pos = 0;
+  while (pos + BLOCK_HEADER_SIZE <= data.size()) {
+    // Two processes created the file together, the second header is junk
+    if (!data.compare(pos, sizeof(FILE_MAGIC), FILE_MAGIC,
+                      sizeof(FILE_MAGIC))) {
+      pos += FILE_HEADER_SIZE;
+      continue;
+    }
+    uint32_t size = 0;
+    uint32_t compressedSize = 0;
+    uint32_t crc = 0;
+    std::memcpy(&size, &data[pos + 4], 4);
+    std::memcpy(&compressedSize, &data[pos + 8], 4);
+    std::memcpy(&crc, &data[pos + 12], 4);
+    const char* compressed = data.data() + pos + BLOCK_HEADER_SIZE;
+    bool ok = !data.compare(pos, sizeof(BLOCK_MAGIC), blockMagic) &&
+              pos + BLOCK_HEADER_SIZE + compressedSize <= data.size() &&
+              crc32(0, reinterpret_cast<const Bytef*>(compressed),
+                    compressedSize) == crc;
+    if (ok) {
+      std::string payload(size, '\0');
+      uLongf payloadSize = size;
+      ok = uncompress(reinterpret_cast<Bytef*>(&payload[0]), &payloadSize,
+                      reinterpret_cast<const Bytef*>(compressed),
+                      compressedSize) == Z_OK &&
+           payloadSize == size && readBlock(payload);
+    }
+    if (!ok) {
+      // The block of a writer that died is followed by the next append,
+      // the last block may still be being written
+      size_t next = data.find(blockMagic, pos + 1);
+      if (next == std::string::npos) break;
+      pos = next;
+      continue;
+    }
+    pos += BLOCK_HEADER_SIZE + compressedSize;
+    m_blocks++;
+  }
+  m_offset += pos;
+  return 0;
+}
+
+int MetricsStore::Append(const std::vector<Row>& rows) {
+  if (rows.empty()) return 0;
+  std::string data = block(encode(rows));
+  if (data.empty() || !appendFile(m_file, data, true)) return -1;
+  return Load();
+}
+
+int MetricsStore::Compact() {
+  if (Load() != 0) return -1;
+  std::string data = fileHeader();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t first = 0; first < m_rows; first += COMPACT_BLOCK_ROWS) {
+      std::vector<Row> rows;
+      for (size_t row = first;
+           row < std::min(m_rows, first + COMPACT_BLOCK_ROWS); row++) {
+        rows.emplace_back();
+        for (const Column& column : m_columns) {
+          Value value = column.Get(row);
+          if (!value.null) rows.back().emplace_back(column.name, value);
+        }
+      }
+      std::string compressed = block(encode(rows));
+      if (compressed.empty()) return -1;
+      data += compressed;
+    }
+  }
+  std::string tmp = m_file + ".tmp";
+  std::error_code ec;
+  std::filesystem::remove(tmp, ec);
+  if (!appendFile(tmp, data, false)) return -1;
+  std::filesystem::rename(tmp, m_file, ec);
+  if (ec) return -1;
+  return Load();
+}
+
+size_t MetricsStore::RowCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_rows;
+}
+
+size_t MetricsStore::BlockCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_blocks;
+}
+
+std::vector<std::string> MetricsStore::Columns() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<std::string> names;
+  for (const Column& column : m_columns) names.push_back(column.name);
+  return names;
+}
+
+const MetricsStore::Column* MetricsStore::column(
+    const std::string& name) const {
+  auto it = m_byName.find(name);
+  return it == m_byName.end() ? nullptr : &m_columns[it->second];
+}
+
+bool MetricsStore::Run(const Query& query, std::vector<std::string>& header,
+                       std::vector<std::vector<Value>>& rows,
+                       std::string& error) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  header.clear();
+  rows.clear();
+
+  std::vector<size_t> selected;
+  if (query.latest) {
+    const Column* run = column("run");
+    const Column* stage = column("stage");
+    std::map<std::pair<std::string, std::string>, size_t> newest;
+    for (size_t row = 0; row < m_rows; row++) {
+      newest[{run ? run->Get(row).ToString() : "",
+              stage ? stage->Get(row).ToString() : ""}] = row;
+    }
+    for (const auto& [key, row] : newest) selected.push_back(row);
+    std::sort(selected.begin(), selected.end());
+  } else {
+    for (size_t row = 0; row < m_rows; row++) selected.push_back(row);
+  }
+
+  std::vector<FilterCondition> filter;
+  if (!FilterParser::Parse(query.where, filter, error)) return false;
+  for (const auto& condition : filter) {
+    // Case insensitive, as the other column names
+    const Column* tested = column(lower(condition.field));
+    if (!tested) {
+      error = "Unknown column " + condition.field;
+      return false;
+    }
+    double number = 0;
+    bool numeric =
+        tested->type != Type::Text && parseNumber(condition.value, number);
+    auto match = [&](size_t row) {
+      Value value = tested->Get(row);
+      if (value.null) return false;
+      const std::string& op = condition.op;
+      if (op == "=~") {
+        return Tcl_StringMatch(value.ToString().c_str(),
+                               condition.value.c_str()) != 0;
+      }
+      int order = 0;
+      if (numeric) {
+        double lhs = value.Number();
+        order = lhs < number ? -1 : (lhs > number ? 1 : 0);
+      } else {
+        order = value.ToString().compare(condition.value);
+      }
+      if (op == "==") return order == 0;
+      if (op == "!=") return order != 0;
+      if (op == "<") return order < 0;
+      if (op == "<=") return order <= 0;
+      if (op == ">") return order > 0;
+      return order >= 0;
+    };
+    selected.erase(std::remove_if(selected.begin(), selected.end(),
+                                  [&](size_t row) { return !match(row); }),
+                   selected.end());
+  }
+
+  // Output columns: plain column or function(column)
+  struct Output {
+    std::string function;
+    const Column* column = nullptr;
+  };
+  std::vector<Output> outputs;
+  std::vector<std::string> names = query.columns;
+  if (names.empty()) {
+    for (const Column& column : m_columns) names.push_back(column.name);
+  }
+  bool aggregate = !query.groupBy.empty();
+  for (const auto& item : names) {
+    std::string name = lower(item);
+    Output output;
+    size_t open = name.find('(');
+    if (open != std::string::npos && name.back() == ')') {
+      output.function = name.substr(0, open);
+      name = name.substr(open + 1, name.size() - open - 2);
+      if (output.function != "count" && output.function != "min" &&
+          output.function != "max" && output.function != "sum" &&
+          output.function != "avg" && output.function != "last") {
+        error = "Unknown function " + output.function;
+        return false;
+      }
+      aggregate = true;
+    }
+    if (!name.empty() || output.function != "count") {
+      output.column = column(name);
+      if (!output.column) {
+        error = "Unknown column " + name;
+        return false;
+      }
+      if ((output.function == "sum" || output.function == "avg") &&
+          output.column->type == Type::Text) {
+        error = output.function + " needs a numeric column: " + name;
+        return false;
+      }
+    }
+    header.push_back(lower(item));
+    outputs.push_back(output);
+  }
+
+  if (!aggregate) {
+    for (size_t row : selected) {
+      rows.emplace_back();
+      for (const Output& output : outputs) {
+        rows.back().push_back(output.column->Get(row));
+      }
+    }
+  } else {
+    std::vector<const Column*> keys;
+    for (const auto& name : query.groupBy) {
+      const Column* key = column(lower(name));
+      if (!key) {
+        error = "Unknown column " + name;
+        return false;
+      }
+      keys.push_back(key);
+    }
+    for (size_t i = 0; i < outputs.size(); i++) {
+      if (outputs[i].function.empty() &&
+          std::find(keys.begin(), keys.end(), outputs[i].column) ==
+              keys.end()) {
+        error = header[i] + " is neither grouped nor aggregated";
+        return false;
+      }
+    }
+    // Groups in order of first row
+    std::vector<std::vector<size_t>> groups;
+    std::map<std::vector<std::string>, size_t> groupOf;
+    // Without keys there is one group, empty if no row is selected
+    if (keys.empty()) groups.push_back(selected);
+    for (size_t row : keys.empty() ? std::vector<size_t>() : selected) {
+      std::vector<std::string> key;
+      for (const Column* column : keys) {
+        key.push_back(column->Get(row).ToString());
+      }
+      auto [it, added] = groupOf.emplace(key, groups.size());
+      if (added) groups.emplace_back();
+      groups[it->second].push_back(row);
+    }
+    for (const auto& group : groups) {
+      rows.emplace_back();
+      for (const Output& output : outputs) {
+        const std::string& function = output.function;
+        Value result;
+        if (function.empty()) {
+          result = output.column->Get(group.front());
+        } else if (function == "count") {
+          int64_t count = 0;
+          for (size_t row : group) {
+            if (!output.column || !output.column->Get(row).null) count++;
+          }
+          result = Value::Of(count);
+        } else {
+          std::vector<Value> values;
+          for (size_t row : group) {
+            Value value = output.column->Get(row);
+            if (!value.null) values.push_back(value);
+          }
+          if (values.empty()) {
+          } else if (function == "min") {
+            result = *std::min_element(values.begin(), values.end(), less);
+          } else if (function == "max") {
+            result = *std::max_element(values.begin(), values.end(), less);
+          } else if (function == "last") {
+            result = values.back();
+          } else if (output.column->type == Type::Integer) {
+            int64_t sum = 0;
+            for (const Value& value : values) sum += value.integer;
+            result = function == "sum" ? Value::Of(sum)
+                                       : Value::Of(double(sum) / values.size());
+          } else {
+            double sum = 0;
+            for (const Value& value : values) sum += value.Number();
+            result = Value::Of(function == "sum" ? sum : sum / values.size());
+          }
+        }
+        rows.back().push_back(result);
+      }
+    }
+  }
+
+  if (!query.orderBy.empty()) {
+    auto it = std::find(header.begin(), header.end(), lower(query.orderBy));
+    if (it == header.end()) {
+      error = "Cannot order by " + query.orderBy + ", it is not selected";
+      return false;
+    }
+    size_t index = it - header.begin();
+    std::stable_sort(rows.begin(), rows.end(),
+                     [&](const std::vector<Value>& a,
+                         const std::vector<Value>& b) {
+                       const Value& x = a[index];
+                       const Value& y = b[index];
+                       // Nulls stay last either way
+                       if (query.descending && !x.null && !y.null)
+                         return less(y, x);
+                       return less(x, y);
+                     });
+  }
+  if (query.limit > 0 && rows.size() > query.limit) rows.resize(query.limit);
+  return true;
+}
+
+MetricsStore& MetricsStore::Open(const std::string& file) {
+  static std::mutex mutex;
+  static std::map<std::string, std::unique_ptr<MetricsStore>> stores;
+  std::error_code ec;
+  std::string path = std::filesystem::absolute(file, ec).string();
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& store = stores[path];
+  if (!store) store.reset(new MetricsStore(path));
+  store->Load();
+  return *store;
+}
+
+std::string MetricsStore::DefaultFile(const std::string& directory) {
+  if (directory.empty()) return DEFAULT_FILE;
+  return (std::filesystem::path(directory) / DEFAULT_FILE).string();
+}
+
+namespace {
+std::string defaultFile(void* clientData) {
+  const auto& directory = *static_cast<MetricsStore::Directory*>(clientData);
+  return MetricsStore::DefaultFile(directory ? directory() : std::string());
+}
+
+void deleteDirectory(void* clientData) {
+  delete static_cast<MetricsStore::Directory*>(clientData);
+}
+}  // namespace
+
+void MetricsStore::RegisterCommands(TclInterpreter* interp,
+                                    const Directory& directory) {
+  // record_metrics ?-file <file>? -run <run> -stage <stage>
+  //                <name> <value> ?<name> <value>...?
+  // Appends a row, with the time. Values are integer, real or text.
+  auto record_metrics = [](void* clientData, Tcl_Interp* interp, int argc,
+                           const char* argv[]) -> int {
+    std::string file = defaultFile(clientData);
+    std::string run;
+    std::string stage;
+    Row row;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i += 2) {
+      if (i + 1 >= argc) {
+        ok = false;
+        break;
+      }
+      std::string name = argv[i];
+      std::string text = argv[i + 1];
+      if (name == "-file") {
+        file = text;
+      } else if (name == "-run") {
+        run = text;
+      } else if (name == "-stage") {
+        stage = text;
+      } else if (name.empty() || name[0] == '-' ||
+                 name.find_first_of("()=!<>& \t") != std::string::npos) {
+        ok = false;
+      } else {
+        char* end = nullptr;
+        long long integer = std::strtoll(text.c_str(), &end, 10);
+        double real = 0;
+        if (!text.empty() && *end == '\0') {
+          row.emplace_back(lower(name), Value::Of(int64_t(integer)));
+        } else if (parseNumber(text, real)) {
+          row.emplace_back(lower(name), Value::Of(real));
+        } else {
+          row.emplace_back(lower(name), Value::Of(text));
+        }
+      }
+    }
+    if (!ok || run.empty() || stage.empty()) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp,
+                       "Usage: record_metrics ?-file <file>? -run <run> "
+                       "-stage <stage> <name> <value> ?<name> <value>...?",
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+    row.insert(row.begin(),
+               {{"run", Value::Of(run)},
+                {"stage", Value::Of(stage)},
+                {"time", Value::Of(int64_t(std::time(nullptr)))}});
+    if (Open(file).Append({row}) != 0) {
+      Tcl_AppendResult(interp, "Cannot write the metrics to ", file.c_str(),
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+    return TCL_OK;
+  };
+  interp->registerCmd("record_metrics", record_metrics,
+                      new Directory(directory), deleteDirectory);
+
+  // query_metrics ?-file <file>? ?-columns <list>? ?-where <filter>?
+  //               ?-group-by <list>? ?-latest? ?-order-by <column>? ?-desc?
+  //               ?-limit <n>? ?-header?
+  // One list per row, the column names first with -header.
+  auto query_metrics = [](void* clientData, Tcl_Interp* interp, int argc,
+                          const char* argv[]) -> int {
+    std::string file = defaultFile(clientData);
+    Query query;
+    bool withHeader = false;
+    bool ok = true;
+    auto split = [interp](const char* list, std::vector<std::string>& items) {
+      int count = 0;
+      const char** elements = nullptr;
+      if (Tcl_SplitList(interp, list, &count, &elements) != TCL_OK) {
+        return false;
+      }
+      for (int i = 0; i < count; i++) items.push_back(elements[i]);
+      Tcl_Free((char*)elements);
+      return true;
+    };
+    for (int i = 1; i < argc && ok; i++) {
+      std::string option = argv[i];
+      bool hasValue = i + 1 < argc;
+      if (option == "-file" && hasValue) {
+        file = argv[++i];
+      } else if (option == "-columns" && hasValue) {
+        ok = split(argv[++i], query.columns);
+      } else if (option == "-where" && hasValue) {
+        query.where = argv[++i];
+      } else if (option == "-group-by" && hasValue) {
+        ok = split(argv[++i], query.groupBy);
+      } else if (option == "-latest") {
+        query.latest = true;
+      } else if (option == "-order-by" && hasValue) {
+        query.orderBy = argv[++i];
+      } else if (option == "-desc") {
+        query.descending = true;
+      } else if (option == "-limit" && hasValue) {
+        int limit = 0;
+        ok = Tcl_GetInt(interp, argv[++i], &limit) == TCL_OK && limit >= 0;
+        query.limit = limit;
+      } else if (option == "-header") {
+        withHeader = true;
+      } else {
+        ok = false;
+      }
+    }
+    if (!ok) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp,
+                       "Usage: query_metrics ?-file <file>? ?-columns <list>? "
+                       "?-where <filter>? ?-group-by <list>? ?-latest? "
+                       "?-order-by <column>? ?-desc? ?-limit <n>? ?-header?",
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+    MetricsStore& store = Open(file);
+    std::vector<std::string> header;
+    std::vector<std::vector<Value>> rows;
+    std::string error;
+    if (!store.Run(query, header, rows, error)) {
+      Tcl_AppendResult(interp, error.c_str(), (char*)NULL);
+      return TCL_ERROR;
+    }
+    Tcl_Obj* result = Tcl_NewListObj(0, nullptr);
+    if (withHeader) {
+      Tcl_Obj* names = Tcl_NewListObj(0, nullptr);
+      for (const auto& name : header) {
+        Tcl_ListObjAppendElement(interp, names,
+                                 Tcl_NewStringObj(name.c_str(), -1));
+      }
+      Tcl_ListObjAppendElement(interp, result, names);
+    }
+    for (const auto& row : rows) {
+      Tcl_Obj* values = Tcl_NewListObj(0, nullptr);
+      for (const Value& value : row) {
+        Tcl_Obj* element = nullptr;
+        if (value.null) {
+          element = Tcl_NewObj();
+        } else if (value.type == Type::Integer) {
+          element = Tcl_NewWideIntObj(value.integer);
+        } else if (value.type == Type::Real) {
+          element = Tcl_NewDoubleObj(value.real);
+        } else {
+          element = Tcl_NewStringObj(value.text.c_str(), -1);
+        }
+        Tcl_ListObjAppendElement(interp, values, element);
+      }
+      Tcl_ListObjAppendElement(interp, result, values);
+    }
+    Tcl_SetObjResult(interp, result);
+    return TCL_OK;
+  };
+  interp->registerCmd("query_metrics", query_metrics,
+                      new Directory(directory), deleteDirectory);
+
+  // compact_metrics ?-file <file>?: rewrites the store in large blocks
+  auto compact_metrics = [](void* clientData, Tcl_Interp* interp, int argc,
+                            const char* argv[]) -> int {
+    std::string file = defaultFile(clientData);
+    if (argc == 3 && std::string(argv[1]) == "-file") {
+      file = argv[2];
+    } else if (argc != 1) {
+      Tcl_AppendResult(interp, "Usage: compact_metrics ?-file <file>?",
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+    MetricsStore& store = Open(file);
+    if (store.Compact() != 0) {
+      Tcl_AppendResult(interp, "Cannot compact ", file.c_str(), (char*)NULL);
+      return TCL_ERROR;
+    }
+    std::string result = std::to_string(store.RowCount()) + " rows in " +
+                         std::to_string(store.BlockCount()) + " blocks";
+    Tcl_AppendResult(interp, result.c_str(), (char*)NULL);
+    return TCL_OK;
+  };
+  interp->registerCmd("compact_metrics", compact_metrics,
+                      new Directory(directory), deleteDirectory);
+}
@@ -0,0 +1,151 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef METRICS_STORE_H
+#define METRICS_STORE_H
+
+namespace FOEDAG {
+
+class TclInterpreter;
+
+// Results of the runs (runtime, memory, slack, utilization...), one row per
+// run and stage, in an append-only file of zlib compressed column blocks.
+// Every Append adds one block with its own columns, a column missing from a
+// block is null for its rows. A column starting as integer becomes real on
+// the first real value, and text on the first text value. Several processes
+// can append to the same file, Load only reads the blocks added since the
+// previous call.
+class MetricsStore {
+ public:
+  enum class Type : uint8_t { Integer, Real, Text };
+  struct Value {
+    Type type = Type::Text;
+    bool null = true;
+    int64_t integer = 0;
+    double real = 0;
+    std::string text;
+
+    static Value Of(int64_t integer);
+    static Value Of(double real);
+    static Value Of(const std::string& text);
+    // Empty when null
+    std::string ToString() const;
+    // NaN for text and null
+    double Number() const;
+  };
+  using Row = std::vector<std::pair<std::string, Value>>;
+
+  // A query, see RegisterCommands for the Tcl syntax
+  struct Query {
+    // Column names or count(), count(c), min(c), max(c), sum(c), avg(c) and
+    // last(c). Empty selects every column.
+    std::vector<std::string> columns;
+    // Same syntax as the device filters: "wns < 0 && run =~ impl_*"
+    std::string where;
+    std::vector<std::string> groupBy;
+    // Only the newest row of each run and stage
+    bool latest = false;
+    std::string orderBy;
+    bool descending = false;
+    size_t limit = 0;
+  };
+
+  static constexpr const char* DEFAULT_FILE = "metrics.qor";
+  // Compact rewrites the store in blocks of this many rows
+  static constexpr size_t COMPACT_BLOCK_ROWS = 4096;
+
+  explicit MetricsStore(const std::string& file) : m_file(file) {}
+  // Store of the file shared by the commands and the compiler, loaded
+  static MetricsStore& Open(const std::string& file);
+
+  // A missing file is an empty store. 0 on success, -1 if the file is not a
+  // metrics store. A block still being written is read by the next call,
+  // damaged blocks (a writer died) are skipped.
+  int Load();
+  // Appends the rows as one block, then loads. 0 on success, -1 on error.
+  int Append(const std::vector<Row>& rows);
+  // Rewrites the file with large blocks. Appends from other processes
+  // while compacting are lost.
+  int Compact();
+
+  const std::string& File() const { return m_file; }
+  size_t RowCount() const;
+  size_t BlockCount() const;
+  std::vector<std::string> Columns() const;
+
+  // false and error set on a bad query. Null values are empty strings in
+  // the result.
+  bool Run(const Query& query, std::vector<std::string>& header,
+           std::vector<std::vector<Value>>& rows, std::string& error) const;
+
+  // Directory of the store the commands use without -file, the current
+  // directory if it returns an empty string
+  using Directory = std::function<std::string()>;
+  // record_metrics, query_metrics, compact_metrics
+  static void RegisterCommands(TclInterpreter* interp,
+                               const Directory& directory = nullptr);
+  // DEFAULT_FILE in the directory
+  static std::string DefaultFile(const std::string& directory);
+
+ private:
+  struct Column {
+    std::string name;
+    Type type = Type::Integer;
+    std::vector<uint8_t> valid;
+    std::vector<int64_t> integers;
+    std::vector<double> reals;
+    // Text values are indexes in the dictionary
+    std::vector<uint32_t> texts;
+    std::vector<std::string> dictionary;
+    std::unordered_map<std::string, uint32_t> lookup;
+
+    Value Get(size_t row) const;
+    void Add(const Value& value);
+    void Promote(Type newType);
+  };
+
+  std::string m_file;
+  // Of the file last read, a new one means it was rewritten
+  std::string m_header;
+  uint64_t m_offset{0};
+  size_t m_rows{0};
+  size_t m_blocks{0};
+  std::vector<Column> m_columns;
+  std::unordered_map<std::string, size_t> m_byName;
+  mutable std::mutex m_mutex;
+
+  void reset();
+  bool readBlock(const std::string& payload);
+  static std::string encode(const std::vector<Row>& rows);
+  const Column* column(const std::string& name) const;
+};
+
+}  // namespace FOEDAG
+
+#endif  // METRICS_STORE_H
@@ -0,0 +1,209 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/MetricsStore.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "Utils/TestDirectory.h"
+#include "gtest/gtest.h"
+
+namespace FOEDAG {
+namespace {
+
+using Value = MetricsStore::Value;
+
+class MetricsStoreTest : public TestDirectory {
+ protected:
+  MetricsStore::Row row(const std::string& run, const std::string& stage,
+                        double wns, int64_t luts) {
+    return {{"run", Value::Of(run)},
+            {"stage", Value::Of(stage)},
+            {"wns", Value::Of(wns)},
+            {"luts", Value::Of(luts)}};
+  }
+  // Values of the result as strings
+  std::vector<std::vector<std::string>> query(
+      const MetricsStore& store, const MetricsStore::Query& query) {
+    std::vector<std::string> header;
+    std::vector<std::vector<Value>> rows;
+    std::string error;
+    EXPECT_TRUE(store.Run(query, header, rows, error)) << error;
+    std::vector<std::vector<std::string>> result;
+    for (const auto& values : rows) {
+      result.emplace_back();
+      for (const auto& value : values) {
+        result.back().push_back(value.ToString());
+      }
+    }
+    return result;
+  }
+  std::string error(const MetricsStore& store,
+                    const MetricsStore::Query& query) {
+    std::vector<std::string> header;
+    std::vector<std::vector<Value>> rows;
+    std::string error;
+    EXPECT_FALSE(store.Run(query, header, rows, error));
+    return error;
+  }
+
+  std::string m_file{Path("metrics")};
+};
+
+using Rows = std::vector<std::vector<std::string>>;
+
+TEST_F(MetricsStoreTest, AppendAndReload) {
+  MetricsStore store(m_file);
+  EXPECT_EQ(store.Load(), 0);
+  EXPECT_EQ(store.RowCount(), 0u);
+  ASSERT_EQ(store.Append({{{"run", Value::Of(std::string("a"))},
+                           {"wns", Value::Of(int64_t(1))}}}),
+            0);
+  // wns becomes real, status only exists in the second block
+  ASSERT_EQ(store.Append({{{"run", Value::Of(std::string("b"))},
+                           {"wns", Value::Of(-0.25)},
+                           {"status", Value::Of(std::string("failed"))}}}),
+            0);
+  EXPECT_EQ(store.RowCount(), 2u);
+  EXPECT_EQ(store.BlockCount(), 2u);
+
+  MetricsStore other(m_file);
+  ASSERT_EQ(other.Load(), 0);
+  EXPECT_EQ(other.Columns(),
+            (std::vector<std::string>{"run", "wns", "status"}));
+  EXPECT_EQ(query(other, {}), (Rows{{"a", "1", ""}, {"b", "-0.25", "failed"}}));
+
+  // Only the new block is read
+  store.Append({row("c", "synth", 0.5, 10)});
+  ASSERT_EQ(other.Load(), 0);
+  EXPECT_EQ(other.RowCount(), 3u);
+  EXPECT_EQ(query(other, {{"run", "luts"}, "", {}, false, "", false, 0}),
+            (Rows{{"a", ""}, {"b", ""}, {"c", "10"}}));
+}
+
+TEST_F(MetricsStoreTest, Queries) {
+  MetricsStore store(m_file);
+  store.Append({row("impl_1", "synth", 0.5, 100),
+                row("impl_2", "synth", -0.1, 120)});
+  store.Append({row("impl_1", "route", -0.3, 100)});
+  store.Append({row("impl_1", "route", 0.2, 90),
+                row("impl_3", "route", 0.1, 80)});
+
+  MetricsStore::Query where;
+  where.columns = {"run", "stage"};
+  where.where = "wns < 0 && run =~ impl_*";
+  EXPECT_EQ(query(store, where),
+            (Rows{{"impl_2", "synth"}, {"impl_1", "route"}}));
+  // Column names are case insensitive, values are not
+  where.where = "WNS < 0 && Run =~ impl_*";
+  EXPECT_EQ(query(store, where),
+            (Rows{{"impl_2", "synth"}, {"impl_1", "route"}}));
+
+  MetricsStore::Query latest;
+  latest.columns = {"run", "wns"};
+  latest.where = "stage == route";
+  latest.latest = true;
+  latest.orderBy = "wns";
+  latest.descending = true;
+  EXPECT_EQ(query(store, latest),
+            (Rows{{"impl_1", "0.2"}, {"impl_3", "0.1"}}));
+
+  MetricsStore::Query grouped;
+  grouped.columns = {"stage", "count()", "min(wns)", "avg(luts)", "sum(luts)",
+                     "last(run)"};
+  grouped.groupBy = {"stage"};
+  EXPECT_EQ(query(store, grouped),
+            (Rows{{"synth", "2", "-0.1", "110", "220", "impl_2"},
+                  {"route", "3", "-0.3", "90", "270", "impl_3"}}));
+
+  MetricsStore::Query total;
+  total.columns = {"count()", "max(wns)"};
+  total.limit = 1;
+  EXPECT_EQ(query(store, total), (Rows{{"5", "0.5"}}));
+  total.where = "luts > 1000";
+  EXPECT_EQ(query(store, total), (Rows{{"0", ""}}));
+
+  MetricsStore::Query bad;
+  bad.where = "slack < 0";
+  EXPECT_EQ(error(store, bad), "Unknown column slack");
+  bad = {};
+  bad.columns = {"run", "count()"};
+  EXPECT_EQ(error(store, bad), "run is neither grouped nor aggregated");
+  bad.columns = {"avg(run)"};
+  EXPECT_EQ(error(store, bad), "avg needs a numeric column: run");
+  bad.columns = {"median(wns)"};
+  EXPECT_EQ(error(store, bad), "Unknown function median");
+}
+
+TEST_F(MetricsStoreTest, Compact) {
+  MetricsStore store(m_file);
+  for (int i = 0; i < 20; i++) {
+    store.Append({row("run_" + std::to_string(i), "synth", i / 10.0, i)});
+  }
+  MetricsStore reader(m_file);
+  ASSERT_EQ(reader.Load(), 0);
+  EXPECT_EQ(reader.BlockCount(), 20u);
+  auto size = std::filesystem::file_size(m_file);
+
+  ASSERT_EQ(store.Compact(), 0);
+  EXPECT_EQ(store.BlockCount(), 1u);
+  EXPECT_LT(std::filesystem::file_size(m_file), size);
+  // The reader notices the file was rewritten
+  ASSERT_EQ(reader.Load(), 0);
+  EXPECT_EQ(reader.RowCount(), 20u);
+  EXPECT_EQ(reader.BlockCount(), 1u);
+  MetricsStore::Query sum;
+  sum.columns = {"sum(luts)"};
+  EXPECT_EQ(query(reader, sum), (Rows{{"190"}}));
+}
+
+TEST_F(MetricsStoreTest, PartialAndCorruptFiles) {
+  MetricsStore store(m_file);
+  store.Append({row("a", "synth", 1, 1)});
+  {
+    // A block still being written
+    std::ofstream out(m_file, std::ios::app | std::ios::binary);
+    out.write("MBLK\x10\0\0\0\x40\0\0\0", 12);
+  }
+  MetricsStore reader(m_file);
+  EXPECT_EQ(reader.Load(), 0);
+  EXPECT_EQ(reader.RowCount(), 1u);
+
+  // Its writer died, the next append follows the partial block
+  store.Append({row("b", "synth", 2, 2)});
+  EXPECT_EQ(store.RowCount(), 2u);
+  EXPECT_EQ(reader.Load(), 0);
+  EXPECT_EQ(reader.RowCount(), 2u);
+  MetricsStore fresh(m_file);
+  EXPECT_EQ(fresh.Load(), 0);
+  EXPECT_EQ(query(fresh, {{"run"}, "", {}, false, "", false, 0}),
+            (Rows{{"a"}, {"b"}}));
+
+  {
+    std::ofstream out(m_file, std::ios::trunc);
+    out << "not a metrics store";
+  }
+  EXPECT_EQ(reader.Load(), -1);
+}
+
+}  // namespace
+}  // namespace FOEDAG
@@ -0,0 +1,179 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/RuntimeHistory.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+using namespace FOEDAG;
+
+namespace {
+
+// Fields are tab separated, one run per line
+std::string field(std::string value) {
+  std::replace_if(
+      value.begin(), value.end(),
+      [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+  return value.empty() ? "-" : value;
+}
+
+std::string unfield(const std::string& value) {
+  return value == "-" ? std::string() : value;
+}
+
+bool parse(const std::string& line, RuntimeHistory::Run& run) {
+  std::vector<std::string> fields;
+  std::stringstream stream(line);
+  std::string value;
+  while (std::getline(stream, value, '\t')) fields.push_back(value);
+  if (fields.size() != 8) return false;
+  char* end = nullptr;
+  run.stage = unfield(fields[0]);
+  run.features.design = unfield(fields[1]);
+  run.features.device = unfield(fields[2]);
+  run.features.options = unfield(fields[3]);
+  run.features.files = std::strtoull(fields[4].c_str(), &end, 10);
+  run.features.bytes = std::strtoull(fields[5].c_str(), &end, 10);
+  run.seconds = std::strtod(fields[6].c_str(), &end);
+  if (*end != '\0' || run.seconds < 0) return false;
+  run.time = std::strtoll(fields[7].c_str(), &end, 10);
+  return !run.stage.empty();
+}
+
+double size(const RuntimeHistory::Features& features) {
+  return features.bytes ? double(features.bytes) : double(features.files);
+}
+
+}  // namespace
+
+int RuntimeHistory::Load() {
+  // Taken first, a run appended while reading is seen by the next Refresh
+  std::error_code ec;
+  uintmax_t loadedSize = std::filesystem::file_size(m_file, ec);
+  auto loadedTime = std::filesystem::last_write_time(m_file, ec);
+  std::ifstream in(m_file);
+  std::vector<Run> runs;
+  if (in.is_open()) {
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      Run run;
+      if (parse(line, run)) runs.push_back(run);
+    }
+    if (in.bad()) return -1;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_runs = std::move(runs);
+  m_loadedSize = ec ? 0 : loadedSize;
+  m_loadedTime = loadedTime;
+  return 0;
+}
+
+int RuntimeHistory::Refresh() {
+  std::error_code ec;
+  uintmax_t size = std::filesystem::file_size(m_file, ec);
+  auto time = std::filesystem::last_write_time(m_file, ec);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!ec && size == m_loadedSize && time == m_loadedTime) return 0;
+    if (ec && m_loadedSize == 0) return 0;
+  }
+  return Load();
+}
+
+int RuntimeHistory::Record(const std::string& stage, const Features& features,
+                           double seconds) {
+  Run run{stage, features, seconds, int64_t(std::time(nullptr))};
+  std::ostringstream line;
+  line << field(stage) << '\t' << field(features.design) << '\t'
+       << field(features.device) << '\t' << field(features.options) << '\t'
+       << features.files << '\t' << features.bytes << '\t' << seconds << '\t'
+       << run.time << '\n';
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_runs.push_back(run);
+  std::ofstream out(m_file, std::ios::app);
+  out << line.str();
+  out.flush();
+  return out.good() ? 0 : -1;
+}
+
+double RuntimeHistory::Predict(const std::string& stage,
+                               const Features& features) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // Same key, newest first with halving weights
+  double sum = 0;
+  double total = 0;
+  double weight = 1;
+  for (auto run = m_runs.rbegin(); run != m_runs.rend() && weight > 0.01;
+       ++run) {
+    if (run->stage != stage || run->features.design != features.design ||
+        run->features.device != features.device ||
+        run->features.options != features.options) {
+      continue;
+    }
+    sum += weight * run->seconds;
+    total += weight;
+    weight /= 2;
+  }
+  if (total > 0) return sum / total;
+
+  std::vector<const Run*> similar;
+  for (const auto& run : m_runs) {
+    if (run.stage == stage && run.features.device == features.device)
+      similar.push_back(&run);
+  }
+  if (similar.empty()) {
+    for (const auto& run : m_runs) {
+      if (run.stage == stage) similar.push_back(&run);
+    }
+  }
+  if (similar.empty()) return -1;
+
+  // Least squares fit of seconds = a + b * size
+  double n = similar.size();
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  std::set<double> sizes;
+  for (const Run* run : similar) {
+    double x = size(run->features);
+    sizes.insert(x);
+    sx += x;
+    sy += run->seconds;
+    sxx += x * x;
+    sxy += x * run->seconds;
+  }
+  double mean = sy / n;
+  if (sizes.size() < 2 || size(features) == 0) return mean;
+  double b = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+  // A runtime going down with the size is noise
+  if (b <= 0) return mean;
+  double a = (sy - b * sx) / n;
+  return std::max(0.0, a + b * size(features));
+}
+
+std::vector<RuntimeHistory::Run> RuntimeHistory::Runs() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_runs;
+}
@@ -0,0 +1,83 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef RUNTIME_HISTORY_H
+#define RUNTIME_HISTORY_H
+
+namespace FOEDAG {
+
+// Runtimes of past stage runs, appended to a tab separated file, used to
+// predict how long a stage will take. Several processes can record to the
+// same file, each run is written with a single append.
+class RuntimeHistory {
+ public:
+  struct Features {
+    std::string design;
+    std::string device;
+    std::string options;
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+  };
+  struct Run {
+    std::string stage;
+    Features features;
+    double seconds = 0;
+    // Seconds since the epoch
+    int64_t time = 0;
+  };
+
+  explicit RuntimeHistory(const std::string& file) : m_file(file) {}
+
+  // A missing file is an empty history. 0 on success, -1 on read error.
+  int Load();
+  // Loads again only if the file changed since the last Load
+  int Refresh();
+  // Appends the run, 0 on success, -1 if the file cannot be written
+  int Record(const std::string& stage, const Features& features,
+             double seconds);
+
+  // Expected seconds, -1 if the stage never ran. Runs with the same design,
+  // device and options predict best, the last ones weigh more. Otherwise the
+  // runtime is fitted against the design size (bytes, or files) over all the
+  // runs of the stage, on the same device if there are some.
+  double Predict(const std::string& stage, const Features& features) const;
+
+  std::vector<Run> Runs() const;
+  const std::string& File() const { return m_file; }
+
+ private:
+  std::string m_file;
+  std::vector<Run> m_runs;
+  // Of the file at the last Load
+  uintmax_t m_loadedSize{0};
+  std::filesystem::file_time_type m_loadedTime;
+  mutable std::mutex m_mutex;
+};
+
+}  // namespace FOEDAG
+
+#endif  // RUNTIME_HISTORY_H
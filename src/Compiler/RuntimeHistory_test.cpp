@@ -0,0 +1,125 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/RuntimeHistory.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include "Utils/TestDirectory.h"
+#include "gtest/gtest.h"
+
+namespace FOEDAG {
+namespace {
+
+class RuntimeHistoryTest : public TestDirectory {
+ protected:
+  std::string m_file{Path("runtimes")};
+};
+
+TEST_F(RuntimeHistoryTest, EmptyHistory) {
+  RuntimeHistory history(m_file);
+  EXPECT_EQ(history.Load(), 0);
+  EXPECT_EQ(history.Predict("synthesis", {"top", "", "", 3, 100}), -1);
+}
+
+TEST_F(RuntimeHistoryTest, SameKeyFavorsRecentRuns) {
+  RuntimeHistory history(m_file);
+  RuntimeHistory::Features features{"top", "dev1", "-O2", 3, 1000};
+  history.Record("synthesis", features, 10);
+  history.Record("synthesis", features, 20);
+  // (20 + 10 / 2) / 1.5
+  EXPECT_NEAR(history.Predict("synthesis", features), 16.67, 0.01);
+  EXPECT_EQ(history.Predict("routing", features), -1);
+
+  // Another process sees the same runs
+  RuntimeHistory other(m_file);
+  EXPECT_EQ(other.Load(), 0);
+  ASSERT_EQ(other.Runs().size(), 2u);
+  EXPECT_EQ(other.Runs()[1].features.options, "-O2");
+  EXPECT_EQ(other.Runs()[1].features.bytes, 1000u);
+  EXPECT_NEAR(other.Predict("synthesis", features), 16.67, 0.01);
+}
+
+TEST_F(RuntimeHistoryTest, RefreshReadsOnlyChangedFiles) {
+  RuntimeHistory history(m_file);
+  EXPECT_EQ(history.Refresh(), 0);
+  EXPECT_TRUE(history.Runs().empty());
+
+  RuntimeHistory other(m_file);
+  other.Record("synthesis", {"top", "dev1", "", 1, 100}, 10);
+  EXPECT_EQ(history.Refresh(), 0);
+  ASSERT_EQ(history.Runs().size(), 1u);
+
+  // Same size and time, not read again
+  auto time = std::filesystem::last_write_time(m_file);
+  std::string content;
+  {
+    std::ifstream in(m_file);
+    std::getline(in, content, '\0');
+  }
+  content.replace(content.find("\t10\t"), 4, "\t99\t");
+  {
+    std::ofstream out(m_file, std::ios::trunc);
+    out << content;
+  }
+  std::filesystem::last_write_time(m_file, time);
+  EXPECT_EQ(history.Refresh(), 0);
+  EXPECT_EQ(history.Runs()[0].seconds, 10);
+
+  std::filesystem::last_write_time(m_file, time + std::chrono::seconds(1));
+  EXPECT_EQ(history.Refresh(), 0);
+  EXPECT_EQ(history.Runs()[0].seconds, 99);
+}
+
+TEST_F(RuntimeHistoryTest, FitsOnDesignSize) {
+  RuntimeHistory history(m_file);
+  history.Record("synthesis", {"a", "dev1", "", 1, 1000}, 12);
+  history.Record("synthesis", {"b", "dev1", "", 2, 2000}, 22);
+  history.Record("synthesis", {"c", "dev2", "", 1, 1000}, 100);
+  // 2 + 0.01 * bytes on dev1
+  EXPECT_NEAR(history.Predict("synthesis", {"d", "dev1", "", 4, 4000}), 42,
+              0.01);
+  // Only one size on dev2
+  EXPECT_NEAR(history.Predict("synthesis", {"d", "dev2", "", 4, 4000}), 100,
+              0.01);
+  // Unknown device, all the runs
+  EXPECT_GT(history.Predict("synthesis", {"d", "dev3", "", 4, 4000}), 0);
+}
+
+TEST_F(RuntimeHistoryTest, SkipsMalformedLines) {
+  {
+    std::ofstream out(m_file);
+    out << "# comment\n"
+        << "synthesis\ttop\t-\t-\t1\t10\t5\t0\n"
+        << "garbage\n"
+        << "synthesis\ttop\t-\t-\t1\t10\tslow\t0\n";
+  }
+  RuntimeHistory history(m_file);
+  EXPECT_EQ(history.Load(), 0);
+  ASSERT_EQ(history.Runs().size(), 1u);
+  EXPECT_EQ(history.Runs()[0].features.device, "");
+  EXPECT_EQ(history.Predict("synthesis", {"top", "", "", 1, 10}), 5);
+}
+
+}  // namespace
+}  // namespace FOEDAG
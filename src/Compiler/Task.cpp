@@ -35,11 +35,39 @@ TaskStatus Task::status() const { return m_status; }
 
 void Task::setStatus(TaskStatus newStatus) {
   if (m_status != newStatus) {
+    if (newStatus == TaskStatus::InProgress) {
+      m_timer.start();
+    } else if (m_status == TaskStatus::InProgress) {
+      m_elapsed = m_timer.elapsed();
+    }
     m_status = newStatus;
+    m_progress = 0;
     emit statusChanged();
   }
 }
 
+int Task::progress() const { return m_progress; }
+
+void Task::setProgress(int newProgress) {
+  if (m_progress != newProgress) {
+    m_progress = newProgress;
+    emit statusChanged();
+  }
+}
+
+int Task::estimate() const { return m_estimate; }
+
+void Task::setEstimate(int seconds) {
+  if (m_estimate != seconds) {
+    m_estimate = seconds;
+    emit statusChanged();
+  }
+}
+
+qint64 Task::elapsed() const {
+  return m_status == TaskStatus::InProgress ? m_timer.elapsed() : m_elapsed;
+}
+
 void Task::trigger() { emit taskTriggered(); }
 
 }  // namespace FOEDAG
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
 
+#include <QElapsedTimer>
 #include <QObject>
 
 namespace FOEDAG {
@@ -42,6 +43,16 @@ class Task : public QObject {
   TaskStatus status() const;
   void setStatus(TaskStatus newStatus);
 
+  // Percent done while in progress
+  int progress() const;
+  void setProgress(int newProgress);
+
+  // Expected runtime in seconds, -1 if unknown
+  int estimate() const;
+  void setEstimate(int seconds);
+  // Milliseconds since the task started, or of the last run once done
+  qint64 elapsed() const;
+
   void trigger();
 
  signals:
@@ -51,6 +62,10 @@ class Task : public QObject {
  private:
   QString m_title;
   TaskStatus m_status{TaskStatus::None};
+  int m_progress{0};
+  int m_estimate{-1};
+  QElapsedTimer m_timer;
+  qint64 m_elapsed{0};
 };
 
 }  // namespace FOEDAG
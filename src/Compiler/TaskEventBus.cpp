@@ -0,0 +1,87 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/TaskEventBus.h"
+
+#include <algorithm>
+
+namespace FOEDAG {
+
+TaskEventBus::~TaskEventBus() { Drain(); }
+
+void TaskEventBus::PublishStatus(int task, int status) {
+  publish({task, status, -1, -1});
+}
+
+void TaskEventBus::PublishProgress(int task, int progress) {
+  publish({task, -1, progress, -1});
+}
+
+void TaskEventBus::PublishEstimate(int task, int seconds) {
+  publish({task, -1, -1, seconds});
+}
+
+void TaskEventBus::publish(const Event &event) {
+  // The node belongs to the consumer as soon as it is linked, only the old
+  // head tells whether the bus was empty
+  Node *head = m_head.load(std::memory_order_relaxed);
+  Node *node = new Node{event, head};
+  while (!m_head.compare_exchange_weak(head, node, std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+    node->next = head;
+  }
+  m_published++;
+  if (head == nullptr && m_notify) m_notify();
+}
+
+std::vector<TaskEventBus::Event> TaskEventBus::Drain() {
+  // The list is newest first, reverse it to apply the records in order
+  Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+  Node *ordered = nullptr;
+  while (node) {
+    Node *next = node->next;
+    node->next = ordered;
+    ordered = node;
+    node = next;
+  }
+  std::vector<Event> events;
+  while (ordered) {
+    const Event &event = ordered->event;
+    auto it = std::find_if(events.begin(), events.end(),
+                           [&](const Event &e) { return e.task == event.task; });
+    if (it == events.end()) {
+      events.push_back(event);
+    } else if (event.status != -1) {
+      it->status = event.status;
+      it->progress = -1;
+    } else if (event.progress != -1) {
+      it->progress = event.progress;
+    } else {
+      it->estimate = event.estimate;
+    }
+    Node *next = ordered->next;
+    delete ordered;
+    ordered = next;
+  }
+  return events;
+}
+
+}  // namespace FOEDAG
@@ -0,0 +1,86 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#ifndef TASK_EVENT_BUS_H
+#define TASK_EVENT_BUS_H
+
+namespace FOEDAG {
+
+// Status and progress of the tasks, published by the compile threads and
+// drained by the GUI thread. Publishing never blocks: records are pushed on
+// a lock-free list that the consumer takes whole. Drain() keeps only the
+// last status and progress of each task, so a burst of updates costs the
+// GUI one refresh.
+class TaskEventBus {
+ public:
+  // -1 in status, progress or estimate means "unchanged"
+  struct Event {
+    int task;
+    int status;
+    int progress;
+    // Expected runtime in seconds
+    int estimate;
+  };
+
+  TaskEventBus() = default;
+  ~TaskEventBus();
+  TaskEventBus(const TaskEventBus &) = delete;
+  TaskEventBus &operator=(const TaskEventBus &) = delete;
+
+  // Any thread
+  void PublishStatus(int task, int status);
+  // Percent
+  void PublishProgress(int task, int progress);
+  void PublishEstimate(int task, int seconds);
+
+  // Consumer thread only. One event per task, in order of first appearance.
+  // A status resets the progress published before it, not the estimate.
+  std::vector<Event> Drain();
+  bool Empty() const {
+    return m_head.load(std::memory_order_acquire) == nullptr;
+  }
+
+  // Called by the publishing thread when a record lands on an empty bus, at
+  // most once per Drain(). Set it before anything is published.
+  void SetNotify(const std::function<void()> &notify) { m_notify = notify; }
+
+  uint64_t Published() const { return m_published.load(); }
+
+ private:
+  struct Node {
+    Event event;
+    Node *next;
+  };
+  std::atomic<Node *> m_head{nullptr};
+  std::atomic<uint64_t> m_published{0};
+  std::function<void()> m_notify;
+
+  void publish(const Event &event);
+};
+
+}  // namespace FOEDAG
+
+#endif  // TASK_EVENT_BUS_H
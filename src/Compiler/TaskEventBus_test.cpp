@@ -0,0 +1,94 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Compiler/TaskEventBus.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace FOEDAG {
+namespace {
+
+TEST(TaskEventBus, Coalesces) {
+  TaskEventBus bus;
+  bus.PublishStatus(1, 1);
+  bus.PublishProgress(1, 10);
+  bus.PublishStatus(0, 1);
+  bus.PublishProgress(1, 20);
+  bus.PublishEstimate(1, 30);
+  bus.PublishStatus(1, 2);
+  bus.PublishProgress(0, 50);
+  auto events = bus.Drain();
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].task, 1);
+  EXPECT_EQ(events[0].status, 2);
+  EXPECT_EQ(events[0].progress, -1);
+  EXPECT_EQ(events[0].estimate, 30);
+  EXPECT_EQ(events[1].task, 0);
+  EXPECT_EQ(events[1].status, 1);
+  EXPECT_EQ(events[1].progress, 50);
+  EXPECT_EQ(events[1].estimate, -1);
+  EXPECT_TRUE(bus.Empty());
+  EXPECT_TRUE(bus.Drain().empty());
+}
+
+TEST(TaskEventBus, NotifiesOncePerDrain) {
+  TaskEventBus bus;
+  int notified = 0;
+  bus.SetNotify([&notified]() { notified++; });
+  bus.PublishProgress(0, 1);
+  bus.PublishProgress(0, 2);
+  bus.PublishStatus(1, 1);
+  EXPECT_EQ(notified, 1);
+  bus.Drain();
+  bus.PublishProgress(0, 3);
+  EXPECT_EQ(notified, 2);
+}
+
+TEST(TaskEventBus, ConcurrentPublishers) {
+  TaskEventBus bus;
+  constexpr int threads = 8;
+  constexpr int updates = 20000;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&bus, t]() {
+      for (int i = 1; i <= updates; i++) bus.PublishProgress(t, i);
+    });
+  }
+  std::vector<int> last(threads, 0);
+  auto apply = [&]() {
+    for (const auto &event : bus.Drain()) {
+      // Records of one task come out in publication order
+      EXPECT_GT(event.progress, last[event.task]);
+      last[event.task] = event.progress;
+    }
+  };
+  for (int i = 0; i < 100; i++) apply();
+  for (auto &worker : workers) worker.join();
+  apply();
+  EXPECT_EQ(bus.Published(), uint64_t(threads) * updates);
+  for (int t = 0; t < threads; t++) EXPECT_EQ(last[t], updates);
+}
+
+}  // namespace
+}  // namespace FOEDAG
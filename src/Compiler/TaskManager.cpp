@@ -31,4 +31,18 @@ TaskManager::~TaskManager() { qDeleteAll(m_tasks); }
 
 const QVector<Task *> &TaskManager::tasks() const { return m_tasks; }
 
+void TaskManager::setTaskStatus(int task, TaskStatus status) {
+  m_events.PublishStatus(task, static_cast<int>(status));
+}
+
+void TaskManager::setTaskProgress(int task, int percent) {
+  m_events.PublishProgress(task, percent);
+}
+
+void TaskManager::setTaskEstimate(int task, int seconds) {
+  m_events.PublishEstimate(task, seconds);
+}
+
+TaskEventBus &TaskManager::events() { return m_events; }
+
 }  // namespace FOEDAG
@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector>
 
 #include "Task.h"
+#include "TaskEventBus.h"
 
 namespace FOEDAG {
 
@@ -34,10 +35,18 @@ class TaskManager : public QObject {
   ~TaskManager();
   const QVector<Task *> &tasks() const;
 
+  // Thread safe, the update reaches the task (and the views) once the GUI
+  // thread drains the events
+  void setTaskStatus(int task, TaskStatus status);
+  void setTaskProgress(int task, int percent);
+  void setTaskEstimate(int task, int seconds);
+  TaskEventBus &events();
+
  signals:
 
  private:
   QVector<Task *> m_tasks;
+  TaskEventBus m_events;
 };
 
 }  // namespace FOEDAG
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "TaskModel.h"
 
+#include <algorithm>
 #include <QDebug>
 #include <QIcon>
 
@@ -29,14 +30,17 @@ namespace FOEDAG {
 
 TaskModel::TaskModel(TaskManager *tManager, QObject *parent)
     : QAbstractTableModel(parent) {
+  m_refreshTimer.setSingleShot(true);
+  m_refreshTimer.setInterval(REFRESH_MS);
+  connect(&m_refreshTimer, &QTimer::timeout, this, &TaskModel::refresh);
+  m_clockTimer.setInterval(1000);
+  connect(&m_clockTimer, &QTimer::timeout, this, &TaskModel::tick);
   setTaskManager(tManager);
 }
 
 void TaskModel::appendTask(Task *newTask) {
   beginInsertRows(QModelIndex(), 0, 0);
   endInsertRows();
-
-  connect(newTask, &Task::statusChanged, this, &TaskModel::taskStatusChanged);
 }
 
 int TaskModel::rowCount(const QModelIndex &parent) const {
@@ -50,6 +54,27 @@ int TaskModel::columnCount(const QModelIndex &parent) const {
 QVariant TaskModel::data(const QModelIndex &index, int role) const {
   if (role == Qt::DisplayRole && index.column() == TITLE_COL) {
     return m_taskManager->tasks().at(index.row())->title();
+  } else if (role == Qt::DisplayRole && index.column() == STATUS_COL) {
+    auto task = m_taskManager->tasks().at(index.row());
+    if (task->status() == TaskStatus::InProgress && task->progress() > 0)
+      return QString("%1%").arg(task->progress());
+  } else if (role == Qt::DisplayRole && index.column() == TIMING_COL) {
+    auto task = m_taskManager->tasks().at(index.row());
+    auto format = [](qint64 seconds) {
+      return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10,
+                                                    QChar('0'));
+    };
+    qint64 elapsed = task->elapsed() / 1000;
+    switch (task->status()) {
+      case TaskStatus::InProgress:
+        if (task->estimate() < 0) return format(elapsed);
+        return "ETA " + format(std::max<qint64>(task->estimate() - elapsed, 0));
+      case TaskStatus::Success:
+      case TaskStatus::Fail:
+        return format(elapsed);
+      default:
+        return QVariant();
+    }
   } else if (role == Qt::DecorationRole && index.column() == STATUS_COL) {
     switch (m_taskManager->tasks().at(index.row())->status()) {
       case TaskStatus::Success:
@@ -80,11 +105,45 @@ QVariant TaskModel::headerData(int section, Qt::Orientation orientation,
   return QAbstractTableModel::headerData(section, orientation, role);
 }
 
-void TaskModel::taskStatusChanged() {
-  if (auto task = dynamic_cast<Task *>(sender())) {
-    auto idx = createIndex(m_taskManager->tasks().indexOf(task), STATUS_COL);
-    emit dataChanged(idx, idx, {Qt::DisplayRole});
+// Called from the compile threads when the first event of a frame is
+// published
+void TaskModel::scheduleRefresh() {
+  if (!m_refreshTimer.isActive()) m_refreshTimer.start();
+}
+
+void TaskModel::refresh() {
+  if (!m_taskManager) return;
+  const auto &tasks = m_taskManager->tasks();
+  int first = tasks.count();
+  int last = -1;
+  for (const auto &event : m_taskManager->events().Drain()) {
+    if (event.task < 0 || event.task >= tasks.count()) continue;
+    Task *task = tasks.at(event.task);
+    if (event.status != -1)
+      task->setStatus(static_cast<TaskStatus>(event.status));
+    if (event.progress != -1) task->setProgress(event.progress);
+    if (event.estimate != -1) task->setEstimate(event.estimate);
+    first = std::min(first, event.task);
+    last = std::max(last, event.task);
+  }
+  if (last >= first) {
+    emit dataChanged(index(first, STATUS_COL), index(last, TIMING_COL),
+                     {Qt::DisplayRole, Qt::DecorationRole});
+  }
+  bool running = false;
+  for (auto task : tasks) {
+    if (task->status() == TaskStatus::InProgress) running = true;
   }
+  if (!running) {
+    m_clockTimer.stop();
+  } else if (!m_clockTimer.isActive()) {
+    m_clockTimer.start();
+  }
+}
+
+void TaskModel::tick() {
+  emit dataChanged(index(0, TIMING_COL), index(rowCount() - 1, TIMING_COL),
+                   {Qt::DisplayRole});
 }
 
 TaskManager *TaskModel::taskManager() const { return m_taskManager; }
@@ -92,6 +151,9 @@ TaskManager *TaskModel::taskManager() const { return m_taskManager; }
 void TaskModel::setTaskManager(TaskManager *newTaskManager) {
   if (!newTaskManager) return;
   m_taskManager = newTaskManager;
+  m_taskManager->events().SetNotify([this]() {
+    QMetaObject::invokeMethod(this, "scheduleRefresh", Qt::QueuedConnection);
+  });
   for (auto task : m_taskManager->tasks()) {
     appendTask(task);
   }
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <QAbstractTableModel>
+#include <QTimer>
 
 #include "Task.h"
 
@@ -48,13 +49,20 @@ class TaskModel : public QAbstractTableModel {
                int role = Qt::EditRole) override;
 
  private slots:
-  void taskStatusChanged();
+  void scheduleRefresh();
+  void refresh();
+  void tick();
 
  private:
   void appendTask(Task *newTask);
 
  private:
   TaskManager *m_taskManager{nullptr};
+  // Task events are applied at most once per frame
+  QTimer m_refreshTimer;
+  static constexpr int REFRESH_MS{33};
+  // Elapsed and remaining times of running tasks
+  QTimer m_clockTimer;
   static constexpr uint STATUS_COL{0};
   static constexpr uint TITLE_COL{1};
   static constexpr uint TIMING_COL{2};
@@ -21,35 +21,300 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Compiler/WorkerThread.h"
 
+#include <filesystem>
+#include <list>
+#include <map>
 #include <mutex>
 #include <thread>
 
+#include "Utils/CpuTopology.h"
+#include "Utils/ResourceGovernor.h"
+
 using namespace FOEDAG;
 
+namespace {
+// Synthesis keeps a few hundred bytes per source byte, on top of a fixed
+// footprint. Rough, it only has to keep the jobs of a machine from
+// swapping.
+uint64_t estimatedMemory(Compiler* compiler) {
+  uint64_t bytes = 256ull << 20;
+  Design* design = compiler->GetDesign();
+  if (!design) return bytes;
+  for (const auto& file : design->FileList()) {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(file.second, ec);
+    if (!ec) bytes += 200 * uint64_t(size);
+  }
+  return bytes;
+}
+
+std::mutex s_tasksMutex;
+std::map<int, WorkerThread*> s_tasks;
+// Threads in ThreadPool::Wait
+std::multiset<Tcl_ThreadId> s_waiters;
+
+// Only wakes the waiting thread, ThreadPool::Wait checks the tasks
+int taskEventProc(Tcl_Event* event, int flags) { return 1; }
+
+// Variables of ThreadPool::TraceDone
+struct DoneTrace {
+  Tcl_ThreadId thread;
+  Tcl_Interp* interp;
+  std::string varName;
+};
+// Never erased, the queued events point to them
+std::list<DoneTrace> s_doneTraces;
+
+struct DoneEvent {
+  Tcl_Event header;
+  const DoneTrace* trace;
+};
+
+int doneEventProc(Tcl_Event* event, int flags) {
+  const DoneTrace* trace = ((DoneEvent*)event)->trace;
+  Tcl_SetVar(trace->interp, trace->varName.c_str(), "1", TCL_GLOBAL_ONLY);
+  return 1;
+}
+
+// Tasks of the arguments from first on, every task without any
+bool parseTasks(Tcl_Interp* interp, int first, int argc, const char* argv[],
+                std::vector<WorkerThread*>& tasks) {
+  if (first == argc) {
+    tasks = ThreadPool::Tasks();
+    return true;
+  }
+  for (int i = first; i < argc; i++) {
+    int id = 0;
+    WorkerThread* task = nullptr;
+    if (Tcl_GetInt(interp, argv[i], &id) == TCL_OK) task = ThreadPool::Task(id);
+    if (!task) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp, "Unknown task ", argv[i], (char*)NULL);
+      return false;
+    }
+    tasks.push_back(task);
+  }
+  return true;
+}
+}  // namespace
+
 std::set<WorkerThread*> ThreadPool::threads;
 
 WorkerThread::WorkerThread(const std::string& threadName,
                            Compiler::Action action, Compiler* compiler)
     : m_threadName(threadName), m_action(action), m_compiler(compiler) {
-  ThreadPool::threads.insert(this);
+  m_id = ThreadPool::add(this);
+}
+
+const char* WorkerThread::StatusName(Status status) {
+  switch (status) {
+    case Status::Pending:
+      return "pending";
+    case Status::Queued:
+      return "queued";
+    case Status::Running:
+      return "running";
+    case Status::Success:
+      return "success";
+    case Status::Failed:
+      return "failed";
+    case Status::Stopped:
+      return "stopped";
+  }
+  return "";
+}
+
+void WorkerThread::setStatus(Status status) {
+  m_status = status;
+  if (isDone()) ThreadPool::notifyWaiters();
 }
 
 WorkerThread::~WorkerThread() {}
 
 bool WorkerThread::start() {
   bool result = true;
-  m_compiler->start();
+  m_compiler->start(m_action);
+  m_cancelled = false;
+  m_running = true;
+  setStatus(Status::Queued);
   m_thread = new std::thread([=] {
-    m_compiler->Compile(m_action);
-    m_compiler->finish();
+    // Waits for a CPU and memory, concurrent runs share the machine
+    ResourceGovernor::Reservation reservation =
+        ResourceGovernor::Instance().Acquire(
+            1, estimatedMemory(m_compiler),
+            [this]() -> bool { return m_cancelled; });
+    bool success = false;
+    if (reservation.Admitted()) {
+      setStatus(Status::Running);
+      // Pinned before the compile allocates, its memory is local to the node
+      CpuTopology& topology = CpuTopology::Instance();
+      int node = topology.PlaceThread();
+      if (node >= 0) {
+        for (const auto& placed : topology.Nodes()) {
+          if (placed.id != node) continue;
+          m_compiler->Out() << "Placement: " << m_threadName << " on NUMA node "
+                            << node << ", CPUs "
+                            << CpuTopology::FormatCpuList(placed.cpus)
+                            << std::endl;
+        }
+      }
+      success = m_compiler->Compile(m_action);
+      topology.Unplace(node);
+    }
+    m_compiler->finish(success);
+    m_running = false;
+    if (m_cancelled) {
+      setStatus(Status::Stopped);
+    } else {
+      setStatus(success ? Status::Success : Status::Failed);
+    }
   });
   return result;
 }
 
 bool WorkerThread::stop() {
+  m_cancelled = true;
   m_compiler->Stop();
   m_thread->join();
   delete m_thread;
   m_thread = nullptr;
   return true;
 }
+
+int ThreadPool::add(WorkerThread* task) {
+  std::lock_guard<std::mutex> lock(s_tasksMutex);
+  int id = s_tasks.empty() ? 1 : s_tasks.rbegin()->first + 1;
+  s_tasks[id] = task;
+  threads.insert(task);
+  return id;
+}
+
+bool ThreadPool::Busy() {
+  std::lock_guard<std::mutex> lock(s_tasksMutex);
+  for (WorkerThread* thread : threads) {
+    if (thread->isRunning()) return true;
+  }
+  return false;
+}
+
+std::set<WorkerThread*> ThreadPool::TakeThreads() {
+  std::lock_guard<std::mutex> lock(s_tasksMutex);
+  std::set<WorkerThread*> taken;
+  taken.swap(threads);
+  return taken;
+}
+
+void ThreadPool::TraceDone(Tcl_Interp* interp, const std::string& varName) {
+  std::lock_guard<std::mutex> lock(s_tasksMutex);
+  for (const DoneTrace& trace : s_doneTraces) {
+    if (trace.interp == interp && trace.varName == varName) return;
+  }
+  s_doneTraces.push_back({Tcl_GetCurrentThread(), interp, varName});
+}
+
+WorkerThread* ThreadPool::Task(int id) {
+  std::lock_guard<std::mutex> lock(s_tasksMutex);
+  auto it = s_tasks.find(id);
+  return it == s_tasks.end() ? nullptr : it->second;
+}
+
+std::vector<WorkerThread*> ThreadPool::Tasks() {
+  std::lock_guard<std::mutex> lock(s_tasksMutex);
+  std::vector<WorkerThread*> tasks;
+  for (const auto& [id, task] : s_tasks) tasks.push_back(task);
+  return tasks;
+}
+
+void ThreadPool::notifyWaiters() {
+  std::lock_guard<std::mutex> lock(s_tasksMutex);
+  for (Tcl_ThreadId waiter : s_waiters) {
+    Tcl_Event* event = (Tcl_Event*)ckalloc(sizeof(Tcl_Event));
+    event->proc = taskEventProc;
+    Tcl_ThreadQueueEvent(waiter, event, TCL_QUEUE_TAIL);
+    Tcl_ThreadAlert(waiter);
+  }
+  for (const DoneTrace& trace : s_doneTraces) {
+    DoneEvent* event = (DoneEvent*)ckalloc(sizeof(DoneEvent));
+    event->header.proc = doneEventProc;
+    event->trace = &trace;
+    Tcl_ThreadQueueEvent(trace.thread, (Tcl_Event*)event, TCL_QUEUE_TAIL);
+    Tcl_ThreadAlert(trace.thread);
+  }
+}
+
+bool ThreadPool::Wait(const std::vector<WorkerThread*>& tasks, int timeoutMs) {
+  auto done = [&tasks]() {
+    for (WorkerThread* task : tasks) {
+      if (!task->isDone()) return false;
+    }
+    return true;
+  };
+  Tcl_ThreadId self = Tcl_GetCurrentThread();
+  std::multiset<Tcl_ThreadId>::iterator waiter;
+  {
+    std::lock_guard<std::mutex> lock(s_tasksMutex);
+    waiter = s_waiters.insert(self);
+  }
+  bool timedOut = false;
+  Tcl_TimerToken timer = nullptr;
+  if (timeoutMs >= 0) {
+    timer = Tcl_CreateTimerHandler(
+        timeoutMs, [](ClientData data) { *(bool*)data = true; }, &timedOut);
+  }
+  // Registered before the check, a task finishing in between still wakes us
+  while (!done() && !timedOut) {
+    Tcl_DoOneEvent(TCL_ALL_EVENTS);
+  }
+  if (timer && !timedOut) Tcl_DeleteTimerHandler(timer);
+  {
+    std::lock_guard<std::mutex> lock(s_tasksMutex);
+    s_waiters.erase(waiter);
+  }
+  return done();
+}
+
+void ThreadPool::RegisterCommands(TclInterpreter* interp) {
+  auto wait_for_task = [](void* clientData, Tcl_Interp* interp, int argc,
+                          const char* argv[]) -> int {
+    int timeout = -1;
+    int first = 1;
+    if (argc > 1 && std::string(argv[1]) == "-timeout") {
+      if (argc < 3 || Tcl_GetInt(interp, argv[2], &timeout) != TCL_OK) {
+        Tcl_ResetResult(interp);
+        Tcl_AppendResult(interp,
+                         "Usage: wait_for_task ?-timeout <ms>? ?<task>...?",
+                         (char*)NULL);
+        return TCL_ERROR;
+      }
+      first = 3;
+    }
+    std::vector<WorkerThread*> tasks;
+    if (!parseTasks(interp, first, argc, argv, tasks)) return TCL_ERROR;
+    if (!Wait(tasks, timeout)) {
+      Tcl_AppendResult(interp, "wait_for_task timed out after ",
+                       std::to_string(timeout).c_str(), " ms", (char*)NULL);
+      return TCL_ERROR;
+    }
+    for (WorkerThread* task : tasks) {
+      Tcl_AppendElement(interp, WorkerThread::StatusName(task->GetStatus()));
+    }
+    return TCL_OK;
+  };
+  interp->registerCmd("wait_for_task", wait_for_task, 0, 0);
+
+  auto task_status = [](void* clientData, Tcl_Interp* interp, int argc,
+                        const char* argv[]) -> int {
+    std::vector<WorkerThread*> tasks;
+    if (!parseTasks(interp, 1, argc, argv, tasks)) return TCL_ERROR;
+    for (WorkerThread* task : tasks) {
+      std::string status = WorkerThread::StatusName(task->GetStatus());
+      // Without arguments {<id> <name> <status>} per task
+      if (argc == 1) {
+        status = std::to_string(task->Id()) + " " + task->Name() + " " + status;
+      }
+      Tcl_AppendElement(interp, status.c_str());
+    }
+    return TCL_OK;
+  };
+  interp->registerCmd("task_status", task_status, 0, 0);
+}
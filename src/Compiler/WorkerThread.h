@@ -19,6 +19,7 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <set>
@@ -39,25 +40,66 @@ namespace FOEDAG {
 
 class WorkerThread {
  public:
+  enum class Status { Pending, Queued, Running, Success, Failed, Stopped };
+
   WorkerThread(const std::string& threadName, Compiler::Action action,
                Compiler* compiler);
   ~WorkerThread();
 
   const std::string& Name() { return m_threadName; }
+  // Task id of wait_for_task and task_status, unique in the process
+  int Id() const { return m_id; }
+  Status GetStatus() const { return m_status; }
+  // Success, Failed or Stopped
+  bool isDone() const { return m_status >= Status::Success; }
+  static const char* StatusName(Status status);
 
   bool start();
   bool stop();
+  // From start() until the compile returned
+  bool isRunning() const { return m_running; }
 
  private:
   std::string m_threadName;
+  int m_id = 0;
   Compiler::Action m_action = Compiler::Action::NoAction;
   std::thread* m_thread = nullptr;
   Compiler* m_compiler = nullptr;
+  // Set by stop() while the job waits for the ResourceGovernor
+  std::atomic<bool> m_cancelled{false};
+  std::atomic<bool> m_running{false};
+  std::atomic<Status> m_status{Status::Pending};
+
+  void setStatus(Status status);
 };
 
 class ThreadPool {
  public:
+  // A started task has not returned from its compile yet
+  static bool Busy();
+  // The started tasks, forgotten by the pool
+  static std::set<WorkerThread*> TakeThreads();
+  // Every task created, nullptr for an unknown id
+  static WorkerThread* Task(int id);
+  static std::vector<WorkerThread*> Tasks();
+
+  // Serves the Tcl events of the calling thread until the tasks are done,
+  // woken by an event the workers post when they finish. false once
+  // timeoutMs (< 0 waits forever) elapsed first.
+  static bool Wait(const std::vector<WorkerThread*>& tasks, int timeoutMs);
+  // From now on every task finishing sets the global variable varName of
+  // interp, an event of the calling thread does it. Scripts vwait on it.
+  static void TraceDone(Tcl_Interp* interp, const std::string& varName);
+
+  // wait_for_task ?-timeout <ms>? ?<task>...?, task_status ?<task>...?
+  static void RegisterCommands(TclInterpreter* interp);
+
+ private:
+  friend class WorkerThread;
+  // Started tasks, locked with the task table
   static std::set<WorkerThread*> threads;
+  static int add(WorkerThread* task);
+  static void notifyWaiters();
 };
 
 }  // namespace FOEDAG
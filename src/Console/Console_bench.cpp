@@ -0,0 +1,69 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QTextEdit>
+#include <string>
+
+#include "Console/DummyParser.h"
+#include "Console/OutputFormatter.h"
+#include "Console/StreamBuffer.h"
+#include "benchmark/benchmark.h"
+
+namespace FOEDAG {
+namespace {
+// range(0) is the line length, every line emits ready()
+void BM_StreamBuffer(benchmark::State& state) {
+  StreamBuffer buffer;
+  int64_t lines = 0;
+  QObject::connect(&buffer, &StreamBuffer::ready,
+                   [&lines](const QString&) { lines++; });
+  const std::string line(state.range(0), 'x');
+  for (auto _ : state) {
+    buffer.getStream() << line << '\n';
+  }
+  state.SetBytesProcessed(state.iterations() * (state.range(0) + 1));
+  state.counters["lines"] = lines;
+}
+BENCHMARK(BM_StreamBuffer)->Arg(16)->Arg(128)->Arg(1024);
+
+// range(0) == 1 installs the console parser on top of the plain formatting
+void BM_OutputFormatterAppend(benchmark::State& state) {
+  QTextEdit textEdit;
+  OutputFormatter formatter;
+  formatter.setTextEdit(&textEdit);
+  if (state.range(0)) formatter.addParser(new DummyParser);
+  const QString line{"INFO: File: \"design.v\" just analyzed, 42 modules\n"};
+  int64_t appended = 0;
+  for (auto _ : state) {
+    formatter.appendMessage(line, OutputFormat::Output);
+    // Keeps the document size, and so the cost per line, bounded
+    if (++appended % 10000 == 0) {
+      state.PauseTiming();
+      textEdit.clear();
+      state.ResumeTiming();
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OutputFormatterAppend)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace FOEDAG
@@ -12,6 +12,7 @@
 #include "ConsoleDefines.h"
 #include "FileInfo.h"
 #include "StreamBuffer.h"
+#include "Utils/MemoryTracker.h"
 
 namespace FOEDAG {
 
@@ -30,6 +31,19 @@ TclConsoleWidget::TclConsoleWidget(TclInterp *interp,
   setTabAllowed(false);
   setMouseTracking(true);
   setObjectName(consoleObjectName());
+  MemoryTracker::Allocate(MemoryTracker::Console, 0);
+  connect(document(), &QTextDocument::contentsChanged, this,
+          &TclConsoleWidget::updateMemoryUsage);
+}
+
+TclConsoleWidget::~TclConsoleWidget() {
+  MemoryTracker::Release(MemoryTracker::Console, m_documentBytes);
+}
+
+void TclConsoleWidget::updateMemoryUsage() {
+  int64_t bytes = document()->characterCount() * int64_t(sizeof(QChar));
+  MemoryTracker::Allocate(MemoryTracker::Console, bytes - m_documentBytes, 0);
+  m_documentBytes = bytes;
 }
 
 bool TclConsoleWidget::isRunning() const {
@@ -24,6 +24,7 @@ class TclConsoleWidget : public QConsole {
   explicit TclConsoleWidget(TclInterp *interp,
                             std::unique_ptr<ConsoleInterface> iConsole,
                             StreamBuffer *buffer, QWidget *parent = nullptr);
+  ~TclConsoleWidget() override;
   bool isRunning() const override;
   QString getPrompt() const;
   StreamBuffer *getBuffer();
@@ -70,6 +71,8 @@ class TclConsoleWidget : public QConsole {
   bool handleCommandFromHistory(const QString &command,
                                 QString &commandFromHist);
 
+  void updateMemoryUsage();
+
   bool hasOpenBracket(const QString &str) const;
   bool hasCloseBracket(const QString &str) const;
 
@@ -81,6 +84,8 @@ class TclConsoleWidget : public QConsole {
   bool m_linkActivated{true};
   Qt::MouseButton m_mouseButtonPressed{Qt::NoButton};
   OutputFormatter m_formatter;
+  // Size of the document reported to the MemoryTracker
+  int64_t m_documentBytes{0};
 };
 
 }  // namespace FOEDAG
@@ -24,7 +24,7 @@ CreateRunsDialog::CreateRunsDialog(QWidget *parent)
 
 CreateRunsDialog::~CreateRunsDialog() { delete ui; }
 
-void CreateRunsDialog::InitDialog(int itype) {
+void CreateRunsDialog::InitDialog(int itype, TaskManager *taskManager) {
   QBoxLayout *box = new QBoxLayout(QBoxLayout::TopToBottom, ui->m_widgetForm);
   box->addWidget(m_createRunsForm);
   box->setContentsMargins(0, 0, 0, 1);
@@ -33,7 +33,7 @@ void CreateRunsDialog::InitDialog(int itype) {
 
   setWindowTitle(tr("Create New Runs"));
 
-  m_createRunsForm->InitForm(itype);
+  m_createRunsForm->InitForm(itype, taskManager);
 }
 
 QList<rundata> CreateRunsDialog::getRunDataList() {
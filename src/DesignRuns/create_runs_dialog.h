@@ -18,7 +18,7 @@ class CreateRunsDialog : public QDialog {
   explicit CreateRunsDialog(QWidget *parent = nullptr);
   ~CreateRunsDialog();
 
-  void InitDialog(int itype);
+  void InitDialog(int itype, TaskManager *taskManager = nullptr);
   QList<rundata> getRunDataList();
 
  private slots:
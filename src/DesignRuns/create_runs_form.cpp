@@ -11,7 +11,7 @@ CreateRunsForm::CreateRunsForm(QWidget *parent)
 
 CreateRunsForm::~CreateRunsForm() { delete ui; }
 
-void CreateRunsForm::InitForm(int itype) {
+void CreateRunsForm::InitForm(int itype, TaskManager *taskManager) {
   m_formType = itype;
   if (RT_SYNTH == m_formType) {
     ui->m_labelTitle->setText(tr("Configure Synthesis Runs"));
@@ -31,6 +31,8 @@ void CreateRunsForm::InitForm(int itype) {
                                   ui->m_groupBox);
   connect(m_widgetRunsGrid, SIGNAL(RowsChanged()), this,
           SLOT(SlotGridRowsChanged()));
+  m_widgetRunsGrid->BindMetrics({"status", "runtime", "peak_memory"});
+  m_widgetRunsGrid->WatchTasks(taskManager);
 
   QBoxLayout *box = new QBoxLayout(QBoxLayout::TopToBottom, ui->m_groupBox);
   box->addWidget(m_widgetRunsGrid);
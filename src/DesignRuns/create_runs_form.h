@@ -18,7 +18,7 @@ class CreateRunsForm : public QWidget {
   explicit CreateRunsForm(QWidget *parent = nullptr);
   ~CreateRunsForm();
 
-  void InitForm(int itype);
+  void InitForm(int itype, TaskManager *taskManager = nullptr);
   QList<rundata> getRunDataList();
 
  private slots:
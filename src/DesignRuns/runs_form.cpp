@@ -207,9 +207,13 @@ void RunsForm::UpdateDesignRunsTree() {
   m_treeRuns->expandAll();
 }
 
+void RunsForm::SetTaskManager(TaskManager *taskManager) {
+  m_taskManager = taskManager;
+}
+
 void RunsForm::CreateRuns(int type) {
   CreateRunsDialog *createRunsDlg = new CreateRunsDialog(this);
-  createRunsDlg->InitDialog(type);
+  createRunsDlg->InitDialog(type, m_taskManager);
   if (createRunsDlg->exec()) {
     QList<rundata> listRun = createRunsDlg->getRunDataList();
     if (listRun.size()) {
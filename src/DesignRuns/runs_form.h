@@ -14,10 +14,14 @@
 
 namespace FOEDAG {
 
+class TaskManager;
+
 class RunsForm : public QWidget {
   Q_OBJECT
  public:
   explicit RunsForm(QString strProPath, QWidget* parent = nullptr);
+  // The metrics of the new runs dialog follow its tasks
+  void SetTaskManager(TaskManager* taskManager);
 
  private slots:
   void SlotItempressed(QTreeWidgetItem* item, int column);
@@ -42,6 +46,7 @@ class RunsForm : public QWidget {
   QAction* m_actCreateImpleRuns;
 
   ProjectManager* m_projManager;
+  TaskManager* m_taskManager{nullptr};
 
   void CreateActions();
   void UpdateDesignRunsTree();
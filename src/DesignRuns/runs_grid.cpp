@@ -1,8 +1,13 @@
 #include "runs_grid.h"
 
+#include <QDir>
+#include <QMap>
 #include <QMouseEvent>
 #include <QVBoxLayout>
+#include <algorithm>
 
+#include "Compiler/MetricsStore.h"
+#include "Compiler/TaskManager.h"
 #include "runs_grid_delegate.h"
 
 using namespace FOEDAG;
@@ -45,6 +50,11 @@ RunsGrid::RunsGrid(RunsType type, QWidget *parent) : QWidget(parent) {
   m_tableViewRuns->setSelectionModel(m_selectModel);
   connect(m_selectModel, &QItemSelectionModel::selectionChanged, this,
           &RunsGrid::SlotTableViewSelectionChanged);
+  // A renamed run shows the metrics of its new name
+  connect(m_model, &QStandardItemModel::itemChanged, this,
+          [this](QStandardItem *item) {
+            if (item->column() == 0) RefreshMetrics();
+          });
 
   m_tableViewRuns->horizontalHeader()->setMinimumHeight(30);
 
@@ -148,9 +158,78 @@ void RunsGrid::SlotAddRuns() {
 
   m_model->insertRow(rows, items);
   m_runId++;
+  RefreshMetrics();
   emit RowsChanged();
 }
 
+void RunsGrid::BindMetrics(const QStringList &columns) {
+  m_metricsColumns = columns;
+  for (int i = 0; i < columns.count(); ++i) {
+    m_model->setHorizontalHeaderItem(METRICS_COL + i,
+                                     new QStandardItem(columns.at(i)));
+  }
+  RefreshMetrics();
+}
+
+void RunsGrid::WatchTasks(TaskManager *taskManager) {
+  if (!taskManager) return;
+  for (Task *task : taskManager->tasks()) {
+    connect(task, &Task::statusChanged, this, [this, task]() {
+      // The compiler records the metrics of a stage before it ends the task
+      if (task->status() != TaskStatus::InProgress) RefreshMetrics();
+    });
+  }
+}
+
+void RunsGrid::RefreshMetrics() {
+  if (m_metricsColumns.isEmpty()) return;
+  // Same store as the compiler records into
+  QString dir = m_projManager->getProjectPath();
+  if (dir.isEmpty()) dir = QDir::currentPath();
+  MetricsStore &store =
+      MetricsStore::Open(MetricsStore::DefaultFile(dir.toStdString()));
+
+  // One row per run, the last value of each metric. Metrics never recorded
+  // stay empty.
+  std::vector<std::string> known = store.Columns();
+  MetricsStore::Query query;
+  query.columns.push_back("run");
+  query.groupBy.push_back("run");
+  QMap<QString, int> resultColumn;
+  for (const auto &column : m_metricsColumns) {
+    std::string name = column.toLower().toStdString();
+    if (std::find(known.begin(), known.end(), name) == known.end()) continue;
+    resultColumn[column] = query.columns.size();
+    query.columns.push_back("last(" + name + ")");
+  }
+  std::vector<std::string> header;
+  std::vector<std::vector<MetricsStore::Value>> rows;
+  std::string error;
+  QMap<QString, int> resultRow;
+  if (std::find(known.begin(), known.end(), "run") != known.end() &&
+      store.Run(query, header, rows, error)) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+      resultRow[QString::fromStdString(rows[i][0].ToString())] = i;
+    }
+  }
+
+  for (int row = 0; row < m_model->rowCount(); ++row) {
+    auto result = resultRow.find(m_model->item(row, 0)->text());
+    for (int i = 0; i < m_metricsColumns.count(); ++i) {
+      QString text;
+      auto column = resultColumn.find(m_metricsColumns.at(i));
+      if (result != resultRow.end() && column != resultColumn.end()) {
+        text = QString::fromStdString(
+            rows[result.value()][column.value()].ToString());
+      }
+      QStandardItem *item = new QStandardItem(text);
+      item->setEditable(false);
+      item->setTextAlignment(Qt::AlignCenter);
+      m_model->setItem(row, METRICS_COL + i, item);
+    }
+  }
+}
+
 void RunsGrid::SlotDeleteRuns() {
   int curRow = m_selectModel->currentIndex().row();
   if (curRow < 0) return;
@@ -12,6 +12,8 @@
 
 namespace FOEDAG {
 
+class TaskManager;
+
 enum RunsType { RT_SYNTH, RT_IMPLE };
 
 typedef struct tagRunData {
@@ -31,6 +33,16 @@ class RunsGrid : public QWidget {
   explicit RunsGrid(RunsType type, QWidget *parent = nullptr);
 
   QList<rundata> getRunDataList();
+
+  // Read only columns after the run settings with the latest value of each
+  // metric recorded for the run (record_metrics, query_metrics)
+  void BindMetrics(const QStringList &columns);
+  // Refreshes the metrics each time a task of the manager ends
+  void WatchTasks(TaskManager *taskManager);
+
+ public slots:
+  void RefreshMetrics();
+
  signals:
   void RowsChanged();
 
@@ -47,6 +59,8 @@ class RunsGrid : public QWidget {
   QString m_strConstrSet;
   QString m_strDevice;
   QString m_strSynthName;
+  QStringList m_metricsColumns;
+  static constexpr int METRICS_COL{4};
 
   QToolBar *m_toolBar;
   QAction *m_actAdd;
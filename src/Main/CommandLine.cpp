@@ -21,6 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "CommandLine.h"
 
+#include <cstdlib>
+
 using namespace FOEDAG;
 
 void CommandLine::printHelp() {
@@ -32,6 +34,13 @@ void CommandLine::printHelp() {
   std::cout << "   --noqt:  Tcl only, no GUI" << std::endl;
   std::cout << "   --replay <script>: Replay GUI test" << std::endl;
   std::cout << "   --script <script>: Execute a Tcl script" << std::endl;
+  std::cout << "   --server:  Serve Tcl clients (foedag-client) on a Unix socket"
+            << std::endl;
+  std::cout << "   --socket <path>: Socket of --server" << std::endl;
+  std::cout << "   --worker <spool>: Run the launch_runs jobs of a spool"
+            << std::endl;
+  std::cout << "   --jobs <n>: Threads for compile jobs, defaults to the CPUs"
+            << std::endl;
   std::cout << "Tcl commands:" << std::endl;
   std::cout << "   help" << std::endl;
   std::cout << "   gui_start" << std::endl;
@@ -57,6 +66,17 @@ void CommandLine::processArgs() {
     } else if (token == "--cmd") {
       i++;
       m_runTclCmd = m_argv[i];
+    } else if (token == "--server") {
+      m_server = true;
+    } else if (token == "--socket") {
+      i++;
+      m_socket = m_argv[i];
+    } else if (token == "--worker") {
+      i++;
+      m_workerSpool = m_argv[i];
+    } else if (token == "--jobs") {
+      i++;
+      m_jobs = std::strtoul(m_argv[i], nullptr, 10);
     } else if (token == "--help") {
       printHelp();
       exit(0);
@@ -48,6 +48,17 @@ class CommandLine {
 
   const std::string& TclCmd() const { return m_runTclCmd; }
 
+  bool Server() const { return m_server; }
+
+  // Socket of the compile server, empty for the default one
+  const std::string& Socket() const { return m_socket; }
+
+  // Spool directory of --worker, empty when not a worker
+  const std::string& WorkerSpool() const { return m_workerSpool; }
+
+  // Threads of --jobs, 0 when not given
+  unsigned int Jobs() const { return m_jobs; }
+
   virtual void printHelp();
   virtual void processArgs();
 
@@ -63,6 +74,10 @@ class CommandLine {
   std::string m_runScript;
   std::string m_runGuiTest;
   std::string m_runTclCmd;
+  bool m_server = false;
+  std::string m_socket;
+  std::string m_workerSpool;
+  unsigned int m_jobs = 0;
 };
 
 }  // namespace FOEDAG
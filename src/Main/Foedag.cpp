@@ -34,6 +34,7 @@ extern "C" {
 }
 
 #include <QApplication>
+#include <QDir>
 #include <QGuiApplication>
 #include <QLabel>
 #include <QQmlApplicationEngine>
@@ -48,6 +49,7 @@ extern "C" {
 #include "Main/Foedag.h"
 #include "MainWindow/Session.h"
 #include "MainWindow/main_window.h"
+#include "NewProject/ProjectManager/config.h"
 #include "Tcl/TclInterpreter.h"
 #include "qttclnotifier.hpp"
 
@@ -59,6 +61,9 @@ bool Foedag::initGui() {
   // Gui mode with Qt Widgets
   int argc = m_cmdLine->Argc();
   QApplication app(argc, m_cmdLine->Argv());
+  // Parse the device catalog while the main window is built
+  FOEDAG::Config::Instance()->InitConfigAsync(QDir::currentPath() +
+                                              "/device.xml");
   FOEDAG::TclInterpreter* interpreter =
       new FOEDAG::TclInterpreter(m_cmdLine->Argv()[0]);
   FOEDAG::CommandStack* commands = new FOEDAG::CommandStack(interpreter);
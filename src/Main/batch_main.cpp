@@ -0,0 +1,112 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// foedag-batch: the Tcl shell of "foedag --noqt" without the Qt widgets.
+// Only the Tcl layer, the compiler flow, the project model and the device
+// database are linked in, no widget or QML library is loaded and
+// initialized, which keeps short farm jobs short.
+
+extern "C" {
+#include <tcl.h>
+}
+
+#include <iostream>
+#include <string>
+
+#include "Command/CommandStack.h"
+#include "Main/CommandLine.h"
+#include "Main/registerCoreCommands.h"
+#include "Server/CompileServer.h"
+#include "Server/JobSpool.h"
+#include "Tcl/TclInterpreter.h"
+#include "Utils/ResourceGovernor.h"
+
+namespace {
+
+struct BatchSession {
+  FOEDAG::CommandLine* cmdLine = nullptr;
+  FOEDAG::TclInterpreter* interp = nullptr;
+  FOEDAG::CommandStack* commands = nullptr;
+};
+
+BatchSession session;
+
+void registerBatchCommands(FOEDAG::TclInterpreter* interp) {
+  auto tcl_exit = [](void* clientData, Tcl_Interp* interp, int argc,
+                     const char* argv[]) -> int {
+    Tcl_Exit(0);
+    return 0;
+  };
+  interp->registerCmd("tcl_exit", tcl_exit, 0, 0);
+
+  auto help = [](void* clientData, Tcl_Interp* interp, int argc,
+                 const char* argv[]) -> int {
+    session.commands->CmdLogger()->log("help");
+    session.cmdLine->printHelp();
+    return 0;
+  };
+  interp->registerCmd("help", help, 0, 0);
+
+  FOEDAG::registerCoreCommands(interp, std::cout, true);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  session.cmdLine = new FOEDAG::CommandLine(argc, argv);
+  session.cmdLine->processArgs();
+  if (session.cmdLine->Jobs()) {
+    FOEDAG::ResourceGovernor::Instance().SetMaxThreads(
+        session.cmdLine->Jobs());
+  }
+  if (!session.cmdLine->GuiTestScript().empty()) {
+    std::cerr << "foedag-batch has no GUI, --replay is ignored" << std::endl;
+  }
+  // --server keeps this process warm for foedag-client
+  if (session.cmdLine->Server()) {
+    return FOEDAG::CompileServer::Serve(session.cmdLine);
+  }
+  // --worker runs the launch_runs jobs of a spool
+  if (!session.cmdLine->WorkerSpool().empty()) {
+    return FOEDAG::JobSpool::Work(session.cmdLine);
+  }
+
+  session.interp = new FOEDAG::TclInterpreter(argv[0]);
+  session.commands = new FOEDAG::CommandStack(session.interp);
+  registerBatchCommands(session.interp);
+
+  // Tcl_AppInit
+  auto tcl_init = [](Tcl_Interp* interp) -> int {
+    // --script <script>
+    if (!session.cmdLine->Script().empty()) {
+      Tcl_EvalFile(interp, session.cmdLine->Script().c_str());
+    }
+    // --cmd \"tcl cmd\"
+    if (!session.cmdLine->TclCmd().empty()) {
+      Tcl_EvalEx(interp, session.cmdLine->TclCmd().c_str(), -1, 0);
+    }
+    return 0;
+  };
+
+  // Start Loop
+  Tcl_MainEx(argc, argv, tcl_init, session.interp->getInterp());
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// foedag-client: runs a Tcl script in a foedag --server process.
+//   foedag-client [--socket <path>] [--script <file>] [--cmd <tcl>]
+// Without --script or --cmd the script is read from stdin. The output of
+// the script is printed as it comes, the exit status is the one of the
+// script. The script runs in the working directory of the server, not the
+// one of the client: relative paths are resolved from there, the client
+// directory is in $client_cwd.
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "Main/CommandLine.h"
+#include "Server/ServerProtocol.h"
+
+int main(int argc, char** argv) {
+  FOEDAG::CommandLine cmd(argc, argv);
+  cmd.processArgs();
+
+  std::string script;
+  if (!cmd.Script().empty()) {
+    std::ifstream file(cmd.Script());
+    if (!file) {
+      std::cerr << "Cannot read " << cmd.Script() << std::endl;
+      return 1;
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    script = content.str();
+  }
+  if (!cmd.TclCmd().empty()) {
+    script += "\n" + cmd.TclCmd();
+  }
+  if (cmd.Script().empty() && cmd.TclCmd().empty()) {
+    script.assign(std::istreambuf_iterator<char>(std::cin),
+                  std::istreambuf_iterator<char>());
+  }
+
+  std::string socket = cmd.Socket().empty()
+                           ? FOEDAG::ServerProtocol::DefaultSocket()
+                           : cmd.Socket();
+  FOEDAG::ServerClient client;
+  if (client.Connect(socket) != 0) {
+    std::cerr << "No foedag server on " << socket << std::endl;
+    return 1;
+  }
+  std::error_code ec;
+  client.SetWorkingDirectory(std::filesystem::current_path(ec).string());
+  std::string result;
+  int status = client.Eval(script, std::cout, std::cerr, result);
+  if (status < 0) {
+    std::cerr << "Connection to " << socket << " lost" << std::endl;
+    return 1;
+  }
+  if (status == 1 && !result.empty()) {
+    std::cerr << "Tcl Error: " << result << std::endl;
+  } else if (!result.empty()) {
+    std::cout << result << std::endl;
+  }
+  return status;
+}
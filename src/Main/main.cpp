@@ -23,6 +23,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Foedag.h"
 #include "MainWindow/Session.h"
 #include "MainWindow/main_window.h"
+#include "Server/CompileServer.h"
+#include "Server/JobSpool.h"
+#include "Utils/ResourceGovernor.h"
 
 QWidget* mainWindowBuilder(FOEDAG::CommandLine* cmd,
                            FOEDAG::TclInterpreter* interp) {
@@ -41,6 +44,14 @@ int main(int argc, char** argv) {
   Q_INIT_RESOURCE(compiler_resources);
   FOEDAG::CommandLine* cmd = new FOEDAG::CommandLine(argc, argv);
   cmd->processArgs();
+  if (cmd->Jobs()) {
+    FOEDAG::ResourceGovernor::Instance().SetMaxThreads(cmd->Jobs());
+  }
+
+  // --server: no GUI, Tcl clients are served until server_shutdown
+  if (cmd->Server()) return FOEDAG::CompileServer::Serve(cmd);
+  // --worker: no GUI, runs the jobs of a spool until stop_workers
+  if (!cmd->WorkerSpool().empty()) return FOEDAG::JobSpool::Work(cmd);
 
   FOEDAG::GUI_TYPE guiType = getGuiType(cmd->WithQt(), cmd->WithQml());
 
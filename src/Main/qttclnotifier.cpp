@@ -19,6 +19,7 @@
 
 #include "qttclnotifier.hpp"
 
+#include <QAbstractEventDispatcher>
 #include <QCoreApplication>
 
 using namespace QtTclNotify;
@@ -166,7 +167,16 @@ QtTclNotifier::QtTclNotifier() {
 // This could be helpful for multi-thread support, though. TBD
 void* QtTclNotifier::InitNotifier() { return 0; }
 void QtTclNotifier::FinalizeNotifier(ClientData) {}
-void QtTclNotifier::AlertNotifier(ClientData) {}
+
+// Tcl_ThreadAlert, another thread queued a Tcl event (a compile task
+// finished, see ThreadPool::Wait): wake the Qt loop blocked in WaitForEvent
+void QtTclNotifier::AlertNotifier(ClientData) {
+  QCoreApplication* app = QCoreApplication::instance();
+  if (!app) return;
+  QAbstractEventDispatcher* dispatcher =
+      QAbstractEventDispatcher::instance(app->thread());
+  if (dispatcher) dispatcher->wakeUp();
+}
 
 // Can't find any examples of how this should work.  Unix implementation is
 // empty
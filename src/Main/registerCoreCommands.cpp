@@ -0,0 +1,130 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Main/registerCoreCommands.h"
+
+extern "C" {
+#include <tcl.h>
+}
+
+#include <mutex>
+#include <string>
+
+#include "Compiler/Compiler.h"
+#include "Compiler/Design.h"
+#include "NewProject/ProjectManager/device_database.h"
+#include "Server/JobSpool.h"
+#include "Tcl/TclInterpreter.h"
+
+using namespace FOEDAG;
+
+namespace {
+
+struct CoreCommands {
+  Design* design;
+  Compiler* compiler;
+};
+
+void deleteCoreCommands(ClientData clientData, Tcl_Interp* interp) {
+  CoreCommands* commands = static_cast<CoreCommands*>(clientData);
+  delete commands->compiler;
+  delete commands->design;
+  delete commands;
+}
+
+}  // namespace
+
+void FOEDAG::registerDeviceCommands(TclInterpreter* interp) {
+  // get_devices [-file <device.xml>] [-filter <expr>]. The catalog stays
+  // open between calls on the same unchanged file, it is shared by all the
+  // interpreters.
+  auto get_devices = [](void* clientData, Tcl_Interp* interp, int argc,
+                        const char* argv[]) -> int {
+    static std::mutex mutex;
+    static DeviceDatabase database;
+    static std::string openedXml;
+    std::string deviceXml = "device.xml";
+    std::string filter;
+    for (int i = 1; i < argc; i++) {
+      std::string option = argv[i];
+      if (option == "-file" && i + 1 < argc) {
+        deviceXml = argv[++i];
+      } else if (option == "-filter" && i + 1 < argc) {
+        filter = argv[++i];
+      } else {
+        Tcl_AppendResult(interp,
+                         "Usage: get_devices [-file <device.xml>] "
+                         "[-filter <expr>]",
+                         (char*)NULL);
+        return TCL_ERROR;
+      }
+    }
+
+    DeviceDatabase::Filter conditions;
+    std::string error;
+    if (!DeviceDatabase::ParseFilter(filter, conditions, error)) {
+      Tcl_AppendResult(interp, error.c_str(), (char*)NULL);
+      return TCL_ERROR;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!database.IsOpen() || openedXml != deviceXml ||
+        !database.IsUpToDate(deviceXml)) {
+      openedXml.clear();
+      if (0 != database.Open(deviceXml)) {
+        Tcl_AppendResult(interp, "Cannot load ", deviceXml.c_str(),
+                         (char*)NULL);
+        return TCL_ERROR;
+      }
+      openedXml = deviceXml;
+    }
+    for (uint32_t device : database.Query(conditions)) {
+      Tcl_AppendElement(interp, std::string(database.Name(device)).c_str());
+    }
+    return TCL_OK;
+  };
+  interp->registerCmd("get_devices", get_devices, 0, 0);
+}
+
+void FOEDAG::registerCoreCommands(
+    TclInterpreter* interp, std::ostream& out, bool threaded,
+    const std::function<std::string()>& directory) {
+  // Used in "make test_install"
+  auto hello = [](void* clientData, Tcl_Interp* interp, int argc,
+                  const char* argv[]) -> int {
+    return Tcl_Eval(interp, "puts Hello!");
+  };
+  interp->registerCmd("hello", hello, 0, 0);
+
+  registerDeviceCommands(interp);
+  registerProjectCommands(interp);
+
+  // Same fake design as foedag, freed with the interpreter
+  std::string designName = "test_design";
+  CoreCommands* commands = new CoreCommands;
+  commands->design = new Design(designName);
+  commands->compiler = new Compiler(interp, commands->design, out);
+  if (directory) commands->compiler->ProjectDirectory(directory);
+  commands->compiler->RegisterCommands(interp, !threaded);
+  Tcl_CallWhenDeleted(interp->getInterp(), deleteCoreCommands, commands);
+
+  // launch_runs, report_jobs, stop_workers
+  JobSpool::RegisterCommands(interp);
+}
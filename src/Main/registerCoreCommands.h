@@ -0,0 +1,53 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <functional>
+#include <ostream>
+#include <string>
+
+#ifndef REGISTER_CORE_COMMANDS_H
+#define REGISTER_CORE_COMMANDS_H
+
+namespace FOEDAG {
+
+class TclInterpreter;
+
+// Commands built without Qt widgets: hello, get_devices, the project
+// commands, the compiler flow on a test design writing to out and the job
+// spool commands. foedag-batch, the compile server clients and the spool
+// jobs get them. threaded runs synthesis and placement on worker threads, as
+// in the foedag shell, otherwise the commands return once done. The
+// compiler keeps its files in directory, the current directory when not
+// given.
+void registerCoreCommands(
+    TclInterpreter* interp, std::ostream& out, bool threaded,
+    const std::function<std::string()>& directory = nullptr);
+
+// get_devices, also registered by the foedag GUI
+void registerDeviceCommands(TclInterpreter* interp);
+
+// create_project and generate_project on the project model, which only
+// needs Qt Core and Xml
+void registerProjectCommands(TclInterpreter* interp);
+
+}  // namespace FOEDAG
+
+#endif
@@ -0,0 +1,102 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Main/registerCoreCommands.h"
+
+extern "C" {
+#include <tcl.h>
+}
+
+#include <QDir>
+#include <QString>
+#include <string>
+
+#include "NewProject/ProjectManager/project_generator.h"
+#include "NewProject/ProjectManager/project_manager.h"
+#include "Tcl/TclInterpreter.h"
+
+namespace {
+
+// The runs and file sets of the current project are children of the manager
+// that created them, it lives as long as the project
+FOEDAG::ProjectManager* projectManager() {
+  static FOEDAG::ProjectManager* manager = new FOEDAG::ProjectManager();
+  return manager;
+}
+
+}  // namespace
+
+void FOEDAG::registerProjectCommands(TclInterpreter* interp) {
+  // create_project --file <project.xml>
+  auto create_project = [](void* clientData, Tcl_Interp* interp, int argc,
+                           const char* argv[]) -> int {
+    projectManager()->Tcl_CreateProject(argc, argv);
+    return TCL_OK;
+  };
+  interp->registerCmd("create_project", create_project, 0, 0);
+
+  // generate_project -path <dir> [-name <name>] [-files <n>] [-filesets <n>]
+  //                  [-runs <n>] [-devices <n>]
+  // Synthetic project for scalability tests, it becomes the current project
+  auto generate_project = [](void* clientData, Tcl_Interp* interp, int argc,
+                             const char* argv[]) -> int {
+    ProjectGenerator::Options options;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++) {
+      std::string option = argv[i];
+      if (i + 1 >= argc) {
+        ok = false;
+      } else if (option == "-path") {
+        options.path = QDir(argv[++i]).absolutePath();
+      } else if (option == "-name") {
+        options.name = argv[++i];
+      } else if (option == "-files") {
+        options.files = QString(argv[++i]).toInt(&ok);
+      } else if (option == "-filesets") {
+        options.filesets = QString(argv[++i]).toInt(&ok);
+      } else if (option == "-runs") {
+        options.runs = QString(argv[++i]).toInt(&ok);
+      } else if (option == "-devices") {
+        options.devices = QString(argv[++i]).toInt(&ok);
+      } else {
+        ok = false;
+      }
+    }
+    if (!ok || options.path.isEmpty()) {
+      Tcl_AppendResult(interp,
+                       "Usage: generate_project -path <dir> [-name <name>] "
+                       "[-files <n>] [-filesets <n>] [-runs <n>] "
+                       "[-devices <n>]",
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+
+    ProjectGenerator generator(projectManager());
+    if (0 != generator.Generate(options)) {
+      Tcl_AppendResult(interp, "Cannot generate the project in ",
+                       qPrintable(options.path), (char*)NULL);
+      return TCL_ERROR;
+    }
+    Tcl_AppendResult(interp, qPrintable(generator.ProjectFile()), (char*)NULL);
+    return TCL_OK;
+  };
+  interp->registerCmd("generate_project", generate_project, 0, 0);
+}
@@ -41,11 +41,16 @@ extern "C" {
 #include <vector>
 
 #include "Command/CommandStack.h"
+#include "Compiler/WorkerThread.h"
+#include "Console/TclConsoleWidget.h"
 #include "CommandLine.h"
 #include "Foedag.h"
 #include "MainWindow/Session.h"
 #include "MainWindow/main_window.h"
+#include "Main/registerCoreCommands.h"
 #include "NewProject/Main/registerNewProjectCommands.h"
+#include "NewProject/ProjectManager/project.h"
+#include "Server/JobSpool.h"
 #include "Tcl/TclInterpreter.h"
 #include "TextEditor/text_editor.h"
 #include "qttclnotifier.hpp"
@@ -104,6 +109,34 @@ void registerBasicGuiCommands(FOEDAG::Session* session) {
   session->TclInterp()->registerCmd("process_qt_events", process_qt_events, 0,
                                     0);
 
+  // --replay runs the next step of a test once this returns 0: no console
+  // command and no compile in progress. The harness drains the Qt events
+  // with update before. Once a console gets idle or a task finishes, the
+  // global variable test_idle is set: the harness vwaits on it.
+  auto test_busy = [](void* clientData, Tcl_Interp* interp, int argc,
+                      const char* argv[]) -> int {
+    FOEDAG::ThreadPool::TraceDone(interp, "test_idle");
+    bool busy = FOEDAG::ThreadPool::Busy();
+    for (QWidget* widget : QApplication::allWidgets()) {
+      auto console = qobject_cast<FOEDAG::TclConsoleWidget*>(widget);
+      if (!console) continue;
+      if (!console->property("test_idle").toBool()) {
+        console->setProperty("test_idle", true);
+        // Runs in the GUI thread, it owns the interpreter
+        QObject::connect(console, &FOEDAG::TclConsoleWidget::stateChanged,
+                         console, [interp](FOEDAG::State state) {
+                           if (state == FOEDAG::State::IDLE)
+                             Tcl_SetVar(interp, "test_idle", "1",
+                                        TCL_GLOBAL_ONLY);
+                         });
+      }
+      if (console->state() != FOEDAG::State::IDLE) busy = true;
+    }
+    Tcl_AppendResult(interp, busy ? "1" : "0", (char*)NULL);
+    return TCL_OK;
+  };
+  session->TclInterp()->registerCmd("test_busy", test_busy, 0, 0);
+
   auto qt_getWidget = [](void* clientData, Tcl_Interp* interp, int argc,
                          const char* argv[]) -> int {
     if (argc < 2) return TCL_ERROR;
@@ -227,8 +260,21 @@ void registerAllFoedagCommands(QWidget* widget, FOEDAG::Session* session) {
   FOEDAG::Design* design = new FOEDAG::Design(designName);
   FOEDAG::Compiler* compiler =
       new FOEDAG::Compiler(GlobalSession->TclInterp(), design, std::cout);
+  compiler->ProjectDirectory([]() {
+    return FOEDAG::Project::Instance()->projectPath().toStdString();
+  });
   compiler->RegisterCommands(GlobalSession->TclInterp(), false);
 
+  // Same get_devices as foedag-batch
+  FOEDAG::registerDeviceCommands(session->TclInterp());
+
+  // create_project, generate_project. The GUI replaces create_project with
+  // the wizard below.
+  FOEDAG::registerProjectCommands(session->TclInterp());
+
+  // launch_runs, report_jobs, stop_workers
+  FOEDAG::JobSpool::RegisterCommands(session->TclInterp());
+
   // GUI Mode
   if (widget) {
     // New Project Wizard
@@ -37,8 +37,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Main/Foedag.h"
 #include "NewFile/new_file.h"
 #include "NewProject/Main/registerNewProjectCommands.h"
+#include "NewProject/ProjectManager/project.h"
 #include "NewProject/new_project_dialog.h"
 #include "ProjNavigator/sources_form.h"
+#include "TextEditor/find_in_files_form.h"
 #include "TextEditor/text_editor.h"
 
 using namespace FOEDAG;
@@ -204,6 +206,30 @@ void MainWindow::ReShowWindow(QString strProject) {
 
   connect(sourForm, SIGNAL(OpenFile(QString)), textEditor,
           SLOT(SlotOpenFile(QString)));
+  textEditor->SetProjectFiles(
+      [sourForm]() {
+        QStringList hdlFiles;
+        QRegularExpression hdl("\\.(v|sv|svh|svi|vh|vhd|vhdl)$",
+                               QRegularExpression::CaseInsensitiveOption);
+        foreach (const QString& strFile, sourForm->ProjectFiles()) {
+          if (hdl.match(strFile).hasMatch()) hdlFiles.append(strFile);
+        }
+        return hdlFiles;
+      },
+      sourForm->ProjectCacheFile(".symbols"));
+  textEditor->UpdateSymbolIndex();
+  connect(sourForm, SIGNAL(ProjectFilesChanged()), textEditor,
+          SLOT(UpdateSymbolIndex()));
+
+  QDockWidget* findDockWidget = new QDockWidget(tr("Find in Files"), this);
+  findDockWidget->setObjectName("finddockwidget");
+  FindInFilesForm* findForm = new FindInFilesForm(this);
+  findForm->SetFileProvider([sourForm]() { return sourForm->ProjectFiles(); });
+  findForm->SetIndexFile(sourForm->ProjectCacheFile(".trigrams"));
+  findForm->RegisterCommands(GlobalSession);
+  findDockWidget->setWidget(findForm);
+  connect(findForm, SIGNAL(OpenFileAtLine(QString, int)), textEditor,
+          SLOT(SlotOpenFileAtLine(QString, int)));
   connect(textEditor, SIGNAL(CurrentFileChanged(QString)), sourForm,
           SLOT(SetCurrentFileItem(QString)));
 
@@ -238,10 +264,13 @@ void MainWindow::ReShowWindow(QString strProject) {
   FOEDAG::Compiler* com = new FOEDAG::Compiler{
       m_interpreter, new FOEDAG::Design(design), buffer->getStream(),
       new FOEDAG::CompilerNotifier{c}};
+  com->ProjectDirectory(
+      []() { return Project::Instance()->projectPath().toStdString(); });
   com->RegisterCommands(m_interpreter, false);
 
   addDockWidget(Qt::BottomDockWidgetArea, consoleDocWidget);
   tabifyDockWidget(consoleDocWidget, runDockWidget);
+  tabifyDockWidget(consoleDocWidget, findDockWidget);
 
   TaskManager* taskManager = new TaskManager;
   TaskModel* model = new TaskModel{taskManager};
@@ -252,6 +281,7 @@ void MainWindow::ReShowWindow(QString strProject) {
   tabifyDockWidget(sourceDockWidget, taskDocWidget);
 
   com->setTaskManager(taskManager);
+  runForm->SetTaskManager(taskManager);
 }
 
 void MainWindow::clearDockWidgets() {
@@ -1,144 +1,164 @@
 #include "config.h"
 
-#include <QDomDocument>
-#include <QFile>
-#include <QTextStream>
-
 using namespace FOEDAG;
 
 Q_GLOBAL_STATIC(Config, config)
 
 Config *Config::Instance() { return config(); }
 
-int Config::InitConfig(const QString &devicexml) {
-  int ret = 0;
-  if ("" != devicexml && devicexml == m_device_xml) {
-    return ret;
-  } else {
-    m_lsit_device_item.clear();
-    m_map_device.clear();
-    m_map_device_info.clear();
-    m_device_xml = devicexml;
+Config::~Config() {
+  if (m_loadThread.joinable()) {
+    m_loadThread.join();
   }
+}
 
-  QFile file(devicexml);
-  if (!file.open(QFile::ReadOnly)) {
-    return -1;
+int Config::InitConfig(const QString &devicexml) {
+  // Do not parse twice, wait for the background load instead
+  if (m_loadThread.joinable() && devicexml == m_loading_xml) {
+    ApplyPendingLoad(m_loadGeneration);
   }
+  // Reopened once the file changed
+  if ("" != devicexml && devicexml == m_device_xml &&
+      (!m_database->IsOpen() ||
+       m_database->IsUpToDate(devicexml.toStdString()))) {
+    return m_database->IsOpen() ? 0 : -1;
+  }
+  // A background load of another catalog is older than this one, it is
+  // dropped when it completes
+  m_generation++;
+  // Never reopen in place, the catalog may be in use on other threads
+  auto database = std::make_shared<DeviceDatabase>();
+  int result = database->Open(devicexml.toStdString());
+  m_database = database;
+  m_device_xml = devicexml;
+  return result;
+}
 
-  QDomDocument doc;
-  if (!doc.setContent(&file)) {
-    file.close();
-    return -2;
+void Config::InitConfigAsync(const QString &devicexml) {
+  if ((isLoading() && devicexml == m_loading_xml) || isLoaded(devicexml)) {
+    return;
+  }
+  if (m_loadThread.joinable()) {
+    // Another catalog is loading, it is superseded
+    m_generation++;
+    m_loadThread.join();
   }
-  file.close();
-
-  QDomElement docElement = doc.documentElement();
-  QDomNode node = docElement.firstChild();
-  if (!node.isNull() && node.isElement()) {
-    m_lsit_device_item.append("name");
-    m_lsit_device_item.append("pin_count");
-    m_lsit_device_item.append("speedgrade");
-    m_lsit_device_item.append("core_voltage");
-    QDomElement e = node.toElement();
-
-    QDomNodeList list = e.childNodes();
-    for (int i = 0; i < list.count(); i++) {
-      QDomNode n = list.at(i);
-      if (!n.isNull() && n.isElement()) {
-        m_lsit_device_item.append(n.toElement().attribute("type"));
-      }
+  m_loading_xml = devicexml;
+  std::string strXml = devicexml.toStdString();
+  quint64 generation = ++m_generation;
+  m_loadGeneration = generation;
+  m_loadThread = std::thread([this, strXml, generation]() {
+    auto database = std::make_shared<DeviceDatabase>();
+    int result = database->Open(strXml);
+    {
+      std::lock_guard<std::mutex> lock(m_pendingMutex);
+      m_pendingDatabase = database;
+      m_pendingResult = result;
     }
-    m_lsit_device_item.append("series");
-    m_lsit_device_item.append("family");
-    m_lsit_device_item.append("package");
+    QMetaObject::invokeMethod(this, "ApplyPendingLoad", Qt::QueuedConnection,
+                              Q_ARG(quint64, generation));
+  });
+}
+
+bool Config::isLoading() const { return m_loadThread.joinable(); }
+
+bool Config::isLoaded(const QString &devicexml) const {
+  return devicexml == m_device_xml && m_database->IsOpen() &&
+         m_database->IsUpToDate(devicexml.toStdString());
+}
+
+void Config::ApplyPendingLoad(quint64 generation) {
+  // Queued by a load that InitConfigAsync joined and replaced since, the
+  // thread is another load's, or applied already by a synchronous InitConfig
+  if (generation != m_loadGeneration || !m_loadThread.joinable()) {
+    return;
+  }
+  m_loadThread.join();
+
+  std::shared_ptr<DeviceDatabase> database;
+  int result = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    database = std::move(m_pendingDatabase);
+    result = m_pendingResult;
   }
+  QString devicexml = m_loading_xml;
+  m_loading_xml = "";
+  if (generation != m_generation) {
+    // InitConfig loaded a catalog meanwhile, keep it
+    emit loaded(m_database->IsOpen() ? 0 : -1);
+    return;
+  }
+  m_database = database;
+  m_device_xml = devicexml;
+  emit loaded(result);
+}
 
-  while (!node.isNull()) {
-    if (node.isElement()) {
-      QDomElement e = node.toElement();
-
-      QStringList devlist;
-      devlist.append(e.attribute("name"));
-      devlist.append(e.attribute("pin_count"));
-      devlist.append(e.attribute("speedgrade"));
-      devlist.append(e.attribute("core_voltage"));
-
-      QDomNodeList list = e.childNodes();
-      for (int i = 0; i < list.count(); i++) {
-        QDomNode n = list.at(i);
-        if (!n.isNull() && n.isElement()) {
-          devlist.append(n.toElement().attribute("num"));
-        }
-      }
-      QString series = e.attribute("series");
-      QString family = e.attribute("family");
-      QString package = e.attribute("package");
-      devlist.append(series);
-      devlist.append(family);
-      devlist.append(package);
-      m_map_device_info.insert(series + family + package, devlist);
-      MakeDeviceMap(series, family, package);
-    }
+QStringList Config::getDeviceItem() const {
+  QStringList listItem;
+  if (!m_database->IsOpen()) {
+    return listItem;
+  }
+  listItem << "name"
+           << "pin_count"
+           << "speedgrade"
+           << "core_voltage";
+  for (const auto &type : m_database->ResourceTypes()) {
+    listItem.append(QString::fromStdString(type));
+  }
+  listItem << "series"
+           << "family"
+           << "package";
+  return listItem;
+}
 
-    node = node.nextSibling();
+QStringList Config::getDeviceRow(uint32_t device) const {
+  auto toQString = [](std::string_view text) {
+    return QString::fromUtf8(text.data(), int(text.size()));
+  };
+  QStringList devlist;
+  devlist.append(toQString(m_database->Name(device)));
+  devlist.append(toQString(m_database->PinCount(device)));
+  devlist.append(toQString(m_database->SpeedGrade(device)));
+  devlist.append(toQString(m_database->CoreVoltage(device)));
+  for (uint32_t type = 0; type < m_database->ResourceTypes().size(); type++) {
+    devlist.append(toQString(m_database->Resource(device, type)));
   }
-  return ret;
+  devlist.append(toQString(m_database->Series(device)));
+  devlist.append(toQString(m_database->Family(device)));
+  devlist.append(toQString(m_database->Package(device)));
+  return devlist;
 }
 
-QStringList Config::getDeviceItem() const { return m_lsit_device_item; }
-
-void Config::MakeDeviceMap(QString series, QString family, QString package) {
-  QMap<QString, QStringList> mapfamily;
-  auto iter = m_map_device.find(series);
-  if (iter != m_map_device.end()) {
-    mapfamily = iter.value();
-    mapfamily[family].append(package);
-  } else {
-    QStringList listpkg;
-    listpkg.append(package);
-    mapfamily.insert(family, listpkg);
+static QStringList toQStringList(const std::vector<std::string> &list) {
+  QStringList result;
+  for (const auto &str : list) {
+    result.append(QString::fromStdString(str));
   }
-  m_map_device.insert(series, mapfamily);
+  return result;
 }
 
-QStringList Config::getSerieslist() const { return m_map_device.keys(); }
+QStringList Config::getSerieslist() const {
+  return toQStringList(m_database->SeriesList());
+}
 
 QStringList Config::getFamilylist(const QString &series) const {
-  QMap<QString, QStringList> mapfamily;
-  auto iter = m_map_device.find(series);
-  if (iter != m_map_device.end()) {
-    mapfamily = iter.value();
-  }
-  return mapfamily.keys();
+  return toQStringList(m_database->FamilyList(series.toStdString()));
 }
 
 QStringList Config::getPackagelist(const QString &series,
                                    const QString &family) const {
-  QMap<QString, QStringList> mapfamily;
-  auto iter = m_map_device.find(series);
-  if (iter != m_map_device.end()) {
-    mapfamily = iter.value();
-  }
-
-  QStringList listpkg;
-  auto iterf = mapfamily.find(family);
-  if (iterf != mapfamily.end()) {
-    listpkg = iterf.value();
-  }
-
-  return listpkg;
+  return toQStringList(
+      m_database->PackageList(series.toStdString(), family.toStdString()));
 }
 
 QList<QStringList> Config::getDevicelist(QString series, QString family,
                                          QString package) const {
   QList<QStringList> listdevice;
-  QString strkey = series + family + package;
-  QList<QString> listkey = m_map_device_info.keys();
-  for (int i = 0; i < listkey.size(); ++i) {
-    if (listkey.at(i).contains(strkey, Qt::CaseSensitive)) {
-      listdevice.append(m_map_device_info[listkey.at(i)]);
-    }
+  for (uint32_t device :
+       m_database->Query(series.toStdString(), family.toStdString(),
+                        package.toStdString())) {
+    listdevice.append(getDeviceRow(device));
   }
   return listdevice;
 }
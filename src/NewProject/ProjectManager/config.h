@@ -4,6 +4,11 @@
 #include <QMap>
 #include <QObject>
 #include <QSet>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "device_database.h"
 
 namespace FOEDAG {
 
@@ -12,8 +17,16 @@ class Config : public QObject {
 
  public:
   static Config *Instance();
+  ~Config();
 
   int InitConfig(const QString &devicexml);
+  // Loads the catalog on a worker thread, loaded() is emitted in the thread
+  // of the Config object once it is available. A later InitConfig or
+  // InitConfigAsync of another catalog wins over it.
+  void InitConfigAsync(const QString &devicexml);
+  bool isLoading() const;
+  bool isLoaded(const QString &devicexml) const;
+
   QStringList getDeviceItem() const;
   QStringList getSerieslist() const;
   QStringList getFamilylist(const QString &series) const;
@@ -21,14 +34,35 @@ class Config : public QObject {
                              const QString &family) const;
   QList<QStringList> getDevicelist(QString series = "", QString family = "",
                                    QString package = "") const;
+  // Same columns as getDeviceItem()
+  QStringList getDeviceRow(uint32_t device) const;
+
+  const DeviceDatabase &getDatabase() const { return *m_database; }
+  // Keeps the catalog alive for readers on other threads across a reload
+  std::shared_ptr<const DeviceDatabase> getSharedDatabase() const {
+    return m_database;
+  }
+
+ signals:
+  void loaded(int result);
 
  private:
   QString m_device_xml = "";
-  QStringList m_lsit_device_item;
-  QMap<QString, QMap<QString, QStringList>> m_map_device;
-  QMap<QString, QStringList> m_map_device_info;
+  std::shared_ptr<DeviceDatabase> m_database{new DeviceDatabase};
+
+  std::thread m_loadThread;
+  QString m_loading_xml = "";
+  // Filled by the worker thread, applied in the Config thread
+  std::mutex m_pendingMutex;
+  std::shared_ptr<DeviceDatabase> m_pendingDatabase;
+  int m_pendingResult{0};
+  // Bumped by every load, a background load behind it is dropped
+  quint64 m_generation{0};
+  // Generation of the load in m_loadThread
+  quint64 m_loadGeneration{0};
 
-  void MakeDeviceMap(QString series, QString family, QString package);
+ private slots:
+  void ApplyPendingLoad(quint64 generation);
 };
 }  // namespace FOEDAG
 #endif  // CONFIG_H
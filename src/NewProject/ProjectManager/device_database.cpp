@@ -0,0 +1,803 @@
+#include "device_database.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+#include "Utils/MemoryTracker.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace FOEDAG;
+
+#define DEVICE_DB_MAGIC "FDDEVDB"
+#define DEVICE_DB_VERSION 1
+
+struct DeviceDatabase::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t deviceCount;
+  uint32_t resourceTypeCount;
+  uint32_t stringsSize;
+  uint64_t xmlSize;
+  int64_t xmlTime;
+  // Offsets from the start of the index
+  uint32_t resourceTypesOffset;
+  uint32_t recordsOffset;
+  uint32_t resourcesOffset;
+  uint32_t stringsOffset;
+};
+
+// Strings are offsets in the string table, 0 is the empty string
+struct DeviceDatabase::Record {
+  uint32_t name;
+  uint32_t series;
+  uint32_t family;
+  uint32_t package;
+  uint32_t pinCount;
+  uint32_t speedGrade;
+  uint32_t coreVoltage;
+  float pinValue;
+  float speedValue;
+  float voltageValue;
+};
+
+namespace {
+
+struct XmlDevice {
+  std::unordered_map<std::string, std::string> attributes;
+  std::vector<std::pair<std::string, std::string>> resources;
+};
+
+std::string decodeEntities(std::string_view text) {
+  std::string result;
+  result.reserve(text.size());
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] != '&') {
+      result += text[i];
+      continue;
+    }
+    size_t end = text.find(';', i);
+    if (end == std::string_view::npos) {
+      result += text[i];
+      continue;
+    }
+    std::string_view entity = text.substr(i + 1, end - i - 1);
+    if (entity == "amp") {
+      result += '&';
+    } else if (entity == "lt") {
+      result += '<';
+    } else if (entity == "gt") {
+      result += '>';
+    } else if (entity == "quot") {
+      result += '"';
+    } else if (entity == "apos") {
+      result += '\'';
+    } else {
+      result.append(text.substr(i, end - i + 1));
+    }
+    i = end;
+  }
+  return result;
+}
+
+// Minimal streaming reader for the device list: <device attr...> elements
+// holding <resource type num/> elements. Returns false on malformed markup.
+template <typename OnDevice>
+bool parseDeviceXml(const char *data, size_t size, OnDevice onDevice) {
+  XmlDevice device;
+  bool inDevice = false;
+  size_t i = 0;
+  auto skipSpace = [&]() {
+    while (i < size && std::isspace(static_cast<unsigned char>(data[i]))) i++;
+  };
+  auto skipTo = [&](const char *marker) {
+    const char *found = std::search(data + i, data + size, marker,
+                                    marker + std::strlen(marker));
+    if (found == data + size) return false;
+    i = (found - data) + std::strlen(marker);
+    return true;
+  };
+
+  while (i < size) {
+    const char *open =
+        static_cast<const char *>(std::memchr(data + i, '<', size - i));
+    if (open == nullptr) break;
+    i = open - data + 1;
+    if (i >= size) return false;
+    if (data[i] == '?') {
+      if (!skipTo("?>")) return false;
+      continue;
+    }
+    if (data[i] == '!') {
+      if (!skipTo(std::strncmp(data + i, "!--", 3) == 0 ? "-->" : ">"))
+        return false;
+      continue;
+    }
+    bool closing = data[i] == '/';
+    if (closing) i++;
+    size_t nameStart = i;
+    while (i < size && !std::isspace(static_cast<unsigned char>(data[i])) &&
+           data[i] != '>' && data[i] != '/')
+      i++;
+    std::string_view name(data + nameStart, i - nameStart);
+
+    std::unordered_map<std::string, std::string> attributes;
+    bool selfClosing = false;
+    while (true) {
+      skipSpace();
+      if (i >= size) return false;
+      if (data[i] == '>') {
+        i++;
+        break;
+      }
+      if (data[i] == '/' && i + 1 < size && data[i + 1] == '>') {
+        selfClosing = true;
+        i += 2;
+        break;
+      }
+      size_t attrStart = i;
+      while (i < size && data[i] != '=' &&
+             !std::isspace(static_cast<unsigned char>(data[i])))
+        i++;
+      std::string attr(data + attrStart, i - attrStart);
+      skipSpace();
+      if (i >= size || data[i] != '=') return false;
+      i++;
+      skipSpace();
+      if (i >= size || (data[i] != '"' && data[i] != '\'')) return false;
+      char quote = data[i++];
+      size_t valueStart = i;
+      while (i < size && data[i] != quote) i++;
+      if (i >= size) return false;
+      attributes[attr] =
+          decodeEntities(std::string_view(data + valueStart, i - valueStart));
+      i++;
+    }
+
+    if (name == "device") {
+      if (closing) {
+        if (inDevice) onDevice(device);
+        inDevice = false;
+      } else {
+        device.attributes = std::move(attributes);
+        device.resources.clear();
+        inDevice = true;
+        if (selfClosing) {
+          onDevice(device);
+          inDevice = false;
+        }
+      }
+    } else if (name == "resource" && inDevice && !closing) {
+      device.resources.emplace_back(attributes["type"], attributes["num"]);
+    }
+  }
+  return !inDevice;
+}
+
+// Leading number of "1.1V", "-2", "484"
+float leadingNumber(std::string_view text) {
+  std::string value(text);
+  const char *begin = value.c_str();
+  while (*begin && !std::isdigit(static_cast<unsigned char>(*begin)) &&
+         *begin != '-' && *begin != '+' && *begin != '.')
+    begin++;
+  char *end = nullptr;
+  double number = std::strtod(begin, &end);
+  return end == begin ? NAN : static_cast<float>(number);
+}
+
+bool globMatch(const char *pattern, const char *text) {
+  const char *star = nullptr;
+  const char *retry = nullptr;
+  while (*text) {
+    if (*pattern == '?' || *pattern == *text) {
+      pattern++;
+      text++;
+    } else if (*pattern == '*') {
+      star = pattern++;
+      retry = text;
+    } else if (star) {
+      pattern = star + 1;
+      text = ++retry;
+    } else {
+      return false;
+    }
+  }
+  while (*pattern == '*') pattern++;
+  return *pattern == 0;
+}
+
+std::string toLower(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return text;
+}
+
+int64_t fileTime(const std::string &file) {
+  std::error_code ec;
+  auto time = std::filesystem::last_write_time(file, ec);
+  return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+}  // namespace
+
+DeviceDatabase::~DeviceDatabase() { Close(); }
+
+void DeviceDatabase::Close() {
+#if !defined(_WIN32)
+  if (m_mapping) munmap(m_mapping, m_size);
+#endif
+  m_mapping = nullptr;
+  m_buffer.clear();
+  m_data = nullptr;
+  m_size = 0;
+  m_header = nullptr;
+  m_records = nullptr;
+  m_resources = nullptr;
+  m_strings = nullptr;
+  m_fromCache = false;
+  m_resourceTypes.clear();
+  m_bySeries.clear();
+  m_byFamily.clear();
+  m_byPackage.clear();
+  m_byPinCount.clear();
+  if (m_trackedBytes) {
+    MemoryTracker::Release(MemoryTracker::DeviceDatabase, m_trackedBytes);
+    m_trackedBytes = 0;
+  }
+}
+
+int DeviceDatabase::Open(const std::string &deviceXml) {
+  Close();
+  std::error_code ec;
+  uint64_t xmlSize = std::filesystem::file_size(deviceXml, ec);
+  if (ec) return -1;
+  int64_t xmlTime = fileTime(deviceXml);
+
+  std::string indexFile = deviceXml + ".idx";
+  if (loadIndex(indexFile, xmlSize, xmlTime)) {
+    m_fromCache = true;
+    return 0;
+  }
+
+  std::vector<char> index;
+  if (!buildIndex(deviceXml, xmlSize, xmlTime, index)) return -2;
+
+  // Write then rename so a concurrent reader never maps a partial index. A
+  // read-only location only costs the cache.
+  std::string tmpFile = indexFile + ".tmp";
+  {
+    std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+    if (out.is_open()) out.write(index.data(), index.size());
+  }
+  std::filesystem::rename(tmpFile, indexFile, ec);
+  if (ec) std::filesystem::remove(tmpFile, ec);
+
+  m_buffer = std::move(index);
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+  if (!attach()) {
+    Close();
+    return -2;
+  }
+  return 0;
+}
+
+bool DeviceDatabase::IsUpToDate(const std::string &deviceXml) const {
+  if (m_header == nullptr) return false;
+  std::error_code ec;
+  uint64_t xmlSize = std::filesystem::file_size(deviceXml, ec);
+  return !ec && xmlSize == m_header->xmlSize &&
+         fileTime(deviceXml) == m_header->xmlTime;
+}
+
+bool DeviceDatabase::loadIndex(const std::string &indexFile, uint64_t xmlSize,
+                               int64_t xmlTime) {
+#if !defined(_WIN32)
+  int fd = ::open(indexFile.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    ::close(fd);
+    return false;
+  }
+  void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) return false;
+  m_mapping = mapping;
+  m_data = static_cast<const char *>(mapping);
+  m_size = st.st_size;
+#else
+  std::ifstream in(indexFile, std::ios::binary);
+  if (!in.is_open()) return false;
+  m_buffer.assign(std::istreambuf_iterator<char>(in),
+                  std::istreambuf_iterator<char>());
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+#endif
+  const Header *header = reinterpret_cast<const Header *>(m_data);
+  if (m_size < sizeof(Header) || header->xmlSize != xmlSize ||
+      header->xmlTime != xmlTime || !attach()) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool DeviceDatabase::buildIndex(const std::string &deviceXml, uint64_t xmlSize,
+                                int64_t xmlTime, std::vector<char> &index) {
+  std::ifstream in(deviceXml, std::ios::binary);
+  if (!in.is_open()) return false;
+  std::string content(xmlSize, '\0');
+  in.read(&content[0], xmlSize);
+  content.resize(in.gcount());
+
+  std::string strings(1, '\0');
+  std::unordered_map<std::string, uint32_t> interned{{std::string(), 0}};
+  auto intern = [&](const std::string &text) -> uint32_t {
+    auto itr = interned.find(text);
+    if (itr != interned.end()) return itr->second;
+    uint32_t offset = strings.size();
+    strings.append(text);
+    strings.push_back('\0');
+    interned.emplace(text, offset);
+    return offset;
+  };
+
+  std::vector<Record> records;
+  std::vector<uint32_t> resourceTypes;
+  std::unordered_map<std::string, uint32_t> typeIndex;
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> deviceResources;
+
+  auto attribute = [](const XmlDevice &device, const char *name) {
+    auto itr = device.attributes.find(name);
+    return itr == device.attributes.end() ? std::string() : itr->second;
+  };
+  bool ok = parseDeviceXml(
+      content.data(), content.size(), [&](const XmlDevice &device) {
+        Record record;
+        record.name = intern(attribute(device, "name"));
+        record.series = intern(attribute(device, "series"));
+        record.family = intern(attribute(device, "family"));
+        record.package = intern(attribute(device, "package"));
+        std::string pinCount = attribute(device, "pin_count");
+        std::string speedGrade = attribute(device, "speedgrade");
+        std::string coreVoltage = attribute(device, "core_voltage");
+        record.pinCount = intern(pinCount);
+        record.speedGrade = intern(speedGrade);
+        record.coreVoltage = intern(coreVoltage);
+        record.pinValue = leadingNumber(pinCount);
+        record.speedValue = leadingNumber(speedGrade);
+        record.voltageValue = leadingNumber(coreVoltage);
+        records.push_back(record);
+
+        std::vector<std::pair<uint32_t, uint32_t>> resources;
+        for (const auto &[type, num] : device.resources) {
+          auto itr = typeIndex.find(type);
+          if (itr == typeIndex.end()) {
+            itr = typeIndex.emplace(type, resourceTypes.size()).first;
+            resourceTypes.push_back(intern(type));
+          }
+          resources.emplace_back(itr->second, intern(num));
+        }
+        deviceResources.push_back(std::move(resources));
+      });
+  if (!ok) return false;
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, DEVICE_DB_MAGIC, sizeof(DEVICE_DB_MAGIC));
+  header.version = DEVICE_DB_VERSION;
+  header.deviceCount = records.size();
+  header.resourceTypeCount = resourceTypes.size();
+  header.stringsSize = strings.size();
+  header.xmlSize = xmlSize;
+  header.xmlTime = xmlTime;
+  header.resourceTypesOffset = sizeof(Header);
+  header.recordsOffset =
+      header.resourceTypesOffset + resourceTypes.size() * sizeof(uint32_t);
+  header.resourcesOffset =
+      header.recordsOffset + records.size() * sizeof(Record);
+  header.stringsOffset = header.resourcesOffset + records.size() *
+                                                      resourceTypes.size() *
+                                                      sizeof(uint32_t);
+
+  // Resources are a dense device x type matrix
+  std::vector<uint32_t> resources(records.size() * resourceTypes.size(), 0);
+  for (size_t device = 0; device < deviceResources.size(); device++) {
+    for (const auto &[type, num] : deviceResources[device]) {
+      resources[device * resourceTypes.size() + type] = num;
+    }
+  }
+
+  index.resize(header.stringsOffset + strings.size());
+  char *out = index.data();
+  std::memcpy(out, &header, sizeof(header));
+  std::memcpy(out + header.resourceTypesOffset, resourceTypes.data(),
+              resourceTypes.size() * sizeof(uint32_t));
+  std::memcpy(out + header.recordsOffset, records.data(),
+              records.size() * sizeof(Record));
+  std::memcpy(out + header.resourcesOffset, resources.data(),
+              resources.size() * sizeof(uint32_t));
+  std::memcpy(out + header.stringsOffset, strings.data(), strings.size());
+  return true;
+}
+
+bool DeviceDatabase::attach() {
+  if (m_size < sizeof(Header)) return false;
+  const Header *header = reinterpret_cast<const Header *>(m_data);
+  if (std::memcmp(header->magic, DEVICE_DB_MAGIC, sizeof(DEVICE_DB_MAGIC)) !=
+          0 ||
+      header->version != DEVICE_DB_VERSION) {
+    return false;
+  }
+  uint64_t resourcesSize = uint64_t(header->deviceCount) *
+                           header->resourceTypeCount * sizeof(uint32_t);
+  if (header->resourceTypesOffset +
+              uint64_t(header->resourceTypeCount) * sizeof(uint32_t) >
+          m_size ||
+      header->recordsOffset + uint64_t(header->deviceCount) * sizeof(Record) >
+          m_size ||
+      header->resourcesOffset + resourcesSize > m_size ||
+      header->stringsOffset + uint64_t(header->stringsSize) > m_size ||
+      header->stringsSize == 0) {
+    return false;
+  }
+  m_header = header;
+  m_records = reinterpret_cast<const Record *>(m_data + header->recordsOffset);
+  m_resources =
+      reinterpret_cast<const uint32_t *>(m_data + header->resourcesOffset);
+  m_strings = m_data + header->stringsOffset;
+  if (m_strings[header->stringsSize - 1] != '\0') return false;
+
+  const uint32_t *types =
+      reinterpret_cast<const uint32_t *>(m_data + header->resourceTypesOffset);
+  for (uint32_t i = 0; i < header->resourceTypeCount; i++) {
+    m_resourceTypes.emplace_back(str(types[i]));
+  }
+  buildLookups();
+  return true;
+}
+
+void DeviceDatabase::buildLookups() {
+  uint32_t count = DeviceCount();
+  m_byPinCount.resize(count);
+  for (uint32_t device = 0; device < count; device++) {
+    m_bySeries[Series(device)].push_back(device);
+    m_byFamily[Family(device)].push_back(device);
+    m_byPackage[Package(device)].push_back(device);
+    m_byPinCount[device] = device;
+  }
+  std::stable_sort(m_byPinCount.begin(), m_byPinCount.end(),
+                   [this](uint32_t a, uint32_t b) {
+                     return m_records[a].pinValue < m_records[b].pinValue;
+                   });
+  // The index (mapped or read) and the facet lookups
+  m_trackedBytes = m_size + int64_t(count) * 4 * sizeof(uint32_t);
+  MemoryTracker::Allocate(MemoryTracker::DeviceDatabase, m_trackedBytes);
+}
+
+std::string_view DeviceDatabase::str(uint32_t offset) const {
+  if (offset >= m_header->stringsSize) return std::string_view();
+  return std::string_view(m_strings + offset);
+}
+
+uint32_t DeviceDatabase::DeviceCount() const {
+  return m_header ? m_header->deviceCount : 0;
+}
+
+std::string_view DeviceDatabase::Name(uint32_t device) const {
+  return str(m_records[device].name);
+}
+
+std::string_view DeviceDatabase::Series(uint32_t device) const {
+  return str(m_records[device].series);
+}
+
+std::string_view DeviceDatabase::Family(uint32_t device) const {
+  return str(m_records[device].family);
+}
+
+std::string_view DeviceDatabase::Package(uint32_t device) const {
+  return str(m_records[device].package);
+}
+
+std::string_view DeviceDatabase::PinCount(uint32_t device) const {
+  return str(m_records[device].pinCount);
+}
+
+std::string_view DeviceDatabase::SpeedGrade(uint32_t device) const {
+  return str(m_records[device].speedGrade);
+}
+
+std::string_view DeviceDatabase::CoreVoltage(uint32_t device) const {
+  return str(m_records[device].coreVoltage);
+}
+
+std::string_view DeviceDatabase::Resource(uint32_t device,
+                                          uint32_t type) const {
+  return str(m_resources[device * m_header->resourceTypeCount + type]);
+}
+
+double DeviceDatabase::NumericValue(uint32_t device,
+                                    const std::string &field) const {
+  const Record &record = m_records[device];
+  if (field == "pin_count") return record.pinValue;
+  if (field == "speedgrade") return record.speedValue;
+  if (field == "core_voltage") return record.voltageValue;
+  for (uint32_t type = 0; type < m_resourceTypes.size(); type++) {
+    if (m_resourceTypes[type] == field) {
+      return leadingNumber(Resource(device, type));
+    }
+  }
+  return NAN;
+}
+
+std::vector<std::string> DeviceDatabase::SeriesList() const {
+  std::vector<std::string> list;
+  for (const auto &[series, devices] : m_bySeries) list.emplace_back(series);
+  std::sort(list.begin(), list.end());
+  return list;
+}
+
+std::vector<std::string> DeviceDatabase::FamilyList(
+    const std::string &series) const {
+  std::set<std::string_view> families;
+  auto itr = m_bySeries.find(series);
+  if (itr != m_bySeries.end()) {
+    for (uint32_t device : itr->second) families.insert(Family(device));
+  }
+  return std::vector<std::string>(families.begin(), families.end());
+}
+
+std::vector<std::string> DeviceDatabase::PackageList(
+    const std::string &series, const std::string &family) const {
+  std::set<std::string_view> packages;
+  auto itr = m_bySeries.find(series);
+  if (itr != m_bySeries.end()) {
+    for (uint32_t device : itr->second) {
+      if (Family(device) == family) packages.insert(Package(device));
+    }
+  }
+  return std::vector<std::string>(packages.begin(), packages.end());
+}
+
+std::vector<uint32_t> DeviceDatabase::Query(const std::string &series,
+                                            const std::string &family,
+                                            const std::string &package) const {
+  Filter filter;
+  if (!series.empty()) filter.push_back({"series", "==", series});
+  if (!family.empty()) filter.push_back({"family", "==", family});
+  if (!package.empty()) filter.push_back({"package", "==", package});
+  return Query(filter);
+}
+
+const std::vector<uint32_t> *DeviceDatabase::facet(const std::string &field,
+                                                   const std::string &value,
+                                                   bool &known) const {
+  const std::unordered_map<std::string_view, std::vector<uint32_t>> *map =
+      nullptr;
+  if (field == "series") {
+    map = &m_bySeries;
+  } else if (field == "family") {
+    map = &m_byFamily;
+  } else if (field == "package") {
+    map = &m_byPackage;
+  }
+  known = map != nullptr;
+  if (map == nullptr) return nullptr;
+  auto itr = map->find(value);
+  return itr == map->end() ? nullptr : &itr->second;
+}
+
+std::vector<uint32_t> DeviceDatabase::Query(const Filter &filter) const {
+  std::vector<uint32_t> result;
+  if (!IsOpen()) return result;
+
+  // Start from the smallest facet, else from the pin count range, else scan
+  const std::vector<uint32_t> *candidates = nullptr;
+  for (const auto &condition : filter) {
+    if (condition.op != "==") continue;
+    bool known = false;
+    const std::vector<uint32_t> *devices =
+        facet(condition.field, condition.value, known);
+    if (!known) continue;
+    if (devices == nullptr) return result;
+    if (candidates == nullptr || devices->size() < candidates->size()) {
+      candidates = devices;
+    }
+  }
+
+  std::vector<uint32_t> range;
+  if (candidates == nullptr) {
+    float low = -INFINITY;
+    float high = INFINITY;
+    bool ranged = false;
+    for (const auto &condition : filter) {
+      if (condition.field != "pin_count") continue;
+      float value = leadingNumber(condition.value);
+      if (std::isnan(value)) continue;
+      if (condition.op == ">=" || condition.op == ">" || condition.op == "==") {
+        low = std::max(low, value);
+        ranged = true;
+      }
+      if (condition.op == "<=" || condition.op == "<" || condition.op == "==") {
+        high = std::min(high, value);
+        ranged = true;
+      }
+    }
+    if (ranged) {
+      auto first = std::lower_bound(
+          m_byPinCount.begin(), m_byPinCount.end(), low,
+          [this](uint32_t d, float v) { return m_records[d].pinValue < v; });
+      auto last = std::upper_bound(
+          first, m_byPinCount.end(), high,
+          [this](float v, uint32_t d) { return v < m_records[d].pinValue; });
+      range.assign(first, last);
+      std::sort(range.begin(), range.end());
+      candidates = &range;
+    }
+  }
+
+  auto accept = [&](uint32_t device) {
+    for (const auto &condition : filter) {
+      if (!match(device, condition)) return false;
+    }
+    return true;
+  };
+  if (candidates) {
+    for (uint32_t device : *candidates) {
+      if (accept(device)) result.push_back(device);
+    }
+  } else {
+    for (uint32_t device = 0; device < DeviceCount(); device++) {
+      if (accept(device)) result.push_back(device);
+    }
+  }
+  return result;
+}
+
+bool DeviceDatabase::match(uint32_t device, const Condition &condition) const {
+  const std::string &field = condition.field;
+  const std::string &op = condition.op;
+  std::string_view text;
+  bool numeric = true;
+  if (field == "name") {
+    text = Name(device);
+    numeric = false;
+  } else if (field == "series") {
+    text = Series(device);
+    numeric = false;
+  } else if (field == "family") {
+    text = Family(device);
+    numeric = false;
+  } else if (field == "package") {
+    text = Package(device);
+    numeric = false;
+  } else if (field == "pin_count") {
+    text = PinCount(device);
+  } else if (field == "speedgrade") {
+    text = SpeedGrade(device);
+  } else if (field == "core_voltage") {
+    text = CoreVoltage(device);
+  } else {
+    auto itr =
+        std::find(m_resourceTypes.begin(), m_resourceTypes.end(), field);
+    if (itr == m_resourceTypes.end()) return false;
+    text = Resource(device, itr - m_resourceTypes.begin());
+  }
+
+  if (op == "=~") {
+    return globMatch(condition.value.c_str(), std::string(text).c_str());
+  }
+  if (numeric) {
+    double lhs = NumericValue(device, field);
+    double rhs = leadingNumber(condition.value);
+    if (!std::isnan(lhs) && !std::isnan(rhs)) {
+      if (op == "==") return lhs == rhs;
+      if (op == "!=") return lhs != rhs;
+      if (op == "<") return lhs < rhs;
+      if (op == "<=") return lhs <= rhs;
+      if (op == ">") return lhs > rhs;
+      if (op == ">=") return lhs >= rhs;
+      return false;
+    }
+  }
+  int cmp = text.compare(condition.value);
+  if (op == "==") return cmp == 0;
+  if (op == "!=") return cmp != 0;
+  if (op == "<") return cmp < 0;
+  if (op == "<=") return cmp <= 0;
+  if (op == ">") return cmp > 0;
+  if (op == ">=") return cmp >= 0;
+  return false;
+}
+
+bool DeviceDatabase::Sort(std::vector<uint32_t> &devices,
+                          const std::vector<SortKey> &keys,
+                          const std::function<bool()> &cancelled) const {
+  // Extract the sort values once, the comparator only touches these arrays
+  struct Column {
+    bool numeric = true;
+    bool ascending = true;
+    std::vector<double> values;
+    std::vector<std::string_view> texts;
+  };
+  std::vector<Column> columns(keys.size());
+  for (size_t k = 0; k < keys.size(); k++) {
+    const std::string &field = keys[k].field;
+    Column &column = columns[k];
+    column.ascending = keys[k].ascending;
+    column.numeric = field != "name" && field != "series" &&
+                     field != "family" && field != "package";
+    if (column.numeric) {
+      column.values.resize(devices.size());
+    } else {
+      column.texts.resize(devices.size());
+    }
+    for (size_t i = 0; i < devices.size(); i++) {
+      if ((i & 4095) == 0 && cancelled && cancelled()) return false;
+      uint32_t device = devices[i];
+      if (column.numeric) {
+        column.values[i] = NumericValue(device, field);
+      } else if (field == "name") {
+        column.texts[i] = Name(device);
+      } else if (field == "series") {
+        column.texts[i] = Series(device);
+      } else if (field == "family") {
+        column.texts[i] = Family(device);
+      } else {
+        column.texts[i] = Package(device);
+      }
+    }
+  }
+
+  std::vector<uint32_t> order(devices.size());
+  for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    for (const Column &column : columns) {
+      int cmp = 0;
+      if (column.numeric) {
+        double lhs = column.values[a];
+        double rhs = column.values[b];
+        // Missing values always last
+        if (std::isnan(lhs) || std::isnan(rhs)) {
+          if (std::isnan(lhs) != std::isnan(rhs)) return std::isnan(rhs);
+          continue;
+        }
+        cmp = lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+      } else {
+        cmp = column.texts[a].compare(column.texts[b]);
+      }
+      if (cmp != 0) return column.ascending ? cmp < 0 : cmp > 0;
+    }
+    return false;
+  });
+  if (cancelled && cancelled()) return false;
+
+  std::vector<uint32_t> sorted(devices.size());
+  for (size_t i = 0; i < order.size(); i++) sorted[i] = devices[order[i]];
+  devices.swap(sorted);
+  return true;
+}
+
+bool DeviceDatabase::ParseFilter(const std::string &expr, Filter &filter,
+                                 std::string &error) {
+  if (!FilterParser::Parse(expr, filter, error)) return false;
+  for (Condition &condition : filter) {
+    condition.field = toLower(condition.field);
+  }
+  return true;
+}
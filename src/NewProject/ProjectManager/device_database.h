@@ -0,0 +1,126 @@
+#ifndef DEVICE_DATABASE_H
+#define DEVICE_DATABASE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Utils/FilterParser.h"
+
+namespace FOEDAG {
+
+// Device catalog read from device.xml. The XML is parsed once (streamed, no
+// DOM) into a compact binary index written next to it as <device.xml>.idx.
+// Later opens map the index directly as long as the XML did not change.
+// Facets (series, family, package) are hashed, numeric attributes can be
+// filtered by range.
+class DeviceDatabase {
+ public:
+  // One term of a filter, see FilterParser. Fields are name, series, family,
+  // package, pin_count, speedgrade, core_voltage or a resource type.
+  using Condition = FilterCondition;
+  using Filter = std::vector<Condition>;
+  // Same fields as Condition, numeric fields sort by value
+  struct SortKey {
+    std::string field;
+    bool ascending = true;
+  };
+
+  DeviceDatabase() = default;
+  ~DeviceDatabase();
+  DeviceDatabase(const DeviceDatabase &) = delete;
+  DeviceDatabase &operator=(const DeviceDatabase &) = delete;
+
+  // 0 on success, -1 the file cannot be read, -2 malformed XML
+  int Open(const std::string &deviceXml);
+  void Close();
+  bool IsOpen() const { return m_data != nullptr; }
+  // True if the last Open used the cached index
+  bool FromCache() const { return m_fromCache; }
+  // False once deviceXml differs in size or modification time from the file
+  // the catalog was built from, it has to be opened again
+  bool IsUpToDate(const std::string &deviceXml) const;
+
+  uint32_t DeviceCount() const;
+  const std::vector<std::string> &ResourceTypes() const {
+    return m_resourceTypes;
+  }
+
+  std::string_view Name(uint32_t device) const;
+  std::string_view Series(uint32_t device) const;
+  std::string_view Family(uint32_t device) const;
+  std::string_view Package(uint32_t device) const;
+  // As written in the XML
+  std::string_view PinCount(uint32_t device) const;
+  std::string_view SpeedGrade(uint32_t device) const;
+  std::string_view CoreVoltage(uint32_t device) const;
+  std::string_view Resource(uint32_t device, uint32_t type) const;
+  // Numeric value used for range queries and sorting
+  double NumericValue(uint32_t device, const std::string &field) const;
+
+  // Sorted, unique
+  std::vector<std::string> SeriesList() const;
+  std::vector<std::string> FamilyList(const std::string &series) const;
+  std::vector<std::string> PackageList(const std::string &series,
+                                       const std::string &family) const;
+
+  // Devices matching all conditions, in catalog order. Empty facet strings
+  // match everything.
+  std::vector<uint32_t> Query(const std::string &series,
+                              const std::string &family,
+                              const std::string &package) const;
+  std::vector<uint32_t> Query(const Filter &filter) const;
+
+  // Stable sort on the keys, first key first. Returns false, leaving devices
+  // unspecified, as soon as cancelled() is true.
+  bool Sort(std::vector<uint32_t> &devices, const std::vector<SortKey> &keys,
+            const std::function<bool()> &cancelled = nullptr) const;
+
+  // "pin_count >= 400 && family == f1", fields are case insensitive. False
+  // and error set on bad syntax.
+  static bool ParseFilter(const std::string &expr, Filter &filter,
+                          std::string &error);
+
+ private:
+  struct Header;
+  struct Record;
+
+  const char *m_data{nullptr};
+  size_t m_size{0};
+  void *m_mapping{nullptr};
+  std::vector<char> m_buffer;
+  bool m_fromCache{false};
+
+  const Header *m_header{nullptr};
+  const Record *m_records{nullptr};
+  const uint32_t *m_resources{nullptr};
+  const char *m_strings{nullptr};
+
+  std::vector<std::string> m_resourceTypes;
+  std::unordered_map<std::string_view, std::vector<uint32_t>> m_bySeries;
+  std::unordered_map<std::string_view, std::vector<uint32_t>> m_byFamily;
+  std::unordered_map<std::string_view, std::vector<uint32_t>> m_byPackage;
+  // Devices sorted by pin count, for range queries without a facet
+  std::vector<uint32_t> m_byPinCount;
+  // Footprint reported to the MemoryTracker
+  int64_t m_trackedBytes{0};
+
+  bool loadIndex(const std::string &indexFile, uint64_t xmlSize,
+                 int64_t xmlTime);
+  static bool buildIndex(const std::string &deviceXml, uint64_t xmlSize,
+                         int64_t xmlTime, std::vector<char> &index);
+  bool attach();
+  void buildLookups();
+  std::string_view str(uint32_t offset) const;
+  bool match(uint32_t device, const Condition &condition) const;
+  const std::vector<uint32_t> *facet(const std::string &field,
+                                     const std::string &value,
+                                     bool &known) const;
+};
+
+}  // namespace FOEDAG
+
+#endif  // DEVICE_DATABASE_H
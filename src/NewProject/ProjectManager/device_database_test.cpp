@@ -0,0 +1,146 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "NewProject/ProjectManager/device_database.h"
+
+#include <fstream>
+#include <string>
+
+#include "Utils/TestDirectory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::ElementsAre;
+
+namespace FOEDAG {
+namespace {
+class DeviceDatabaseTest : public TestDirectory {
+ protected:
+  std::string writeCatalog() {
+    return WriteFile(
+        "device.xml",
+        "<device_list>\n"
+        "  <device name=\"d1\" series=\"s1\" family=\"f1\" package=\"p1\" "
+        "pin_count=\"238\" speedgrade=\"1\" core_voltage=\"1.1V\">\n"
+        "    <resource type=\"lut\" num=\"8000\"/>\n"
+        "  </device>\n"
+        "  <device name=\"d2\" series=\"s1\" family=\"f2\" package=\"p2\" "
+        "pin_count=\"484\" speedgrade=\"2\" core_voltage=\"1.0V\">\n"
+        "    <resource type=\"lut\" num=\"20000\"/>\n"
+        "  </device>\n"
+        "  <device name=\"d3\" series=\"s2\" family=\"f1\" package=\"p1\" "
+        "pin_count=\"900\" speedgrade=\"2\" core_voltage=\"0.9V\"/>\n"
+        "</device_list>\n");
+  }
+};
+
+TEST_F(DeviceDatabaseTest, IndexIsCached) {
+  std::string file = writeCatalog();
+  DeviceDatabase first;
+  ASSERT_EQ(first.Open(file), 0);
+  EXPECT_FALSE(first.FromCache());
+  EXPECT_EQ(first.DeviceCount(), 3u);
+
+  DeviceDatabase second;
+  ASSERT_EQ(second.Open(file), 0);
+  EXPECT_TRUE(second.FromCache());
+  EXPECT_EQ(second.Name(1), "d2");
+  EXPECT_EQ(second.Resource(1, 0), "20000");
+  EXPECT_THAT(second.SeriesList(), ElementsAre("s1", "s2"));
+  EXPECT_THAT(second.FamilyList("s1"), ElementsAre("f1", "f2"));
+}
+
+TEST_F(DeviceDatabaseTest, ChangedCatalogIsReopened) {
+  std::string file = writeCatalog();
+  DeviceDatabase database;
+  ASSERT_EQ(database.Open(file), 0);
+  EXPECT_TRUE(database.IsUpToDate(file));
+
+  {
+    std::ofstream out(file, std::ios::app);
+    out << "<!-- edited -->\n";
+  }
+  EXPECT_FALSE(database.IsUpToDate(file));
+  ASSERT_EQ(database.Open(file), 0);
+  EXPECT_FALSE(database.FromCache());
+  EXPECT_TRUE(database.IsUpToDate(file));
+}
+
+TEST_F(DeviceDatabaseTest, CorruptIndexIsRebuilt) {
+  std::string file = writeCatalog();
+  {
+    DeviceDatabase database;
+    ASSERT_EQ(database.Open(file), 0);
+  }
+  // Point the resource types (offset 40 in the header) past the end
+  {
+    std::fstream index(file + ".idx",
+                       std::ios::in | std::ios::out | std::ios::binary);
+    uint32_t offset = 0xfffffff0;
+    index.seekp(40);
+    index.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+  }
+  DeviceDatabase database;
+  ASSERT_EQ(database.Open(file), 0);
+  EXPECT_FALSE(database.FromCache());
+  EXPECT_EQ(database.DeviceCount(), 3u);
+}
+
+TEST_F(DeviceDatabaseTest, Filter) {
+  std::string file = writeCatalog();
+  DeviceDatabase db;
+  ASSERT_EQ(db.Open(file), 0);
+
+  DeviceDatabase::Filter filter;
+  std::string error;
+  ASSERT_TRUE(DeviceDatabase::ParseFilter(
+      "pin_count >= 400 && core_voltage < 1.05", filter, error));
+  EXPECT_THAT(db.Query(filter), ElementsAre(1u, 2u));
+
+  ASSERT_TRUE(DeviceDatabase::ParseFilter("family == f1 && lut > 1000",
+                                          filter, error));
+  EXPECT_THAT(db.Query(filter), ElementsAre(0u));
+
+  EXPECT_FALSE(DeviceDatabase::ParseFilter("pin_count 400", filter, error));
+}
+
+TEST_F(DeviceDatabaseTest, Sort) {
+  std::string file = writeCatalog();
+  DeviceDatabase db;
+  ASSERT_EQ(db.Open(file), 0);
+
+  std::vector<uint32_t> devices{0, 1, 2};
+  ASSERT_TRUE(db.Sort(devices, {{"pin_count", false}}));
+  EXPECT_THAT(devices, ElementsAre(2, 1, 0));
+
+  // Ties on the family are broken by the speedgrade
+  ASSERT_TRUE(db.Sort(devices, {{"family", true}, {"speedgrade", false}}));
+  EXPECT_THAT(devices, ElementsAre(2, 0, 1));
+
+  // d3 has no lut resource and goes last
+  ASSERT_TRUE(db.Sort(devices, {{"lut", false}}));
+  EXPECT_THAT(devices, ElementsAre(1, 0, 2));
+
+  EXPECT_FALSE(db.Sort(devices, {{"name", true}}, []() { return true; }));
+}
+
+}  // namespace
+}  // namespace FOEDAG
@@ -8,6 +8,18 @@ ProjectFileSet::ProjectFileSet(QObject *parent) : ProjectOption(parent) {
   m_mapFiles.clear();
 }
 
+ProjectFileSet::~ProjectFileSet() { setFilesBytes(0); }
+
+void ProjectFileSet::setFilesBytes(int64_t bytes) {
+  MemoryTracker::Allocate(MemoryTracker::Project, bytes - m_filesBytes, 0);
+  m_filesBytes = bytes;
+}
+
+static int64_t fileBytes(const QString &strFileName,
+                         const QString &strFilePath) {
+  return (strFileName.size() + strFilePath.size()) * int64_t(sizeof(QChar));
+}
+
 ProjectFileSet &ProjectFileSet::operator=(const ProjectFileSet &other) {
   if (this == &other) {
     return *this;
@@ -16,6 +28,7 @@ ProjectFileSet &ProjectFileSet::operator=(const ProjectFileSet &other) {
   this->m_setType = other.m_setType;
   this->m_relSrcDir = other.m_relSrcDir;
   this->m_mapFiles = other.m_mapFiles;
+  setFilesBytes(other.m_filesBytes);
   ProjectOption::operator=(other);
 
   return *this;
@@ -23,7 +36,11 @@ ProjectFileSet &ProjectFileSet::operator=(const ProjectFileSet &other) {
 
 void ProjectFileSet::addFile(const QString &strFileName,
                              const QString &strFilePath) {
+  int64_t bytes = m_filesBytes + fileBytes(strFileName, strFilePath);
+  auto iter = m_mapFiles.find(strFileName);
+  if (iter != m_mapFiles.end()) bytes -= fileBytes(iter.key(), iter.value());
   m_mapFiles[strFileName] = strFilePath;
+  setFilesBytes(bytes);
 }
 
 QString ProjectFileSet::getFilePath(const QString &strFileName) {
@@ -38,6 +55,7 @@ QString ProjectFileSet::getFilePath(const QString &strFileName) {
 void ProjectFileSet::deleteFile(const QString &strFileName) {
   auto iter = m_mapFiles.find(strFileName);
   if (iter != m_mapFiles.end()) {
+    setFilesBytes(m_filesBytes - fileBytes(iter.key(), iter.value()));
     m_mapFiles.erase(iter);
   }
 }
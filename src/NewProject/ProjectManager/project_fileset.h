@@ -10,6 +10,7 @@ class ProjectFileSet : public ProjectOption {
   Q_OBJECT
  public:
   explicit ProjectFileSet(QObject *parent = nullptr);
+  ~ProjectFileSet();
 
   ProjectFileSet &operator=(const ProjectFileSet &other);
 
@@ -33,6 +34,10 @@ class ProjectFileSet : public ProjectOption {
   QString m_setType;
   QString m_relSrcDir;
   QMap<QString, QString> m_mapFiles;
+  // Bytes of the file names and paths, reported to the MemoryTracker
+  int64_t m_filesBytes{0};
+
+  void setFilesBytes(int64_t bytes);
 };
 }  // namespace FOEDAG
 #endif  // PROJECTFILESET_H
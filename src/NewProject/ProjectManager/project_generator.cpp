@@ -0,0 +1,132 @@
+#include "project_generator.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include "project_manager.h"
+
+using namespace FOEDAG;
+
+ProjectGenerator::ProjectGenerator(ProjectManager *manager)
+    : m_manager(manager) {}
+
+QString ProjectGenerator::DesignFileSetName(int index) {
+  return 0 == index ? QString(DEFAULT_FOLDER_SOURCE)
+                    : QString("sources_%1").arg(index + 1);
+}
+
+QString ProjectGenerator::ModuleText(int index, int count, int filesets) {
+  QString strText;
+  QTextStream out(&strText);
+  out << "module m" << index << " (input clk, input [7:0] d, output [7:0] q);\n";
+  out << "  reg [7:0] r;\n";
+  out << "  always @(posedge clk) r <= d ^ 8'd" << index % 256 << ";\n";
+  QString strOut = "r";
+  int set = index % filesets;
+  int row = index / filesets;
+  for (int childRow = 2 * row + 1; childRow <= 2 * row + 2; childRow++) {
+    int child = childRow * filesets + set;
+    if (child >= count) break;
+    out << "  wire [7:0] w" << child << ";\n";
+    out << "  m" << child << " u" << child << " (.clk(clk), .d(" << strOut
+        << "), .q(w" << child << "));\n";
+    strOut = QString("w%1").arg(child);
+  }
+  out << "  assign q = " << strOut << ";\n";
+  out << "endmodule\n";
+  return strText;
+}
+
+int ProjectGenerator::WriteDeviceCatalog(const QString &strFile, int devices) {
+  QFile file(strFile);
+  if (!file.open(QFile::WriteOnly | QFile::Text | QFile::Truncate)) {
+    return -1;
+  }
+  QTextStream out(&file);
+  out << "<device_list>\n";
+  for (int i = 0; i < devices; i++) {
+    out << "  <device name=\"dev" << i << "\" series=\"s" << i % 4
+        << "\" family=\"f" << i % 16 << "\" package=\"p" << i % 64
+        << "\" pin_count=\"" << 100 + i % 900 << "\" speedgrade=\""
+        << 1 + i % 3 << "\" core_voltage=\"1.0V\">\n";
+    out << "    <resource type=\"lut\" num=\"" << 1000 + i * 10 << "\"/>\n";
+    out << "    <resource type=\"ff\" num=\"" << 2000 + i * 20 << "\"/>\n";
+    out << "  </device>\n";
+  }
+  out << "</device_list>\n";
+  return 0;
+}
+
+int ProjectGenerator::Generate(const Options &options) {
+  if (options.path.isEmpty() || options.files < 0 || options.filesets < 1 ||
+      options.runs < 1 || options.devices < 0) {
+    return -1;
+  }
+  m_designFiles.clear();
+  int ret = m_manager->CreateProject(options.name, options.path);
+  if (0 != ret) {
+    return ret;
+  }
+  QString strSrcs = options.path + "/" + options.name + ".srcs/";
+
+  for (int set = 1; set < options.filesets; set++) {
+    ret = m_manager->setDesignFileSet(DesignFileSetName(set));
+    if (0 != ret) {
+      return ret;
+    }
+  }
+
+  for (int i = 0; i < options.files; i++) {
+    QString strSet = DesignFileSetName(i % options.filesets);
+    QString strFile = QString("%1%2/m%3.v").arg(strSrcs, strSet).arg(i);
+    QFile file(strFile);
+    if (!file.open(QFile::WriteOnly | QFile::Text | QFile::Truncate)) {
+      return -1;
+    }
+    QTextStream(&file) << ModuleText(i, options.files, options.filesets);
+    file.close();
+
+    m_manager->setCurrentFileSet(strSet);
+    ret = m_manager->setDesignFile(strFile, false);
+    if (0 != ret) {
+      return ret;
+    }
+    m_designFiles.append(strFile);
+  }
+  for (int set = 0; set < options.filesets && set < options.files; set++) {
+    m_manager->setCurrentFileSet(DesignFileSetName(set));
+    m_manager->setTopModule(QString("m%1.v").arg(set));
+  }
+
+  QString strSdc = strSrcs + DEFAULT_FOLDER_CONSTRS + "/top.sdc";
+  QFile sdc(strSdc);
+  if (sdc.open(QFile::WriteOnly | QFile::Text | QFile::Truncate)) {
+    QTextStream(&sdc) << "create_clock -period 10 clk\n";
+    sdc.close();
+    m_manager->setCurrentFileSet(DEFAULT_FOLDER_CONSTRS);
+    m_manager->setConstrsFile(strSdc, false);
+  }
+
+  for (int run = 1; run < options.runs; run++) {
+    QString strSynth = QString("synth_%1").arg(run + 1);
+    m_manager->setSynthRun(strSynth);
+    m_manager->setRunSrcSet(DesignFileSetName(run % options.filesets));
+    m_manager->setRunConstrSet(DEFAULT_FOLDER_CONSTRS);
+    m_manager->setImpleRun(QString("imple_%1").arg(run + 1));
+    m_manager->setRunSrcSet(DesignFileSetName(run % options.filesets));
+    m_manager->setRunConstrSet(DEFAULT_FOLDER_CONSTRS);
+    m_manager->setRunSynthRun(strSynth);
+  }
+  m_manager->setCurrentFileSet(DEFAULT_FOLDER_SOURCE);
+
+  if (options.devices > 0) {
+    ret = WriteDeviceCatalog(options.path + "/device.xml", options.devices);
+    if (0 != ret) {
+      return ret;
+    }
+  }
+
+  ret = m_manager->ExportProjectData();
+  m_strProjectFile = options.path + "/" + options.name + PROJECT_FILE_FORMAT;
+  return ret;
+}
@@ -0,0 +1,49 @@
+#ifndef PROJECT_GENERATOR_H
+#define PROJECT_GENERATOR_H
+
+#include <QString>
+#include <QStringList>
+
+namespace FOEDAG {
+class ProjectManager;
+
+// Writes synthetic projects to stress the project handling: design files
+// forming a module tree, extra file sets and runs and a device catalog of
+// the requested size. Used by generate_project and the scaling benchmarks.
+class ProjectGenerator {
+ public:
+  struct Options {
+    QString name{"synthetic"};
+    QString path;
+    int files{100};
+    // Design file sets, the files are spread over them
+    int filesets{1};
+    // Synthesis runs, each with its implementation run
+    int runs{1};
+    // Entries of <path>/device.xml, none written when 0
+    int devices{0};
+  };
+
+  explicit ProjectGenerator(ProjectManager *manager);
+
+  // Creates the project and saves it, returns 0 on success
+  int Generate(const Options &options);
+  // Absolute path of the .ospr file written by the last Generate()
+  QString ProjectFile() const { return m_strProjectFile; }
+  QStringList DesignFiles() const { return m_designFiles; }
+
+  static QString DesignFileSetName(int index);
+  // Module m<index> of a design of count modules spread over filesets file
+  // sets (m<index> is in set index % filesets). Each set is a binary tree:
+  // the module of row k in its set instantiates the ones of rows 2k+1 and
+  // 2k+2 of the same set when they are part of the design.
+  static QString ModuleText(int index, int count, int filesets = 1);
+  static int WriteDeviceCatalog(const QString &strFile, int devices);
+
+ private:
+  ProjectManager *m_manager;
+  QString m_strProjectFile;
+  QStringList m_designFiles;
+};
+}  // namespace FOEDAG
+#endif  // PROJECT_GENERATOR_H
@@ -0,0 +1,198 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include "NewProject/ProjectManager/device_database.h"
+#include "NewProject/ProjectManager/project_generator.h"
+#include "NewProject/ProjectManager/project_manager.h"
+#include "ProjNavigator/sources_form.h"
+#include "benchmark/benchmark.h"
+
+namespace FOEDAG {
+namespace {
+// The project operations are measured against the number of design files,
+// the reported complexity shows when one of them stops scaling linearly.
+void ScalingRange(benchmark::internal::Benchmark* bench) {
+  bench->RangeMultiplier(4)->Range(16, 4096)->Complexity();
+}
+
+// Synthetic project with range(0) design files in a temporary directory
+class ProjectFixture {
+ public:
+  explicit ProjectFixture(int files) : m_generator(&m_manager) {
+    ProjectGenerator::Options options;
+    options.name = "bench";
+    options.path = m_dir.path() + "/bench";
+    options.files = files;
+    options.filesets = 2;
+    options.runs = 2;
+    m_generator.Generate(options);
+  }
+  ProjectManager& Manager() { return m_manager; }
+  QString Ospro() const { return m_generator.ProjectFile(); }
+  QString Path() const { return m_dir.path(); }
+
+ private:
+  QTemporaryDir m_dir;
+  ProjectManager m_manager;
+  ProjectGenerator m_generator;
+};
+
+void BM_ProjectCreate(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    QTemporaryDir dir;
+    ProjectManager manager;
+    ProjectGenerator generator(&manager);
+    ProjectGenerator::Options options;
+    options.path = dir.path() + "/bench";
+    options.files = state.range(0);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(generator.Generate(options));
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ProjectCreate)->Apply(ScalingRange);
+
+void BM_ProjectOpen(benchmark::State& state) {
+  ProjectFixture fixture(state.range(0));
+  for (auto _ : state) {
+    // Importing the project that is already open is a no-op, forget it first
+    state.PauseTiming();
+    Project::Instance()->InitProject();
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(
+        fixture.Manager().ImportProjectData(fixture.Ospro()));
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ProjectOpen)->Apply(ScalingRange);
+
+void BM_ProjectSave(benchmark::State& state) {
+  ProjectFixture fixture(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fixture.Manager().ExportProjectData());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ProjectSave)->Apply(ScalingRange);
+
+// One more file in a project of range(0) files, and its removal
+void BM_ProjectAddFile(benchmark::State& state) {
+  ProjectFixture fixture(state.range(0));
+  QString strFile = fixture.Path() + "/extra.v";
+  QFile file(strFile);
+  if (file.open(QFile::WriteOnly | QFile::Text)) {
+    QTextStream(&file) << ProjectGenerator::ModuleText(0, 1);
+    file.close();
+  }
+  ProjectManager& manager = fixture.Manager();
+  manager.setCurrentFileSet(DEFAULT_FOLDER_SOURCE);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.setDesignFile(strFile, false));
+    state.PauseTiming();
+    manager.deleteFile("extra.v");
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ProjectAddFile)->Apply(ScalingRange);
+
+void BM_ProjectDeleteFile(benchmark::State& state) {
+  ProjectFixture fixture(state.range(0));
+  // The last file of the first set, the top module cannot be deleted
+  QString strFile = fixture.Path() + "/bench/bench.srcs/" +
+                    ProjectGenerator::DesignFileSetName(0) +
+                    QString("/m%1.v").arg((state.range(0) - 1) / 2 * 2);
+  QString strName = QFileInfo(strFile).fileName();
+  ProjectManager& manager = fixture.Manager();
+  manager.setCurrentFileSet(DEFAULT_FOLDER_SOURCE);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.deleteFile(strName));
+    state.PauseTiming();
+    manager.setDesignFile(strFile, false);
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ProjectDeleteFile)->Apply(ScalingRange);
+
+// Rebuild of the Sources tree of the project navigator
+void BM_NavigatorRefresh(benchmark::State& state) {
+  ProjectFixture fixture(state.range(0));
+  SourcesForm form(fixture.Ospro());
+  for (auto _ : state) {
+    QMetaObject::invokeMethod(&form, "SlotRefreshSourceTree",
+                              Qt::DirectConnection);
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_NavigatorRefresh)->Apply(ScalingRange);
+
+// Catalog of range(0) devices, every iteration parses the xml file and
+// writes the index next to it
+void BM_DeviceCatalogBuild(benchmark::State& state) {
+  QTemporaryDir dir;
+  QString strXml = dir.path() + "/device.xml";
+  ProjectGenerator::WriteDeviceCatalog(strXml, state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    QFile::remove(strXml + ".idx");
+    DeviceDatabase database;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(database.Open(strXml.toStdString()));
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_DeviceCatalogBuild)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Complexity();
+
+// Same catalog, every iteration loads the index cached by the first Open.
+// Config::InitConfig is not used, it does not reopen an unchanged catalog.
+void BM_DeviceCatalogOpen(benchmark::State& state) {
+  QTemporaryDir dir;
+  QString strXml = dir.path() + "/device.xml";
+  ProjectGenerator::WriteDeviceCatalog(strXml, state.range(0));
+  DeviceDatabase().Open(strXml.toStdString());
+  for (auto _ : state) {
+    DeviceDatabase database;
+    benchmark::DoNotOptimize(database.Open(strXml.toStdString()));
+    if (!database.FromCache()) {
+      state.SkipWithError("The index is not cached");
+      break;
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_DeviceCatalogOpen)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Complexity();
+
+}  // namespace
+}  // namespace FOEDAG
@@ -4,9 +4,13 @@
 #include <QMap>
 #include <QObject>
 
+#include "Utils/MemoryTracker.h"
+
 namespace FOEDAG {
 
-class ProjectOption : public QObject {
+class ProjectOption
+    : public QObject,
+      public MemoryTracked<MemoryTracker::Project, ProjectOption> {
   Q_OBJECT
  public:
   explicit ProjectOption(QObject *parent = nullptr);
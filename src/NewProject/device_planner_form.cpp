@@ -6,6 +6,7 @@
 #include <QTextStream>
 
 #include "ProjectManager/config.h"
+#include "device_table_model.h"
 #include "ui_device_planner_form.h"
 
 using namespace FOEDAG;
@@ -37,13 +38,16 @@ devicePlannerForm::devicePlannerForm(QWidget *parent)
        QTableView::item:selected{color:black;background:rgb(177,220,255);}");
   m_tableView->setColumnWidth(0, 80);
 
-  m_model = new QStandardItemModel();
+  m_model = new DeviceTableModel(this);
   m_selectmodel = new QItemSelectionModel(m_model);
 
   m_tableView->horizontalHeader()->setMinimumHeight(30);
 
   m_tableView->setModel(m_model);
   m_tableView->setSelectionModel(m_selectmodel);
+  // Sorted by the model on its worker thread
+  m_tableView->setSortingEnabled(true);
+  m_tableView->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
 
   QVBoxLayout *vbox = new QVBoxLayout(ui->m_frame);
   vbox->addWidget(m_tableView);
@@ -57,31 +61,85 @@ devicePlannerForm::devicePlannerForm(QWidget *parent)
           &devicePlannerForm::onSeriestextChanged);
   connect(ui->m_comboBoxPackage, &QComboBox::currentTextChanged, this,
           &devicePlannerForm::onPackagetextChanged);
-
-  QString devicexml = QDir::currentPath() + "/device.xml";
-  if (0 == Config::Instance()->InitConfig(devicexml)) {
+  connect(m_selectmodel, &QItemSelectionModel::currentRowChanged, this,
+          &devicePlannerForm::onCurrentRowChanged);
+
+  // The catalog is normally being loaded since startup, do not block the GUI
+  // thread on it
+  m_deviceXml = QDir::currentPath() + "/device.xml";
+  Config *config = Config::Instance();
+  if (config->isLoaded(m_deviceXml)) {
     InitSeriesComboBox();
+  } else {
+    SetLoading(true);
+    connect(config, &Config::loaded, this,
+            &devicePlannerForm::onDeviceCatalogLoaded);
+    config->InitConfigAsync(m_deviceXml);
   }
 }
 
 devicePlannerForm::~devicePlannerForm() { delete ui; }
 
+void devicePlannerForm::onDeviceCatalogLoaded(int result) {
+  disconnect(Config::Instance(), &Config::loaded, this,
+             &devicePlannerForm::onDeviceCatalogLoaded);
+  SetLoading(false);
+  if (0 == result) {
+    InitSeriesComboBox();
+  } else {
+    ui->m_labelDetail->setText(tr("Failed to load the device catalog."));
+  }
+}
+
+void devicePlannerForm::SetLoading(bool loading) {
+  ui->m_labelDetail->setText(
+      loading
+          ? tr("Loading device catalog...")
+          : tr("Select the series and device you want to target for "
+               "compilation."));
+  ui->groupBox->setEnabled(!loading);
+  m_tableView->setEnabled(!loading);
+}
+
 QList<QString> devicePlannerForm::getSelectedDevice() const {
+  // Finished before the catalog was there, wait for it. loaded() fills the
+  // combo boxes.
+  Config *config = Config::Instance();
+  if (!config->isLoaded(m_deviceXml)) {
+    config->InitConfig(m_deviceXml);
+  }
+
   QList<QString> listRtn;
   listRtn.append(ui->m_comboBoxSeries->currentText());
   listRtn.append(ui->m_comboBoxFamily->currentText());
   listRtn.append(ui->m_comboBoxPackage->currentText());
 
-  if (m_selectmodel->hasSelection()) {
-    int curRow = m_selectmodel->currentIndex().row();
-    listRtn.append(m_model->data(m_model->index(curRow, 0)).toString());
-  } else {
-    listRtn.append(m_model->data(m_model->index(0, 0)).toString());
+  // The table may still be waiting for its rows, the first device of the
+  // catalog is the default
+  QString device = m_selectedDevice;
+  auto database = Config::Instance()->getSharedDatabase();
+  if (device.isEmpty() && database && database->IsOpen()) {
+    auto devices = database->Query(listRtn.at(0).toStdString(),
+                                   listRtn.at(1).toStdString(),
+                                   listRtn.at(2).toStdString());
+    if (!devices.empty()) {
+      device = QString::fromStdString(std::string(database->Name(devices[0])));
+    }
   }
+  listRtn.append(device);
 
   return listRtn;
 }
 
+void devicePlannerForm::onCurrentRowChanged(const QModelIndex &current,
+                                            const QModelIndex &previous) {
+  Q_UNUSED(previous);
+  if (current.isValid()) {
+    m_selectedDevice =
+        m_model->data(m_model->index(current.row(), 0)).toString();
+  }
+}
+
 void devicePlannerForm::onSeriestextChanged(const QString &arg1) {
   Q_UNUSED(arg1);
   UpdateFamilyComboBox();
@@ -113,13 +171,6 @@ void devicePlannerForm::InitSeriesComboBox() {
           &devicePlannerForm::onSeriestextChanged);
 }
 
-void devicePlannerForm::InitDeviceTableViewHead() {
-  QList<QString> listHead = Config::Instance()->getDeviceItem();
-  for (int i = 0; i < listHead.size(); ++i) {
-    m_model->setHorizontalHeaderItem(i, new QStandardItem(listHead.at(i)));
-  }
-}
-
 void devicePlannerForm::UpdateFamilyComboBox() {
   disconnect(ui->m_comboBoxFamily, &QComboBox::currentTextChanged, this,
              &devicePlannerForm::onFamilytextChanged);
@@ -155,23 +206,9 @@ void devicePlannerForm::UpdatePackageComboBox() {
 }
 
 void devicePlannerForm::UpdateDeviceTableView() {
-  m_model->clear();
-  InitDeviceTableViewHead();
-  QList<QStringList> listDevice = Config::Instance()->getDevicelist(
-      ui->m_comboBoxSeries->currentText(), ui->m_comboBoxFamily->currentText(),
-      ui->m_comboBoxPackage->currentText());
-  for (int i = 0; i < listDevice.count(); ++i) {
-    int rows = m_model->rowCount();
-    QList<QStandardItem *> items;
-    QStandardItem *item = nullptr;
-
-    QList<QString> listDev = listDevice.at(i);
-    foreach (QString strItem, listDev) {
-      item = new QStandardItem(strItem);
-      item->setTextAlignment(Qt::AlignCenter);
-      items.append(item);
-    }
-
-    m_model->insertRow(rows, items);
-  }
+  m_selectedDevice.clear();
+  m_model->SetFilter(Config::Instance()->getSharedDatabase(),
+                     ui->m_comboBoxSeries->currentText(),
+                     ui->m_comboBoxFamily->currentText(),
+                     ui->m_comboBoxPackage->currentText());
 }
@@ -1,6 +1,6 @@
 #ifndef DEVICEPLANNERFORM_H
 #define DEVICEPLANNERFORM_H
-#include <QStandardItemModel>
+#include <QItemSelectionModel>
 #include <QTableView>
 #include <QWidget>
 
@@ -10,6 +10,8 @@ class devicePlannerForm;
 
 namespace FOEDAG {
 
+class DeviceTableModel;
+
 class devicePlannerForm : public QWidget {
   Q_OBJECT
 
@@ -23,16 +25,22 @@ class devicePlannerForm : public QWidget {
   void onSeriestextChanged(const QString &arg1);
   void onFamilytextChanged(const QString &arg1);
   void onPackagetextChanged(const QString &arg1);
+  void onDeviceCatalogLoaded(int result);
+  void onCurrentRowChanged(const QModelIndex &current,
+                           const QModelIndex &previous);
 
  private:
   Ui::devicePlannerForm *ui;
 
   QTableView *m_tableView;
-  QStandardItemModel *m_model;
+  DeviceTableModel *m_model;
   QItemSelectionModel *m_selectmodel;
+  QString m_deviceXml;
+  // Picked in the table, the rows are filled asynchronously
+  QString m_selectedDevice;
 
+  void SetLoading(bool loading);
   void InitSeriesComboBox();
-  void InitDeviceTableViewHead();
   void UpdateFamilyComboBox();
   void UpdatePackageComboBox();
   void UpdateDeviceTableView();
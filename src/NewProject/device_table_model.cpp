@@ -0,0 +1,236 @@
+#include "device_table_model.h"
+
+using namespace FOEDAG;
+
+#define FETCH_BATCH 256
+// Older keys beyond this are dropped
+#define MAX_SORT_KEYS 3
+
+static QString toQString(std::string_view text) {
+  return QString::fromUtf8(text.data(), int(text.size()));
+}
+
+static QStringList columnsOf(const DeviceDatabase *database) {
+  QStringList columns;
+  if (database == nullptr || !database->IsOpen()) {
+    return columns;
+  }
+  columns << "name"
+          << "pin_count"
+          << "speedgrade"
+          << "core_voltage";
+  for (const auto &type : database->ResourceTypes()) {
+    columns.append(QString::fromStdString(type));
+  }
+  columns << "series"
+          << "family"
+          << "package";
+  return columns;
+}
+
+DeviceTableModel::DeviceTableModel(QObject *parent)
+    : QAbstractTableModel(parent) {
+  m_worker = std::thread(&DeviceTableModel::Run, this);
+}
+
+DeviceTableModel::~DeviceTableModel() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_generation++;
+  m_wakeUp.notify_one();
+  m_worker.join();
+}
+
+int DeviceTableModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : m_fetched;
+}
+
+int DeviceTableModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : m_columns.size();
+}
+
+QVariant DeviceTableModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= m_fetched) {
+    return QVariant();
+  }
+  if (role == Qt::TextAlignmentRole) {
+    return int(Qt::AlignCenter);
+  }
+  if (role != Qt::DisplayRole) {
+    return QVariant();
+  }
+
+  const DeviceDatabase *database = m_shownDatabase.get();
+  uint32_t device = m_devices[index.row()];
+  int column = index.column();
+  int resources = int(database->ResourceTypes().size());
+  switch (column) {
+    case 0:
+      return toQString(database->Name(device));
+    case 1:
+      return toQString(database->PinCount(device));
+    case 2:
+      return toQString(database->SpeedGrade(device));
+    case 3:
+      return toQString(database->CoreVoltage(device));
+    default:
+      break;
+  }
+  column -= 4;
+  if (column < resources) {
+    return toQString(database->Resource(device, column));
+  }
+  switch (column - resources) {
+    case 0:
+      return toQString(database->Series(device));
+    case 1:
+      return toQString(database->Family(device));
+    case 2:
+      return toQString(database->Package(device));
+    default:
+      return QVariant();
+  }
+}
+
+QVariant DeviceTableModel::headerData(int section, Qt::Orientation orientation,
+                                      int role) const {
+  if (orientation == Qt::Horizontal && role == Qt::DisplayRole &&
+      section < m_columns.size()) {
+    return m_columns.at(section);
+  }
+  return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool DeviceTableModel::canFetchMore(const QModelIndex &parent) const {
+  return !parent.isValid() && m_fetched < int(m_devices.size());
+}
+
+void DeviceTableModel::fetchMore(const QModelIndex &parent) {
+  if (parent.isValid()) {
+    return;
+  }
+  int count = qMin(FETCH_BATCH, int(m_devices.size()) - m_fetched);
+  if (count <= 0) {
+    return;
+  }
+  beginInsertRows(QModelIndex(), m_fetched, m_fetched + count - 1);
+  m_fetched += count;
+  endInsertRows();
+}
+
+void DeviceTableModel::sort(int column, Qt::SortOrder order) {
+  QString field = FieldName(column);
+  if (field.isEmpty()) {
+    return;
+  }
+  std::string key = field.toStdString();
+  for (auto itr = m_sortKeys.begin(); itr != m_sortKeys.end(); ++itr) {
+    if (itr->field == key) {
+      m_sortKeys.erase(itr);
+      break;
+    }
+  }
+  m_sortKeys.insert(m_sortKeys.begin(), {key, order == Qt::AscendingOrder});
+  if (m_sortKeys.size() > MAX_SORT_KEYS) {
+    m_sortKeys.resize(MAX_SORT_KEYS);
+  }
+  Submit();
+}
+
+void DeviceTableModel::SetFilter(
+    std::shared_ptr<const DeviceDatabase> database, const QString &series,
+    const QString &family, const QString &package) {
+  if (database != m_database) {
+    // Resource columns may differ between catalogs
+    m_sortKeys.clear();
+  }
+  m_database = database;
+  m_series = series;
+  m_family = family;
+  m_package = package;
+  Submit();
+}
+
+void DeviceTableModel::Submit() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job.database = m_database;
+    m_job.series = m_series.toStdString();
+    m_job.family = m_family.toStdString();
+    m_job.package = m_package.toStdString();
+    m_job.keys = m_sortKeys;
+    m_job.generation = ++m_generation;
+    m_hasJob = true;
+  }
+  m_wakeUp.notify_one();
+}
+
+void DeviceTableModel::Run() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wakeUp.wait(lock, [this]() { return m_stop || m_hasJob; });
+      if (m_stop) {
+        return;
+      }
+      job = std::move(m_job);
+      m_hasJob = false;
+    }
+
+    auto cancelled = [this, &job]() {
+      return m_generation.load() != job.generation;
+    };
+    Result result;
+    result.database = job.database;
+    result.generation = job.generation;
+    result.pending = true;
+    if (job.database && job.database->IsOpen()) {
+      result.devices =
+          job.database->Query(job.series, job.family, job.package);
+      if (cancelled()) {
+        continue;
+      }
+      if (!job.keys.empty() &&
+          !job.database->Sort(result.devices, job.keys, cancelled)) {
+        continue;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (cancelled()) {
+        continue;
+      }
+      m_result = std::move(result);
+    }
+    QMetaObject::invokeMethod(this, "ApplyResult", Qt::QueuedConnection);
+  }
+}
+
+void DeviceTableModel::ApplyResult() {
+  Result result;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // A newer request is running, or this result was already applied
+    if (m_result.generation != m_generation || !m_result.pending) {
+      return;
+    }
+    result = std::move(m_result);
+    m_result.pending = false;
+  }
+
+  beginResetModel();
+  m_shownDatabase = std::move(result.database);
+  m_columns = columnsOf(m_shownDatabase.get());
+  m_devices = std::move(result.devices);
+  m_fetched = qMin(FETCH_BATCH, int(m_devices.size()));
+  endResetModel();
+}
+
+QString DeviceTableModel::FieldName(int column) const {
+  return column >= 0 && column < m_columns.size() ? m_columns.at(column)
+                                                  : QString();
+}
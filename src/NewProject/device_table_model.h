@@ -0,0 +1,91 @@
+#ifndef DEVICE_TABLE_MODEL_H
+#define DEVICE_TABLE_MODEL_H
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ProjectManager/device_database.h"
+
+namespace FOEDAG {
+
+// Device list of the planner read straight from the catalog index. The model
+// only stores device numbers, cells are formatted when the view asks for
+// them. Querying and sorting run on a worker thread, a new request cancels
+// the one in flight.
+class DeviceTableModel : public QAbstractTableModel {
+  Q_OBJECT
+
+ public:
+  explicit DeviceTableModel(QObject *parent = nullptr);
+  ~DeviceTableModel();
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const override;
+  bool canFetchMore(const QModelIndex &parent) const override;
+  void fetchMore(const QModelIndex &parent) override;
+  // The column becomes the primary key, the previous keys break ties.
+  void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+  // Shows the devices of the series/family/package of the given catalog.
+  // The rows are replaced once the worker is done.
+  void SetFilter(std::shared_ptr<const DeviceDatabase> database,
+                 const QString &series, const QString &family,
+                 const QString &package);
+
+ private slots:
+  void ApplyResult();
+
+ private:
+  struct Job {
+    std::shared_ptr<const DeviceDatabase> database;
+    std::string series;
+    std::string family;
+    std::string package;
+    std::vector<DeviceDatabase::SortKey> keys;
+    uint64_t generation{0};
+  };
+  struct Result {
+    std::shared_ptr<const DeviceDatabase> database;
+    std::vector<uint32_t> devices;
+    uint64_t generation{0};
+    bool pending{false};
+  };
+
+  // Catalog of the next request
+  std::shared_ptr<const DeviceDatabase> m_database;
+  // Catalog the shown rows belong to
+  std::shared_ptr<const DeviceDatabase> m_shownDatabase;
+  QStringList m_columns;
+  std::vector<uint32_t> m_devices;
+  int m_fetched{0};
+  QString m_series;
+  QString m_family;
+  QString m_package;
+  std::vector<DeviceDatabase::SortKey> m_sortKeys;
+
+  // Bumped by every request, a job whose generation is behind is dropped
+  std::atomic<uint64_t> m_generation{0};
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  bool m_hasJob{false};
+  bool m_stop{false};
+  Job m_job;
+  Result m_result;
+  std::thread m_worker;
+
+  void Submit();
+  void Run();
+  QString FieldName(int column) const;
+};
+}  // namespace FOEDAG
+#endif  // DEVICE_TABLE_MODEL_H
@@ -5,6 +5,8 @@
 #include <QMessageBox>
 #include <QTextStream>
 
+#include "Compiler/HdlScanner.h"
+#include "sources_tree_model.h"
 #include "ui_sources_form.h"
 
 using namespace FOEDAG;
@@ -12,8 +14,9 @@ using namespace FOEDAG;
 SourcesForm::SourcesForm(QString strproject, QWidget *parent)
     : QWidget(parent), ui(new Ui::SourcesForm) {
   ui->setupUi(this);
+  m_hdlScanner = new HdlScanner();
 
-  m_treeSrcHierachy = new QTreeWidget(ui->m_tabHierarchy);
+  m_treeSrcHierachy = new QTreeView(ui->m_tabHierarchy);
   m_treeSrcHierachy->setSelectionMode(
       QAbstractItemView::SelectionMode::SingleSelection);
 
@@ -23,22 +26,76 @@ SourcesForm::SourcesForm(QString strproject, QWidget *parent)
   vbox->setSpacing(0);
   ui->m_tabHierarchy->setLayout(vbox);
 
+  m_treeModules = new QTreeWidget(ui->m_tabModules);
+  m_treeModules->setHeaderHidden(true);
+  m_treeModules->setSelectionMode(
+      QAbstractItemView::SelectionMode::SingleSelection);
+
+  QVBoxLayout *vboxModules = new QVBoxLayout();
+  vboxModules->addWidget(m_treeModules);
+  vboxModules->setContentsMargins(0, 0, 0, 0);
+  vboxModules->setSpacing(0);
+  ui->m_tabModules->setLayout(vboxModules);
+
   CreateActions();
 
   m_projManager = new ProjectManager(this);
   m_projManager->StartProject(strproject);
 
+  m_modelSrcHierachy = new SourcesTreeModel(m_projManager, this);
+  m_treeSrcHierachy->setModel(m_modelSrcHierachy);
+  m_treeSrcHierachy->setHeaderHidden(true);
+  // All rows have the same height, lets the view skip measuring them
+  m_treeSrcHierachy->setUniformRowHeights(true);
+
   UpdateSrcHierachyTree();
 
-  connect(m_treeSrcHierachy, SIGNAL(itemPressed(QTreeWidgetItem *, int)), this,
-          SLOT(SlotItempressed(QTreeWidgetItem *, int)));
-  connect(m_treeSrcHierachy, SIGNAL(itemDoubleClicked(QTreeWidgetItem *, int)),
-          this, SLOT(SlotItemDoubleClicked(QTreeWidgetItem *, int)));
+  connect(m_treeSrcHierachy, SIGNAL(pressed(const QModelIndex &)), this,
+          SLOT(SlotItempressed(const QModelIndex &)));
+  connect(m_treeSrcHierachy, SIGNAL(doubleClicked(const QModelIndex &)), this,
+          SLOT(SlotItemDoubleClicked(const QModelIndex &)));
+  connect(m_treeSrcHierachy, SIGNAL(expanded(const QModelIndex &)), this,
+          SLOT(SlotItemExpanded(const QModelIndex &)));
+  connect(m_treeModules, SIGNAL(itemExpanded(QTreeWidgetItem *)), this,
+          SLOT(SlotModuleItemExpanded(QTreeWidgetItem *)));
+  connect(m_treeModules, SIGNAL(itemPressed(QTreeWidgetItem *, int)), this,
+          SLOT(SlotModuleItemPressed(QTreeWidgetItem *)));
+}
 
-  ui->m_tabWidget->removeTab(ui->m_tabWidget->indexOf(ui->tab_2));
+SourcesForm::~SourcesForm() {
+  if (m_scanThread.joinable()) {
+    m_scanThread.join();
+  }
+  delete m_hdlScanner;
+  delete ui;
 }
 
-SourcesForm::~SourcesForm() { delete ui; }
+QStringList SourcesForm::ProjectFiles() const {
+  QStringList listFiles;
+  foreach (auto strSet, m_projManager->getDesignFileSets()) {
+    listFiles.append(m_projManager->getDesignFiles(strSet));
+  }
+  foreach (auto strSet, m_projManager->getConstrFileSets()) {
+    listFiles.append(m_projManager->getConstrFiles(strSet));
+  }
+  foreach (auto strSet, m_projManager->getSimulationFileSets()) {
+    listFiles.append(m_projManager->getSimulationFiles(strSet));
+  }
+  for (auto &strFile : listFiles) {
+    strFile = m_modelSrcHierachy->ExpandFilePath(strFile);
+  }
+  listFiles.removeDuplicates();
+  return listFiles;
+}
+
+QString SourcesForm::ProjectCacheFile(const QString &strSuffix) const {
+  QString strPath = m_projManager->getProjectPath();
+  QString strName = m_projManager->getProjectName();
+  if (strPath.isEmpty() || strName.isEmpty()) {
+    return QString();
+  }
+  return strPath + "/" + strName + strSuffix;
+}
 
 void SourcesForm::TestOpenProject(int argc, const char *argv[]) {
   QTextStream out(stdout);
@@ -60,6 +117,7 @@ void SourcesForm::TestOpenProject(int argc, const char *argv[]) {
   fileInfo.setFile(QString(argv[2]));
   if (fileInfo.exists()) {
     m_projManager->StartProject(QString(argv[2]));
+    m_modelSrcHierachy->ResetModel();
     UpdateSrcHierachyTree();
   } else {
     out << " Warning : This file <" << QString(argv[2]) << "> is not exist! \n";
@@ -67,33 +125,21 @@ void SourcesForm::TestOpenProject(int argc, const char *argv[]) {
 }
 
 void SourcesForm::SetCurrentFileItem(const QString &strFileName) {
-  QString filename = strFileName.right(strFileName.size() -
-                                       (strFileName.lastIndexOf("/") + 1));
-  QList<QTreeWidgetItem *> listItem = m_treeSrcHierachy->findItems(
-      filename, Qt::MatchContains | Qt::MatchRecursive);
-  foreach (auto item, listItem) {
-    if (item == nullptr) {
-      continue;
-    }
-    QString strItemFileName = (item->data(0, Qt::UserRole)).toString();
-    QString strPath = m_projManager->getProjectPath();
-    if (!strFileName.compare(strItemFileName.replace("$OSRCDIR", strPath))) {
-      m_treeSrcHierachy->setCurrentItem(item);
-      break;
-    }
+  QModelIndex index = m_modelSrcHierachy->IndexFromFilePath(strFileName);
+  if (index.isValid()) {
+    m_treeSrcHierachy->setCurrentIndex(index);
   }
 }
 
-void SourcesForm::SlotItempressed(QTreeWidgetItem *item, int column) {
-  Q_UNUSED(column);
+void SourcesForm::SlotItempressed(const QModelIndex &index) {
   if (qApp->mouseButtons() == Qt::RightButton) {
     QMenu *menu = new QMenu(m_treeSrcHierachy);
     menu->addAction(m_actRefresh);
     menu->addSeparator();
 
     QString strPropertyRole =
-        (item->data(0, Qt::WhatsThisPropertyRole)).toString();
-    QString strName = item->text(0);
+        (index.data(Qt::WhatsThisPropertyRole)).toString();
+    QString strName = (index.data(Qt::DisplayRole)).toString();
 
     if (SRC_TREE_DESIGN_TOP_ITEM == strPropertyRole ||
         SRC_TREE_CONSTR_TOP_ITEM == strPropertyRole ||
@@ -135,10 +181,8 @@ void SourcesForm::SlotItempressed(QTreeWidgetItem *item, int column) {
   }
 }
 
-void SourcesForm::SlotItemDoubleClicked(QTreeWidgetItem *item, int column) {
-  Q_UNUSED(column);
-  QString strPropertyRole =
-      (item->data(0, Qt::WhatsThisPropertyRole)).toString();
+void SourcesForm::SlotItemDoubleClicked(const QModelIndex &index) {
+  QString strPropertyRole = (index.data(Qt::WhatsThisPropertyRole)).toString();
   if (SRC_TREE_DESIGN_FILE_ITEM == strPropertyRole ||
       SRC_TREE_SIM_FILE_ITEM == strPropertyRole ||
       SRC_TREE_CONSTR_FILE_ITEM == strPropertyRole) {
@@ -146,15 +190,21 @@ void SourcesForm::SlotItemDoubleClicked(QTreeWidgetItem *item, int column) {
   }
 }
 
+void SourcesForm::SlotItemExpanded(const QModelIndex &index) {
+  // The view would stop fetching this file set once another one is below it
+  if (!m_modelSrcHierachy->IsLastFileSet(index)) {
+    m_modelSrcHierachy->FetchAll(index);
+  }
+}
+
 void SourcesForm::SlotRefreshSourceTree() { UpdateSrcHierachyTree(); }
 
 void SourcesForm::SlotCreateDesign() {
-  QTreeWidgetItem *item = m_treeSrcHierachy->currentItem();
-  if (item == nullptr) {
+  QModelIndex index = m_treeSrcHierachy->currentIndex();
+  if (!index.isValid()) {
     return;
   }
-  QString strPropertyRole =
-      (item->data(0, Qt::WhatsThisPropertyRole)).toString();
+  QString strPropertyRole = (index.data(Qt::WhatsThisPropertyRole)).toString();
   QString strContent;
   if (SRC_TREE_DESIGN_TOP_ITEM == strPropertyRole) {
     strContent = tr("Enter Design Set Name");
@@ -194,14 +244,13 @@ void SourcesForm::SlotCreateDesign() {
 
 void SourcesForm::SlotAddFile() {
   int ret = 0;
-  QTreeWidgetItem *item = m_treeSrcHierachy->currentItem();
-  if (item == nullptr) {
+  QModelIndex index = m_treeSrcHierachy->currentIndex();
+  if (!index.isValid()) {
     return;
   }
 
-  QString strPropertyRole =
-      (item->data(0, Qt::WhatsThisPropertyRole)).toString();
-  QString strFielSetName = (item->data(0, Qt::UserRole)).toString();
+  QString strPropertyRole = (index.data(Qt::WhatsThisPropertyRole)).toString();
+  QString strFielSetName = (index.data(Qt::UserRole)).toString();
 
   AddFileDialog *addFileDialog = new AddFileDialog(this);
   if (SRC_TREE_DESIGN_SET_ITEM == strPropertyRole) {
@@ -253,23 +302,21 @@ void SourcesForm::SlotAddFile() {
 }
 
 void SourcesForm::SlotOpenFile() {
-  QTreeWidgetItem *item = m_treeSrcHierachy->currentItem();
-  if (item == nullptr) {
+  QModelIndex index = m_treeSrcHierachy->currentIndex();
+  if (!index.isValid()) {
     return;
   }
-  QString strFileName = (item->data(0, Qt::UserRole)).toString();
-
-  QString strPath = m_projManager->getProjectPath();
+  QString strFileName = (index.data(Qt::UserRole)).toString();
 
-  emit OpenFile(strFileName.replace("$OSRCDIR", strPath));
+  emit OpenFile(m_modelSrcHierachy->ExpandFilePath(strFileName));
 }
 
 void SourcesForm::SlotRemoveDesign() {
-  QTreeWidgetItem *item = m_treeSrcHierachy->currentItem();
-  if (item == nullptr) {
+  QModelIndex index = m_treeSrcHierachy->currentIndex();
+  if (!index.isValid()) {
     return;
   }
-  QString strName = item->text(0);
+  QString strName = (index.data(SourcesTreeModel::NameRole)).toString();
 
   int ret = m_projManager->deleteFileSet(strName);
   if (0 == ret) {
@@ -279,14 +326,12 @@ void SourcesForm::SlotRemoveDesign() {
 }
 
 void SourcesForm::SlotRemoveFile() {
-  QTreeWidgetItem *item = m_treeSrcHierachy->currentItem();
-  if (item == nullptr) {
+  QModelIndex index = m_treeSrcHierachy->currentIndex();
+  if (!index.isValid()) {
     return;
   }
-  QString strFileName = item->text(0);
-
-  QTreeWidgetItem *itemparent = item->parent();
-  QString strFileSetName = (itemparent->data(0, Qt::UserRole)).toString();
+  QString strFileName = (index.data(SourcesTreeModel::NameRole)).toString();
+  QString strFileSetName = (index.parent().data(Qt::UserRole)).toString();
 
   m_projManager->setCurrentFileSet(strFileSetName);
   int ret = m_projManager->deleteFile(strFileName);
@@ -297,14 +342,12 @@ void SourcesForm::SlotRemoveFile() {
 }
 
 void SourcesForm::SlotSetAsTop() {
-  QTreeWidgetItem *item = m_treeSrcHierachy->currentItem();
-  if (item == nullptr) {
+  QModelIndex index = m_treeSrcHierachy->currentIndex();
+  if (!index.isValid()) {
     return;
   }
-  QString strFileName = item->text(0);
-
-  QTreeWidgetItem *itemparent = item->parent();
-  QString strFileSetName = (itemparent->data(0, Qt::UserRole)).toString();
+  QString strFileName = (index.data(SourcesTreeModel::NameRole)).toString();
+  QString strFileSetName = (index.parent().data(Qt::UserRole)).toString();
 
   m_projManager->setCurrentFileSet(strFileSetName);
   int ret = m_projManager->setTopModule(strFileName);
@@ -315,14 +358,12 @@ void SourcesForm::SlotSetAsTop() {
 }
 
 void SourcesForm::SlotSetAsTarget() {
-  QTreeWidgetItem *item = m_treeSrcHierachy->currentItem();
-  if (item == nullptr) {
+  QModelIndex index = m_treeSrcHierachy->currentIndex();
+  if (!index.isValid()) {
     return;
   }
-  QString strFileName = item->text(0);
-
-  QTreeWidgetItem *itemparent = item->parent();
-  QString strFileSetName = (itemparent->data(0, Qt::UserRole)).toString();
+  QString strFileName = (index.data(SourcesTreeModel::NameRole)).toString();
+  QString strFileSetName = (index.parent().data(Qt::UserRole)).toString();
 
   m_projManager->setCurrentFileSet(strFileSetName);
   int ret = m_projManager->setTargetConstrs(strFileName);
@@ -334,14 +375,13 @@ void SourcesForm::SlotSetAsTarget() {
 
 void SourcesForm::SlotSetActive() {
   int ret = 0;
-  QTreeWidgetItem *item = m_treeSrcHierachy->currentItem();
-  if (item == nullptr) {
+  QModelIndex index = m_treeSrcHierachy->currentIndex();
+  if (!index.isValid()) {
     return;
   }
 
-  QString strPropertyRole =
-      (item->data(0, Qt::WhatsThisPropertyRole)).toString();
-  QString strName = item->text(0);
+  QString strPropertyRole = (index.data(Qt::WhatsThisPropertyRole)).toString();
+  QString strName = (index.data(SourcesTreeModel::NameRole)).toString();
 
   if (SRC_TREE_DESIGN_SET_ITEM == strPropertyRole) {
     ret = m_projManager->setDesignActive(strName);
@@ -390,6 +430,10 @@ void SourcesForm::CreateActions() {
 
   m_actMakeActive = new QAction(tr("Make Active"), m_treeSrcHierachy);
   connect(m_actMakeActive, SIGNAL(triggered()), this, SLOT(SlotSetActive()));
+
+  m_actSetModuleAsTop = new QAction(tr("Set As TopModule"), m_treeModules);
+  connect(m_actSetModuleAsTop, SIGNAL(triggered()), this,
+          SLOT(SlotSetModuleAsTop()));
 }
 
 void SourcesForm::UpdateSrcHierachyTree() {
@@ -397,117 +441,149 @@ void SourcesForm::UpdateSrcHierachyTree() {
     return;
   }
 
-  m_treeSrcHierachy->clear();
-
-  // Initialize design sources tree
-  QTreeWidgetItem *topitemDS = new QTreeWidgetItem(m_treeSrcHierachy);
-  topitemDS->setText(0, tr("Design Sources"));
-  topitemDS->setData(0, Qt::WhatsThisPropertyRole, SRC_TREE_DESIGN_TOP_ITEM);
-  m_treeSrcHierachy->addTopLevelItem(topitemDS);
+  // Only the changed rows are touched, expansion and selection survive
+  m_modelSrcHierachy->Refresh();
 
-  QStringList listDesFset = m_projManager->getDesignFileSets();
-  QString strDesAct = m_projManager->getDesignActiveFileSet();
-  foreach (auto str, listDesFset) {
-    QTreeWidgetItem *itemfolder = new QTreeWidgetItem(topitemDS);
-    if (str == strDesAct) {
-      itemfolder->setText(0, str + SRC_TREE_FLG_ACTIVE);
-    } else {
-      itemfolder->setText(0, str);
-    }
-    itemfolder->setData(0, Qt::UserRole, str);
-    itemfolder->setData(0, Qt::WhatsThisPropertyRole, SRC_TREE_DESIGN_SET_ITEM);
-
-    QStringList listDesFile = m_projManager->getDesignFiles(str);
-    QString strTop = m_projManager->getDesignTopModule(str);
-
-    foreach (auto strfile, listDesFile) {
-      QString filename =
-          strfile.right(strfile.size() - (strfile.lastIndexOf("/") + 1));
-      QTreeWidgetItem *itemf = new QTreeWidgetItem(itemfolder);
-      if (filename == strTop) {
-        itemf->setText(0, filename + SRC_TREE_FLG_TOP);
-      } else {
-        itemf->setText(0, filename);
-      }
-      itemf->setData(0, Qt::UserRole, strfile);
-      itemf->setData(0, Qt::WhatsThisPropertyRole, SRC_TREE_DESIGN_FILE_ITEM);
+  // expandAll() emits no expanded(), fetch the file sets it expanded
+  m_treeSrcHierachy->expandAll();
+  for (int category = 0; category < m_modelSrcHierachy->rowCount();
+       ++category) {
+    QModelIndex categoryIndex = m_modelSrcHierachy->index(category, 0);
+    for (int set = 0; set < m_modelSrcHierachy->rowCount(categoryIndex);
+         ++set) {
+      SlotItemExpanded(m_modelSrcHierachy->index(set, 0, categoryIndex));
     }
   }
 
-  // Initialize Constraints sources tree
-  QTreeWidgetItem *topitemCS = new QTreeWidgetItem(m_treeSrcHierachy);
-  m_treeSrcHierachy->addTopLevelItem(topitemCS);
-  topitemCS->setText(0, tr("Constraints"));
-  topitemCS->setData(0, Qt::WhatsThisPropertyRole, SRC_TREE_CONSTR_TOP_ITEM);
+  UpdateModuleHierarchy();
+  emit ProjectFilesChanged();
+}
 
-  QStringList listConstrFset = m_projManager->getConstrFileSets();
-  QString strConstrAct = m_projManager->getConstrActiveFileSet();
+void SourcesForm::UpdateModuleHierarchy() {
+  // One scan at a time, a change during the scan triggers another one
+  if (m_scanThread.joinable()) {
+    m_scanPending = true;
+    return;
+  }
 
-  foreach (auto str, listConstrFset) {
-    QTreeWidgetItem *itemfolder = new QTreeWidgetItem(topitemCS);
-    if (str == strConstrAct) {
-      itemfolder->setText(0, str + SRC_TREE_FLG_ACTIVE);
-    } else {
-      itemfolder->setText(0, str);
-    }
-    itemfolder->setData(0, Qt::UserRole, str);
-    itemfolder->setData(0, Qt::WhatsThisPropertyRole, SRC_TREE_CONSTR_SET_ITEM);
-
-    QStringList listConstrFile = m_projManager->getConstrFiles(str);
-    QString strTarget = m_projManager->getConstrTargetFile(str);
-
-    foreach (auto strfile, listConstrFile) {
-      QString filename =
-          strfile.right(strfile.size() - (strfile.lastIndexOf("/") + 1));
-      QTreeWidgetItem *itemf = new QTreeWidgetItem(itemfolder);
-      if (filename == strTarget) {
-        itemf->setText(0, filename + SRC_TREE_FLG_TARGET);
-      } else {
-        itemf->setText(0, filename);
-      }
-      itemf->setData(0, Qt::UserRole, strfile);
-      itemf->setData(0, Qt::WhatsThisPropertyRole, SRC_TREE_CONSTR_FILE_ITEM);
-    }
+  std::vector<std::string> files;
+  QString strActive = m_projManager->getDesignActiveFileSet();
+  foreach (auto strfile, m_projManager->getDesignFiles(strActive)) {
+    files.push_back(
+        m_modelSrcHierachy->ExpandFilePath(strfile).toStdString());
   }
 
-  // Initialize simulation sources tree
-  QTreeWidgetItem *topitemSS = new QTreeWidgetItem(m_treeSrcHierachy);
-  m_treeSrcHierachy->addTopLevelItem(topitemSS);
-  topitemSS->setText(0, tr("Simulation Sources"));
-  topitemSS->setData(0, Qt::WhatsThisPropertyRole, SRC_TREE_SIM_TOP_ITEM);
+  m_scanThread = std::thread([this, files]() {
+    m_hdlScanner->Scan(files);
+    QMetaObject::invokeMethod(this, "SlotModuleScanFinished",
+                              Qt::QueuedConnection);
+  });
+}
 
-  QStringList listSimFset = m_projManager->getSimulationFileSets();
-  QString strSimAct = m_projManager->getSimulationActiveFileSet();
+void SourcesForm::SlotModuleScanFinished() {
+  m_scanThread.join();
+  m_moduleHierarchy = m_hdlScanner->Hierarchy();
+  m_moduleDefinitions = m_hdlScanner->Definitions();
 
-  foreach (auto str, listSimFset) {
-    QTreeWidgetItem *itemfolder = new QTreeWidgetItem(topitemSS);
-    if (str == strSimAct) {
-      itemfolder->setText(0, str + SRC_TREE_FLG_ACTIVE);
-    } else {
-      itemfolder->setText(0, str);
-    }
-    itemfolder->setData(0, Qt::UserRole, str);
-    itemfolder->setData(0, Qt::WhatsThisPropertyRole, SRC_TREE_SIM_SET_ITEM);
-
-    QStringList listSimFile = m_projManager->getSimulationFiles(str);
-    QString strTop = m_projManager->getSimulationTopModule(str);
-
-    foreach (auto strfile, listSimFile) {
-      QString filename =
-          strfile.right(strfile.size() - (strfile.lastIndexOf("/") + 1));
-      QTreeWidgetItem *itemf = new QTreeWidgetItem(itemfolder);
-      if (filename == strTop) {
-        itemf->setText(0, filename + SRC_TREE_FLG_TOP);
-      } else {
-        itemf->setText(0, filename);
-      }
-      itemf->setData(0, Qt::UserRole, strfile);
-      itemf->setData(0, Qt::WhatsThisPropertyRole, SRC_TREE_SIM_FILE_ITEM);
-    }
+  m_treeModules->clear();
+  for (const auto &top : m_hdlScanner->TopCandidates()) {
+    AddModuleItem(nullptr, QString::fromStdString(top));
   }
+  ProposeTopModule();
 
-  m_treeSrcHierachy->setHeaderHidden(true);
-  m_treeSrcHierachy->expandAll();
+  if (m_scanPending) {
+    m_scanPending = false;
+    UpdateModuleHierarchy();
+  }
+}
+
+void SourcesForm::SlotModuleItemPressed(QTreeWidgetItem *item) {
+  // Only modules nobody instantiates can be the top
+  if (qApp->mouseButtons() == Qt::RightButton && nullptr == item->parent()) {
+    QMenu *menu = new QMenu(m_treeModules);
+    menu->addAction(m_actSetModuleAsTop);
+    QPoint p = QCursor::pos();
+    menu->exec(QPoint(p.rx(), p.ry() + 3));
+  }
+}
+
+void SourcesForm::SlotSetModuleAsTop() {
+  QTreeWidgetItem *item = m_treeModules->currentItem();
+  if (nullptr == item) {
+    return;
+  }
+  auto def = m_moduleDefinitions.find(
+      item->data(0, Qt::UserRole).toString().toStdString());
+  if (def == m_moduleDefinitions.end()) {
+    return;
+  }
+
+  // The project records the top as the file defining it
+  QString strFile = QString::fromStdString(def->second);
+  QString strFileName = strFile.right(strFile.size() -
+                                      (strFile.lastIndexOf("/") + 1));
+  m_projManager->setCurrentFileSet(m_projManager->getDesignActiveFileSet());
+  if (0 == m_projManager->setTopModule(strFileName)) {
+    UpdateSrcHierachyTree();
+    m_projManager->FinishedProject();
+  }
+}
+
+void SourcesForm::SlotModuleItemExpanded(QTreeWidgetItem *item) {
+  // Children are created on first expansion, the hierarchy can be huge
+  if (item->childCount() != 1 ||
+      !item->child(0)->data(0, Qt::UserRole).isNull()) {
+    return;
+  }
+  delete item->takeChild(0);
+
+  std::string module = item->data(0, Qt::UserRole).toString().toStdString();
+  auto itr = m_moduleHierarchy.find(module);
+  if (itr == m_moduleHierarchy.end()) {
+    return;
+  }
+  for (const auto &child : itr->second) {
+    AddModuleItem(item, QString::fromStdString(child));
+  }
+}
+
+void SourcesForm::AddModuleItem(QTreeWidgetItem *parent,
+                                const QString &strModule) {
+  QTreeWidgetItem *item = parent ? new QTreeWidgetItem(parent)
+                                 : new QTreeWidgetItem(m_treeModules);
+  item->setText(0, strModule);
+  item->setData(0, Qt::UserRole, strModule);
+
+  auto def = m_moduleDefinitions.find(strModule.toStdString());
+  if (def != m_moduleDefinitions.end()) {
+    item->setToolTip(0, QString::fromStdString(def->second));
+  }
+
+  auto itr = m_moduleHierarchy.find(strModule.toStdString());
+  if (itr != m_moduleHierarchy.end() && !itr->second.empty()) {
+    // Placeholder so the item can be expanded
+    new QTreeWidgetItem(item);
+  }
+}
+
+void SourcesForm::ProposeTopModule() {
+  QString strActive = m_projManager->getDesignActiveFileSet();
+  std::string top = m_hdlScanner->ProposedTop();
+  if (top.empty() || !m_projManager->getDesignTopModule(strActive).isEmpty()) {
+    return;
+  }
+
+  // Only highlighted, the project changes when the user sets the top
+  QTreeWidgetItem *item = m_treeModules->topLevelItem(0);
+  if (nullptr == item || item->text(0).toStdString() != top) {
+    return;
+  }
+  QFont font = item->font(0);
+  font.setBold(true);
+  item->setFont(0, font);
+  item->setToolTip(0, tr("Proposed top module, defined in %1")
+                          .arg(QString::fromStdString(
+                              m_moduleDefinitions.at(top))));
 }
 
 void SourcesForm::TclHelper() {
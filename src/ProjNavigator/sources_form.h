@@ -1,8 +1,13 @@
 #ifndef SOURCES_FORM_H
 #define SOURCES_FORM_H
 #include <QAction>
+#include <QTreeView>
 #include <QTreeWidget>
 #include <QWidget>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
 
 #include "NewProject/ProjectManager/project_manager.h"
 #include "add_file_dialog.h"
@@ -28,6 +33,9 @@ class SourcesForm;
 
 namespace FOEDAG {
 
+class SourcesTreeModel;
+class HdlScanner;
+
 class SourcesForm : public QWidget {
   Q_OBJECT
 
@@ -35,18 +43,26 @@ class SourcesForm : public QWidget {
   explicit SourcesForm(QString strprojpath, QWidget* parent = nullptr);
   ~SourcesForm();
 
+  // Absolute paths of the files of all file sets
+  QStringList ProjectFiles() const;
+  // Cache file in the project directory, empty if no project is open
+  QString ProjectCacheFile(const QString& strSuffix) const;
+
   /*for test*/
   void TestOpenProject(int argc, const char* argv[]);
 
  signals:
   void OpenFile(QString);
+  // Files were added to or removed from the project
+  void ProjectFilesChanged();
 
  public slots:
   void SetCurrentFileItem(const QString& strFileName);
 
  private slots:
-  void SlotItempressed(QTreeWidgetItem* item, int column);
-  void SlotItemDoubleClicked(QTreeWidgetItem* item, int column);
+  void SlotItempressed(const QModelIndex& index);
+  void SlotItemDoubleClicked(const QModelIndex& index);
+  void SlotItemExpanded(const QModelIndex& index);
 
   void SlotRefreshSourceTree();
   void SlotCreateDesign();
@@ -58,10 +74,17 @@ class SourcesForm : public QWidget {
   void SlotSetAsTarget();
   void SlotSetActive();
 
+  void SlotModuleScanFinished();
+  void SlotModuleItemExpanded(QTreeWidgetItem* item);
+  void SlotModuleItemPressed(QTreeWidgetItem* item);
+  void SlotSetModuleAsTop();
+
  private:
   Ui::SourcesForm* ui;
 
-  QTreeWidget* m_treeSrcHierachy;
+  QTreeView* m_treeSrcHierachy;
+  SourcesTreeModel* m_modelSrcHierachy;
+  QTreeWidget* m_treeModules;
   QAction* m_actRefresh;
   QAction* m_actCreateDesign;
   QAction* m_actAddFile;
@@ -71,11 +94,22 @@ class SourcesForm : public QWidget {
   QAction* m_actSetAsTop;
   QAction* m_actSetAsTarget;
   QAction* m_actMakeActive;
+  QAction* m_actSetModuleAsTop;
 
   ProjectManager* m_projManager;
 
+  HdlScanner* m_hdlScanner;
+  std::thread m_scanThread;
+  bool m_scanPending{false};
+  // Copies of the last scan, the scanner is busy in the next one
+  std::map<std::string, std::set<std::string>> m_moduleHierarchy;
+  std::map<std::string, std::string> m_moduleDefinitions;
+
   void CreateActions();
   void UpdateSrcHierachyTree();
+  void UpdateModuleHierarchy();
+  void AddModuleItem(QTreeWidgetItem* parent, const QString& strModule);
+  void ProposeTopModule();
 
   void TclHelper();
   bool TclCheckType(QString strType);
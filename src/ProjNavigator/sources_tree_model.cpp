@@ -0,0 +1,474 @@
+#include "sources_tree_model.h"
+
+#include "NewProject/ProjectManager/project_manager.h"
+#include "sources_form.h"
+
+using namespace FOEDAG;
+
+SourcesTreeModel::SourcesTreeModel(ProjectManager *projManager,
+                                   QObject *parent)
+    : QAbstractItemModel(parent), m_projManager(projManager) {
+  m_root = new Node;
+  buildCategories();
+}
+
+SourcesTreeModel::~SourcesTreeModel() { deleteNode(m_root); }
+
+QModelIndex SourcesTreeModel::index(int row, int column,
+                                    const QModelIndex &parent) const {
+  Node *parentNode = nodeFromIndex(parent);
+  if (column != 0 || row < 0 || row >= parentNode->m_children.size()) {
+    return QModelIndex();
+  }
+  return createIndex(row, column, parentNode->m_children.at(row));
+}
+
+QModelIndex SourcesTreeModel::parent(const QModelIndex &child) const {
+  if (!child.isValid()) {
+    return QModelIndex();
+  }
+  Node *node = nodeFromIndex(child);
+  return indexFromNode(node->m_parent);
+}
+
+int SourcesTreeModel::rowCount(const QModelIndex &parent) const {
+  if (parent.column() > 0) {
+    return 0;
+  }
+  return nodeFromIndex(parent)->m_children.size();
+}
+
+int SourcesTreeModel::columnCount(const QModelIndex &parent) const {
+  Q_UNUSED(parent);
+  return 1;
+}
+
+QVariant SourcesTreeModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid()) {
+    return QVariant();
+  }
+  Node *node = nodeFromIndex(index);
+  switch (role) {
+    case Qt::DisplayRole:
+      return node->m_text;
+    case Qt::WhatsThisPropertyRole:
+      return node->m_type;
+    case Qt::UserRole:
+      // File sets keep their name, files keep the path from the project
+      return node->m_path.isEmpty() ? node->m_key : node->m_path;
+    case NameRole:
+      return node->m_key;
+    default:
+      break;
+  }
+  return QVariant();
+}
+
+bool SourcesTreeModel::hasChildren(const QModelIndex &parent) const {
+  Node *node = nodeFromIndex(parent);
+  if (!node->m_children.isEmpty()) {
+    return true;
+  }
+  // Do not populate a file set just to know if it needs an expander
+  if (node->m_parent && node->m_parent->m_parent == m_root) {
+    return fileSetFileCount(node) > 0;
+  }
+  return false;
+}
+
+bool SourcesTreeModel::canFetchMore(const QModelIndex &parent) const {
+  if (!parent.isValid()) {
+    return false;
+  }
+  Node *node = nodeFromIndex(parent);
+  if (node->m_parent == nullptr || node->m_parent->m_parent != m_root) {
+    return false;
+  }
+  return node->m_children.size() < fileSetFileCount(node);
+}
+
+void SourcesTreeModel::fetchMore(const QModelIndex &parent) {
+  Node *fileSet = nodeFromIndex(parent);
+  ProjectFileSet *proFileSet =
+      Project::Instance()->getProjectFileset(fileSet->m_key);
+  if (nullptr == proFileSet) {
+    return;
+  }
+
+  // Children are always a sorted prefix of the file map
+  const QMap<QString, QString> mapFiles = proFileSet->getMapFiles();
+  auto iter = fileSet->m_children.isEmpty()
+                  ? mapFiles.constBegin()
+                  : mapFiles.upperBound(fileSet->m_children.last()->m_key);
+  int count = 0;
+  for (auto it = iter; it != mapFiles.constEnd() && count < FETCH_BATCH;
+       ++it) {
+    ++count;
+  }
+  if (0 == count) {
+    fileSet->m_fetchedAll = true;
+    return;
+  }
+
+  int first = fileSet->m_children.size();
+  beginInsertRows(parent, first, first + count - 1);
+  for (int i = 0; i < count; ++i, ++iter) {
+    appendChild(fileSet, createFileNode(fileSet, iter.key(), iter.value()));
+  }
+  fileSet->m_fetchedAll = (iter == mapFiles.constEnd());
+  endInsertRows();
+}
+
+void SourcesTreeModel::FetchAll(const QModelIndex &parent) {
+  Node *node = nodeFromIndex(parent);
+  while (canFetchMore(parent)) {
+    int rows = node->m_children.size();
+    fetchMore(parent);
+    if (node->m_children.size() == rows) break;
+  }
+}
+
+bool SourcesTreeModel::IsLastFileSet(const QModelIndex &index) const {
+  Node *node = nodeFromIndex(index);
+  if (node->m_parent == nullptr || node->m_parent->m_parent != m_root) {
+    return false;
+  }
+  Node *category = node->m_parent;
+  if (node->m_row != category->m_children.size() - 1) {
+    return false;
+  }
+  for (int row = category->m_row + 1; row < m_root->m_children.size();
+       ++row) {
+    if (!m_root->m_children.at(row)->m_children.isEmpty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SourcesTreeModel::ResetModel() {
+  beginResetModel();
+  for (auto child : m_root->m_children) {
+    deleteNode(child);
+  }
+  m_root->m_children.clear();
+  m_pathToNode.clear();
+  buildCategories();
+  endResetModel();
+}
+
+void SourcesTreeModel::Refresh() {
+  for (auto category : m_root->m_children) {
+    refreshCategory(category);
+  }
+}
+
+QModelIndex SourcesTreeModel::IndexFromFilePath(const QString &strFilePath) {
+  auto iter = m_pathToNode.find(strFilePath);
+  if (iter != m_pathToNode.end()) {
+    return indexFromNode(iter.value());
+  }
+
+  // The file may live in a file set that was not fetched yet. The project
+  // keys files by name, so only one lookup per file set is needed.
+  QString strFileName = strFilePath.mid(strFilePath.lastIndexOf("/") + 1);
+  for (auto category : m_root->m_children) {
+    for (auto fileSet : category->m_children) {
+      ProjectFileSet *proFileSet =
+          Project::Instance()->getProjectFileset(fileSet->m_key);
+      if (nullptr == proFileSet ||
+          ExpandFilePath(proFileSet->getFilePath(strFileName)) !=
+              strFilePath) {
+        continue;
+      }
+      QModelIndex fileSetIndex = indexFromNode(fileSet);
+      while (!m_pathToNode.contains(strFilePath) &&
+             canFetchMore(fileSetIndex)) {
+        fetchMore(fileSetIndex);
+      }
+      iter = m_pathToNode.find(strFilePath);
+      if (iter != m_pathToNode.end()) {
+        return indexFromNode(iter.value());
+      }
+    }
+  }
+  return QModelIndex();
+}
+
+QString SourcesTreeModel::ExpandFilePath(const QString &strFilePath) const {
+  QString strPath = strFilePath;
+  return strPath.replace("$OSRCDIR", m_projManager->getProjectPath());
+}
+
+SourcesTreeModel::Node *SourcesTreeModel::nodeFromIndex(
+    const QModelIndex &index) const {
+  if (index.isValid()) {
+    return static_cast<Node *>(index.internalPointer());
+  }
+  return m_root;
+}
+
+QModelIndex SourcesTreeModel::indexFromNode(Node *node) const {
+  if (nullptr == node || node == m_root) {
+    return QModelIndex();
+  }
+  return createIndex(rowOfNode(node), 0, node);
+}
+
+int SourcesTreeModel::rowOfNode(const Node *node) const {
+  if (nullptr == node->m_parent) {
+    return 0;
+  }
+  return node->m_row;
+}
+
+void SourcesTreeModel::appendChild(Node *parent, Node *child) {
+  child->m_row = parent->m_children.size();
+  parent->m_children.append(child);
+}
+
+void SourcesTreeModel::insertChild(Node *parent, int row, Node *child) {
+  parent->m_children.insert(row, child);
+  renumberChildren(parent, row);
+}
+
+void SourcesTreeModel::removeChild(Node *parent, int row) {
+  parent->m_children.remove(row);
+  renumberChildren(parent, row);
+}
+
+void SourcesTreeModel::renumberChildren(Node *parent, int first) {
+  for (int row = first; row < parent->m_children.size(); ++row) {
+    parent->m_children[row]->m_row = row;
+  }
+}
+
+void SourcesTreeModel::buildCategories() {
+  const QList<QPair<QString, QString>> categories = {
+      {tr("Design Sources"), SRC_TREE_DESIGN_TOP_ITEM},
+      {tr("Constraints"), SRC_TREE_CONSTR_TOP_ITEM},
+      {tr("Simulation Sources"), SRC_TREE_SIM_TOP_ITEM}};
+  for (const auto &category : categories) {
+    Node *node = new Node;
+    node->m_text = category.first;
+    node->m_type = category.second;
+    node->m_parent = m_root;
+    appendChild(m_root, node);
+
+    QString strSetType = categorySetType(node);
+    QMap<QString, ProjectFileSet *> tmpFileSetMap =
+        Project::Instance()->getMapProjectFileset();
+    for (auto iter = tmpFileSetMap.begin(); iter != tmpFileSetMap.end();
+         ++iter) {
+      if (iter.value() && strSetType == iter.value()->getSetType()) {
+        Node *fileSet = new Node;
+        fileSet->m_key = iter.key();
+        fileSet->m_type = categorySetItemType(node);
+        fileSet->m_text = fileSetText(node, iter.key());
+        fileSet->m_parent = node;
+        appendChild(node, fileSet);
+      }
+    }
+  }
+}
+
+void SourcesTreeModel::deleteNode(Node *node) {
+  for (auto child : node->m_children) {
+    deleteNode(child);
+  }
+  if (!node->m_path.isEmpty()) {
+    auto iter = m_pathToNode.find(ExpandFilePath(node->m_path));
+    if (iter != m_pathToNode.end() && iter.value() == node) {
+      m_pathToNode.erase(iter);
+    }
+  }
+  delete node;
+}
+
+QString SourcesTreeModel::categorySetType(const Node *category) const {
+  if (SRC_TREE_DESIGN_TOP_ITEM == category->m_type) {
+    return PROJECT_FILE_TYPE_DS;
+  } else if (SRC_TREE_CONSTR_TOP_ITEM == category->m_type) {
+    return PROJECT_FILE_TYPE_CS;
+  }
+  return PROJECT_FILE_TYPE_SS;
+}
+
+QString SourcesTreeModel::categorySetItemType(const Node *category) const {
+  if (SRC_TREE_DESIGN_TOP_ITEM == category->m_type) {
+    return SRC_TREE_DESIGN_SET_ITEM;
+  } else if (SRC_TREE_CONSTR_TOP_ITEM == category->m_type) {
+    return SRC_TREE_CONSTR_SET_ITEM;
+  }
+  return SRC_TREE_SIM_SET_ITEM;
+}
+
+QString SourcesTreeModel::categoryActiveSet(const Node *category) const {
+  if (SRC_TREE_DESIGN_TOP_ITEM == category->m_type) {
+    return m_projManager->getDesignActiveFileSet();
+  } else if (SRC_TREE_CONSTR_TOP_ITEM == category->m_type) {
+    return m_projManager->getConstrActiveFileSet();
+  }
+  return m_projManager->getSimulationActiveFileSet();
+}
+
+QString SourcesTreeModel::fileSetFlaggedFile(const Node *fileSet) const {
+  if (SRC_TREE_DESIGN_SET_ITEM == fileSet->m_type) {
+    return m_projManager->getDesignTopModule(fileSet->m_key);
+  } else if (SRC_TREE_CONSTR_SET_ITEM == fileSet->m_type) {
+    return m_projManager->getConstrTargetFile(fileSet->m_key);
+  }
+  return m_projManager->getSimulationTopModule(fileSet->m_key);
+}
+
+QString SourcesTreeModel::fileSetFileType(const Node *fileSet) const {
+  if (SRC_TREE_DESIGN_SET_ITEM == fileSet->m_type) {
+    return SRC_TREE_DESIGN_FILE_ITEM;
+  } else if (SRC_TREE_CONSTR_SET_ITEM == fileSet->m_type) {
+    return SRC_TREE_CONSTR_FILE_ITEM;
+  }
+  return SRC_TREE_SIM_FILE_ITEM;
+}
+
+QString SourcesTreeModel::fileSetText(const Node *category,
+                                      const QString &strSetName) const {
+  if (strSetName == categoryActiveSet(category)) {
+    return strSetName + SRC_TREE_FLG_ACTIVE;
+  }
+  return strSetName;
+}
+
+QString SourcesTreeModel::fileText(const Node *fileSet,
+                                   const QString &strFileName) const {
+  if (strFileName == fileSetFlaggedFile(fileSet)) {
+    return strFileName + ((SRC_TREE_CONSTR_SET_ITEM == fileSet->m_type)
+                              ? SRC_TREE_FLG_TARGET
+                              : SRC_TREE_FLG_TOP);
+  }
+  return strFileName;
+}
+
+int SourcesTreeModel::fileSetFileCount(const Node *fileSet) const {
+  ProjectFileSet *proFileSet =
+      Project::Instance()->getProjectFileset(fileSet->m_key);
+  return proFileSet ? proFileSet->getMapFiles().size() : 0;
+}
+
+SourcesTreeModel::Node *SourcesTreeModel::createFileNode(
+    Node *fileSet, const QString &strFileName, const QString &strFilePath) {
+  Node *node = new Node;
+  node->m_key = strFileName;
+  node->m_path = strFilePath;
+  node->m_type = fileSetFileType(fileSet);
+  node->m_text = fileText(fileSet, strFileName);
+  node->m_parent = fileSet;
+  QString strExpanded = ExpandFilePath(strFilePath);
+  if (!m_pathToNode.contains(strExpanded)) {
+    m_pathToNode.insert(strExpanded, node);
+  }
+  return node;
+}
+
+void SourcesTreeModel::refreshCategory(Node *category) {
+  QStringList listSets;
+  QString strSetType = categorySetType(category);
+  QMap<QString, ProjectFileSet *> tmpFileSetMap =
+      Project::Instance()->getMapProjectFileset();
+  for (auto iter = tmpFileSetMap.begin(); iter != tmpFileSetMap.end();
+       ++iter) {
+    if (iter.value() && strSetType == iter.value()->getSetType()) {
+      listSets.append(iter.key());
+    }
+  }
+
+  // Both lists are sorted by set name, merge them
+  QModelIndex parentIndex = indexFromNode(category);
+  QString strSetItem = categorySetItemType(category);
+  int row = 0;
+  int i = 0;
+  while (row < category->m_children.size() || i < listSets.size()) {
+    Node *child = (row < category->m_children.size())
+                      ? category->m_children[row]
+                      : nullptr;
+    if (i >= listSets.size() || (child && child->m_key < listSets[i])) {
+      beginRemoveRows(parentIndex, row, row);
+      removeChild(category, row);
+      deleteNode(child);
+      endRemoveRows();
+    } else if (nullptr == child || listSets[i] < child->m_key) {
+      Node *fileSet = new Node;
+      fileSet->m_key = listSets[i];
+      fileSet->m_type = strSetItem;
+      fileSet->m_text = fileSetText(category, listSets[i]);
+      fileSet->m_parent = category;
+      beginInsertRows(parentIndex, row, row);
+      insertChild(category, row, fileSet);
+      endInsertRows();
+      ++row;
+      ++i;
+    } else {
+      updateText(child, fileSetText(category, listSets[i]));
+      refreshFileSet(child);
+      ++row;
+      ++i;
+    }
+  }
+}
+
+void SourcesTreeModel::refreshFileSet(Node *fileSet) {
+  if (fileSet->m_children.isEmpty() && !fileSet->m_fetchedAll) {
+    // Nothing fetched yet, the view will ask when it needs the files
+    return;
+  }
+  ProjectFileSet *proFileSet =
+      Project::Instance()->getProjectFileset(fileSet->m_key);
+  if (nullptr == proFileSet) {
+    return;
+  }
+
+  const QMap<QString, QString> mapFiles = proFileSet->getMapFiles();
+  // A partially fetched set only keeps its fetched prefix in sync, the rest
+  // is picked up by fetchMore.
+  QModelIndex parentIndex = indexFromNode(fileSet);
+  int row = 0;
+  auto iter = mapFiles.constBegin();
+  auto end = fileSet->m_fetchedAll
+                 ? mapFiles.constEnd()
+                 : mapFiles.upperBound(fileSet->m_children.last()->m_key);
+  while (row < fileSet->m_children.size() || iter != end) {
+    Node *child = (row < fileSet->m_children.size())
+                      ? fileSet->m_children[row]
+                      : nullptr;
+    if (iter == end || (child && child->m_key < iter.key())) {
+      beginRemoveRows(parentIndex, row, row);
+      removeChild(fileSet, row);
+      deleteNode(child);
+      endRemoveRows();
+    } else if (nullptr == child || iter.key() < child->m_key) {
+      beginInsertRows(parentIndex, row, row);
+      insertChild(fileSet, row,
+                  createFileNode(fileSet, iter.key(), iter.value()));
+      endInsertRows();
+      ++row;
+      ++iter;
+    } else {
+      if (child->m_path != iter.value()) {
+        m_pathToNode.remove(ExpandFilePath(child->m_path));
+        child->m_path = iter.value();
+        m_pathToNode.insert(ExpandFilePath(child->m_path), child);
+      }
+      updateText(child, fileText(fileSet, child->m_key));
+      ++row;
+      ++iter;
+    }
+  }
+}
+
+void SourcesTreeModel::updateText(Node *node, const QString &strText) {
+  if (node->m_text == strText) {
+    return;
+  }
+  node->m_text = strText;
+  QModelIndex idx = indexFromNode(node);
+  emit dataChanged(idx, idx, {Qt::DisplayRole});
+}
@@ -0,0 +1,106 @@
+#ifndef SOURCES_TREE_MODEL_H
+#define SOURCES_TREE_MODEL_H
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QVector>
+
+namespace FOEDAG {
+
+class ProjectManager;
+
+// Navigator model backed directly by the project data. Categories and file
+// sets are created on demand, the files of a file set are fetched in batches
+// as the view asks for them. Refresh() diffs the model against the project and
+// only emits the rows that were really inserted, removed or renamed.
+class SourcesTreeModel : public QAbstractItemModel {
+  Q_OBJECT
+
+ public:
+  enum Roles {
+    // Set name for file sets, file name for files. No (Active)/(Top) flags.
+    NameRole = Qt::UserRole + 1,
+  };
+
+  explicit SourcesTreeModel(ProjectManager *projManager,
+                            QObject *parent = nullptr);
+  ~SourcesTreeModel();
+
+  QModelIndex index(int row, int column,
+                    const QModelIndex &parent = QModelIndex()) const override;
+  QModelIndex parent(const QModelIndex &child) const override;
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const override;
+  bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+  bool canFetchMore(const QModelIndex &parent) const override;
+  void fetchMore(const QModelIndex &parent) override;
+
+  // Drop everything and start again from the project (new project opened).
+  void ResetModel();
+  // Synchronize with the project, emitting only the changed rows.
+  void Refresh();
+
+  // Fetches the remaining files of a file set.
+  void FetchAll(const QModelIndex &parent);
+  // The view asks canFetchMore() only for the ancestors of its last row, so
+  // the last file set of the tree is the only one it can fetch lazily.
+  bool IsLastFileSet(const QModelIndex &index) const;
+
+  // strFilePath is the absolute path ($OSRCDIR already expanded).
+  QModelIndex IndexFromFilePath(const QString &strFilePath);
+
+  QString ExpandFilePath(const QString &strFilePath) const;
+
+ private:
+  struct Node {
+    QString m_key;   // set name or file name
+    QString m_path;  // file path as stored in the project (files only)
+    QString m_text;  // display text including flags
+    QString m_type;  // SRC_TREE_* property role
+    bool m_fetchedAll{false};  // file sets only
+    int m_row{0};              // index in m_parent->m_children
+    Node *m_parent{nullptr};
+    QVector<Node *> m_children;
+  };
+
+  ProjectManager *m_projManager;
+  Node *m_root;
+  QHash<QString, Node *> m_pathToNode;
+
+  static constexpr int FETCH_BATCH{256};
+
+  Node *nodeFromIndex(const QModelIndex &index) const;
+  QModelIndex indexFromNode(Node *node) const;
+  int rowOfNode(const Node *node) const;
+
+  // Keep m_row of the children in sync with their position
+  void appendChild(Node *parent, Node *child);
+  void insertChild(Node *parent, int row, Node *child);
+  void removeChild(Node *parent, int row);
+  void renumberChildren(Node *parent, int first);
+
+  void buildCategories();
+  void deleteNode(Node *node);
+
+  QString categorySetType(const Node *category) const;
+  QString categorySetItemType(const Node *category) const;
+  QString categoryActiveSet(const Node *category) const;
+  QString fileSetFlaggedFile(const Node *fileSet) const;
+  QString fileSetFileType(const Node *fileSet) const;
+  QString fileSetText(const Node *category, const QString &strSetName) const;
+  QString fileText(const Node *fileSet, const QString &strFileName) const;
+
+  int fileSetFileCount(const Node *fileSet) const;
+  Node *createFileNode(Node *fileSet, const QString &strFileName,
+                       const QString &strFilePath);
+
+  void refreshCategory(Node *category);
+  void refreshFileSet(Node *fileSet);
+  void updateText(Node *node, const QString &strText);
+};
+
+}  // namespace FOEDAG
+
+#endif  // SOURCES_TREE_MODEL_H
@@ -0,0 +1,89 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ProjNavigator/sources_tree_model.h"
+
+#include <QApplication>
+#include <QTemporaryDir>
+#include <QTreeView>
+
+#include "NewProject/ProjectManager/project_generator.h"
+#include "NewProject/ProjectManager/project_manager.h"
+#include "ProjNavigator/sources_form.h"
+#include "gtest/gtest.h"
+
+namespace FOEDAG {
+namespace {
+
+class SourcesTreeModelTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+      qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    static int argc = 1;
+    static char name[] = "sources_tree_model_test";
+    static char *argv[] = {name, nullptr};
+    if (QApplication::instance() == nullptr) new QApplication(argc, argv);
+  }
+};
+
+// Each file set has several fetch batches, the first one is not the last
+// file set of the tree so the view never asks it for more rows
+TEST_F(SourcesTreeModelTest, TwoLargeFileSets) {
+  QTemporaryDir dir;
+  ProjectManager manager;
+  ProjectGenerator generator(&manager);
+  ProjectGenerator::Options options;
+  options.name = "large";
+  options.path = dir.path() + "/large";
+  options.files = 2000;
+  options.filesets = 2;
+  ASSERT_EQ(generator.Generate(options), 0);
+
+  SourcesForm form(generator.ProjectFile());
+  QTreeView *view = nullptr;
+  SourcesTreeModel *model = nullptr;
+  for (QTreeView *child : form.findChildren<QTreeView *>()) {
+    model = qobject_cast<SourcesTreeModel *>(child->model());
+    if (model != nullptr) {
+      view = child;
+      break;
+    }
+  }
+  ASSERT_NE(model, nullptr);
+
+  QModelIndex design = model->index(0, 0);
+  ASSERT_EQ(model->rowCount(design), 2);
+  for (int set = 0; set < 2; set++) {
+    QModelIndex fileSet = model->index(set, 0, design);
+    EXPECT_TRUE(view->isExpanded(fileSet));
+    if (model->IsLastFileSet(fileSet)) {
+      EXPECT_TRUE(model->rowCount(fileSet) == 1000 ||
+                  model->canFetchMore(fileSet));
+    } else {
+      EXPECT_EQ(model->rowCount(fileSet), 1000);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace FOEDAG
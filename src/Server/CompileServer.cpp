@@ -0,0 +1,329 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "Server/CompileServer.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <csignal>
+#endif
+
+extern "C" {
+#include <tcl.h>
+}
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+
+#include "Main/CommandLine.h"
+#include "Main/registerCoreCommands.h"
+#include "Server/ServerProtocol.h"
+#include "Tcl/TclInterpreter.h"
+
+using namespace FOEDAG;
+
+namespace {
+
+// Instance data of the stdout/stderr channels of a client thread
+struct ClientOutput {
+  int fd;
+  const char* type;
+};
+
+int channelClose(ClientData instanceData, Tcl_Interp* interp) {
+  delete static_cast<ClientOutput*>(instanceData);
+  return 0;
+}
+
+int channelInput(ClientData instanceData, char* buf, int toRead,
+                 int* errorCodePtr) {
+  return 0;
+}
+
+int channelOutput(ClientData instanceData, const char* buf, int toWrite,
+                  int* errorCodePtr) {
+  ClientOutput* output = static_cast<ClientOutput*>(instanceData);
+  if (!ServerProtocol::Write(output->fd, output->type,
+                             std::string(buf, toWrite))) {
+    *errorCodePtr = EPIPE;
+    return -1;
+  }
+  return toWrite;
+}
+
+void channelWatch(ClientData instanceData, int mask) {}
+
+int channelHandle(ClientData instanceData, int direction,
+                  ClientData* handlePtr) {
+  return TCL_ERROR;
+}
+
+Tcl_ChannelType clientChannelType = {
+    "foedag_client", TCL_CHANNEL_VERSION_5, channelClose, channelInput,
+    channelOutput,   nullptr,               nullptr,      nullptr,
+    channelWatch,    channelHandle,         nullptr,      nullptr,
+    nullptr,         nullptr,               nullptr,      nullptr,
+    nullptr};
+
+// std::ostream output of the client commands (compiler messages), sent as
+// frames at each line
+class FrameBuffer : public std::streambuf {
+ public:
+  FrameBuffer(int fd, const char* type) : m_fd(fd), m_type(type) {}
+
+ protected:
+  int overflow(int c) override {
+    if (c == traits_type::eof()) return traits_type::not_eof(c);
+    m_buffer += traits_type::to_char_type(c);
+    if (c == '\n') sync();
+    return c;
+  }
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    m_buffer.append(s, n);
+    if (std::memchr(s, '\n', n)) sync();
+    return n;
+  }
+  int sync() override {
+    if (m_buffer.empty()) return 0;
+    bool written = ServerProtocol::Write(m_fd, m_type, m_buffer);
+    m_buffer.clear();
+    return written ? 0 : -1;
+  }
+
+ private:
+  int m_fd;
+  const char* m_type;
+  std::string m_buffer;
+};
+
+struct ClientSession {
+  CompileServer* server;
+  bool exited = false;
+  int exitCode = 0;
+};
+
+// exit ?code? and tcl_exit end the connection. The error unwinds the script,
+// the session ends even if it is caught.
+int clientExit(ClientData clientData, Tcl_Interp* interp, int argc,
+               const char* argv[]) {
+  ClientSession* session = static_cast<ClientSession*>(clientData);
+  int code = 0;
+  if (argc > 2 || (argc == 2 && Tcl_GetInt(interp, argv[1], &code) != TCL_OK)) {
+    Tcl_ResetResult(interp);
+    Tcl_AppendResult(interp, "Usage: exit ?code?", (char*)NULL);
+    return TCL_ERROR;
+  }
+  session->exited = true;
+  session->exitCode = code;
+  Tcl_SetResult(interp, (char*)"exit", TCL_STATIC);
+  return TCL_ERROR;
+}
+
+int serverShutdown(ClientData clientData, Tcl_Interp* interp, int argc,
+                   const char* argv[]) {
+  static_cast<ClientSession*>(clientData)->server->Stop();
+  return TCL_OK;
+}
+
+}  // namespace
+
+CompileServer::CompileServer(const std::string& socket, Setup setup)
+    : m_socket(socket.empty() ? ServerProtocol::DefaultSocket() : socket),
+      m_setup(setup) {}
+
+void CompileServer::Stop() { m_stop = true; }
+
+#ifndef _WIN32
+
+CompileServer::~CompileServer() {
+  if (m_listenFd >= 0) {
+    ::close(m_listenFd);
+    ::unlink(m_socket.c_str());
+  }
+}
+
+int CompileServer::Start() {
+  sockaddr_un address{};
+  if (m_socket.empty() || m_socket.size() >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  // A live server is left alone, a stale socket file is replaced
+  ServerClient probe;
+  if (probe.Connect(m_socket) == 0) return -1;
+  ::unlink(m_socket.c_str());
+
+  // Writing to a client that went away fails instead of killing the server
+  std::signal(SIGPIPE, SIG_IGN);
+
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, m_socket.c_str(),
+               sizeof(address.sun_path) - 1);
+  m_listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (m_listenFd < 0) return -1;
+  if (::bind(m_listenFd, (sockaddr*)&address, sizeof(address)) != 0 ||
+      ::listen(m_listenFd, SOMAXCONN) != 0) {
+    ::close(m_listenFd);
+    m_listenFd = -1;
+    return -1;
+  }
+  // Clients run arbitrary Tcl, only the owner may connect
+  ::chmod(m_socket.c_str(), S_IRUSR | S_IWUSR);
+  return 0;
+}
+
+void CompileServer::Run() {
+  while (!m_stop && m_listenFd >= 0) {
+    // Wakes up regularly to notice Stop()
+    pollfd listen{m_listenFd, POLLIN, 0};
+    if (::poll(&listen, 1, 200) <= 0) continue;
+    int fd = ::accept(m_listenFd, nullptr, nullptr);
+    if (fd < 0) continue;
+    m_clients++;
+    std::thread(&CompileServer::serveClient, this, fd).detach();
+  }
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_clientsDone.wait(lock, [this]() { return m_clients == 0; });
+}
+
+void CompileServer::serveClient(int fd) {
+  // Tcl standard channels are per thread, the interpreter created below
+  // picks these up
+  Tcl_Channel out =
+      Tcl_CreateChannel(&clientChannelType, "client_stdout",
+                        new ClientOutput{fd, "out"}, TCL_WRITABLE);
+  Tcl_Channel err =
+      Tcl_CreateChannel(&clientChannelType, "client_stderr",
+                        new ClientOutput{fd, "err"}, TCL_WRITABLE);
+  Tcl_SetChannelOption(nullptr, out, "-buffering", "line");
+  Tcl_SetChannelOption(nullptr, err, "-buffering", "none");
+  Tcl_SetStdChannel(out, TCL_STDOUT);
+  Tcl_SetStdChannel(err, TCL_STDERR);
+
+  {
+    std::error_code ec;
+    Client client{++m_lastClientId,
+                  std::filesystem::current_path(ec).string()};
+    FrameBuffer outBuffer(fd, "out");
+    std::ostream outStream(&outBuffer);
+    std::string name = "client" + std::to_string(client.id);
+    TclInterpreter interpreter(name.c_str());
+    Tcl_Interp* interp = interpreter.getInterp();
+    if (m_setup) m_setup(&interpreter, outStream, client);
+    ClientSession session{this};
+    Tcl_CreateCommand(interp, "exit", clientExit, &session, nullptr);
+    Tcl_CreateCommand(interp, "tcl_exit", clientExit, &session, nullptr);
+    Tcl_CreateCommand(interp, "server_shutdown", serverShutdown, &session,
+                      nullptr);
+
+    std::string type;
+    std::string script;
+    while (!session.exited && ServerProtocol::Read(fd, type, script)) {
+      if (type == "cwd") {
+        Tcl_SetVar(interp, "client_cwd", script.c_str(), TCL_GLOBAL_ONLY);
+        if (std::filesystem::is_directory(script, ec)) {
+          client.directory = script;
+        }
+        // The working directory is the one of the process, it cannot follow
+        // each client
+        std::filesystem::path serverCwd = std::filesystem::current_path(ec);
+        if (!std::filesystem::equivalent(script, serverCwd, ec)) {
+          ServerProtocol::Write(fd, "err",
+                                "Warning: relative paths are resolved from "
+                                "the server directory " +
+                                    serverCwd.string() + "\n");
+        }
+        continue;
+      }
+      if (type != "eval") break;
+      int code = Tcl_EvalEx(interp, script.c_str(), -1, TCL_EVAL_GLOBAL);
+      Tcl_Flush(out);
+      outStream.flush();
+      std::string result;
+      int status = session.exitCode;
+      if (!session.exited) {
+        result = Tcl_GetStringResult(interp);
+        status = (code == TCL_ERROR) ? 1 : 0;
+      }
+      if (!ServerProtocol::Write(fd, "result", result) ||
+          !ServerProtocol::Write(fd, "exit", std::to_string(status))) {
+        break;
+      }
+    }
+  }
+  // Closes the standard channels of the thread
+  Tcl_FinalizeThread();
+  ::close(fd);
+
+  // Notified under the lock, Run() may destroy the server right after
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_clients--;
+  m_clientsDone.notify_all();
+}
+
+#else
+
+CompileServer::~CompileServer() {}
+
+// Unix sockets only
+int CompileServer::Start() { return -1; }
+
+void CompileServer::Run() {}
+
+void CompileServer::serveClient(int fd) {}
+
+#endif
+
+int CompileServer::Serve(CommandLine* cmdLine) {
+  // Also gives Tcl the executable path before the client threads need it
+  TclInterpreter interpreter(cmdLine->Argv()[0]);
+  registerCoreCommands(&interpreter, std::cout, false);
+  std::string result;
+  if (!cmdLine->Script().empty()) {
+    result = interpreter.evalFile(cmdLine->Script());
+  }
+  if (!cmdLine->TclCmd().empty()) {
+    result = interpreter.evalCmd(cmdLine->TclCmd());
+  }
+  if (!result.empty()) std::cout << result << std::endl;
+
+  // Each client compiles in its own directory
+  CompileServer server(
+      cmdLine->Socket(),
+      [](TclInterpreter* interp, std::ostream& out, const Client& client) {
+        registerCoreCommands(interp, out, false,
+                             [&client]() { return client.directory; });
+      });
+  if (server.Start() != 0) {
+    std::cerr << "Cannot serve on " << server.Socket() << std::endl;
+    return 1;
+  }
+  std::cout << "Serving on " << server.Socket() << std::endl;
+  server.Run();
+  return 0;
+}
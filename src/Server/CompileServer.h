@@ -0,0 +1,94 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#ifndef COMPILE_SERVER_H
+#define COMPILE_SERVER_H
+
+namespace FOEDAG {
+
+class CommandLine;
+class TclInterpreter;
+
+// Keeps a process warm and runs the Tcl scripts of ServerClient connections
+// on a Unix domain socket. Every connection gets its own interpreter on its
+// own thread, its puts output and the compiler output are streamed back.
+// In the client interpreters exit and tcl_exit end the connection, not the
+// server, and server_shutdown stops the server once the clients are done.
+// The working directory a client reports (ServerClient::SetWorkingDirectory)
+// becomes its session directory, where its compiler keeps its files. Tcl
+// still resolves relative paths from the server working directory, clients
+// in another one are warned.
+class CompileServer {
+ public:
+  struct Client {
+    int id;
+    // Reported by the client, the server working directory until then
+    std::string directory;
+  };
+  // Registers the commands of a client interpreter, out goes to the client.
+  // client lives as long as the interpreter.
+  using Setup = std::function<void(TclInterpreter* interp, std::ostream& out,
+                                   const Client& client)>;
+
+  // An empty socket is ServerProtocol::DefaultSocket()
+  CompileServer(const std::string& socket, Setup setup);
+  ~CompileServer();
+  CompileServer(const CompileServer&) = delete;
+  CompileServer& operator=(const CompileServer&) = delete;
+
+  // 0 on success, -1 the socket cannot be created or a server already
+  // listens on it
+  int Start();
+  // Serves clients until Stop(), then waits for the connected ones
+  void Run();
+  void Stop();
+
+  const std::string& Socket() const { return m_socket; }
+  int Clients() const { return m_clients; }
+
+  // foedag --server: runs --script and --cmd first (to open a device
+  // catalog...), then serves with the Qt-free foedag commands on --socket.
+  // Returns the exit status of the process.
+  static int Serve(CommandLine* cmdLine);
+
+ private:
+  std::string m_socket;
+  Setup m_setup;
+  int m_listenFd{-1};
+  std::atomic<bool> m_stop{false};
+  std::atomic<int> m_clients{0};
+  std::atomic<int> m_lastClientId{0};
+  std::mutex m_mutex;
+  std::condition_variable m_clientsDone;
+
+  void serveClient(int fd);
+};
+
+}  // namespace FOEDAG
+
+#endif
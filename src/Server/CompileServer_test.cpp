@@ -0,0 +1,188 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "Server/CompileServer.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Main/registerCoreCommands.h"
+#include "Server/ServerProtocol.h"
+#include "Tcl/TclInterpreter.h"
+#include "gtest/gtest.h"
+
+namespace FOEDAG {
+namespace {
+
+class CompileServerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Initializes Tcl in the main thread, as foedag does
+    TclInterpreter interpreter;
+    m_server = new CompileServer(
+        "/tmp/foedag_test_" + std::to_string(getpid()) + ".sock",
+        [](TclInterpreter* interp, std::ostream& out,
+           const CompileServer::Client& client) {
+          auto say = [](void* clientData, Tcl_Interp* interp, int argc,
+                        const char* argv[]) -> int {
+            *static_cast<std::ostream*>(clientData) << argv[1] << std::endl;
+            return TCL_OK;
+          };
+          interp->registerCmd("say", say, &out, 0);
+        });
+    ASSERT_EQ(m_server->Start(), 0);
+    m_thread = std::thread([this]() { m_server->Run(); });
+  }
+  void TearDown() override {
+    m_server->Stop();
+    m_thread.join();
+    delete m_server;
+  }
+
+  CompileServer* m_server = nullptr;
+  std::thread m_thread;
+};
+
+TEST_F(CompileServerTest, EvalStreamsOutput) {
+  ServerClient client;
+  ASSERT_EQ(client.Connect(m_server->Socket()), 0);
+  std::ostringstream out;
+  std::ostringstream err;
+  std::string result;
+  EXPECT_EQ(client.Eval("puts hello; say compiler; puts stderr oops; "
+                        "expr {6 * 7}",
+                        out, err, result),
+            0);
+  EXPECT_EQ(out.str(), "hello\ncompiler\n");
+  EXPECT_EQ(err.str(), "oops\n");
+  EXPECT_EQ(result, "42");
+
+  // Same interpreter for the whole connection
+  EXPECT_EQ(client.Eval("set x 1", out, err, result), 0);
+  EXPECT_EQ(client.Eval("incr x", out, err, result), 0);
+  EXPECT_EQ(result, "2");
+
+  EXPECT_EQ(client.Eval("error failed", out, err, result), 1);
+  EXPECT_EQ(result, "failed");
+}
+
+TEST_F(CompileServerTest, ClientsHaveTheirOwnInterpreter) {
+  ServerClient first;
+  ServerClient second;
+  ASSERT_EQ(first.Connect(m_server->Socket()), 0);
+  ASSERT_EQ(second.Connect(m_server->Socket()), 0);
+  std::ostringstream out;
+  std::string result;
+  EXPECT_EQ(first.Eval("set x first", out, out, result), 0);
+  EXPECT_EQ(second.Eval("info exists x", out, out, result), 0);
+  EXPECT_EQ(result, "0");
+
+  // exit ends the connection, not the server
+  EXPECT_EQ(first.Eval("exit 3", out, out, result), 3);
+  EXPECT_EQ(first.Eval("set x", out, out, result), -1);
+  EXPECT_EQ(second.Eval("set y 1", out, out, result), 0);
+}
+
+TEST_F(CompileServerTest, ClientWorkingDirectory) {
+  ServerClient client;
+  ASSERT_EQ(client.Connect(m_server->Socket()), 0);
+  std::ostringstream out;
+  std::ostringstream err;
+  std::string result;
+  std::string cwd = std::filesystem::current_path().string();
+  ASSERT_TRUE(client.SetWorkingDirectory(cwd));
+  EXPECT_EQ(client.Eval("set client_cwd", out, err, result), 0);
+  EXPECT_EQ(result, cwd);
+  EXPECT_EQ(err.str(), "");
+
+  // Another directory is only reported, the server does not move
+  std::string other = std::filesystem::temp_directory_path().string();
+  ASSERT_TRUE(client.SetWorkingDirectory(other));
+  EXPECT_EQ(client.Eval("pwd", out, err, result), 0);
+  EXPECT_TRUE(std::filesystem::equivalent(result, cwd));
+  EXPECT_NE(err.str().find("relative paths"), std::string::npos);
+}
+
+TEST_F(CompileServerTest, SecondServerOnSameSocket) {
+  CompileServer other(m_server->Socket(), nullptr);
+  EXPECT_EQ(other.Start(), -1);
+}
+
+TEST(CompileServerSessions, ConcurrentClientsAreIsolated) {
+  TclInterpreter interpreter;
+  CompileServer server(
+      "/tmp/foedag_sessions_" + std::to_string(getpid()) + ".sock",
+      [](TclInterpreter* interp, std::ostream& out,
+         const CompileServer::Client& client) {
+        registerCoreCommands(interp, out, false,
+                             [&client]() { return client.directory; });
+      });
+  ASSERT_EQ(server.Start(), 0);
+  std::thread serverThread([&server]() { server.Run(); });
+
+  std::filesystem::path root =
+      std::filesystem::temp_directory_path() /
+      ("foedag_sessions_" + std::to_string(getpid()));
+  std::vector<std::filesystem::path> directories{root / "first",
+                                                 root / "second"};
+  std::vector<std::thread> clients;
+  std::vector<int> status(directories.size(), -1);
+  for (size_t i = 0; i < directories.size(); i++) {
+    std::filesystem::create_directories(directories[i]);
+    std::ofstream(directories[i] / "top.v") << "module top; endmodule\n";
+    clients.emplace_back([&, i]() {
+      ServerClient client;
+      if (client.Connect(server.Socket()) != 0 ||
+          !client.SetWorkingDirectory(directories[i].string()))
+        return;
+      std::ostringstream out;
+      std::string result;
+      status[i] = client.Eval(
+          "add_design_file " + (directories[i] / "top.v").string() +
+              "; synthesize",
+          out, out, result);
+    });
+  }
+  for (std::thread& client : clients) client.join();
+
+  // Each session keeps its files in its own directory
+  for (size_t i = 0; i < directories.size(); i++) {
+    EXPECT_EQ(status[i], 0);
+    EXPECT_TRUE(std::filesystem::exists(directories[i] / "metrics.qor"));
+    std::ifstream deps(directories[i] / "test_design.deps");
+    std::string content((std::istreambuf_iterator<char>(deps)),
+                        std::istreambuf_iterator<char>());
+    EXPECT_NE(content.find(directories[i].string()), std::string::npos);
+    EXPECT_EQ(content.find(directories[1 - i].string()), std::string::npos);
+  }
+  server.Stop();
+  serverThread.join();
+  std::filesystem::remove_all(root);
+}
+
+}  // namespace
+}  // namespace FOEDAG
@@ -0,0 +1,580 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "Server/JobSpool.h"
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+extern "C" {
+#include <tcl.h>
+}
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "Compiler/HdlScanner.h"
+#include "Compiler/RuntimeHistory.h"
+#include "Main/CommandLine.h"
+#include "Main/registerCoreCommands.h"
+#include "Tcl/TclInterpreter.h"
+
+using namespace FOEDAG;
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const STATE_DIRS[] = {"pending", "running", "done", "failed"};
+
+std::string readFile(const std::string& file) {
+  std::ifstream in(file, std::ios::binary);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+bool writeFile(const std::string& file, const std::string& content) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out << content;
+  return bool(out);
+}
+
+int processId() {
+#ifdef _WIN32
+  return _getpid();
+#else
+  return getpid();
+#endif
+}
+
+std::string hostName() {
+#ifdef _WIN32
+  const char* name = std::getenv("COMPUTERNAME");
+  return name ? name : "localhost";
+#else
+  char name[256] = {};
+  if (gethostname(name, sizeof(name) - 1) != 0) return "localhost";
+  return name;
+#endif
+}
+
+// Job ids are file names
+std::string sanitize(const std::string& name) {
+  std::string id = name;
+  for (char& c : id) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.') {
+      c = '_';
+    }
+  }
+  return id;
+}
+
+// Jobs are recorded under their name and the hash of their script
+RuntimeHistory::Features jobFeatures(const std::string& name,
+                                     const std::string& script) {
+  RuntimeHistory::Features features;
+  features.design = name;
+  std::ostringstream hash;
+  // Persisted, std::hash may differ between builds
+  hash << std::hex << HdlScanner::ContentHash(script.data(), script.size());
+  features.options = hash.str();
+  return features;
+}
+
+struct JobExit {
+  bool exited = false;
+  int code = 0;
+};
+
+// exit ?code? and tcl_exit end the job, not the worker
+int jobExit(ClientData clientData, Tcl_Interp* interp, int argc,
+            const char* argv[]) {
+  JobExit* state = static_cast<JobExit*>(clientData);
+  int code = 0;
+  if (argc > 2 || (argc == 2 && Tcl_GetInt(interp, argv[1], &code) != TCL_OK)) {
+    Tcl_ResetResult(interp);
+    Tcl_AppendResult(interp, "Usage: exit ?code?", (char*)NULL);
+    return TCL_ERROR;
+  }
+  state->exited = true;
+  state->code = code;
+  Tcl_SetResult(interp, (char*)"exit", TCL_STATIC);
+  return TCL_ERROR;
+}
+
+}  // namespace
+
+int JobSpool::Init() {
+  std::error_code ec;
+  for (const char* dir : {"pending", "running", "done", "failed", "logs",
+                          "tmp"}) {
+    fs::create_directories(fs::path(m_dir) / dir, ec);
+    if (ec) return -1;
+  }
+  return 0;
+}
+
+std::string JobSpool::path(const char* state, const std::string& id,
+                           const char* extension) const {
+  return (fs::path(m_dir) / state / (id + extension)).string();
+}
+
+int JobSpool::attempts(const std::string& id) const {
+  return std::atoi(readFile(path("logs", id, ".attempts")).c_str());
+}
+
+std::string JobSpool::Submit(const std::string& name,
+                             const std::string& script, double estimate) {
+  static std::atomic<unsigned int> counter{0};
+  std::string id = sanitize(name) + "-" + sanitize(hostName()) + "-" +
+                   std::to_string(processId()) + "-" +
+                   std::to_string(++counter);
+  // Written aside first, workers never see a partial script
+  std::string tmp = path("tmp", id, ".tcl");
+  if (!writeFile(tmp, script)) return std::string();
+  writeFile(path("logs", id, ".name"), name);
+  if (estimate >= 0) {
+    writeFile(path("logs", id, ".estimate"), std::to_string(estimate));
+  }
+  std::error_code ec;
+  fs::rename(tmp, path("pending", id, ".tcl"), ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return std::string();
+  }
+  return id;
+}
+
+bool JobSpool::Claim(const std::string& worker, std::string& id,
+                     std::string& script, std::string& claim) {
+  std::error_code ec;
+  struct Candidate {
+    double estimate;
+    fs::file_time_type time;
+    fs::path file;
+  };
+  std::vector<Candidate> pending;
+  for (const auto& entry :
+       fs::directory_iterator(fs::path(m_dir) / "pending", ec)) {
+    if (entry.path().extension() != ".tcl") continue;
+    std::string estimate =
+        readFile(path("logs", entry.path().stem().string(), ".estimate"));
+    pending.push_back(
+        {estimate.empty() ? HUGE_VAL : std::atof(estimate.c_str()),
+         fs::last_write_time(entry.path(), ec), entry.path()});
+  }
+  // Longest first, a long job started last stretches the whole run
+  std::sort(pending.begin(), pending.end(),
+            [](const Candidate& a, const Candidate& b) {
+              if (a.estimate != b.estimate) return a.estimate > b.estimate;
+              return a.time < b.time;
+            });
+  for (const auto& [estimate, time, file] : pending) {
+    std::string candidate = file.stem().string();
+    std::string running = path("running", candidate, ".tcl");
+    fs::rename(file, running, ec);
+    if (ec) continue;  // Another worker was faster
+    // Still carries the submit time, Requeue may have found it stale and
+    // put it back before it was touched
+    fs::last_write_time(running, fs::file_time_type::clock::now(), ec);
+    if (ec) continue;
+    id = candidate;
+    int attempt = attempts(id) + 1;
+    claim = worker + "#" + std::to_string(attempt);
+    writeFile(path("running", id, ".worker"), claim);
+    writeFile(path("logs", id, ".attempts"), std::to_string(attempt));
+    script = readFile(running);
+    return true;
+  }
+  return false;
+}
+
+bool JobSpool::Heartbeat(const std::string& claim, const std::string& id) {
+  if (readFile(path("running", id, ".worker")) != claim) return false;
+  std::error_code ec;
+  fs::last_write_time(path("running", id, ".tcl"),
+                      fs::file_time_type::clock::now(), ec);
+  return !ec;
+}
+
+bool JobSpool::Complete(const std::string& claim, const std::string& id,
+                        int exitCode) {
+  if (readFile(path("running", id, ".worker")) != claim) return false;
+  // Moves with the job, the exit code is only published once it is done
+  std::string status = path("running", id, ".status");
+  if (!writeFile(status, std::to_string(exitCode))) return false;
+  std::error_code ec;
+  fs::rename(path("running", id, ".tcl"), path("done", id, ".tcl"), ec);
+  if (ec) {
+    fs::remove(status, ec);
+    return false;
+  }
+  fs::rename(status, path("logs", id, ".status"), ec);
+  fs::remove(path("running", id, ".worker"), ec);
+  return true;
+}
+
+int JobSpool::Requeue(int staleSeconds, int maxAttempts) {
+  int moved = 0;
+  std::error_code ec;
+  auto now = fs::file_time_type::clock::now();
+  for (const auto& entry :
+       fs::directory_iterator(fs::path(m_dir) / "running", ec)) {
+    if (entry.path().extension() != ".tcl") continue;
+    auto touched = fs::last_write_time(entry.path(), ec);
+    if (ec || now - touched < std::chrono::seconds(staleSeconds)) continue;
+    std::string id = entry.path().stem().string();
+    const char* target = attempts(id) >= maxAttempts ? "failed" : "pending";
+    // Dropped before the move, once pending another worker may claim the
+    // job and write its own
+    std::error_code renamed;
+    fs::remove(path("running", id, ".worker"), renamed);
+    fs::rename(entry.path(), path(target, id, ".tcl"), renamed);
+    if (renamed) continue;
+    moved++;
+  }
+  return moved;
+}
+
+JobSpool::Job JobSpool::Get(const std::string& id) const {
+  Job job;
+  job.id = id;
+  const State states[] = {State::Pending, State::Running, State::Done,
+                          State::Failed};
+  // Checked in the order jobs move, a job moving meanwhile is still found
+  for (int i = 0; i < 4; i++) {
+    if (fs::exists(path(STATE_DIRS[i], id, ".tcl"))) {
+      job.state = states[i];
+      break;
+    }
+  }
+  job.name = readFile(path("logs", id, ".name"));
+  std::string estimate = readFile(path("logs", id, ".estimate"));
+  if (!estimate.empty()) job.estimate = std::atof(estimate.c_str());
+  job.attempts = attempts(id);
+  if (job.state == State::Done) {
+    // Complete moves the status to logs/ right after the job
+    std::string status = readFile(path("running", id, ".status"));
+    if (status.empty()) status = readFile(path("logs", id, ".status"));
+    if (!status.empty()) job.exitCode = std::atoi(status.c_str());
+  }
+  return job;
+}
+
+std::vector<JobSpool::Job> JobSpool::Jobs() const {
+  std::vector<Job> jobs;
+  std::error_code ec;
+  for (const char* state : STATE_DIRS) {
+    for (const auto& entry :
+         fs::directory_iterator(fs::path(m_dir) / state, ec)) {
+      if (entry.path().extension() != ".tcl") continue;
+      jobs.push_back(Get(entry.path().stem().string()));
+    }
+  }
+  std::sort(jobs.begin(), jobs.end(),
+            [](const Job& a, const Job& b) { return a.id < b.id; });
+  return jobs;
+}
+
+std::string JobSpool::LogFile(const std::string& id) const {
+  return path("logs", id, ".log");
+}
+
+std::string JobSpool::HistoryFile() const {
+  return (fs::path(m_dir) / "runtimes.history").string();
+}
+
+double JobSpool::Estimate(const std::string& name,
+                          const std::string& script) const {
+  RuntimeHistory history(HistoryFile());
+  if (history.Load() != 0) return -1;
+  return history.Predict("job", jobFeatures(name, script));
+}
+
+void JobSpool::StopWorkers() {
+  writeFile((fs::path(m_dir) / "stop").string(), "");
+}
+
+bool JobSpool::Stopped() const { return fs::exists(fs::path(m_dir) / "stop"); }
+
+const char* JobSpool::StateName(State state) {
+  switch (state) {
+    case State::Pending:
+      return "pending";
+    case State::Running:
+      return "running";
+    case State::Done:
+      return "done";
+    case State::Failed:
+      return "failed";
+    default:
+      return "unknown";
+  }
+}
+
+int JobSpool::RunJob(const std::string& script, const std::string& log,
+                     const std::function<void()>& tick) {
+  int exitCode = 0;
+  bool finished = false;
+  std::mutex mutex;
+  std::condition_variable done;
+  std::thread job([&]() {
+    // Standard channels are per thread in Tcl, the interpreter created
+    // below writes its puts output to the log
+    Tcl_Channel out = Tcl_OpenFileChannel(nullptr, log.c_str(), "a", 0644);
+    Tcl_Channel err = Tcl_OpenFileChannel(nullptr, log.c_str(), "a", 0644);
+    if (out) {
+      Tcl_SetChannelOption(nullptr, out, "-buffering", "line");
+      Tcl_SetStdChannel(out, TCL_STDOUT);
+    }
+    if (err) {
+      Tcl_SetChannelOption(nullptr, err, "-buffering", "none");
+      Tcl_SetStdChannel(err, TCL_STDERR);
+    }
+    {
+      std::ofstream compilerOut(log, std::ios::app);
+      TclInterpreter interpreter;
+      Tcl_Interp* interp = interpreter.getInterp();
+      registerCoreCommands(&interpreter, compilerOut, false);
+      JobExit exitState;
+      Tcl_CreateCommand(interp, "exit", jobExit, &exitState, nullptr);
+      Tcl_CreateCommand(interp, "tcl_exit", jobExit, &exitState, nullptr);
+      int code = Tcl_EvalEx(interp, script.c_str(), -1, TCL_EVAL_GLOBAL);
+      if (exitState.exited) {
+        exitCode = exitState.code;
+      } else if (code == TCL_ERROR) {
+        exitCode = 1;
+        const char* errorInfo =
+            Tcl_GetVar(interp, "errorInfo", TCL_GLOBAL_ONLY);
+        if (err && errorInfo) {
+          Tcl_WriteChars(err, errorInfo, -1);
+          Tcl_WriteChars(err, "\n", 1);
+        }
+      }
+    }
+    // Flushes and closes the log channels
+    Tcl_FinalizeThread();
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    done.notify_all();
+  });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!done.wait_for(lock, std::chrono::seconds(1),
+                          [&finished]() { return finished; })) {
+      if (tick) tick();
+    }
+  }
+  job.join();
+  return exitCode;
+}
+
+int JobSpool::Work(CommandLine* cmdLine) {
+  // Gives Tcl the executable path before the job threads need it
+  TclInterpreter interpreter(cmdLine->Argv()[0]);
+  JobSpool spool(cmdLine->WorkerSpool());
+  if (spool.Init() != 0) {
+    std::cerr << "Cannot use the spool " << spool.Dir() << std::endl;
+    return 1;
+  }
+  std::string worker = hostName() + ":" + std::to_string(processId());
+  std::cout << "Worker " << worker << " on " << spool.Dir() << std::endl;
+  std::string id;
+  std::string script;
+  std::string claim;
+  while (true) {
+    if (!spool.Claim(worker, id, script, claim)) {
+      if (spool.Stopped()) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      continue;
+    }
+    std::cout << "Running " << id << std::endl;
+    // Retries append to the log, the output of the failed attempts stays
+    {
+      std::ofstream log(spool.LogFile(id), std::ios::app);
+      log << "==== attempt " << spool.Get(id).attempts << " on " << worker
+          << " ====" << std::endl;
+    }
+    auto start = std::chrono::steady_clock::now();
+    int exitCode = RunJob(script, spool.LogFile(id),
+                          [&]() { spool.Heartbeat(claim, id); });
+    std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start;
+    if (exitCode == 0) {
+      RuntimeHistory history(spool.HistoryFile());
+      history.Record("job", jobFeatures(spool.Get(id).name, script),
+                     seconds.count());
+    }
+    if (!spool.Complete(claim, id, exitCode)) {
+      std::cout << id << " was given to another worker" << std::endl;
+    }
+  }
+  return 0;
+}
+
+void JobSpool::RegisterCommands(TclInterpreter* interp) {
+  // launch_runs -spool <dir> [-script <tcl>] [-retries <n>] [-timeout <s>]
+  //             [-nowait] <run>...
+  // One job per run, run_name is set in its script. Waits for the workers,
+  // jobs of dead workers (not seen for -timeout seconds) are retried.
+  auto launch_runs = [](void* clientData, Tcl_Interp* interp, int argc,
+                        const char* argv[]) -> int {
+    std::string dir;
+    std::string script = "synthesize\nglobal_placement";
+    int retries = 2;
+    int timeout = 30;
+    bool wait = true;
+    std::vector<std::string> runs;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++) {
+      std::string option = argv[i];
+      bool hasValue = i + 1 < argc;
+      if (option == "-spool" && hasValue) {
+        dir = argv[++i];
+      } else if (option == "-script" && hasValue) {
+        script = argv[++i];
+      } else if (option == "-retries" && hasValue) {
+        ok = Tcl_GetInt(interp, argv[++i], &retries) == TCL_OK && retries >= 0;
+      } else if (option == "-timeout" && hasValue) {
+        ok = Tcl_GetInt(interp, argv[++i], &timeout) == TCL_OK && timeout > 0;
+      } else if (option == "-nowait") {
+        wait = false;
+      } else if (option[0] == '-') {
+        ok = false;
+      } else {
+        runs.push_back(option);
+      }
+    }
+    if (!ok || dir.empty() || runs.empty()) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp,
+                       "Usage: launch_runs -spool <dir> [-script <tcl>] "
+                       "[-retries <n>] [-timeout <s>] [-nowait] <run>...",
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+
+    JobSpool spool(dir);
+    if (spool.Init() != 0) {
+      Tcl_AppendResult(interp, "Cannot use the spool ", dir.c_str(),
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+    std::vector<std::string> ids;
+    for (const auto& run : runs) {
+      std::string job = "set run_name {" + run + "}\n" + script;
+      std::string id = spool.Submit(run, job, spool.Estimate(run, job));
+      if (id.empty()) {
+        Tcl_AppendResult(interp, "Cannot submit ", run.c_str(), (char*)NULL);
+        return TCL_ERROR;
+      }
+      ids.push_back(id);
+    }
+    if (!wait) {
+      for (const auto& id : ids) Tcl_AppendElement(interp, id.c_str());
+      return TCL_OK;
+    }
+
+    while (true) {
+      spool.Requeue(timeout, retries + 1);
+      bool running = false;
+      for (const auto& id : ids) {
+        State state = spool.Get(id).state;
+        if (state == State::Pending || state == State::Running) running = true;
+      }
+      if (!running) break;
+      // Waits in the Tcl event loop, in the GUI the notifier keeps
+      // processing the Qt events meanwhile
+      bool expired = false;
+      Tcl_CreateTimerHandler(
+          200, [](ClientData data) { *(bool*)data = true; }, &expired);
+      while (!expired) Tcl_DoOneEvent(TCL_ALL_EVENTS);
+    }
+
+    std::string failed;
+    for (size_t i = 0; i < ids.size(); i++) {
+      Job job = spool.Get(ids[i]);
+      if (job.state != State::Done || job.exitCode != 0) {
+        failed += "\n" + runs[i] + ": " + StateName(job.state) + ", exit " +
+                  std::to_string(job.exitCode) + ", log " +
+                  spool.LogFile(ids[i]);
+      }
+    }
+    if (!failed.empty()) {
+      Tcl_AppendResult(interp, "Failed runs:", failed.c_str(), (char*)NULL);
+      return TCL_ERROR;
+    }
+    for (const auto& id : ids) {
+      Tcl_AppendElement(interp, spool.LogFile(id).c_str());
+    }
+    return TCL_OK;
+  };
+  interp->registerCmd("launch_runs", launch_runs, 0, 0);
+
+  // report_jobs -spool <dir>: {id state attempts exit_code} per job
+  auto report_jobs = [](void* clientData, Tcl_Interp* interp, int argc,
+                        const char* argv[]) -> int {
+    if (argc != 3 || std::string(argv[1]) != "-spool") {
+      Tcl_AppendResult(interp, "Usage: report_jobs -spool <dir>", (char*)NULL);
+      return TCL_ERROR;
+    }
+    JobSpool spool(argv[2]);
+    for (const Job& job : spool.Jobs()) {
+      std::string line = job.id + " " + StateName(job.state) + " " +
+                         std::to_string(job.attempts) + " " +
+                         std::to_string(job.exitCode);
+      Tcl_AppendElement(interp, line.c_str());
+    }
+    return TCL_OK;
+  };
+  interp->registerCmd("report_jobs", report_jobs, 0, 0);
+
+  // stop_workers -spool <dir>: the workers exit once out of jobs
+  auto stop_workers = [](void* clientData, Tcl_Interp* interp, int argc,
+                         const char* argv[]) -> int {
+    if (argc != 3 || std::string(argv[1]) != "-spool") {
+      Tcl_AppendResult(interp, "Usage: stop_workers -spool <dir>",
+                       (char*)NULL);
+      return TCL_ERROR;
+    }
+    JobSpool spool(argv[2]);
+    if (spool.Init() != 0) {
+      Tcl_AppendResult(interp, "Cannot use the spool ", argv[2], (char*)NULL);
+      return TCL_ERROR;
+    }
+    spool.StopWorkers();
+    return TCL_OK;
+  };
+  interp->registerCmd("stop_workers", stop_workers, 0, 0);
+}
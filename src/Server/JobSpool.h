@@ -0,0 +1,118 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef JOB_SPOOL_H
+#define JOB_SPOOL_H
+
+namespace FOEDAG {
+
+class CommandLine;
+class TclInterpreter;
+
+// Queue of Tcl jobs in a spool directory, shared by a coordinator and worker
+// processes ("foedag --worker <spool>"), on one machine or on a shared file
+// system. A job moves between pending/, running/, done/ and failed/ by
+// rename, which is atomic, so a job is claimed by exactly one worker.
+// Running jobs are touched by their worker every second, the coordinator
+// puts back the ones whose worker died. Logs, exit codes and attempt counts
+// are in logs/. Workers record the runtime of the jobs in runtimes.history,
+// the longest jobs are claimed first.
+class JobSpool {
+ public:
+  enum class State { Unknown, Pending, Running, Done, Failed };
+  struct Job {
+    std::string id;
+    // As given to Submit
+    std::string name;
+    State state = State::Unknown;
+    int attempts = 0;
+    // Exit code of the script, -1 until done
+    int exitCode = -1;
+    // Expected seconds, -1 if unknown
+    double estimate = -1;
+  };
+
+  explicit JobSpool(const std::string& dir) : m_dir(dir) {}
+
+  // Creates the directories, 0 on success, -1 on error
+  int Init();
+  const std::string& Dir() const { return m_dir; }
+
+  // Returns the job id, empty on error
+  std::string Submit(const std::string& name, const std::string& script,
+                     double estimate = -1);
+
+  // Worker side. Claim returns false when no job is pending, it takes the
+  // job expected to run the longest, jobs without estimate first, then the
+  // oldest. claim identifies this claim of the job: once Requeue gave the
+  // job back, Heartbeat and Complete with it return false, even if the same
+  // worker claimed the job again.
+  bool Claim(const std::string& worker, std::string& id, std::string& script,
+             std::string& claim);
+  bool Heartbeat(const std::string& claim, const std::string& id);
+  bool Complete(const std::string& claim, const std::string& id,
+                int exitCode);
+
+  // Coordinator side: running jobs not touched for staleSeconds go back to
+  // pending, or to failed once claimed maxAttempts times. Returns the number
+  // of jobs moved.
+  int Requeue(int staleSeconds, int maxAttempts);
+
+  Job Get(const std::string& id) const;
+  std::vector<Job> Jobs() const;
+  std::string LogFile(const std::string& id) const;
+  // Runtimes of the jobs done, by name and script
+  std::string HistoryFile() const;
+  // Expected seconds of a job from the history, -1 if unknown
+  double Estimate(const std::string& name, const std::string& script) const;
+
+  // Workers exit once idle
+  void StopWorkers();
+  bool Stopped() const;
+
+  static const char* StateName(State state);
+
+  // Runs a job script on a thread, in a new interpreter with the core
+  // commands, output is appended to the log file. tick is called every
+  // second meanwhile. Returns the exit code of the script: 0, 1 on a Tcl
+  // error or the code given to exit.
+  static int RunJob(const std::string& script, const std::string& log,
+                    const std::function<void()>& tick = nullptr);
+  // foedag --worker <spool>: runs jobs until stop_workers
+  static int Work(CommandLine* cmdLine);
+  // launch_runs, report_jobs, stop_workers
+  static void RegisterCommands(TclInterpreter* interp);
+
+ private:
+  std::string m_dir;
+
+  std::string path(const char* state, const std::string& id,
+                   const char* extension) const;
+  int attempts(const std::string& id) const;
+};
+
+}  // namespace FOEDAG
+
+#endif
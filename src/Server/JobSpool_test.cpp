@@ -0,0 +1,153 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "Server/JobSpool.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "Tcl/TclInterpreter.h"
+#include "Utils/TestDirectory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::HasSubstr;
+
+namespace FOEDAG {
+namespace {
+namespace fs = std::filesystem;
+
+class JobSpoolTest : public TestDirectory {
+ protected:
+  void SetUp() override {
+    TestDirectory::SetUp();
+    ASSERT_EQ(m_spool.Init(), 0);
+  }
+
+  // As if the worker of the job died a minute ago
+  void age(const std::string& id) {
+    fs::last_write_time(fs::path(m_spoolDir) / "running" / (id + ".tcl"),
+                        fs::file_time_type::clock::now() -
+                            std::chrono::seconds(60));
+  }
+
+  std::string m_spoolDir{Path("spool")};
+  JobSpool m_spool{m_spoolDir};
+};
+
+TEST_F(JobSpoolTest, JobsAreClaimedOnce) {
+  std::string first = m_spool.Submit("impl 1", "puts 1");
+  std::string second = m_spool.Submit("impl_2", "puts 2");
+  ASSERT_FALSE(first.empty());
+  EXPECT_EQ(first.find(' '), std::string::npos);
+
+  std::string id;
+  std::string script;
+  std::string claim;
+  ASSERT_TRUE(m_spool.Claim("w1", id, script, claim));
+  std::string claimed = id;
+  std::string firstClaim = claim;
+  EXPECT_EQ(m_spool.Get(id).state, JobSpool::State::Running);
+  ASSERT_TRUE(m_spool.Claim("w2", id, script, claim));
+  EXPECT_NE(id, claimed);
+  EXPECT_FALSE(m_spool.Claim("w3", id, script, claim));
+
+  EXPECT_FALSE(m_spool.Complete(claim, claimed, 0));
+  EXPECT_TRUE(m_spool.Complete(firstClaim, claimed, 2));
+  JobSpool::Job job = m_spool.Get(claimed);
+  EXPECT_EQ(job.state, JobSpool::State::Done);
+  EXPECT_EQ(job.exitCode, 2);
+  EXPECT_EQ(job.attempts, 1);
+  EXPECT_EQ(m_spool.Jobs().size(), 2u);
+}
+
+TEST_F(JobSpoolTest, JobsOfDeadWorkersAreRetried) {
+  std::string submitted = m_spool.Submit("synth", "puts 1");
+  std::string id;
+  std::string script;
+  std::string claim;
+  ASSERT_TRUE(m_spool.Claim("w1", id, script, claim));
+  EXPECT_EQ(script, "puts 1");
+  EXPECT_EQ(m_spool.Requeue(30, 3), 0);
+  EXPECT_TRUE(m_spool.Heartbeat(claim, id));
+
+  age(id);
+  EXPECT_EQ(m_spool.Requeue(30, 3), 1);
+  EXPECT_EQ(m_spool.Get(id).state, JobSpool::State::Pending);
+  // The first worker comes back too late, after claiming the job again
+  std::string stale = claim;
+  ASSERT_TRUE(m_spool.Claim("w1", id, script, claim));
+  EXPECT_NE(claim, stale);
+  EXPECT_FALSE(m_spool.Heartbeat(stale, id));
+  EXPECT_FALSE(m_spool.Complete(stale, id, 0));
+  EXPECT_EQ(m_spool.Get(id).state, JobSpool::State::Running);
+
+  age(id);
+  EXPECT_EQ(m_spool.Requeue(30, 3), 1);
+  ASSERT_TRUE(m_spool.Claim("w2", id, script, claim));
+  age(id);
+  EXPECT_EQ(m_spool.Requeue(30, 3), 1);
+  JobSpool::Job job = m_spool.Get(submitted);
+  EXPECT_EQ(job.state, JobSpool::State::Failed);
+  EXPECT_EQ(job.attempts, 3);
+}
+
+TEST_F(JobSpoolTest, LongestJobsFirst) {
+  std::string shortJob = m_spool.Submit("short", "puts 1", 5);
+  std::string longJob = m_spool.Submit("long", "puts 2", 50);
+  std::string newJob = m_spool.Submit("new", "puts 3");
+  EXPECT_EQ(m_spool.Estimate("new", "puts 3"), -1);
+  JobSpool::Job job = m_spool.Get(longJob);
+  EXPECT_EQ(job.name, "long");
+  EXPECT_EQ(job.estimate, 50);
+
+  std::string id;
+  std::string script;
+  std::string claim;
+  ASSERT_TRUE(m_spool.Claim("w1", id, script, claim));
+  EXPECT_EQ(id, newJob);
+  ASSERT_TRUE(m_spool.Claim("w1", id, script, claim));
+  EXPECT_EQ(id, longJob);
+  ASSERT_TRUE(m_spool.Claim("w1", id, script, claim));
+  EXPECT_EQ(id, shortJob);
+}
+
+TEST_F(JobSpoolTest, RunJob) {
+  TclInterpreter interpreter;
+  std::string log = m_spool.LogFile("job");
+  EXPECT_EQ(JobSpool::RunJob("puts hello; exit 3; puts never", log), 3);
+  std::stringstream content;
+  content << std::ifstream(log).rdbuf();
+  EXPECT_EQ(content.str(), "hello\n");
+
+  EXPECT_EQ(JobSpool::RunJob("set run_name impl_1\nerror broken", log), 1);
+  content.str("");
+  content << std::ifstream(log).rdbuf();
+  EXPECT_THAT(content.str(), HasSubstr("broken"));
+  // A retry keeps the output of the failed attempt
+  EXPECT_THAT(content.str(), HasSubstr("hello\n"));
+
+  EXPECT_EQ(JobSpool::RunJob("info commands launch_runs", log), 0);
+}
+
+}  // namespace
+}  // namespace FOEDAG
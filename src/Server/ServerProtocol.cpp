@@ -0,0 +1,156 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "Server/ServerProtocol.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+using namespace FOEDAG;
+
+// Frames larger than this are rejected as malformed
+static constexpr size_t MAX_FRAME_SIZE = 1 << 30;
+
+#ifndef _WIN32
+
+static bool writeAll(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t written = ::write(fd, data, size);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) return false;
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+static bool readAll(int fd, char* data, size_t size) {
+  while (size > 0) {
+    ssize_t count = ::read(fd, data, size);
+    if (count < 0 && errno == EINTR) continue;
+    if (count <= 0) return false;
+    data += count;
+    size -= count;
+  }
+  return true;
+}
+
+bool ServerProtocol::Write(int fd, const std::string& type,
+                           const std::string& payload) {
+  std::string frame = type + " " + std::to_string(payload.size()) + "\n";
+  frame += payload;
+  return writeAll(fd, frame.data(), frame.size());
+}
+
+bool ServerProtocol::Read(int fd, std::string& type, std::string& payload) {
+  std::string header;
+  char c = 0;
+  while (readAll(fd, &c, 1) && c != '\n') {
+    if (header.size() > 64) return false;
+    header += c;
+  }
+  if (c != '\n') return false;
+  size_t space = header.find(' ');
+  if (space == std::string::npos) return false;
+  char* end = nullptr;
+  unsigned long long size =
+      std::strtoull(header.c_str() + space + 1, &end, 10);
+  if (*end != '\0' || size > MAX_FRAME_SIZE) return false;
+  type = header.substr(0, space);
+  payload.resize(size);
+  return readAll(fd, payload.data(), size);
+}
+
+std::string ServerProtocol::DefaultSocket() {
+  if (const char* runtime = std::getenv("XDG_RUNTIME_DIR")) {
+    if (*runtime) return std::string(runtime) + "/foedag.sock";
+  }
+  return "/tmp/foedag-" + std::to_string(getuid()) + ".sock";
+}
+
+int ServerClient::Connect(const std::string& socket) {
+  Close();
+  sockaddr_un address{};
+  if (socket.size() >= sizeof(address.sun_path)) return -1;
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socket.c_str(), sizeof(address.sun_path) - 1);
+  m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (m_fd < 0) return -1;
+  if (::connect(m_fd, (sockaddr*)&address, sizeof(address)) != 0) {
+    Close();
+    return -1;
+  }
+  return 0;
+}
+
+void ServerClient::Close() {
+  if (m_fd >= 0) ::close(m_fd);
+  m_fd = -1;
+}
+
+#else
+
+bool ServerProtocol::Write(int, const std::string&, const std::string&) {
+  return false;
+}
+
+bool ServerProtocol::Read(int, std::string&, std::string&) { return false; }
+
+std::string ServerProtocol::DefaultSocket() { return std::string(); }
+
+// Unix sockets only
+int ServerClient::Connect(const std::string&) { return -1; }
+
+void ServerClient::Close() {}
+
+#endif
+
+ServerClient::~ServerClient() { Close(); }
+
+bool ServerClient::SetWorkingDirectory(const std::string& directory) {
+  return m_fd >= 0 && ServerProtocol::Write(m_fd, "cwd", directory);
+}
+
+int ServerClient::Eval(const std::string& script, std::ostream& out,
+                       std::ostream& err, std::string& result) {
+  if (m_fd < 0 || !ServerProtocol::Write(m_fd, "eval", script)) return -1;
+  std::string type;
+  std::string payload;
+  while (ServerProtocol::Read(m_fd, type, payload)) {
+    if (type == "out") {
+      out << payload << std::flush;
+    } else if (type == "err") {
+      err << payload << std::flush;
+    } else if (type == "result") {
+      result = payload;
+    } else if (type == "exit") {
+      return std::atoi(payload.c_str());
+    }
+  }
+  Close();
+  return -1;
+}
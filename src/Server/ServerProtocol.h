@@ -0,0 +1,75 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ostream>
+#include <string>
+
+#ifndef SERVER_PROTOCOL_H
+#define SERVER_PROTOCOL_H
+
+namespace FOEDAG {
+
+// Messages between the compile server and its clients are frames:
+// "<type> <size>\n" followed by size bytes of payload.
+// The client sends "eval" frames, each holding a Tcl script. For each one the
+// server streams back "out" and "err" frames, then a "result" frame with the
+// Tcl result and an "exit" frame with the exit code. A "cwd" frame holds the
+// working directory of the client.
+class ServerProtocol {
+ public:
+  static bool Write(int fd, const std::string& type,
+                    const std::string& payload);
+  // False when the connection is closed or the frame is malformed
+  static bool Read(int fd, std::string& type, std::string& payload);
+  // $XDG_RUNTIME_DIR/foedag.sock, /tmp/foedag-<uid>.sock without it
+  static std::string DefaultSocket();
+};
+
+class ServerClient {
+ public:
+  ServerClient() = default;
+  ~ServerClient();
+  ServerClient(const ServerClient&) = delete;
+  ServerClient& operator=(const ServerClient&) = delete;
+
+  // 0 on success, -1 no server listens on the socket
+  int Connect(const std::string& socket);
+  void Close();
+
+  // The server keeps its own working directory, shared by all its clients.
+  // It sets ::client_cwd to this one and warns on stderr when they differ,
+  // as relative paths are resolved from the server working directory.
+  bool SetWorkingDirectory(const std::string& directory);
+
+  // Runs the script in the interpreter the server keeps for this client,
+  // output is written to out and err as it comes. Returns the exit code:
+  // 0, 1 on a Tcl error, the code given to exit, -1 if the connection is
+  // lost.
+  int Eval(const std::string& script, std::ostream& out, std::ostream& err,
+           std::string& result);
+
+ private:
+  int m_fd{-1};
+};
+
+}  // namespace FOEDAG
+
+#endif
@@ -0,0 +1,377 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Tcl/CommandProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+#include "Utils/MemoryTracker.h"
+
+extern "C" {
+#include <tcl.h>
+}
+
+using namespace FOEDAG;
+
+#ifdef FOEDAG_COUNT_ALLOCATIONS
+static thread_local uint64_t t_allocations = 0;
+
+void *operator new(std::size_t size) {
+  t_allocations++;
+  void *ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  t_allocations++;
+  return std::malloc(size ? size : 1);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return operator new(size, std::nothrow);
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+uint64_t CommandProfiler::ThreadAllocations() { return t_allocations; }
+#else
+uint64_t CommandProfiler::ThreadAllocations() { return 0; }
+#endif
+
+CommandProfiler &CommandProfiler::Instance() {
+  static CommandProfiler profiler;
+  return profiler;
+}
+
+std::vector<CommandProfiler::Frame> &CommandProfiler::frames() {
+  static thread_local std::vector<Frame> stack;
+  return stack;
+}
+
+CommandProfiler::Scope::Scope(Record *record)
+    : m_entered(record && Instance().Enabled()) {
+  if (m_entered) Instance().Enter(record);
+}
+
+CommandProfiler::Scope::~Scope() {
+  if (m_entered) Instance().Leave();
+}
+
+CommandProfiler::Record *CommandProfiler::Lookup(const std::string &name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto &record = m_records[name];
+  if (!record) {
+    record = std::make_unique<Record>(name);
+    MemoryTracker::Allocate(MemoryTracker::Tcl, sizeof(Record));
+  }
+  return record.get();
+}
+
+void CommandProfiler::Enter(Record *record) {
+  frames().push_back(
+      {record, std::chrono::steady_clock::now(), 0, ThreadAllocations()});
+}
+
+void CommandProfiler::Leave() {
+  std::vector<Frame> &stack = frames();
+  if (stack.empty()) return;
+  Frame frame = stack.back();
+  stack.pop_back();
+
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - frame.start)
+                    .count();
+  if (!stack.empty()) stack.back().childNs += ns;
+
+  Record *record = frame.record;
+  record->calls++;
+  record->totalNs += ns;
+  record->selfNs += ns > frame.childNs ? ns - frame.childNs : 0;
+  record->allocations += ThreadAllocations() - frame.allocations;
+  record->histogram[Bucket(ns)]++;
+  uint64_t max = record->maxNs;
+  while (ns > max && !record->maxNs.compare_exchange_weak(max, ns)) {
+  }
+}
+
+void CommandProfiler::Reset() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto &entry : m_records) {
+    Record *record = entry.second.get();
+    record->calls = 0;
+    record->totalNs = 0;
+    record->selfNs = 0;
+    record->maxNs = 0;
+    record->allocations = 0;
+    for (auto &count : record->histogram) count = 0;
+  }
+}
+
+size_t CommandProfiler::Bucket(uint64_t ns) {
+  if (ns < 8) return ns;
+  size_t msb = 0;
+  for (uint64_t v = ns; v > 1; v >>= 1) msb++;
+  size_t sub = (ns >> (msb - 2)) & 3;
+  return 8 + (msb - 3) * 4 + sub;
+}
+
+uint64_t CommandProfiler::BucketValue(size_t bucket) {
+  if (bucket < 8) return bucket;
+  size_t msb = 3 + (bucket - 8) / 4;
+  uint64_t sub = (bucket - 8) % 4;
+  uint64_t width = uint64_t{1} << (msb - 2);
+  return ((4 + sub) << (msb - 2)) + width / 2;
+}
+
+static uint64_t percentile(const CommandProfiler::Record &record,
+                           uint64_t calls, double fraction) {
+  uint64_t rank = static_cast<uint64_t>(calls * fraction);
+  if (rank >= calls) rank = calls - 1;
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < CommandProfiler::BUCKETS; bucket++) {
+    seen += record.histogram[bucket];
+    if (seen > rank) return CommandProfiler::BucketValue(bucket);
+  }
+  return record.maxNs;
+}
+
+std::vector<CommandProfiler::Stats> CommandProfiler::Report(SortKey key,
+                                                            size_t top) const {
+  std::vector<Stats> stats;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &entry : m_records) {
+      const Record &record = *entry.second;
+      uint64_t calls = record.calls;
+      if (calls == 0) continue;
+      uint64_t max = record.maxNs;
+      stats.push_back({record.name, calls, record.totalNs, record.selfNs,
+                       std::min(percentile(record, calls, 0.5), max),
+                       std::min(percentile(record, calls, 0.99), max), max,
+                       record.allocations});
+    }
+  }
+  auto value = [key](const Stats &s) -> uint64_t {
+    switch (key) {
+      case SortKey::Calls:
+        return s.calls;
+      case SortKey::Total:
+        return s.totalNs;
+      case SortKey::Self:
+        return s.selfNs;
+      case SortKey::P50:
+        return s.p50Ns;
+      case SortKey::P99:
+        return s.p99Ns;
+      case SortKey::Max:
+        return s.maxNs;
+      case SortKey::Allocations:
+        return s.allocations;
+    }
+    return 0;
+  };
+  std::stable_sort(stats.begin(), stats.end(),
+                   [&value](const Stats &a, const Stats &b) {
+                     return value(a) > value(b);
+                   });
+  if (top > 0 && stats.size() > top) stats.resize(top);
+  return stats;
+}
+
+bool CommandProfiler::ParseSortKey(const std::string &name, SortKey &key) {
+  static const std::map<std::string, SortKey> keys{
+      {"calls", SortKey::Calls}, {"total", SortKey::Total},
+      {"self", SortKey::Self},   {"p50", SortKey::P50},
+      {"p99", SortKey::P99},     {"max", SortKey::Max},
+      {"allocs", SortKey::Allocations}};
+  auto it = keys.find(name);
+  if (it == keys.end()) return false;
+  key = it->second;
+  return true;
+}
+
+std::string CommandProfiler::Format(const std::vector<Stats> &stats) {
+  std::ostringstream out;
+  char line[256];
+  snprintf(line, sizeof(line), "%-32s %10s %12s %12s %10s %10s %10s %10s\n",
+           "command", "calls", "total(ms)", "self(ms)", "p50(us)", "p99(us)",
+           "max(us)", "allocs");
+  out << line;
+  for (const Stats &s : stats) {
+    snprintf(line, sizeof(line),
+             "%-32s %10llu %12.3f %12.3f %10.1f %10.1f %10.1f %10llu\n",
+             s.name.c_str(), (unsigned long long)s.calls, s.totalNs / 1e6,
+             s.selfNs / 1e6, s.p50Ns / 1e3, s.p99Ns / 1e3, s.maxNs / 1e3,
+             (unsigned long long)s.allocations);
+    out << line;
+  }
+  return out.str();
+}
+
+// Procs are timed through execution traces. Procs defined later are traced
+// from a leave trace on the proc command.
+// profile_procs may change in the middle of a proc, each traced call records
+// whether it was entered and its leave pops only then. The traces of procs
+// still running stay until the outermost one returns.
+static thread_local std::vector<bool> t_procFrames;
+static thread_local bool t_profileProcs = false;
+
+static const char *PROC_TRACES = R"(
+namespace eval ::foedag::profile {
+  variable traced
+  if {![info exists traced]} {
+    set traced {}
+  }
+
+  # Redefining a proc drops its traces, check them rather than the list
+  proc trace_proc {name} {
+    variable traced
+    if {$name == "" || [string match ::foedag::profile::* $name] ||
+        [string match ::tcl::* $name]} {
+      return
+    }
+    set hook [list ::foedag::profile::hook $name]
+    if {[lsearch -exact [trace info execution $name] \
+           [list {enter leave} $hook]] >= 0} {
+      return
+    }
+    trace add execution $name {enter leave} $hook
+    dict set traced $name 1
+  }
+
+  proc trace_namespace {ns} {
+    foreach name [info procs ${ns}::*] {
+      trace_proc $name
+    }
+    foreach child [namespace children $ns] {
+      trace_namespace $child
+    }
+  }
+
+  proc on_proc {cmd code result op} {
+    if {$code == 0} {
+      trace_proc [uplevel 1 [list namespace which -command [lindex $cmd 1]]]
+    }
+  }
+
+  proc enable {} {
+    trace_namespace ::
+    trace add execution proc leave ::foedag::profile::on_proc
+  }
+
+  proc disable {} {
+    variable traced
+    trace remove execution proc leave ::foedag::profile::on_proc
+    foreach name [dict keys $traced] {
+      catch {trace remove execution $name {enter leave} \
+        [list ::foedag::profile::hook $name]}
+    }
+    set traced {}
+  }
+}
+)";
+
+void CommandProfiler::RegisterCommands(Tcl_Interp *interp) {
+  // profile_report ?-sort calls|total|self|p50|p99|max|allocs? ?-top <n>?
+  auto profile_report = [](void *clientData, Tcl_Interp *interp, int argc,
+                           const char *argv[]) -> int {
+    SortKey key = SortKey::Total;
+    size_t top = 0;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++) {
+      std::string option = argv[i];
+      if (option == "-sort" && i + 1 < argc) {
+        ok = ParseSortKey(argv[++i], key);
+      } else if (option == "-top" && i + 1 < argc) {
+        int value = 0;
+        ok = Tcl_GetInt(interp, argv[++i], &value) == TCL_OK && value >= 0;
+        top = value;
+      } else {
+        ok = false;
+      }
+    }
+    if (!ok) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp,
+                       "Usage: profile_report ?-sort "
+                       "calls|total|self|p50|p99|max|allocs? ?-top <n>?",
+                       (char *)NULL);
+      return TCL_ERROR;
+    }
+    std::string report = Format(Instance().Report(key, top));
+    Tcl_AppendResult(interp, report.c_str(), (char *)NULL);
+    return TCL_OK;
+  };
+  Tcl_CreateCommand(interp, "profile_report", profile_report, nullptr,
+                    nullptr);
+
+  auto profile_reset = [](void *clientData, Tcl_Interp *interp, int argc,
+                          const char *argv[]) -> int {
+    Instance().Reset();
+    return TCL_OK;
+  };
+  Tcl_CreateCommand(interp, "profile_reset", profile_reset, nullptr, nullptr);
+
+  // profile_procs on|off
+  auto profile_procs = [](void *clientData, Tcl_Interp *interp, int argc,
+                          const char *argv[]) -> int {
+    int on = 0;
+    if (argc != 2 || Tcl_GetBoolean(interp, argv[1], &on) != TCL_OK) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp, "Usage: profile_procs on|off", (char *)NULL);
+      return TCL_ERROR;
+    }
+    if (Tcl_Eval(interp, PROC_TRACES) != TCL_OK) return TCL_ERROR;
+    t_profileProcs = on;
+    if (on) return Tcl_Eval(interp, "::foedag::profile::enable");
+    if (!t_procFrames.empty()) return TCL_OK;
+    return Tcl_Eval(interp, "::foedag::profile::disable");
+  };
+  Tcl_CreateCommand(interp, "profile_procs", profile_procs, nullptr, nullptr);
+
+  // hook <proc> <command> ?<code> <result>? enter|leave
+  auto hook = [](void *clientData, Tcl_Interp *interp, int argc,
+                 const char *argv[]) -> int {
+    if (argc < 4) return TCL_OK;
+    if (std::string(argv[argc - 1]) == "enter") {
+      t_procFrames.push_back(t_profileProcs);
+      if (t_profileProcs)
+        Instance().Enter(Instance().Lookup(std::string("proc ") + argv[1]));
+      return TCL_OK;
+    }
+    // A proc traced while running has no enter
+    if (t_procFrames.empty()) return TCL_OK;
+    bool entered = t_procFrames.back();
+    t_procFrames.pop_back();
+    if (entered) Instance().Leave();
+    if (!t_profileProcs && t_procFrames.empty())
+      return Tcl_Eval(interp, "::foedag::profile::disable");
+    return TCL_OK;
+  };
+  Tcl_CreateCommand(interp, "::foedag::profile::hook", hook, nullptr,
+                    nullptr);
+}
@@ -0,0 +1,131 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef COMMAND_PROFILER_H
+#define COMMAND_PROFILER_H
+
+struct Tcl_Interp;
+
+namespace FOEDAG {
+
+// Latency of the Tcl commands registered through TclInterpreter::registerCmd
+// and, when enabled, of the Tcl procs. Calls are timed with a steady clock,
+// the time spent in nested profiled calls is the difference between total and
+// self time. Latencies go into a log scale histogram (4 buckets per power of
+// two) from which p50/p99 are read. Allocation counts need a build with
+// FOEDAG_COUNT_ALLOCATIONS, they are 0 otherwise.
+class CommandProfiler {
+ public:
+  static constexpr size_t BUCKETS = 252;
+
+  struct Record {
+    explicit Record(const std::string &n) : name(n) {}
+    const std::string name;
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> selfNs{0};
+    std::atomic<uint64_t> maxNs{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> histogram[BUCKETS] = {};
+  };
+
+  struct Stats {
+    std::string name;
+    uint64_t calls;
+    uint64_t totalNs;
+    uint64_t selfNs;
+    uint64_t p50Ns;
+    uint64_t p99Ns;
+    uint64_t maxNs;
+    uint64_t allocations;
+  };
+
+  enum class SortKey { Calls, Total, Self, P50, P99, Max, Allocations };
+
+  // Times a call for the lifetime of the scope, nothing when disabled
+  class Scope {
+   public:
+    explicit Scope(Record *record);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    bool m_entered;
+  };
+
+  static CommandProfiler &Instance();
+
+  void SetEnabled(bool enabled) { m_enabled = enabled; }
+  bool Enabled() const { return m_enabled; }
+
+  // Record of a command, created on first use. Records live as long as the
+  // profiler, the pointer can be kept by the caller.
+  Record *Lookup(const std::string &name);
+
+  void Enter(Record *record);
+  // Ends the innermost call of the calling thread
+  void Leave();
+
+  void Reset();
+  // Commands called at least once, best first. top == 0 returns them all
+  std::vector<Stats> Report(SortKey key, size_t top = 0) const;
+  static std::string Format(const std::vector<Stats> &stats);
+  static bool ParseSortKey(const std::string &name, SortKey &key);
+
+  static size_t Bucket(uint64_t ns);
+  // Middle of the latencies falling into the bucket
+  static uint64_t BucketValue(size_t bucket);
+
+  // Allocations made by the calling thread so far
+  static uint64_t ThreadAllocations();
+
+  // profile_report, profile_reset and profile_procs
+  static void RegisterCommands(Tcl_Interp *interp);
+
+ private:
+  CommandProfiler() = default;
+
+  struct Frame {
+    Record *record;
+    std::chrono::steady_clock::time_point start;
+    uint64_t childNs;
+    uint64_t allocations;
+  };
+  static std::vector<Frame> &frames();
+
+  std::atomic<bool> m_enabled{true};
+  mutable std::mutex m_mutex;
+  std::map<std::string, std::unique_ptr<Record>> m_records;
+};
+
+}  // namespace FOEDAG
+
+#endif
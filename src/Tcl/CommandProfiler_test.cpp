@@ -0,0 +1,152 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Tcl/CommandProfiler.h"
+
+#include <string>
+
+#include "Tcl/TclInterpreter.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::HasSubstr;
+
+namespace FOEDAG {
+namespace {
+const CommandProfiler::Stats *find(
+    const std::vector<CommandProfiler::Stats> &stats, const std::string &name) {
+  for (const auto &s : stats) {
+    if (s.name == name) return &s;
+  }
+  return nullptr;
+}
+
+TEST(CommandProfiler, Buckets) {
+  for (uint64_t ns : {0ull, 7ull, 8ull, 100ull, 12345ull, 1000000007ull}) {
+    size_t bucket = CommandProfiler::Bucket(ns);
+    ASSERT_LT(bucket, CommandProfiler::BUCKETS);
+    uint64_t value = CommandProfiler::BucketValue(bucket);
+    // 4 buckets per power of two, the value is within 12.5%
+    EXPECT_LE(value, ns + ns / 8 + 1);
+    EXPECT_GE(value + ns / 8 + 1, ns);
+  }
+  EXPECT_LT(CommandProfiler::Bucket(UINT64_MAX), CommandProfiler::BUCKETS);
+}
+
+TEST(CommandProfiler, RegisteredCommands) {
+  TclInterpreter interpreter;
+  auto noop = [](void *clientData, Tcl_Interp *interp, int argc,
+                 const char *argv[]) -> int { return TCL_OK; };
+  auto outer = [](void *clientData, Tcl_Interp *interp, int argc,
+                  const char *argv[]) -> int {
+    return Tcl_Eval(interp, "profiler_test_inner; profiler_test_inner");
+  };
+  interpreter.registerCmd("profiler_test_inner", noop, nullptr, 0);
+  interpreter.registerCmd("profiler_test_outer", outer, nullptr, 0);
+  CommandProfiler::Instance().Reset();
+
+  for (int i = 0; i < 10; i++) interpreter.evalCmd("profiler_test_outer");
+
+  auto stats = CommandProfiler::Instance().Report(
+      CommandProfiler::SortKey::Calls);
+  const CommandProfiler::Stats *inner = find(stats, "profiler_test_inner");
+  const CommandProfiler::Stats *outerStats = find(stats, "profiler_test_outer");
+  ASSERT_NE(inner, nullptr);
+  ASSERT_NE(outerStats, nullptr);
+  EXPECT_EQ(inner->calls, 20u);
+  EXPECT_EQ(outerStats->calls, 10u);
+  EXPECT_EQ(stats.front().name, "profiler_test_inner");
+  EXPECT_GE(outerStats->totalNs, inner->totalNs);
+  EXPECT_LE(outerStats->selfNs, outerStats->totalNs - inner->totalNs);
+  EXPECT_LE(inner->p50Ns, inner->p99Ns);
+  EXPECT_LE(inner->p99Ns, inner->maxNs);
+
+  std::string report =
+      interpreter.evalCmd("profile_report -sort calls -top 1");
+  EXPECT_THAT(report, HasSubstr("profiler_test_inner"));
+  EXPECT_EQ(report.find("profiler_test_outer"), std::string::npos);
+
+  interpreter.evalCmd("profile_reset");
+  EXPECT_EQ(find(CommandProfiler::Instance().Report(
+                     CommandProfiler::SortKey::Total),
+                 "profiler_test_inner"),
+            nullptr);
+}
+
+TEST(CommandProfiler, Procs) {
+  TclInterpreter interpreter;
+  interpreter.evalCmd("proc profiler_before {} { return 1 }");
+  EXPECT_EQ(interpreter.evalCmd("profile_procs on"), "");
+  interpreter.evalCmd("namespace eval ns { proc after {} { ::profiler_before } }");
+  CommandProfiler::Instance().Reset();
+
+  interpreter.evalCmd("ns::after; ns::after; profiler_before");
+
+  auto stats = CommandProfiler::Instance().Report(
+      CommandProfiler::SortKey::Calls);
+  const CommandProfiler::Stats *before = find(stats, "proc ::profiler_before");
+  const CommandProfiler::Stats *after = find(stats, "proc ::ns::after");
+  ASSERT_NE(before, nullptr);
+  ASSERT_NE(after, nullptr);
+  EXPECT_EQ(before->calls, 3u);
+  EXPECT_EQ(after->calls, 2u);
+
+  EXPECT_EQ(interpreter.evalCmd("profile_procs off"), "");
+  CommandProfiler::Instance().Reset();
+  interpreter.evalCmd("profiler_before");
+  EXPECT_EQ(find(CommandProfiler::Instance().Report(
+                     CommandProfiler::SortKey::Calls),
+                 "proc ::profiler_before"),
+            nullptr);
+}
+
+TEST(CommandProfiler, ProcsSwitchedWhileRunning) {
+  TclInterpreter interpreter;
+  interpreter.evalCmd("proc profiler_stop {} { profile_procs off; return 1 }");
+  interpreter.evalCmd("proc profiler_start {} { profile_procs on; return 1 }");
+  interpreter.evalCmd("proc profiler_leaf {} { return 1 }");
+  EXPECT_EQ(interpreter.evalCmd("profile_procs on"), "");
+  CommandProfiler::Instance().Reset();
+
+  // Entered while on, so the leave still pops it
+  interpreter.evalCmd("profiler_stop");
+  interpreter.evalCmd("profiler_leaf");
+  auto stats =
+      CommandProfiler::Instance().Report(CommandProfiler::SortKey::Calls);
+  const CommandProfiler::Stats *stop = find(stats, "proc ::profiler_stop");
+  ASSERT_NE(stop, nullptr);
+  EXPECT_EQ(stop->calls, 1u);
+  EXPECT_EQ(find(stats, "proc ::profiler_leaf"), nullptr);
+
+  // Traced while running, the leave has no enter to pop
+  CommandProfiler::Instance().Reset();
+  interpreter.evalCmd("profiler_start");
+  interpreter.evalCmd("profiler_leaf; profiler_leaf");
+  stats = CommandProfiler::Instance().Report(CommandProfiler::SortKey::Calls);
+  EXPECT_EQ(find(stats, "proc ::profiler_start"), nullptr);
+  const CommandProfiler::Stats *leaf = find(stats, "proc ::profiler_leaf");
+  ASSERT_NE(leaf, nullptr);
+  EXPECT_EQ(leaf->calls, 2u);
+  EXPECT_EQ(interpreter.evalCmd("profile_procs off"), "");
+}
+
+}  // namespace
+}  // namespace FOEDAG
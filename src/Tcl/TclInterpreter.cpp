@@ -20,28 +20,41 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "TclInterpreter.h"
 
-#include <QString>
-#include <QSysInfo>
+#include <filesystem>
 #include <mutex>
 
+#include "Tcl/CommandProfiler.h"
+#include "Tcl/TclSampler.h"
+#include "Utils/MemoryTracker.h"
+#include "Utils/ResourceGovernor.h"
+
 using namespace FOEDAG;
 
 #include <tcl.h>
 
 TclInterpreter::TclInterpreter(const char *argv0) : interp(nullptr) {
-  static bool initLib;
-  if (!initLib) {
-    Tcl_FindExecutable(argv0);
-    initLib = true;
-  }
+  // Interpreters are also created on the compile server client threads
+  static std::once_flag initLib;
+  std::call_once(initLib, [argv0]() { Tcl_FindExecutable(argv0); });
   interp = Tcl_CreateInterp();
   Tcl_Init(interp);
   if (!interp) throw new std::runtime_error("failed to initialise Tcl library");
   evalCmd(TclHistoryScript());
+  CommandProfiler::RegisterCommands(interp);
+  TclSampler::Instance().Attach(
+      interp, argv0 ? std::filesystem::path(argv0).filename().string() : "");
+  TclSampler::RegisterCommands(interp);
+  MemoryTracker::RegisterCommands(interp);
+  ResourceGovernor::RegisterCommands(interp);
+  MemoryTracker::Allocate(MemoryTracker::TclInterpreters, 0);
 }
 
 TclInterpreter::~TclInterpreter() {
-  if (interp) Tcl_DeleteInterp(interp);
+  if (interp) {
+    TclSampler::Instance().Detach(interp);
+    Tcl_DeleteInterp(interp);
+    MemoryTracker::Release(MemoryTracker::TclInterpreters, 0);
+  }
 }
 
 std::string TclInterpreter::evalFile(const std::string &filename) {
@@ -65,82 +78,156 @@ std::string TclInterpreter::evalCmd(const std::string cmd, int *ret) {
   return std::string(Tcl_GetStringResult(interp));
 }
 
+// Registered commands are called through this wrapper to be profiled
+struct ProfiledCmd {
+  Tcl_CmdProc *proc;
+  ClientData clientData;
+  Tcl_CmdDeleteProc *deleteProc;
+  CommandProfiler::Record *record;
+};
+
+static int profiledCmd(ClientData clientData, Tcl_Interp *interp, int argc,
+                       const char *argv[]) {
+  ProfiledCmd *cmd = static_cast<ProfiledCmd *>(clientData);
+  CommandProfiler::Scope scope(cmd->record);
+  return cmd->proc(cmd->clientData, interp, argc, argv);
+}
+
+static void deleteProfiledCmd(ClientData clientData) {
+  ProfiledCmd *cmd = static_cast<ProfiledCmd *>(clientData);
+  if (cmd->deleteProc) cmd->deleteProc(cmd->clientData);
+  delete cmd;
+}
+
 void TclInterpreter::registerCmd(const std::string &cmdName, Tcl_CmdProc proc,
                                  ClientData clientData,
                                  Tcl_CmdDeleteProc *deleteProc) {
-  Tcl_CreateCommand(interp, cmdName.c_str(), proc, clientData, deleteProc);
+  ProfiledCmd *cmd = new ProfiledCmd{
+      proc, clientData, deleteProc,
+      CommandProfiler::Instance().Lookup(cmdName)};
+  Tcl_CreateCommand(interp, cmdName.c_str(), profiledCmd, cmd,
+                    deleteProfiledCmd);
 }
 
 std::string TclInterpreter::evalGuiTestFile(const std::string &filename) {
-  QString testHarness = R"(
+  // Each step (a complete command, it may span lines) runs as soon as the
+  // application settled: nothing pending in the event loop and, when the
+  // GUI defines test_busy, no console command or compile at work. Until
+  // then the step waits for test_busy to signal test_idle. A step not
+  // settling within test_timeout ms fails the test, so do background
+  // errors. wait_for waits on an explicit condition.
+  std::string testHarness = R"(
+  set test_timeout 30000
+
   proc test_harness { gui_script } {
-    global CONT errorInfo
+    global CONT test_steps test_error
     set fid [open $gui_script]
     set content [read $fid]
     close $fid
-    set errorInfo ""
-
-    catch {
-        
-        # Schedule commands
-        set lines [split $content "\n"]
-        set time 500
-        foreach line $lines {
-            if {[regexp {^#} $line]} {
-                continue
-            }
-            if {$line == ""} {
-                continue
-            }
-            after $time $line 
-            
-            
-            set time [expr $time + 500]
-        }
+
+    set test_steps {}
+    set command ""
+    foreach line [split $content "\n"] {
+      if {$command == "" &&
+          ([regexp {^\s*#} $line] || [string trim $line] == "")} {
+        continue
+      }
+      append command $line "\n"
+      if {[info complete $command]} {
+        lappend test_steps $command
+        set command ""
+      }
     }
-    
-    # Schedule GUI exit
-    set time [expr $time + 500]
-    after $time "puts \"GUI EXIT\" ; flush stdout; set CONT 0"
-    
-    # Enter loop
-    set CONT 1 
+
+    set test_error ""
+    interp bgerror {} test_bgerror
+    after idle [list test_step 0 [clock milliseconds]]
+
+    set CONT 1
     puts TEST_LOOP_ENTERED
     flush stdout
-    while {$CONT} {
-        set a 0
-        after 10 set a 1
-        %1
-        vwait a
-        if {$errorInfo != ""} {
-          puts $errorInfo
-          exit 1
-        }
-    }
+    vwait CONT
     puts TEST_LOOP_EXITED
     flush stdout
-    if {$errorInfo != ""} {
-        puts $errorInfo
+    if {$test_error != ""} {
+        puts $test_error
         exit 1
     }
-    
+
     puts "Tcl Exit" ; flush stdout
     tcl_exit
   }
 
+  proc test_bgerror { message options } {
+    global CONT test_error
+    set test_error [dict get $options -errorinfo]
+    set CONT 0
+  }
+
+  proc test_settled { } {
+    update
+    return [expr {![llength [info commands test_busy]] || ![test_busy]}]
+  }
+
+  # Runs step <index> once settled, waiting since <since>
+  proc test_step { index since } {
+    global CONT test_steps test_error test_timeout
+    if {$CONT == 0} {
+      return
+    }
+    while {![test_settled]} {
+      set remaining [expr {$test_timeout - ([clock milliseconds] - $since)}]
+      if {$remaining <= 0} {
+        set test_error "Step $index did not settle within $test_timeout ms:\
+                        [lindex $test_steps [expr {$index - 1}]]"
+        set CONT 0
+        return
+      }
+      set timer [after $remaining {set ::test_idle 0}]
+      vwait ::test_idle
+      after cancel $timer
+      if {$CONT == 0} {
+        return
+      }
+    }
+    if {$index >= [llength $test_steps]} {
+      puts "GUI EXIT" ; flush stdout
+      set CONT 0
+      return
+    }
+    if {[catch {uplevel #0 [lindex $test_steps $index]}]} {
+      set test_error $::errorInfo
+      set CONT 0
+      return
+    }
+    after idle [list test_step [expr {$index + 1}] [clock milliseconds]]
+  }
+
+  # wait_for <condition> ?-timeout <ms>?, the condition is an expression
+  # evaluated in the caller
+  proc wait_for { condition args } {
+    set timeout 10000
+    if {[llength $args] == 2 && [lindex $args 0] == "-timeout"} {
+      set timeout [lindex $args 1]
+    } elseif {[llength $args] != 0} {
+      error "Usage: wait_for <condition> ?-timeout <ms>?"
+    }
+    set deadline [expr {[clock milliseconds] + $timeout}]
+    while {![uplevel 1 [list expr $condition]]} {
+      if {[clock milliseconds] > $deadline} {
+        error "wait_for timed out after $timeout ms: $condition"
+      }
+      after 5 {set ::wait_for_tick 1}
+      vwait ::wait_for_tick
+    }
+  }
   )";
-  testHarness =
-      testHarness.arg((QSysInfo::productType() == "centos") ? R"(
-  # this delay for some reason fixes tests on CentOS but stuck on MAC
-  after 20
-)"
-                                                            : QString());
 
   std::string call_test = "proc call_test { } {\n";
   call_test += "test_harness " + filename + "\n";
   call_test += "}\n";
 
-  std::string completeScript = testHarness.toStdString() + "\n" + call_test;
+  std::string completeScript = testHarness + "\n" + call_test;
 
   int code = Tcl_Eval(interp, completeScript.c_str());
 
@@ -0,0 +1,67 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string>
+
+#include "Tcl/TclInterpreter.h"
+#include "benchmark/benchmark.h"
+
+namespace FOEDAG {
+namespace {
+void BM_EvalCmd(benchmark::State& state) {
+  TclInterpreter interpreter;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interpreter.evalCmd("set a 1"));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EvalCmd);
+
+// Script of range(0) commands evaluated in one evalCmd call
+void BM_EvalScript(benchmark::State& state) {
+  TclInterpreter interpreter;
+  std::string script;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    script += "set v" + std::to_string(i) + " [expr {" + std::to_string(i) +
+              " * 2}]\n";
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interpreter.evalCmd(script));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EvalScript)->RangeMultiplier(10)->Range(10, 10000);
+
+void BM_EvalProcLoop(benchmark::State& state) {
+  TclInterpreter interpreter;
+  interpreter.evalCmd(
+      "proc count {n} { set s 0; for {set i 0} {$i < $n} {incr i} { incr s "
+      "$i }; return $s }");
+  std::string cmd = "count " + std::to_string(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interpreter.evalCmd(cmd));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EvalProcLoop)->Arg(1000)->Arg(100000);
+
+}  // namespace
+}  // namespace FOEDAG
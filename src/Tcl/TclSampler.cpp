@@ -0,0 +1,220 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Tcl/TclSampler.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+extern "C" {
+#include <tcl.h>
+}
+
+using namespace FOEDAG;
+
+TclSampler &TclSampler::Instance() {
+  static TclSampler sampler;
+  return sampler;
+}
+
+TclSampler::~TclSampler() { Stop(); }
+
+void TclSampler::Attach(Tcl_Interp *interp, const std::string &name) {
+  Target *target = new Target;
+  target->handler = Tcl_AsyncCreate(asyncProc, target);
+  target->label = name.empty() ? "interp" : name;
+  // ';' separates the frames of a collapsed stack
+  for (char &ch : target->label) {
+    if (ch == ';' || ch == ' ') ch = '_';
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_targets[interp] = target;
+}
+
+void TclSampler::Detach(Tcl_Interp *interp) {
+  Target *target = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_targets.find(interp);
+    if (it == m_targets.end()) return;
+    target = it->second;
+    m_targets.erase(it);
+  }
+  Tcl_AsyncDelete(target->handler);
+  delete target;
+}
+
+int TclSampler::Start(int intervalMs) {
+  if (m_running || intervalMs <= 0) return -1;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stacks.clear();
+  }
+  m_running = true;
+  m_timer = std::thread(&TclSampler::timerLoop, this, intervalMs);
+  return 0;
+}
+
+void TclSampler::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_timerMutex);
+    m_running = false;
+  }
+  m_timerCv.notify_all();
+  if (m_timer.joinable()) m_timer.join();
+}
+
+void TclSampler::timerLoop(int intervalMs) {
+  auto next = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> timerLock(m_timerMutex);
+  while (m_running) {
+    next += std::chrono::milliseconds(intervalMs);
+    m_timerCv.wait_until(timerLock, next, [this] { return !m_running; });
+    if (!m_running) break;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &entry : m_targets) {
+      Tcl_AsyncMark(entry.second->handler);
+    }
+  }
+}
+
+void TclSampler::setStartFile(Tcl_Interp *interp, const std::string &file) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_targets.find(interp);
+  if (it != m_targets.end()) it->second->file = file;
+}
+
+std::string TclSampler::startFile(Tcl_Interp *interp) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_targets.find(interp);
+  return it == m_targets.end() ? "" : it->second->file;
+}
+
+int TclSampler::asyncProc(void *clientData, Tcl_Interp *interp, int code) {
+  // No interpreter is running a script, the thread is idle
+  if (interp == nullptr) return code;
+  Target *target = static_cast<Target *>(clientData);
+  Tcl_InterpState state = Tcl_SaveInterpState(interp, code);
+  Instance().sample(target, interp);
+  return Tcl_RestoreInterpState(interp, state);
+}
+
+void TclSampler::sample(Target *target, Tcl_Interp *interp) {
+  if (!m_running) return;
+
+  std::string stack = target->label;
+  int depth = 0;
+  if (Tcl_Eval(interp, "info level") == TCL_OK &&
+      Tcl_GetIntFromObj(nullptr, Tcl_GetObjResult(interp), &depth) == TCL_OK) {
+    for (int level = 1; level <= depth; level++) {
+      std::string cmd = "info level " + std::to_string(level);
+      if (Tcl_Eval(interp, cmd.c_str()) != TCL_OK) break;
+      Tcl_Obj *name = nullptr;
+      if (Tcl_ListObjIndex(nullptr, Tcl_GetObjResult(interp), 0, &name) !=
+              TCL_OK ||
+          name == nullptr) {
+        break;
+      }
+      // ';' separates the frames of a collapsed stack
+      std::string frame = Tcl_GetString(name);
+      for (char &ch : frame) {
+        if (ch == ';' || ch == ' ') ch = '_';
+      }
+      stack += ";" + frame;
+    }
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stacks[stack]++;
+}
+
+void TclSampler::WriteCollapsed(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const auto &entry : m_stacks) {
+    out << entry.first << " " << entry.second << "\n";
+  }
+}
+
+uint64_t TclSampler::Samples() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  uint64_t samples = 0;
+  for (const auto &entry : m_stacks) samples += entry.second;
+  return samples;
+}
+
+void TclSampler::RegisterCommands(Tcl_Interp *interp) {
+  auto profile_tcl = [](void *clientData, Tcl_Interp *interp, int argc,
+                        const char *argv[]) -> int {
+    std::string action = argc > 1 ? argv[1] : "";
+    int interval = 10;
+    std::string file;
+    bool ok = action == "start" || action == "stop";
+    for (int i = 2; i < argc && ok; i++) {
+      std::string option = argv[i];
+      if (action == "start" && option == "-interval" && i + 1 < argc) {
+        ok = Tcl_GetInt(interp, argv[++i], &interval) == TCL_OK;
+      } else if (option == "-file" && i + 1 < argc) {
+        file = argv[++i];
+      } else {
+        ok = false;
+      }
+    }
+    if (!ok) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp,
+                       "Usage: profile_tcl start ?-interval <ms>? ?-file "
+                       "<file>? | stop ?-file <file>?",
+                       (char *)NULL);
+      return TCL_ERROR;
+    }
+
+    TclSampler &sampler = Instance();
+    if (action == "start") {
+      if (0 != sampler.Start(interval)) {
+        Tcl_AppendResult(interp, "profile_tcl is already running",
+                         (char *)NULL);
+        return TCL_ERROR;
+      }
+      sampler.setStartFile(interp, file);
+      return TCL_OK;
+    }
+
+    sampler.Stop();
+    if (file.empty()) file = sampler.startFile(interp);
+    if (file.empty()) {
+      // Collapsed stacks as the result
+      std::ostringstream out;
+      sampler.WriteCollapsed(out);
+      Tcl_AppendResult(interp, out.str().c_str(), (char *)NULL);
+      return TCL_OK;
+    }
+    std::ofstream out(file);
+    if (!out) {
+      Tcl_AppendResult(interp, "Cannot write ", file.c_str(), (char *)NULL);
+      return TCL_ERROR;
+    }
+    sampler.WriteCollapsed(out);
+    Tcl_AppendResult(interp, std::to_string(sampler.Samples()).c_str(),
+                     " samples written to ", file.c_str(), (char *)NULL);
+    return TCL_OK;
+  };
+  Tcl_CreateCommand(interp, "profile_tcl", profile_tcl, nullptr, nullptr);
+}
@@ -0,0 +1,94 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef TCL_SAMPLER_H
+#define TCL_SAMPLER_H
+
+struct Tcl_Interp;
+struct Tcl_AsyncHandler_;
+
+namespace FOEDAG {
+
+// Sampling profiler of the Tcl call stacks. A timer thread marks an async
+// handler of every interpreter, the handler runs at the next safe point of
+// the interpreter thread and records the proc stack ("info level"). Safe
+// points are between byte codes, so a long C++ command counts as one sample of
+// its caller: the flame graph shows which procs run, not the native code.
+// Output is the collapsed stack format of flamegraph.pl, the first frame is
+// the name of the interpreter: "batchInterp;proc_a;proc_b <samples>".
+class TclSampler {
+ public:
+  static TclSampler &Instance();
+
+  // Called from the thread owning the interpreter. The samples of an
+  // interpreter without a name are labelled "interp".
+  void Attach(Tcl_Interp *interp, const std::string &name = "");
+  void Detach(Tcl_Interp *interp);
+
+  int Start(int intervalMs);
+  void Stop();
+  bool Running() const { return m_running; }
+  void WriteCollapsed(std::ostream &out) const;
+  uint64_t Samples() const;
+
+  // profile_tcl start ?-interval <ms>? | stop ?-file <file>?
+  static void RegisterCommands(Tcl_Interp *interp);
+
+ private:
+  TclSampler() = default;
+  ~TclSampler();
+
+  struct Target {
+    Tcl_AsyncHandler_ *handler;
+    std::string label;
+    // -file of the profile_tcl start of this interpreter
+    std::string file;
+  };
+
+  static int asyncProc(void *clientData, Tcl_Interp *interp, int code);
+  void sample(Target *target, Tcl_Interp *interp);
+  void timerLoop(int intervalMs);
+  void setStartFile(Tcl_Interp *interp, const std::string &file);
+  std::string startFile(Tcl_Interp *interp) const;
+
+  mutable std::mutex m_mutex;
+  std::map<Tcl_Interp *, Target *> m_targets;
+  std::map<std::string, uint64_t> m_stacks;
+
+  std::thread m_timer;
+  std::atomic<bool> m_running{false};
+  std::mutex m_timerMutex;
+  std::condition_variable m_timerCv;
+};
+
+}  // namespace FOEDAG
+
+#endif
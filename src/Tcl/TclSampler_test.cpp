@@ -0,0 +1,79 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Tcl/TclSampler.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <sstream>
+#include <string>
+
+#include "Tcl/TclInterpreter.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::ContainsRegex;
+using ::testing::HasSubstr;
+
+namespace FOEDAG {
+namespace {
+TEST(TclSampler, CollapsedStacks) {
+  TclInterpreter interpreter;
+  interpreter.evalCmd(
+      "proc spin {ms} { set end [expr {[clock milliseconds] + $ms}]; while "
+      "{[clock milliseconds] < $end} {} }");
+  interpreter.evalCmd("proc outer {} { spin 200 }");
+
+  EXPECT_EQ(interpreter.evalCmd("profile_tcl start -interval 1"), "");
+  interpreter.evalCmd("outer");
+  std::string stacks = interpreter.evalCmd("profile_tcl stop");
+
+  EXPECT_THAT(stacks, ContainsRegex("^interp;outer;spin [0-9]+"));
+  EXPECT_GT(TclSampler::Instance().Samples(), 10u);
+}
+
+TEST(TclSampler, NamedInterpreter) {
+  TclInterpreter named("/usr/bin/batch interp");
+  TclInterpreter other;
+  named.evalCmd(
+      "proc spin {ms} { set end [expr {[clock milliseconds] + $ms}]; while "
+      "{[clock milliseconds] < $end} {} }");
+  std::string file = ::testing::TempDir() + "tcl_sampler_" +
+                     std::to_string(getpid()) + ".folded";
+
+  // The -file of a start belongs to the interpreter that started
+  EXPECT_EQ(named.evalCmd("profile_tcl start -interval 1 -file " + file), "");
+  named.evalCmd("spin 100");
+  std::string stacks = other.evalCmd("profile_tcl stop");
+  EXPECT_THAT(stacks, ContainsRegex("^batch_interp;spin [0-9]+"));
+  EXPECT_FALSE(std::filesystem::exists(file));
+}
+
+TEST(TclSampler, Usage) {
+  TclInterpreter interpreter;
+  EXPECT_THAT(interpreter.evalCmd("profile_tcl"), HasSubstr("Usage"));
+  EXPECT_THAT(interpreter.evalCmd("profile_tcl stop -interval 1"),
+              HasSubstr("Usage"));
+}
+
+}  // namespace
+}  // namespace FOEDAG
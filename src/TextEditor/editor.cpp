@@ -1,16 +1,25 @@
 #include "editor.h"
 
+#include <QTimer>
+
 using namespace FOEDAG;
 
+// Files above this are mapped and appended to the editor in chunks of this
+// size, one chunk per event loop iteration
+#define LOAD_CHUNK_SIZE (4 * 1024 * 1024)
+// Above this lexing, folding and auto completion stay off
+#define LARGE_FILE_SIZE (32 * 1024 * 1024)
+
 Editor::Editor(QString strFileName, int iFileType, QWidget *parent)
     : QWidget(parent) {
   m_strFileName = strFileName;
+  m_iFileType = iFileType;
   m_toolBar = new QToolBar(this);
   m_toolBar->setIconSize(QSize(32, 32));
   InitToolBar();
 
   m_scintilla = new QsciScintilla(this);
-  InitScintilla(iFileType);
+  InitScintilla();
   SetScintillaText(strFileName);
 
   connect(m_scintilla, SIGNAL(textChanged()), this,
@@ -32,6 +41,20 @@ QString Editor::getFileName() const { return m_strFileName; }
 
 bool Editor::isModified() const { return m_scintilla->isModified(); }
 
+bool Editor::isLoading() const { return m_file.isOpen(); }
+
+bool Editor::isLargeFile() const { return m_largeFile; }
+
+void Editor::GotoLine(int line) {
+  if (isLoading()) {
+    m_pendingLine = line;
+    return;
+  }
+  m_scintilla->setCursorPosition(qMax(0, line - 1), 0);
+  m_scintilla->ensureLineVisible(qMax(0, line - 1));
+  m_scintilla->setFocus();
+}
+
 void Editor::FindFirst(const QString &strWord) {
   m_scintilla->findFirst(strWord, true, true, true, true, false);
   m_scintilla->findNext();
@@ -66,17 +89,28 @@ void Editor::Search() {
 }
 
 void Editor::Save() {
+  // The file is still mapped and only partly in the buffer
+  if (isLoading()) return;
   QFile file(m_strFileName);
   if (!file.open(QFile::WriteOnly)) {
     return;
   }
 
-  QTextStream out(&file);
   QApplication::setOverrideCursor(Qt::WaitCursor);
-  out << m_scintilla->text();
+  if (m_largeFile) {
+    // Write the editor buffer as is, no QString copy of the whole file
+    const char *text = reinterpret_cast<const char *>(
+        m_scintilla->SendScintilla(QsciScintilla::SCI_GETCHARACTERPOINTER));
+    long length = m_scintilla->SendScintilla(QsciScintilla::SCI_GETLENGTH);
+    file.write(text, length);
+  } else {
+    QTextStream out(&file);
+    out << m_scintilla->text();
+  }
   QApplication::restoreOverrideCursor();
 
   m_scintilla->setModified(false);
+  emit FileSaved(m_strFileName);
 }
 
 void Editor::Undo() { m_scintilla->undo(); }
@@ -93,9 +127,52 @@ void Editor::Delete() { m_scintilla->removeSelectedText(); }
 
 void Editor::SelectAll() { m_scintilla->selectAll(); }
 
+void Editor::Definition() {
+  QString strWord = CurrentWord();
+  if (!strWord.isEmpty()) emit GotoDefinition(strWord);
+}
+
+void Editor::References() {
+  QString strWord = CurrentWord();
+  if (!strWord.isEmpty()) emit FindReferences(strWord);
+}
+
+QString Editor::CurrentWord() const {
+  int line = 0, index = 0;
+  m_scintilla->getCursorPosition(&line, &index);
+  return m_scintilla->wordAtLineIndex(line, index);
+}
+
+QPoint Editor::CursorGlobalPos() const {
+  long pos = m_scintilla->SendScintilla(QsciScintilla::SCI_GETCURRENTPOS);
+  int x = m_scintilla->SendScintilla(QsciScintilla::SCI_POINTXFROMPOSITION, 0,
+                                     pos);
+  int y = m_scintilla->SendScintilla(QsciScintilla::SCI_POINTYFROMPOSITION, 0,
+                                     pos);
+  int height =
+      m_scintilla->SendScintilla(QsciScintilla::SCI_TEXTHEIGHT, 0, 0L);
+  return m_scintilla->viewport()->mapToGlobal(QPoint(x, y + height));
+}
+
+void Editor::SetCompletionWords(const QStringList &listWords) {
+  if (m_apis == nullptr) {
+    return;
+  }
+  // prepare() builds the completion lists on its own thread
+  m_apis->clear();
+  m_apis->add(QString("begin"));
+  m_apis->add(QString("always"));
+  foreach (const QString &strWord, listWords) {
+    m_apis->add(strWord);
+  }
+  m_apis->prepare();
+}
+
 void Editor::QscintillaSelectionChanged() { UpdateToolBarStates(); }
 
 void Editor::QscintillaModificationChanged(bool m) {
+  // Appending the chunks of a file being loaded is not a modification
+  if (isLoading()) return;
   m_actSave->setEnabled(m);
   emit EditorModificationChanged(m);
 }
@@ -169,6 +246,27 @@ void Editor::InitToolBar() {
   m_actSelect->setText(tr("&Select"));
   m_actSelect->setShortcut(tr("Ctrl+A"));
   m_toolBar->addAction(m_actSelect);
+  m_toolBar->addSeparator();
+
+  m_actReadOnly = new QAction(m_toolBar);
+  m_actReadOnly->setText(tr("Read Only"));
+  m_actReadOnly->setCheckable(true);
+  m_toolBar->addAction(m_actReadOnly);
+  m_toolBar->addSeparator();
+
+  m_actDefinition = new QAction(m_toolBar);
+  m_actDefinition->setText(tr("Go to Definition"));
+  m_actDefinition->setShortcut(tr("F12"));
+  m_toolBar->addAction(m_actDefinition);
+
+  m_actReferences = new QAction(m_toolBar);
+  m_actReferences->setText(tr("Find References"));
+  m_actReferences->setShortcut(tr("Shift+F12"));
+  m_toolBar->addAction(m_actReferences);
+  m_toolBar->addSeparator();
+
+  m_labelStatus = new QLabel(m_toolBar);
+  m_toolBar->addWidget(m_labelStatus);
 
   connect(m_actSearch, SIGNAL(triggered()), this, SLOT(Search()));
   connect(m_actSave, SIGNAL(triggered()), this, SLOT(Save()));
@@ -179,9 +277,13 @@ void Editor::InitToolBar() {
   connect(m_actPaste, SIGNAL(triggered()), this, SLOT(Paste()));
   connect(m_actDelete, SIGNAL(triggered()), this, SLOT(Delete()));
   connect(m_actSelect, SIGNAL(triggered()), this, SLOT(SelectAll()));
+  connect(m_actReadOnly, SIGNAL(toggled(bool)), this,
+          SLOT(ReadOnlyToggled(bool)));
+  connect(m_actDefinition, SIGNAL(triggered()), this, SLOT(Definition()));
+  connect(m_actReferences, SIGNAL(triggered()), this, SLOT(References()));
 }
 
-void Editor::InitScintilla(int iFileType) {
+void Editor::InitScintilla() {
   QFont font("Arial", 9, QFont::Normal);
   m_scintilla->setFont(font);
   QFontMetrics fontmetrics = QFontMetrics(font);
@@ -192,6 +294,14 @@ void Editor::InitScintilla(int iFileType) {
   m_scintilla->setTabWidth(4);
   m_scintilla->setAutoIndent(true);
   m_scintilla->setIndentationGuides(QsciScintilla::SC_IV_LOOKBOTH);
+
+  m_scintilla->setCaretLineVisible(true);
+  m_scintilla->setCaretLineBackgroundColor(Qt::lightGray);
+  m_scintilla->SendScintilla(QsciScintilla::SCI_SETCODEPAGE,
+                             QsciScintilla::SC_CP_UTF8);
+}
+
+void Editor::InitLexer(int iFileType) {
   m_scintilla->setBraceMatching(QsciScintilla::SloppyBraceMatch);
 
   QsciLexer *textLexer;
@@ -207,43 +317,162 @@ void Editor::InitScintilla(int iFileType) {
       FILE_TYPE_TCL == iFileType) {
     m_scintilla->setLexer(textLexer);
 
-    QsciAPIs *apis = new QsciAPIs(textLexer);
-    apis->add(QString("begin"));
-    apis->add(QString("always"));
-    apis->prepare();
+    m_apis = new QsciAPIs(textLexer);
+    m_apis->add(QString("begin"));
+    m_apis->add(QString("always"));
+    m_apis->prepare();
 
     m_scintilla->setAutoCompletionSource(QsciScintilla::AcsAll);
     m_scintilla->setAutoCompletionCaseSensitivity(true);
     m_scintilla->setAutoCompletionThreshold(1);
   }
 
-  m_scintilla->setCaretLineVisible(true);
-  m_scintilla->setCaretLineBackgroundColor(Qt::lightGray);
-  m_scintilla->SendScintilla(QsciScintilla::SCI_SETCODEPAGE,
-                             QsciScintilla::SC_CP_UTF8);
   m_scintilla->setFolding(QsciScintilla::BoxedTreeFoldStyle);
   m_scintilla->setFoldMarginColors(Qt::gray, Qt::lightGray);
 }
 
 void Editor::SetScintillaText(QString strFileName) {
-  QFile file(strFileName);
-  if (!file.open(QFile::ReadOnly)) {
+  m_file.setFileName(strFileName);
+  if (!m_file.open(QFile::ReadOnly)) {
     return;
   }
 
-  QTextStream in(&file);
-  QApplication::setOverrideCursor(Qt::WaitCursor);
-  m_scintilla->setText(in.readAll());
-  QApplication::restoreOverrideCursor();
+  qint64 size = m_file.size();
+  QByteArray head = m_file.peek(4096);
+  if (IsGeneratedFile(strFileName, head.constData(), head.size())) {
+    m_actReadOnly->setChecked(true);
+  }
+
+  if (size <= LOAD_CHUNK_SIZE) {
+    QTextStream in(&m_file);
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    m_scintilla->setText(in.readAll());
+    QApplication::restoreOverrideCursor();
+    m_file.close();
+
+    InitLexer(m_iFileType);
+    m_scintilla->setReadOnly(m_actReadOnly->isChecked());
+    m_scintilla->setModified(false);
+    return;
+  }
+
+  // Falls back to plain reads if the file cannot be mapped
+  m_mapped = m_file.map(0, size);
+  m_largeFile = size > LARGE_FILE_SIZE;
+
+  m_scintilla->setReadOnly(true);
+  m_scintilla->SendScintilla(QsciScintilla::SCI_SETUNDOCOLLECTION, false);
+  m_scintilla->SendScintilla(QsciScintilla::SCI_ALLOCATE,
+                             static_cast<unsigned long>(size + 1));
+  QTimer::singleShot(0, this, &Editor::LoadNextChunk);
+}
+
+void Editor::LoadNextChunk() {
+  if (!m_file.isOpen()) {
+    return;
+  }
+  qint64 size = m_file.size();
+  qint64 length = qMin<qint64>(LOAD_CHUNK_SIZE, size - m_loadOffset);
+  QByteArray buffer;
+  const char *data = nullptr;
+  if (m_mapped) {
+    data = reinterpret_cast<const char *>(m_mapped) + m_loadOffset;
+  } else {
+    buffer = m_file.read(length);
+    data = buffer.constData();
+    length = buffer.size();
+  }
+
+  // Stop after the last line feed so a UTF-8 sequence is never split
+  if (m_loadOffset + length < size) {
+    qint64 end = length;
+    while (end > 0 && data[end - 1] != '\n') end--;
+    if (end > 0) {
+      length = end;
+      if (!m_mapped) m_file.seek(m_loadOffset + length);
+    }
+  }
 
+  // Read only also blocks appending, the user must not edit meanwhile
+  m_scintilla->setReadOnly(false);
+  m_scintilla->SendScintilla(QsciScintilla::SCI_APPENDTEXT,
+                             static_cast<unsigned long>(length), data);
+  m_scintilla->SendScintilla(QsciScintilla::SCI_SETSAVEPOINT);
+  m_scintilla->setReadOnly(true);
+  m_loadOffset += length;
+
+  if (length <= 0 || m_loadOffset >= size) {
+    FinishLoading();
+    return;
+  }
+  m_labelStatus->setText(
+      tr("Loading %1%").arg(int(m_loadOffset * 100 / size)));
+  QTimer::singleShot(0, this, &Editor::LoadNextChunk);
+}
+
+void Editor::FinishLoading() {
+  if (m_mapped) {
+    m_file.unmap(const_cast<uchar *>(m_mapped));
+    m_mapped = nullptr;
+  }
+  m_file.close();
+
+  m_scintilla->SendScintilla(QsciScintilla::SCI_SETUNDOCOLLECTION, true);
+  m_scintilla->SendScintilla(QsciScintilla::SCI_EMPTYUNDOBUFFER);
+  m_scintilla->setReadOnly(m_actReadOnly->isChecked());
   m_scintilla->setModified(false);
+  m_actSave->setEnabled(false);
+  m_scintilla->setMarginWidth(
+      0, QString(QString::number(m_scintilla->lines()).size() + 1, '0'));
+
+  if (m_largeFile) {
+    m_labelStatus->setText(tr("Large file: highlighting disabled"));
+  } else {
+    // Lexing a file of this size is deferred until the text is complete
+    m_labelStatus->clear();
+    InitLexer(m_iFileType);
+  }
+  UpdateToolBarStates();
+
+  if (m_pendingLine > 0) {
+    GotoLine(m_pendingLine);
+    m_pendingLine = 0;
+  }
+}
+
+void Editor::ReadOnlyToggled(bool checked) {
+  if (!isLoading()) {
+    m_scintilla->setReadOnly(checked);
+  }
+  UpdateToolBarStates();
+}
+
+bool Editor::IsGeneratedFile(const QString &strFileName, const char *head,
+                             qint64 size) {
+  QString name = QFileInfo(strFileName).fileName().toLower();
+  static const QStringList generatedNames = {"netlist", "post_synth",
+                                             "post_route", "_synth."};
+  for (const QString &pattern : generatedNames) {
+    if (name.contains(pattern)) return true;
+  }
+  static const QStringList generatedSuffixes = {"edif", "edf", "blif",
+                                                "eblif", "vqm", "vm"};
+  if (generatedSuffixes.contains(QFileInfo(strFileName).suffix().toLower())) {
+    return true;
+  }
+  // Tools write a banner at the top of their output
+  QByteArray text = QByteArray(head, int(size)).toLower();
+  return text.contains("generated by") ||
+         text.contains("automatically generated");
 }
 
 void Editor::UpdateToolBarStates() {
   m_actUndo->setEnabled(m_scintilla->isUndoAvailable());
   m_actRedo->setEnabled(m_scintilla->isRedoAvailable());
 
-  m_actCut->setEnabled(m_scintilla->hasSelectedText());
+  bool editable = !m_scintilla->isReadOnly();
+  m_actCut->setEnabled(editable && m_scintilla->hasSelectedText());
   m_actCopy->setEnabled(m_scintilla->hasSelectedText());
-  m_actDelete->setEnabled(m_scintilla->hasSelectedText());
+  m_actPaste->setEnabled(editable);
+  m_actDelete->setEnabled(editable && m_scintilla->hasSelectedText());
 }
@@ -4,6 +4,7 @@
 #include <QApplication>
 #include <QFile>
 #include <QFileInfo>
+#include <QLabel>
 #include <QObject>
 #include <QTextStream>
 #include <QToolBar>
@@ -32,6 +33,19 @@ class Editor : public QWidget {
 
   QString getFileName() const;
   bool isModified() const;
+  // Text is still being loaded in chunks
+  bool isLoading() const;
+  // Highlighting and folding are off for files above LARGE_FILE_SIZE
+  bool isLargeFile() const;
+
+  // 1 based, applied once loading is done
+  void GotoLine(int line);
+
+  // Project symbols offered by the auto completion
+  void SetCompletionWords(const QStringList& listWords);
+  // Word under the cursor and the cursor position on screen
+  QString CurrentWord() const;
+  QPoint CursorGlobalPos() const;
 
   void FindFirst(const QString& strWord);
   void FindNext(const QString& strWord);
@@ -42,6 +56,9 @@ class Editor : public QWidget {
  signals:
   void EditorModificationChanged(bool m);
   void ShowSearchDialog(QString);
+  void GotoDefinition(QString);
+  void FindReferences(QString);
+  void FileSaved(QString);
 
  public slots:
   void Save();
@@ -55,14 +72,27 @@ class Editor : public QWidget {
   void Paste();
   void Delete();
   void SelectAll();
+  void Definition();
+  void References();
 
   void QScintillaTextChanged();
   void QscintillaSelectionChanged();
   void QscintillaModificationChanged(bool m);
 
+  void LoadNextChunk();
+  void ReadOnlyToggled(bool checked);
+
  private:
   QString m_strFileName;
   QsciScintilla* m_scintilla;
+  int m_iFileType;
+
+  // Chunked loading of a memory mapped file
+  QFile m_file;
+  const uchar* m_mapped{nullptr};
+  qint64 m_loadOffset{0};
+  bool m_largeFile{false};
+  int m_pendingLine{0};
 
   QToolBar* m_toolBar;
   QAction* m_actSearch;
@@ -77,10 +107,19 @@ class Editor : public QWidget {
   QAction* m_actDelete;
 
   QAction* m_actSelect;
+  QAction* m_actReadOnly;
+  QAction* m_actDefinition;
+  QAction* m_actReferences;
+  QsciAPIs* m_apis{nullptr};
+  QLabel* m_labelStatus;
 
   void InitToolBar();
-  void InitScintilla(int iFileType);
+  void InitScintilla();
+  void InitLexer(int iFileType);
   void SetScintillaText(QString strFileName);
+  void FinishLoading();
+  static bool IsGeneratedFile(const QString& strFileName, const char* head,
+                              qint64 size);
 
   void UpdateToolBarStates();
 };
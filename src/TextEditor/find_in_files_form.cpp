@@ -0,0 +1,231 @@
+#include "find_in_files_form.h"
+
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+#include "MainWindow/Session.h"
+
+using namespace FOEDAG;
+
+#define MAX_RESULTS 10000
+
+FindInFilesForm::FindInFilesForm(QWidget *parent) : QWidget(parent) {
+  m_lineEditPattern = new QLineEdit(this);
+  m_lineEditPattern->setPlaceholderText(tr("Find in project files"));
+  m_checkRegex = new QCheckBox(tr("Regex"), this);
+  m_checkCase = new QCheckBox(tr("Match case"), this);
+  m_labelStatus = new QLabel(this);
+
+  m_treeResults = new QTreeWidget(this);
+  m_treeResults->setHeaderHidden(true);
+  m_treeResults->setUniformRowHeights(true);
+
+  QHBoxLayout *hbox = new QHBoxLayout();
+  hbox->addWidget(m_lineEditPattern);
+  hbox->addWidget(m_checkRegex);
+  hbox->addWidget(m_checkCase);
+
+  QVBoxLayout *vbox = new QVBoxLayout();
+  vbox->addLayout(hbox);
+  vbox->addWidget(m_labelStatus);
+  vbox->addWidget(m_treeResults);
+  vbox->setContentsMargins(0, 0, 0, 0);
+  vbox->setSpacing(1);
+  setLayout(vbox);
+
+  connect(m_lineEditPattern, SIGNAL(returnPressed()), this, SLOT(SlotFind()));
+  connect(m_treeResults, SIGNAL(itemActivated(QTreeWidgetItem *, int)), this,
+          SLOT(SlotItemActivated(QTreeWidgetItem *, int)));
+}
+
+FindInFilesForm::~FindInFilesForm() {
+  if (m_searchThread.joinable()) {
+    m_searchThread.join();
+  }
+}
+
+void FindInFilesForm::SetFileProvider(std::function<QStringList()> provider) {
+  m_fileProvider = provider;
+}
+
+void FindInFilesForm::SetIndexFile(const QString &strIndexFile) {
+  m_strIndexFile = strIndexFile;
+  m_indexLoaded = false;
+}
+
+std::vector<std::string> FindInFilesForm::CollectFiles() const {
+  std::vector<std::string> files;
+  if (m_fileProvider) {
+    foreach (const QString &strFile, m_fileProvider()) {
+      files.push_back(strFile.toStdString());
+    }
+  }
+  return files;
+}
+
+// Runs on the search thread or the Tcl thread, never both at once
+void FindInFilesForm::UpdateIndex(const std::vector<std::string> &files) {
+  if (!m_indexLoaded && !m_strIndexFile.isEmpty()) {
+    m_index.Load(m_strIndexFile.toStdString());
+    m_indexLoaded = true;
+  }
+  m_index.Update(files);
+  if (m_index.FilesIndexed() > 0 && !m_strIndexFile.isEmpty()) {
+    m_index.Save(m_strIndexFile.toStdString());
+  }
+}
+
+bool FindInFilesForm::Search(const QString &strPattern,
+                             const TrigramIndex::Options &options,
+                             std::vector<TrigramIndex::Match> &matches,
+                             QString &strError) {
+  if (m_searchThread.joinable()) {
+    m_searchThread.join();
+    // The finished signal of the joined search is stale now, finish it
+    // under a new generation: show its results or run the pending search
+    int generation = ++m_searchGeneration;
+    QMetaObject::invokeMethod(this, "SlotSearchFinished", Qt::QueuedConnection,
+                              Q_ARG(int, generation));
+  }
+  UpdateIndex(CollectFiles());
+  std::string error;
+  bool ok = m_index.Search(strPattern.toStdString(), options, matches, error);
+  strError = QString::fromStdString(error);
+  return ok;
+}
+
+void FindInFilesForm::SlotFind() {
+  QString strPattern = m_lineEditPattern->text();
+  if (strPattern.isEmpty()) {
+    return;
+  }
+  // One search at a time, the last request runs once the current one is done
+  if (m_searchThread.joinable()) {
+    m_searchPending = true;
+    return;
+  }
+
+  TrigramIndex::Options options;
+  options.regex = m_checkRegex->isChecked();
+  options.caseSensitive = m_checkCase->isChecked();
+  options.maxResults = MAX_RESULTS;
+  std::vector<std::string> files = CollectFiles();
+  std::string pattern = strPattern.toStdString();
+  m_labelStatus->setText(tr("Searching..."));
+
+  int generation = ++m_searchGeneration;
+  m_searchThread = std::thread([this, files, pattern, options, generation]() {
+    UpdateIndex(files);
+    std::string error;
+    m_matches.clear();
+    m_index.Search(pattern, options, m_matches, error);
+    m_strError = QString::fromStdString(error);
+    QMetaObject::invokeMethod(this, "SlotSearchFinished",
+                              Qt::QueuedConnection, Q_ARG(int, generation));
+  });
+}
+
+void FindInFilesForm::SlotSearchFinished(int generation) {
+  // Search() joined this one already, the thread may belong to a newer search
+  if (generation != m_searchGeneration) {
+    return;
+  }
+  if (m_searchThread.joinable()) {
+    m_searchThread.join();
+  }
+  if (m_searchPending) {
+    m_searchPending = false;
+    SlotFind();
+    return;
+  }
+
+  m_treeResults->clear();
+  if (!m_strError.isEmpty()) {
+    m_labelStatus->setText(m_strError);
+    return;
+  }
+
+  QTreeWidgetItem *fileItem = nullptr;
+  int files = 0;
+  for (const auto &match : m_matches) {
+    QString strFile = QString::fromStdString(match.file);
+    if (fileItem == nullptr || fileItem->data(0, Qt::UserRole) != strFile) {
+      fileItem = new QTreeWidgetItem(m_treeResults);
+      fileItem->setText(0, strFile);
+      fileItem->setData(0, Qt::UserRole, strFile);
+      fileItem->setData(0, Qt::UserRole + 1, 1);
+      fileItem->setExpanded(true);
+      files++;
+    }
+    QTreeWidgetItem *item = new QTreeWidgetItem(fileItem);
+    item->setText(0, QString("%1: %2")
+                         .arg(match.line)
+                         .arg(QString::fromStdString(match.text).trimmed()));
+    item->setData(0, Qt::UserRole, strFile);
+    item->setData(0, Qt::UserRole + 1, match.line);
+  }
+  QString strStatus =
+      tr("%1 matches in %2 files").arg(m_matches.size()).arg(files);
+  if (m_matches.size() >= MAX_RESULTS) {
+    strStatus += tr(" (truncated)");
+  }
+  m_labelStatus->setText(strStatus);
+}
+
+void FindInFilesForm::SlotItemActivated(QTreeWidgetItem *item, int column) {
+  Q_UNUSED(column);
+  emit OpenFileAtLine(item->data(0, Qt::UserRole).toString(),
+                      item->data(0, Qt::UserRole + 1).toInt());
+}
+
+void FindInFilesForm::RegisterCommands(FOEDAG::Session *session) {
+  auto find_in_files = [](void *clientData, Tcl_Interp *interp, int argc,
+                          const char *argv[]) -> int {
+    FindInFilesForm *form = static_cast<FindInFilesForm *>(clientData);
+    TrigramIndex::Options options;
+    QString strPattern;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++) {
+      QString arg{argv[i]};
+      if (arg == "-regexp") {
+        options.regex = true;
+      } else if (arg == "-nocase") {
+        options.caseSensitive = false;
+      } else if (arg == "-max" && i + 1 < argc) {
+        int max = 0;
+        ok = Tcl_GetInt(interp, argv[++i], &max) == TCL_OK && max >= 0;
+        options.maxResults = size_t(max);
+      } else if (strPattern.isEmpty()) {
+        strPattern = arg;
+      } else {
+        ok = false;
+      }
+    }
+    if (!ok || strPattern.isEmpty()) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp,
+                       "Usage: find_in_files ?-regexp? ?-nocase? ?-max "
+                       "<count>? <pattern>",
+                       (char *)NULL);
+      return TCL_ERROR;
+    }
+
+    std::vector<TrigramIndex::Match> matches;
+    QString strError;
+    if (!form->Search(strPattern, options, matches, strError)) {
+      Tcl_AppendResult(interp, qPrintable(strError), (char *)NULL);
+      return TCL_ERROR;
+    }
+    // One {file line text} element per match
+    for (const auto &match : matches) {
+      std::string line = std::to_string(match.line);
+      const char *fields[] = {match.file.c_str(), line.c_str(),
+                              match.text.c_str()};
+      char *element = Tcl_Merge(3, fields);
+      Tcl_AppendElement(interp, element);
+      Tcl_Free(element);
+    }
+    return TCL_OK;
+  };
+  session->TclInterp()->registerCmd("find_in_files", find_in_files, this, 0);
+}
@@ -0,0 +1,70 @@
+#ifndef FIND_IN_FILES_FORM_H
+#define FIND_IN_FILES_FORM_H
+
+#include <QCheckBox>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTreeWidget>
+#include <QWidget>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "trigram_index.h"
+
+namespace FOEDAG {
+class Session;
+
+// Searches all the files of the project. The trigram index is brought up to
+// date and queried on a worker thread, results are listed per file.
+class FindInFilesForm : public QWidget {
+  Q_OBJECT
+
+ public:
+  explicit FindInFilesForm(QWidget *parent = nullptr);
+  ~FindInFilesForm();
+
+  // Returns the absolute paths of the files to search
+  void SetFileProvider(std::function<QStringList()> provider);
+  // Index persisted there between sessions
+  void SetIndexFile(const QString &strIndexFile);
+
+  // Blocking search used by the find_in_files command
+  bool Search(const QString &strPattern, const TrigramIndex::Options &options,
+              std::vector<TrigramIndex::Match> &matches, QString &strError);
+
+  void RegisterCommands(FOEDAG::Session *session);
+
+ signals:
+  void OpenFileAtLine(QString, int);
+
+ public slots:
+  void SlotFind();
+
+ private slots:
+  void SlotSearchFinished(int generation);
+  void SlotItemActivated(QTreeWidgetItem *item, int column);
+
+ private:
+  QLineEdit *m_lineEditPattern;
+  QCheckBox *m_checkRegex;
+  QCheckBox *m_checkCase;
+  QLabel *m_labelStatus;
+  QTreeWidget *m_treeResults;
+
+  std::function<QStringList()> m_fileProvider;
+  QString m_strIndexFile;
+  TrigramIndex m_index;
+  bool m_indexLoaded{false};
+
+  std::thread m_searchThread;
+  bool m_searchPending{false};
+  int m_searchGeneration{0};
+  std::vector<TrigramIndex::Match> m_matches;
+  QString m_strError;
+
+  std::vector<std::string> CollectFiles() const;
+  void UpdateIndex(const std::vector<std::string> &files);
+};
+}  // namespace FOEDAG
+#endif  // FIND_IN_FILES_FORM_H
@@ -0,0 +1,615 @@
+#include "symbol_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <sstream>
+#include <unordered_set>
+
+#include "Utils/HdlLexer.h"
+#include "Utils/ParallelFor.h"
+
+using namespace FOEDAG;
+
+namespace {
+
+using Token = HdlToken;
+
+std::string toLower(std::string str) {
+  std::transform(str.begin(), str.end(), str.begin(),
+                 [](unsigned char ch) { return std::tolower(ch); });
+  return str;
+}
+
+bool isIdent(const Token &token) {
+  return token.kind == Token::Kind::Identifier;
+}
+
+// Identifiers and punctuation with their position, the extractor does not
+// look at strings, numbers and compiler directives
+std::vector<Token> tokenize(const char *data, size_t size, bool vhdl) {
+  std::vector<Token> tokens = HdlLexer::Tokenize(data, size, vhdl);
+  tokens.erase(std::remove_if(tokens.begin(), tokens.end(),
+                              [](const Token &token) {
+                                return token.kind != Token::Kind::Identifier &&
+                                       token.kind != Token::Kind::Punct;
+                              }),
+               tokens.end());
+  return tokens;
+}
+
+// Words skipped when looking for the declared name
+const std::unordered_set<std::string> verilogTypeWords = {
+    "input",   "output",   "inout",  "ref",      "wire",     "reg",
+    "logic",   "bit",      "byte",   "integer",  "int",      "shortint",
+    "longint", "real",     "time",   "tri",      "tri0",     "tri1",
+    "wand",    "wor",      "supply0", "supply1", "genvar",   "var",
+    "signed",  "unsigned", "const",  "static",   "automatic", "parameter",
+    "localparam", "type",  "typedef", "struct",  "union",    "enum",
+    "packed",  "void",     "string", "shortreal", "realtime", "interconnect",
+    "uwire",   "trireg",   "triand", "trior"};
+
+const std::unordered_set<std::string> verilogSignalWords = {
+    "wire",    "reg",     "logic",  "bit",     "byte",    "integer",
+    "int",     "shortint", "longint", "real",  "time",    "tri",
+    "tri0",    "tri1",    "wand",   "wor",     "supply0", "supply1",
+    "genvar",  "var",     "uwire",  "trireg",  "triand",  "trior",
+    "string",  "shortreal", "realtime"};
+
+class Extractor {
+ public:
+  Extractor(const std::vector<Token> &tokens,
+            std::vector<SymbolIndex::Symbol> &symbols)
+      : m_tokens(tokens), m_symbols(symbols) {}
+
+  void Verilog();
+  void Vhdl();
+
+ private:
+  const std::vector<Token> &m_tokens;
+  std::vector<SymbolIndex::Symbol> &m_symbols;
+  std::string m_scope;
+
+  void emit(const Token &token, SymbolIndex::Kind kind,
+            const std::string &scope) {
+    m_symbols.push_back(
+        {token.text, kind, std::string(), token.line, token.column, scope});
+  }
+  // Next identifier at or after i, skipping the given words
+  size_t nextIdent(size_t i,
+                   const std::unordered_set<std::string> &skip = {}) const {
+    while (i < m_tokens.size() &&
+           (!isIdent(m_tokens[i]) || skip.count(toLower(m_tokens[i].text)))) {
+      if (!isIdent(m_tokens[i])) return m_tokens.size();
+      i++;
+    }
+    return i;
+  }
+};
+
+void Extractor::Verilog() {
+  using Kind = SymbolIndex::Kind;
+  bool inDecl = false;
+  Kind declKind = Kind::Signal;
+  int declDepth = 0;
+  int depth = 0;
+  long last = -1;
+  bool skipInit = false;
+
+  auto endName = [&]() {
+    if (inDecl && last >= 0 && !skipInit) {
+      emit(m_tokens[last], declKind, m_scope);
+    }
+    last = -1;
+  };
+
+  for (size_t i = 0; i < m_tokens.size(); i++) {
+    const Token &token = m_tokens[i];
+    if (isIdent(token)) {
+      const std::string &word = token.text;
+      if (word == "module" || word == "macromodule" || word == "interface" ||
+          word == "program" || word == "package") {
+        size_t n = nextIdent(i + 1, {"automatic", "static"});
+        if (n < m_tokens.size()) {
+          emit(m_tokens[n],
+               word == "interface"
+                   ? Kind::Interface
+                   : (word == "package" ? Kind::Package : Kind::Module),
+               std::string());
+          m_scope = m_tokens[n].text;
+          i = n;
+        }
+        inDecl = false;
+        depth = 0;
+        continue;
+      }
+      if (word == "endmodule" || word == "endinterface" ||
+          word == "endprogram" || word == "endpackage") {
+        m_scope.clear();
+        inDecl = false;
+        depth = 0;
+        continue;
+      }
+      if (word == "function" || word == "task") {
+        // Name is the last identifier before the arguments, the body and its
+        // local declarations are skipped
+        long name = -1;
+        size_t n = i + 1;
+        for (; n < m_tokens.size(); n++) {
+          if (!isIdent(m_tokens[n])) {
+            if (m_tokens[n].text == "(" || m_tokens[n].text == ";") break;
+            continue;
+          }
+          if (!verilogTypeWords.count(m_tokens[n].text)) name = n;
+        }
+        if (name >= 0) emit(m_tokens[name], Kind::Function, m_scope);
+        // Prototypes (DPI imports, extern, pure virtual) have no body
+        bool prototype = false;
+        for (size_t back = 1; back <= 2 && back <= i; back++) {
+          const std::string &prev = m_tokens[i - back].text;
+          if (prev == "import" || prev == "extern" || prev == "pure") {
+            prototype = true;
+          }
+        }
+        std::string end = word == "function" ? "endfunction" : "endtask";
+        if (prototype) end = ";";
+        while (n < m_tokens.size() && m_tokens[n].text != end) n++;
+        i = n;
+        continue;
+      }
+      Kind kind = Kind::Signal;
+      bool starts = true;
+      if (word == "input" || word == "output" || word == "inout" ||
+          word == "ref") {
+        kind = Kind::Port;
+      } else if (word == "parameter" || word == "localparam") {
+        kind = Kind::Parameter;
+      } else if (word == "typedef") {
+        kind = Kind::Type;
+      } else if (verilogSignalWords.count(word)) {
+        // "input wire a" or "parameter int W" keep their kind
+        starts = !inDecl;
+      } else {
+        starts = false;
+      }
+      if (starts) {
+        inDecl = true;
+        declKind = kind;
+        declDepth = depth;
+        last = -1;
+        skipInit = false;
+        continue;
+      }
+      if (inDecl && depth == declDepth && !skipInit &&
+          !verilogTypeWords.count(word)) {
+        last = i;
+      }
+      continue;
+    }
+
+    char ch = token.text[0];
+    if (ch == '(' || ch == '[' || ch == '{') {
+      depth++;
+    } else if (ch == ')' || ch == ']' || ch == '}') {
+      if (inDecl && depth == declDepth) {
+        // End of an ANSI port or parameter list
+        endName();
+        inDecl = false;
+      }
+      depth = std::max(0, depth - 1);
+    } else if (inDecl && depth == declDepth) {
+      if (ch == '=') {
+        endName();
+        skipInit = true;
+      } else if (ch == ',') {
+        endName();
+        skipInit = false;
+      } else if (ch == ';') {
+        endName();
+        inDecl = false;
+      }
+    }
+  }
+}
+
+void Extractor::Vhdl() {
+  using Kind = SymbolIndex::Kind;
+  bool inDecl = false;
+  Kind declKind = Kind::Signal;
+  int nameDepth = 0;
+  bool listDecl = false;   // port ( ... ) or generic ( ... )
+  bool waitParen = false;
+  bool afterColon = false;
+  int depth = 0;
+  std::vector<size_t> names;
+
+  for (size_t i = 0; i < m_tokens.size(); i++) {
+    const Token &token = m_tokens[i];
+    if (isIdent(token)) {
+      std::string word = toLower(token.text);
+      if (inDecl && !waitParen) {
+        if (depth == nameDepth && !afterColon) names.push_back(i);
+        continue;
+      }
+      if (word == "entity" || word == "package") {
+        size_t n = nextIdent(i + 1);
+        if (n < m_tokens.size() && toLower(m_tokens[n].text) == "body") {
+          n = nextIdent(n + 1);
+          if (n < m_tokens.size()) m_scope = m_tokens[n].text;
+          i = n;
+          continue;
+        }
+        // "end entity" and "u0 : entity work.core" are not declarations
+        bool afterEnd = i > 0 && toLower(m_tokens[i - 1].text) == "end";
+        if (n < m_tokens.size() && !afterEnd &&
+            toLower(m_tokens[n].text) != "work") {
+          emit(m_tokens[n], word == "entity" ? Kind::Module : Kind::Package,
+               std::string());
+          m_scope = m_tokens[n].text;
+          i = n;
+        }
+        continue;
+      }
+      if (word == "architecture") {
+        size_t n = nextIdent(i + 1);
+        if (n + 2 < m_tokens.size() && toLower(m_tokens[n + 1].text) == "of") {
+          m_scope = m_tokens[n + 2].text;
+          i = n + 2;
+        }
+        continue;
+      }
+      if (word == "component") {
+        // Ports of a component declaration belong to another entity
+        size_t n = i + 1;
+        while (n + 1 < m_tokens.size() &&
+               !(toLower(m_tokens[n].text) == "end" &&
+                 toLower(m_tokens[n + 1].text) == "component")) {
+          n++;
+        }
+        i = n + 1;
+        continue;
+      }
+      if (word == "function" || word == "procedure") {
+        size_t n = nextIdent(i + 1);
+        if (n < m_tokens.size() && (i == 0 || toLower(m_tokens[i - 1].text) !=
+                                                  "end")) {
+          emit(m_tokens[n], Kind::Function, m_scope);
+          i = n;
+        }
+        continue;
+      }
+      if (word == "type" || word == "subtype") {
+        size_t n = nextIdent(i + 1);
+        if (n < m_tokens.size()) {
+          emit(m_tokens[n], Kind::Type, m_scope);
+          i = n;
+        }
+        continue;
+      }
+      if (word == "port" || word == "generic") {
+        // "port map" is an instantiation
+        if (i + 1 < m_tokens.size() && toLower(m_tokens[i + 1].text) == "map") {
+          continue;
+        }
+        inDecl = true;
+        waitParen = true;
+        listDecl = true;
+        afterColon = false;
+        declKind = word == "port" ? Kind::Port : Kind::Parameter;
+        names.clear();
+        continue;
+      }
+      if (word == "signal" || word == "constant" || word == "variable") {
+        inDecl = true;
+        waitParen = false;
+        listDecl = false;
+        afterColon = false;
+        nameDepth = depth;
+        declKind = word == "constant" ? Kind::Parameter : Kind::Signal;
+        names.clear();
+      }
+      continue;
+    }
+
+    char ch = token.text[0];
+    if (ch == '(') {
+      depth++;
+      if (inDecl && waitParen) {
+        waitParen = false;
+        nameDepth = depth;
+      }
+    } else if (ch == ')') {
+      if (inDecl && listDecl && depth == nameDepth) inDecl = false;
+      depth = std::max(0, depth - 1);
+    } else if (inDecl && depth == nameDepth) {
+      if (ch == ':' && !afterColon) {
+        for (size_t n : names) emit(m_tokens[n], declKind, m_scope);
+        names.clear();
+        afterColon = true;
+      } else if (ch == ';') {
+        afterColon = false;
+        names.clear();
+        if (!listDecl) inDecl = false;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+SymbolIndex::SymbolIndex(unsigned int threads)
+    : m_threads(ParallelFor::Threads(threads)) {}
+
+const char *SymbolIndex::KindName(Kind kind) {
+  switch (kind) {
+    case Kind::Module:
+      return "module";
+    case Kind::Interface:
+      return "interface";
+    case Kind::Package:
+      return "package";
+    case Kind::Port:
+      return "port";
+    case Kind::Parameter:
+      return "parameter";
+    case Kind::Signal:
+      return "signal";
+    case Kind::Function:
+      return "function";
+    case Kind::Type:
+      return "type";
+  }
+  return "";
+}
+
+void SymbolIndex::ScanBuffer(const char *data, size_t size, bool vhdl,
+                             std::vector<Symbol> &symbols,
+                             std::set<std::string> &identifiers) {
+  std::vector<Token> tokens = tokenize(data, size, vhdl);
+  Extractor extractor(tokens, symbols);
+  if (vhdl) {
+    extractor.Vhdl();
+  } else {
+    extractor.Verilog();
+  }
+  for (const auto &token : tokens) {
+    if (isIdent(token)) identifiers.insert(toLower(token.text));
+  }
+}
+
+void SymbolIndex::Update(const std::vector<std::string> &files) {
+  struct Known {
+    int64_t mtime;
+    uint64_t size;
+  };
+  std::unordered_map<std::string, Known> known;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &[file, entry] : m_files) {
+      known[file] = {entry.mtime, entry.size};
+    }
+  }
+
+  // Parsing runs without the lock, lookups keep answering from the
+  // previous state meanwhile
+  struct Result {
+    bool exists = false;
+    bool parsed = false;
+    FileEntry entry;
+  };
+  std::vector<Result> results(files.size());
+  ParallelFor::Run(files.size(), m_threads, [&](size_t i) {
+    const std::string &file = files[i];
+    Result &result = results[i];
+    std::error_code ec;
+    result.entry.size = std::filesystem::file_size(file, ec);
+    if (ec) return true;
+    auto mtime = std::filesystem::last_write_time(file, ec);
+    if (ec) return true;
+    result.exists = true;
+    result.entry.mtime = mtime.time_since_epoch().count();
+    auto itr = known.find(file);
+    if (itr != known.end() && itr->second.mtime == result.entry.mtime &&
+        itr->second.size == result.entry.size) {
+      return true;
+    }
+    std::string content;
+    if (!HdlLexer::ReadFile(file, content)) {
+      result.exists = false;
+      return true;
+    }
+    result.entry.vhdl = HdlLexer::IsVhdlFile(file);
+    ScanBuffer(content.data(), content.size(), result.entry.vhdl,
+               result.entry.symbols, result.entry.identifiers);
+    for (auto &symbol : result.entry.symbols) symbol.file = file;
+    result.parsed = true;
+    return true;
+  });
+
+  // Only the lookups of the changed and removed files are touched
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::unordered_set<std::string> listed;
+  m_filesParsed = 0;
+  for (size_t i = 0; i < files.size(); i++) {
+    Result &result = results[i];
+    if (!result.exists) continue;
+    listed.insert(files[i]);
+    if (!result.parsed) continue;
+    m_filesParsed++;
+    if (m_files.count(files[i])) removeLookups(files[i]);
+    m_files[files[i]] = std::move(result.entry);
+    addLookups(files[i]);
+  }
+  for (auto itr = m_files.begin(); itr != m_files.end();) {
+    if (listed.count(itr->first)) {
+      ++itr;
+    } else {
+      removeLookups(itr->first);
+      itr = m_files.erase(itr);
+    }
+  }
+}
+
+void SymbolIndex::addLookups(const std::string &file) {
+  const FileEntry &entry = m_files.at(file);
+  for (size_t s = 0; s < entry.symbols.size(); s++) {
+    m_byName.emplace(toLower(entry.symbols[s].name), std::make_pair(file, s));
+  }
+  for (const auto &identifier : entry.identifiers) {
+    m_filesUsing[identifier].insert(file);
+  }
+}
+
+void SymbolIndex::removeLookups(const std::string &file) {
+  const FileEntry &entry = m_files.at(file);
+  for (const auto &symbol : entry.symbols) {
+    auto range = m_byName.equal_range(toLower(symbol.name));
+    for (auto itr = range.first; itr != range.second;) {
+      itr = itr->second.first == file ? m_byName.erase(itr) : std::next(itr);
+    }
+  }
+  for (const auto &identifier : entry.identifiers) {
+    auto itr = m_filesUsing.find(identifier);
+    if (itr == m_filesUsing.end()) continue;
+    itr->second.erase(file);
+    if (itr->second.empty()) m_filesUsing.erase(itr);
+  }
+}
+
+std::vector<SymbolIndex::Symbol> SymbolIndex::Definitions(
+    const std::string &name) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<Symbol> symbols;
+  auto range = m_byName.equal_range(toLower(name));
+  for (auto itr = range.first; itr != range.second; ++itr) {
+    const FileEntry &entry = m_files.at(itr->second.first);
+    const Symbol &symbol = entry.symbols[itr->second.second];
+    // Verilog is case sensitive
+    if (!entry.vhdl && symbol.name != name) continue;
+    symbols.push_back(symbol);
+  }
+  std::stable_sort(symbols.begin(), symbols.end(),
+                   [](const Symbol &a, const Symbol &b) {
+                     bool topA = a.scope.empty();
+                     bool topB = b.scope.empty();
+                     if (topA != topB) return topA;
+                     if (a.file != b.file) return a.file < b.file;
+                     return a.line < b.line;
+                   });
+  return symbols;
+}
+
+std::vector<SymbolIndex::Location> SymbolIndex::References(
+    const std::string &name) const {
+  std::string lowerName = toLower(name);
+  std::vector<std::pair<std::string, bool>> files;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto itr = m_filesUsing.find(lowerName);
+    if (itr == m_filesUsing.end()) return {};
+    for (const auto &file : itr->second) {
+      files.emplace_back(file, m_files.at(file).vhdl);
+    }
+  }
+
+  std::vector<std::vector<Location>> perFile(files.size());
+  ParallelFor::Run(files.size(), m_threads, [&](size_t i) {
+    std::string content;
+    const auto &[file, vhdl] = files[i];
+    if (!HdlLexer::ReadFile(file, content)) return true;
+    for (const auto &token : tokenize(content.data(), content.size(), vhdl)) {
+      if (!isIdent(token)) continue;
+      if (vhdl ? toLower(token.text) == lowerName : token.text == name) {
+        perFile[i].push_back({file, token.line, token.column});
+      }
+    }
+    return true;
+  });
+
+  std::vector<Location> locations;
+  for (auto &list : perFile) {
+    locations.insert(locations.end(), list.begin(), list.end());
+  }
+  return locations;
+}
+
+std::vector<std::string> SymbolIndex::Complete(const std::string &prefix,
+                                               size_t max) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::string lowerPrefix = toLower(prefix);
+  std::set<std::string> names;
+  for (auto itr = m_byName.lower_bound(lowerPrefix);
+       itr != m_byName.end() && names.size() < max &&
+       itr->first.compare(0, lowerPrefix.size(), lowerPrefix) == 0;
+       ++itr) {
+    names.insert(
+        m_files.at(itr->second.first).symbols[itr->second.second].name);
+  }
+  return std::vector<std::string>(names.begin(), names.end());
+}
+
+std::vector<SymbolIndex::Symbol> SymbolIndex::FileSymbols(
+    const std::string &file) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto itr = m_files.find(file);
+  if (itr == m_files.end()) return {};
+  return itr->second.symbols;
+}
+
+// One F line per file followed by its S (symbol) lines and one I line with
+// the identifiers it uses
+void SymbolIndex::Save(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  out << "foedag-symbols 1\n";
+  for (const auto &[file, entry] : m_files) {
+    out << "F " << entry.mtime << " " << entry.size << " " << entry.vhdl
+        << " " << file << "\n";
+    for (const auto &symbol : entry.symbols) {
+      out << "S " << int(symbol.kind) << " " << symbol.line << " "
+          << symbol.column << " " << symbol.name;
+      if (!symbol.scope.empty()) out << " " << symbol.scope;
+      out << "\n";
+    }
+    out << "I";
+    for (const auto &identifier : entry.identifiers) out << " " << identifier;
+    out << "\n";
+  }
+}
+
+bool SymbolIndex::Load(std::istream &in) {
+  std::string line;
+  if (!std::getline(in, line) || line != "foedag-symbols 1") return false;
+  std::unordered_map<std::string, FileEntry> files;
+  FileEntry *current = nullptr;
+  std::string currentFile;
+  while (std::getline(in, line)) {
+    if (line.size() < 2) continue;
+    std::istringstream fields(line.substr(2));
+    if (line[0] == 'F') {
+      FileEntry entry;
+      fields >> entry.mtime >> entry.size >> entry.vhdl;
+      std::getline(fields >> std::ws, currentFile);
+      if (fields.fail() || currentFile.empty()) return false;
+      current = &(files[currentFile] = std::move(entry));
+    } else if (line[0] == 'S' && current) {
+      int kind = 0;
+      Symbol symbol;
+      fields >> kind >> symbol.line >> symbol.column >> symbol.name;
+      if (fields.fail()) return false;
+      if (kind < int(Kind::Module) || kind > int(Kind::Type)) return false;
+      fields >> symbol.scope;
+      symbol.kind = Kind(kind);
+      symbol.file = currentFile;
+      current->symbols.push_back(std::move(symbol));
+    } else if (line[0] == 'I' && current) {
+      std::string identifier;
+      while (fields >> identifier) current->identifiers.insert(identifier);
+    }
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_files = std::move(files);
+  m_byName.clear();
+  m_filesUsing.clear();
+  for (const auto &[file, entry] : m_files) addLookups(file);
+  return true;
+}
@@ -0,0 +1,98 @@
+#ifndef SYMBOL_INDEX_H
+#define SYMBOL_INDEX_H
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FOEDAG {
+
+// Declarations of the HDL files of the project: modules/entities,
+// interfaces, packages, ports, parameters/generics, signals, functions and
+// types. Files are scanned in parallel and only again once they changed.
+// Lookups never wait for a scan, the symbol tables are swapped in at the end.
+class SymbolIndex {
+ public:
+  enum class Kind {
+    Module,
+    Interface,
+    Package,
+    Port,
+    Parameter,
+    Signal,
+    Function,
+    Type
+  };
+  struct Symbol {
+    std::string name;
+    Kind kind;
+    std::string file;
+    int line;    // 1 based
+    int column;  // 0 based
+    // Enclosing module, entity or package, empty at the top level
+    std::string scope;
+  };
+  struct Location {
+    std::string file;
+    int line;
+    int column;
+  };
+
+  // threads == 0 uses ResourceGovernor::MaxThreads()
+  explicit SymbolIndex(unsigned int threads = 0);
+
+  // Rescans new and changed files, forgets the files not in the list
+  void Update(const std::vector<std::string> &files);
+
+  // Top level symbols (modules, packages...) first. VHDL names are matched
+  // case insensitively.
+  std::vector<Symbol> Definitions(const std::string &name) const;
+  // Every occurrence of the identifier, files are read again to find them
+  std::vector<Location> References(const std::string &name) const;
+  // Sorted unique names starting with the prefix
+  std::vector<std::string> Complete(const std::string &prefix,
+                                    size_t max = 100) const;
+  std::vector<Symbol> FileSymbols(const std::string &file) const;
+
+  void Save(std::ostream &out) const;
+  bool Load(std::istream &in);
+
+  size_t FilesParsed() const { return m_filesParsed; }
+
+  static const char *KindName(Kind kind);
+  // Declarations and identifiers used in a buffer
+  static void ScanBuffer(const char *data, size_t size, bool vhdl,
+                         std::vector<Symbol> &symbols,
+                         std::set<std::string> &identifiers);
+
+ private:
+  struct FileEntry {
+    int64_t mtime = 0;
+    uint64_t size = 0;
+    bool vhdl = false;
+    std::vector<Symbol> symbols;
+    // Lower cased identifiers used in the file, narrows References()
+    std::set<std::string> identifiers;
+  };
+
+  unsigned int m_threads;
+  size_t m_filesParsed = 0;
+  std::unordered_map<std::string, FileEntry> m_files;
+  // Lower cased name -> (file, position in the file symbols)
+  std::multimap<std::string, std::pair<std::string, size_t>> m_byName;
+  std::unordered_map<std::string, std::set<std::string>> m_filesUsing;
+  mutable std::mutex m_mutex;
+
+  void addLookups(const std::string &file);
+  void removeLookups(const std::string &file);
+};
+
+}  // namespace FOEDAG
+
+#endif  // SYMBOL_INDEX_H
@@ -0,0 +1,139 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TextEditor/symbol_index.h"
+
+#include <sstream>
+#include <string>
+
+#include "Utils/TestDirectory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::ElementsAre;
+
+namespace FOEDAG {
+namespace {
+using SymbolIndexTest = TestDirectory;
+
+std::vector<std::string> names(const std::vector<SymbolIndex::Symbol>& list,
+                               SymbolIndex::Kind kind) {
+  std::vector<std::string> result;
+  for (const auto& symbol : list) {
+    if (symbol.kind == kind) result.push_back(symbol.name);
+  }
+  return result;
+}
+
+TEST(SymbolIndex, VerilogDeclarations) {
+  std::string text =
+      "module top #(parameter W = 8, parameter D = 2)\n"
+      "  (input wire clk, output reg [W-1:0] q);\n"
+      "  localparam int L = W * 2;\n"
+      "  wire [3:0] a, b = 4'h1; // wire c;\n"
+      "  typedef enum logic [1:0] {IDLE, RUN} state_t;\n"
+      "  function automatic int add(input int x);\n"
+      "    int tmp;\n"
+      "  endfunction\n"
+      "  sub u0 (.clk(clk));\n"
+      "endmodule\n";
+  std::vector<SymbolIndex::Symbol> symbols;
+  std::set<std::string> identifiers;
+  SymbolIndex::ScanBuffer(text.data(), text.size(), false, symbols,
+                          identifiers);
+  using Kind = SymbolIndex::Kind;
+  EXPECT_THAT(names(symbols, Kind::Module), ElementsAre("top"));
+  EXPECT_THAT(names(symbols, Kind::Parameter), ElementsAre("W", "D", "L"));
+  EXPECT_THAT(names(symbols, Kind::Port), ElementsAre("clk", "q"));
+  EXPECT_THAT(names(symbols, Kind::Signal), ElementsAre("a", "b"));
+  EXPECT_THAT(names(symbols, Kind::Type), ElementsAre("state_t"));
+  EXPECT_THAT(names(symbols, Kind::Function), ElementsAre("add"));
+  EXPECT_EQ(symbols[0].line, 1);
+  EXPECT_EQ(symbols[0].column, 7);
+  EXPECT_TRUE(identifiers.count("sub"));
+}
+
+TEST(SymbolIndex, VhdlDeclarations) {
+  std::string text =
+      "entity Counter is\n"
+      "  generic (WIDTH : integer := 8);\n"
+      "  port (clk, rst : in std_logic; -- comment\n"
+      "        q : out std_logic_vector(WIDTH-1 downto 0));\n"
+      "end entity;\n"
+      "architecture rtl of Counter is\n"
+      "  signal cnt, nxt : unsigned(WIDTH-1 downto 0);\n"
+      "  component other port (x : in bit); end component;\n"
+      "begin\n"
+      "  u0 : entity work.core port map (clk => clk);\n"
+      "end architecture;\n";
+  std::vector<SymbolIndex::Symbol> symbols;
+  std::set<std::string> identifiers;
+  SymbolIndex::ScanBuffer(text.data(), text.size(), true, symbols,
+                          identifiers);
+  using Kind = SymbolIndex::Kind;
+  EXPECT_THAT(names(symbols, Kind::Module), ElementsAre("Counter"));
+  EXPECT_THAT(names(symbols, Kind::Parameter), ElementsAre("WIDTH"));
+  EXPECT_THAT(names(symbols, Kind::Port), ElementsAre("clk", "rst", "q"));
+  EXPECT_THAT(names(symbols, Kind::Signal), ElementsAre("cnt", "nxt"));
+  EXPECT_EQ(symbols.back().scope, "Counter");
+}
+
+TEST_F(SymbolIndexTest, Lookups) {
+  std::string a = WriteFile(
+      "top.v", "module top;\n  wire go;\n  core u0(.go(go));\nendmodule\n");
+  std::string b = WriteFile("core.v", "module core(input go);\nendmodule\n");
+  SymbolIndex index(2);
+  index.Update({a, b});
+  EXPECT_EQ(index.FilesParsed(), 2u);
+
+  auto defs = index.Definitions("core");
+  ASSERT_EQ(defs.size(), 1u);
+  EXPECT_EQ(defs[0].file, b);
+  EXPECT_EQ(defs[0].line, 1);
+
+  // The module first, then the declarations inside modules
+  defs = index.Definitions("go");
+  ASSERT_EQ(defs.size(), 2u);
+  EXPECT_EQ(defs[0].file, b);
+
+  auto refs = index.References("core");
+  ASSERT_EQ(refs.size(), 2u);
+  EXPECT_THAT(index.Complete("co"), ElementsAre("core"));
+
+  std::stringstream cache;
+  index.Save(cache);
+  SymbolIndex loaded(2);
+  ASSERT_TRUE(loaded.Load(cache));
+  loaded.Update({a, b});
+  EXPECT_EQ(loaded.FilesParsed(), 0u);
+  EXPECT_EQ(loaded.Definitions("top").size(), 1u);
+
+  WriteFile("core.v", "module core2(input go);\nendmodule\n");
+  loaded.Update({a, b});
+  EXPECT_EQ(loaded.FilesParsed(), 1u);
+  EXPECT_TRUE(loaded.Definitions("core").empty());
+  EXPECT_EQ(loaded.Definitions("core2").size(), 1u);
+
+  loaded.Update({b});
+  EXPECT_TRUE(loaded.Definitions("top").empty());
+}
+}  // namespace
+}  // namespace FOEDAG
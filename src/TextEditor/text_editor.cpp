@@ -73,6 +73,19 @@ void TextEditor::SlotOpenFile(const QString& strFileName) {
   TextEditorForm::Instance()->OpenFile(strFileName);
 }
 
+void TextEditor::SetProjectFiles(std::function<QStringList()> provider,
+                                 const QString& strCacheFile) {
+  TextEditorForm::Instance()->SetProjectFiles(provider, strCacheFile);
+}
+
+void TextEditor::UpdateSymbolIndex() {
+  TextEditorForm::Instance()->UpdateSymbolIndex();
+}
+
+void TextEditor::SlotOpenFileAtLine(const QString& strFileName, int line) {
+  TextEditorForm::Instance()->OpenFileAtLine(strFileName, line);
+}
+
 void TextEditor::SlotCurrentFileChanged(const QString& strFileName) {
   emit CurrentFileChanged(strFileName);
 }
@@ -2,6 +2,7 @@
 #define TEXTEDITOR_H
 
 #include <QObject>
+#include <QStringList>
 #include <QWidget>
 
 #include "text_editor_form.h"
@@ -20,11 +21,16 @@ class TextEditor : public QWidget {
 
   void RegisterCommands(FOEDAG::Session *session);
 
+  void SetProjectFiles(std::function<QStringList()> provider,
+                       const QString &strCacheFile);
+
  signals:
   void CurrentFileChanged(QString);
 
  public slots:
+  void UpdateSymbolIndex();
   void SlotOpenFile(const QString &strFileName);
+  void SlotOpenFileAtLine(const QString &strFileName, int line);
 
  private slots:
   void SlotCurrentFileChanged(const QString &strFileName);
@@ -1,13 +1,28 @@
 #include "text_editor_form.h"
 
+#include <QMenu>
 #include <QMessageBox>
+#include <filesystem>
+#include <fstream>
 
 using namespace FOEDAG;
 
 Q_GLOBAL_STATIC(TextEditorForm, texteditor)
 
+#define MAX_COMPLETION_WORDS 20000
+#define MAX_REFERENCES 200
+
 TextEditorForm *TextEditorForm::Instance() { return texteditor(); }
 
+TextEditorForm::~TextEditorForm() {
+  if (m_indexThread.joinable()) {
+    m_indexThread.join();
+  }
+  if (m_referencesThread.joinable()) {
+    m_referencesThread.join();
+  }
+}
+
 void TextEditorForm::InitForm() {
   static bool initForm;
   if (initForm) {
@@ -79,6 +94,15 @@ int TextEditorForm::OpenFile(const QString &strFileName) {
           SLOT(SlotUpdateTabTitle(bool)));
   connect(editor, SIGNAL(ShowSearchDialog(QString)), this,
           SLOT(SlotShowSearchDialog(QString)));
+  connect(editor, SIGNAL(GotoDefinition(QString)), this,
+          SLOT(SlotGotoDefinition(QString)));
+  connect(editor, SIGNAL(FindReferences(QString)), this,
+          SLOT(SlotFindReferences(QString)));
+  connect(editor, SIGNAL(FileSaved(QString)), this,
+          SLOT(SlotFileSaved(QString)));
+  if (!m_completionWords.isEmpty()) {
+    editor->SetCompletionWords(m_completionWords);
+  }
 
   index = m_tab_editor->addTab(editor, filename);
   m_tab_editor->setCurrentIndex(index);
@@ -91,6 +115,15 @@ int TextEditorForm::OpenFile(const QString &strFileName) {
   return ret;
 }
 
+int TextEditorForm::OpenFileAtLine(const QString &strFileName, int line) {
+  int ret = OpenFile(strFileName);
+  if (0 == ret) {
+    Editor *editor = m_map_file_tabIndex_editor.value(strFileName).second;
+    if (editor) editor->GotoLine(line);
+  }
+  return ret;
+}
+
 void TextEditorForm::SlotTabCloseRequested(int index) {
   if (index == -1) {
     return;
@@ -180,3 +213,149 @@ void TextEditorForm::SlotReplaceAll(const QString &strFindWord,
     tabEditor->ReplaceAll(strFindWord, strDesWord);
   }
 }
+
+void TextEditorForm::SetProjectFiles(std::function<QStringList()> provider,
+                                     const QString &strCacheFile) {
+  m_fileProvider = provider;
+  m_strSymbolCache = strCacheFile;
+  m_symbolCacheLoaded = false;
+}
+
+void TextEditorForm::UpdateSymbolIndex() {
+  if (!m_fileProvider) {
+    return;
+  }
+  // One scan at a time, a request during the scan runs once it is done
+  if (m_indexThread.joinable()) {
+    m_indexPending = true;
+    return;
+  }
+
+  std::vector<std::string> files;
+  foreach (const QString &strFile, m_fileProvider()) {
+    files.push_back(strFile.toStdString());
+  }
+  bool loadCache = !m_symbolCacheLoaded && !m_strSymbolCache.isEmpty();
+  m_symbolCacheLoaded = true;
+  std::string cacheFile = m_strSymbolCache.toStdString();
+
+  m_indexThread = std::thread([this, files, loadCache, cacheFile]() {
+    if (loadCache) {
+      std::ifstream in(cacheFile);
+      if (in) m_symbolIndex.Load(in);
+    }
+    size_t parsed = m_symbolIndex.FilesParsed();
+    m_symbolIndex.Update(files);
+    if (m_symbolIndex.FilesParsed() != parsed && !cacheFile.empty()) {
+      // Replace the cache in one step, a crash never leaves half of it
+      std::string tmpFile = cacheFile + ".tmp";
+      bool saved = false;
+      {
+        std::ofstream out(tmpFile, std::ios::trunc);
+        if (out) {
+          m_symbolIndex.Save(out);
+          saved = out.good();
+        }
+      }
+      std::error_code ec;
+      if (saved) {
+        std::filesystem::rename(tmpFile, cacheFile, ec);
+      } else {
+        std::filesystem::remove(tmpFile, ec);
+      }
+    }
+    QMetaObject::invokeMethod(this, "SlotSymbolIndexUpdated",
+                              Qt::QueuedConnection);
+  });
+}
+
+void TextEditorForm::SlotSymbolIndexUpdated() {
+  m_indexThread.join();
+  if (m_indexPending) {
+    m_indexPending = false;
+    UpdateSymbolIndex();
+    return;
+  }
+
+  m_completionWords.clear();
+  for (const auto &name : m_symbolIndex.Complete("", MAX_COMPLETION_WORDS)) {
+    m_completionWords.append(QString::fromStdString(name));
+  }
+  foreach (const auto &pair, m_map_file_tabIndex_editor) {
+    pair.second->SetCompletionWords(m_completionWords);
+  }
+}
+
+void TextEditorForm::SlotFileSaved(const QString &strFileName) {
+  Q_UNUSED(strFileName);
+  UpdateSymbolIndex();
+}
+
+Editor *TextEditorForm::CurrentEditor() const {
+  return (Editor *)m_tab_editor->currentWidget();
+}
+
+void TextEditorForm::ShowLocations(const QList<QPair<QString, int>> &locations,
+                                   const QString &strTitle) {
+  if (locations.isEmpty()) {
+    return;
+  }
+  if (locations.size() == 1) {
+    OpenFileAtLine(locations.first().first, locations.first().second);
+    return;
+  }
+
+  QMenu menu(this);
+  menu.addSection(strTitle);
+  for (const auto &location : locations) {
+    QAction *action =
+        menu.addAction(QString("%1:%2")
+                           .arg(QFileInfo(location.first).fileName())
+                           .arg(location.second));
+    action->setToolTip(location.first);
+    action->setData(QVariant::fromValue(location));
+  }
+  Editor *editor = CurrentEditor();
+  QPoint pos = editor ? editor->CursorGlobalPos() : QCursor::pos();
+  QAction *selected = menu.exec(pos);
+  if (selected) {
+    auto location = selected->data().value<QPair<QString, int>>();
+    OpenFileAtLine(location.first, location.second);
+  }
+}
+
+void TextEditorForm::SlotGotoDefinition(const QString &strWord) {
+  QList<QPair<QString, int>> locations;
+  for (const auto &symbol :
+       m_symbolIndex.Definitions(strWord.toStdString())) {
+    locations.append(
+        qMakePair(QString::fromStdString(symbol.file), symbol.line));
+  }
+  ShowLocations(locations, tr("Definitions of %1").arg(strWord));
+}
+
+void TextEditorForm::SlotFindReferences(const QString &strWord) {
+  if (m_referencesThread.joinable()) {
+    return;
+  }
+  m_strReferencesWord = strWord;
+  std::string name = strWord.toStdString();
+  // Candidate files are read again, keep the GUI responsive meanwhile
+  m_referencesThread = std::thread([this, name]() {
+    m_references = m_symbolIndex.References(name);
+    QMetaObject::invokeMethod(this, "SlotReferencesFound",
+                              Qt::QueuedConnection);
+  });
+}
+
+void TextEditorForm::SlotReferencesFound() {
+  m_referencesThread.join();
+  QList<QPair<QString, int>> locations;
+  for (const auto &location : m_references) {
+    if (locations.size() >= MAX_REFERENCES) break;
+    locations.append(
+        qMakePair(QString::fromStdString(location.file), location.line));
+  }
+  m_references.clear();
+  ShowLocations(locations, tr("References to %1").arg(m_strReferencesWord));
+}
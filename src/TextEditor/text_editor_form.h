@@ -3,9 +3,12 @@
 
 #include <QTabWidget>
 #include <QWidget>
+#include <functional>
+#include <thread>
 
 #include "editor.h"
 #include "search_dialog.h"
+#include "symbol_index.h"
 
 namespace FOEDAG {
 
@@ -14,9 +17,18 @@ class TextEditorForm : public QWidget {
 
  public:
   static TextEditorForm *Instance();
+  ~TextEditorForm();
 
   void InitForm();
   int OpenFile(const QString &strFileName);
+  int OpenFileAtLine(const QString &strFileName, int line);
+
+  // The provider returns the absolute paths of the project HDL files, the
+  // symbol index is persisted in the cache file between sessions
+  void SetProjectFiles(std::function<QStringList()> provider,
+                       const QString &strCacheFile);
+  // Rescans the changed project files on a worker thread
+  void UpdateSymbolIndex();
 
  signals:
   void CurrentFileChanged(QString);
@@ -36,11 +48,33 @@ class TextEditorForm : public QWidget {
                           const QString &strDesWord);
   void SlotReplaceAll(const QString &strFindWord, const QString &strDesWord);
 
+  void SlotGotoDefinition(const QString &strWord);
+  void SlotFindReferences(const QString &strWord);
+  void SlotFileSaved(const QString &strFileName);
+  void SlotSymbolIndexUpdated();
+  void SlotReferencesFound();
+
  private:
   QTabWidget *m_tab_editor;
   QMap<QString, QPair<int, Editor *>> m_map_file_tabIndex_editor;
 
   SearchDialog *m_searchDialog;
+
+  std::function<QStringList()> m_fileProvider;
+  QString m_strSymbolCache;
+  SymbolIndex m_symbolIndex;
+  bool m_symbolCacheLoaded{false};
+  std::thread m_indexThread;
+  bool m_indexPending{false};
+  QStringList m_completionWords;
+
+  std::thread m_referencesThread;
+  QString m_strReferencesWord;
+  std::vector<SymbolIndex::Location> m_references;
+
+  Editor *CurrentEditor() const;
+  void ShowLocations(const QList<QPair<QString, int>> &locations,
+                     const QString &strTitle);
 };
 }  // namespace FOEDAG
 #endif  // TEXT_EDITOR_FORM_H
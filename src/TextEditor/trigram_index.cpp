@@ -0,0 +1,465 @@
+#include "trigram_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <string_view>
+
+#include "Utils/HdlLexer.h"
+#include "Utils/ParallelFor.h"
+
+using namespace FOEDAG;
+
+namespace {
+
+const char indexMagic[] = "FDTRIGR1";
+
+inline unsigned char lower(char ch) {
+  return static_cast<unsigned char>(
+      std::tolower(static_cast<unsigned char>(ch)));
+}
+
+inline uint32_t trigram(const char *text) {
+  return (uint32_t(lower(text[0])) << 16) | (uint32_t(lower(text[1])) << 8) |
+         uint32_t(lower(text[2]));
+}
+
+std::vector<uint32_t> trigramsOf(const char *data, size_t size) {
+  std::vector<uint32_t> trigrams;
+  if (size < 3) return trigrams;
+  trigrams.reserve(std::min<size_t>(size, 1 << 16));
+  for (size_t i = 0; i + 2 < size; i++) {
+    // Lines are matched one at a time, a trigram never spans two
+    if (data[i] == '\n' || data[i + 1] == '\n' || data[i + 2] == '\n') {
+      continue;
+    }
+    trigrams.push_back(trigram(data + i));
+  }
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+                 trigrams.end());
+  return trigrams;
+}
+
+void writeVarint(std::ostream &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.put(char((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.put(char(value));
+}
+
+bool readVarint(std::istream &in, uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int ch = in.get();
+    if (ch == EOF) return false;
+    value |= uint64_t(ch & 0x7f) << shift;
+    if ((ch & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+TrigramIndex::TrigramIndex(unsigned int threads)
+    : m_threads(ParallelFor::Threads(threads)) {}
+
+void TrigramIndex::Update(const std::vector<std::string> &files) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  struct Result {
+    bool exists = false;
+    bool changed = false;
+    int64_t mtime = 0;
+    uint64_t size = 0;
+    std::vector<uint32_t> trigrams;
+  };
+  std::vector<Result> results(files.size());
+
+  ParallelFor::Run(files.size(), m_threads, [&](size_t i) {
+    const std::string &file = files[i];
+    Result &result = results[i];
+    std::error_code ec;
+    result.size = std::filesystem::file_size(file, ec);
+    if (ec) return true;
+    auto mtime = std::filesystem::last_write_time(file, ec);
+    if (ec) return true;
+    result.exists = true;
+    result.mtime = mtime.time_since_epoch().count();
+
+    auto known = m_ids.find(file);
+    if (known != m_ids.end()) {
+      const FileEntry &entry = m_entries[known->second];
+      if (entry.size == result.size && entry.mtime == result.mtime) return true;
+    }
+    std::string content;
+    if (!HdlLexer::ReadFile(file, content)) {
+      result.exists = false;
+      return true;
+    }
+    result.trigrams = trigramsOf(content.data(), content.size());
+    result.changed = true;
+    return true;
+  });
+
+  // Drop the files no longer listed or gone
+  std::unordered_map<std::string, size_t> listed;
+  for (size_t i = 0; i < files.size(); i++) {
+    if (results[i].exists) listed.emplace(files[i], i);
+  }
+  for (auto itr = m_ids.begin(); itr != m_ids.end();) {
+    if (listed.count(itr->first)) {
+      ++itr;
+      continue;
+    }
+    removePostings(itr->second);
+    m_entries[itr->second] = FileEntry();
+    m_freeIds.push_back(itr->second);
+    itr = m_ids.erase(itr);
+  }
+
+  m_filesIndexed = 0;
+  for (size_t i = 0; i < files.size(); i++) {
+    Result &result = results[i];
+    if (!result.changed || listed[files[i]] != i) continue;
+    m_filesIndexed++;
+    uint32_t id = 0;
+    auto known = m_ids.find(files[i]);
+    if (known != m_ids.end()) {
+      id = known->second;
+      removePostings(id);
+    } else if (!m_freeIds.empty()) {
+      id = m_freeIds.back();
+      m_freeIds.pop_back();
+    } else {
+      id = m_entries.size();
+      m_entries.emplace_back();
+    }
+    m_ids[files[i]] = id;
+    FileEntry &entry = m_entries[id];
+    entry.path = files[i];
+    entry.mtime = result.mtime;
+    entry.size = result.size;
+    entry.trigrams = std::move(result.trigrams);
+    addPostings(id);
+  }
+}
+
+void TrigramIndex::addPostings(uint32_t id) {
+  for (uint32_t tri : m_entries[id].trigrams) {
+    std::vector<uint32_t> &ids = m_postings[tri];
+    // Ids mostly come in increasing order on a full build
+    if (ids.empty() || ids.back() < id) {
+      ids.push_back(id);
+    } else {
+      ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+    }
+  }
+}
+
+void TrigramIndex::removePostings(uint32_t id) {
+  for (uint32_t tri : m_entries[id].trigrams) {
+    auto itr = m_postings.find(tri);
+    if (itr == m_postings.end()) continue;
+    std::vector<uint32_t> &ids = itr->second;
+    auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+    if (pos != ids.end() && *pos == id) ids.erase(pos);
+    if (ids.empty()) m_postings.erase(itr);
+  }
+}
+
+std::vector<uint32_t> TrigramIndex::candidateIds(const std::string &pattern,
+                                                 bool regex) const {
+  std::vector<std::string> literals;
+  if (regex) {
+    literals = RequiredLiterals(pattern);
+  } else {
+    literals.push_back(pattern);
+  }
+
+  std::vector<uint32_t> trigrams;
+  for (const auto &literal : literals) {
+    for (size_t i = 0; i + 2 < literal.size(); i++) {
+      trigrams.push_back(trigram(literal.data() + i));
+    }
+  }
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+                 trigrams.end());
+
+  std::vector<uint32_t> ids;
+  if (trigrams.empty()) {
+    // Nothing to narrow down with, every file is a candidate
+    for (const auto &[path, id] : m_ids) ids.push_back(id);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  }
+
+  // Intersect the shortest posting lists first
+  std::vector<const std::vector<uint32_t> *> lists;
+  for (uint32_t tri : trigrams) {
+    auto itr = m_postings.find(tri);
+    if (itr == m_postings.end()) return {};
+    lists.push_back(&itr->second);
+  }
+  std::sort(lists.begin(), lists.end(),
+            [](const std::vector<uint32_t> *a, const std::vector<uint32_t> *b) {
+              return a->size() < b->size();
+            });
+  ids = *lists.front();
+  for (size_t l = 1; l < lists.size() && !ids.empty(); l++) {
+    std::vector<uint32_t> both;
+    std::set_intersection(ids.begin(), ids.end(), lists[l]->begin(),
+                          lists[l]->end(), std::back_inserter(both));
+    ids.swap(both);
+  }
+  return ids;
+}
+
+std::vector<std::string> TrigramIndex::Candidates(const std::string &pattern,
+                                                  bool regex) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<std::string> files;
+  for (uint32_t id : candidateIds(pattern, regex)) {
+    files.push_back(m_entries[id].path);
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+bool TrigramIndex::Search(const std::string &pattern, const Options &options,
+                          std::vector<Match> &matches,
+                          std::string &error) const {
+  matches.clear();
+  if (pattern.empty()) {
+    error = "empty pattern";
+    return false;
+  }
+  std::regex expr;
+  if (options.regex) {
+    auto flags = std::regex::ECMAScript;
+    if (!options.caseSensitive) flags |= std::regex::icase;
+    try {
+      expr = std::regex(pattern, flags);
+    } catch (const std::regex_error &e) {
+      error = e.what();
+      return false;
+    }
+  }
+
+  std::vector<std::string> files = Candidates(pattern, options.regex);
+  std::string lowerPattern = pattern;
+  for (auto &ch : lowerPattern) ch = char(lower(ch));
+
+  // Each worker collects per file, the lists are merged in file order
+  std::vector<std::vector<Match>> perFile(files.size());
+  std::atomic<size_t> found{0};
+  ParallelFor::Run(files.size(), m_threads, [&](size_t i) {
+    std::string content;
+    std::string lowerLine;
+    if (found >= options.maxResults) return false;
+    if (!HdlLexer::ReadFile(files[i], content)) return true;
+    size_t begin = 0;
+    int line = 1;
+    while (begin <= content.size()) {
+      size_t end = content.find('\n', begin);
+      if (end == std::string::npos) end = content.size();
+      std::string_view text(content.data() + begin, end - begin);
+      long column = -1;
+      if (options.regex) {
+        std::cmatch match;
+        if (std::regex_search(text.data(), text.data() + text.size(), match,
+                              expr)) {
+          column = match.position(0);
+        }
+      } else if (options.caseSensitive) {
+        size_t pos = text.find(pattern);
+        if (pos != std::string_view::npos) column = pos;
+      } else {
+        lowerLine.assign(text.begin(), text.end());
+        for (auto &ch : lowerLine) ch = char(lower(ch));
+        size_t pos = lowerLine.find(lowerPattern);
+        if (pos != std::string::npos) column = pos;
+      }
+      if (column >= 0) {
+        if (found++ >= options.maxResults) return false;
+        perFile[i].push_back(
+            {files[i], line, int(column), std::string(text)});
+      }
+      if (end == content.size()) break;
+      begin = end + 1;
+      line++;
+    }
+    return true;
+  });
+
+  for (auto &list : perFile) {
+    for (auto &match : list) {
+      if (matches.size() >= options.maxResults) return true;
+      matches.push_back(std::move(match));
+    }
+  }
+  return true;
+}
+
+// Only literals outside of groups are collected, a group may be optional or
+// repeated zero times. A character followed by ?, * or {n,m} is optional.
+std::vector<std::string> TrigramIndex::RequiredLiterals(
+    const std::string &regex) {
+  std::vector<std::string> literals;
+  std::string run;
+  int depth = 0;
+  auto flush = [&]() {
+    if (run.size() >= 3) literals.push_back(run);
+    run.clear();
+  };
+  for (size_t i = 0; i < regex.size(); i++) {
+    char ch = regex[i];
+    switch (ch) {
+      case '\\':
+        if (i + 1 < regex.size() &&
+            !std::isalnum(static_cast<unsigned char>(regex[i + 1]))) {
+          if (depth == 0) run.push_back(regex[i + 1]);
+        } else {
+          // \d, \w, \b... match classes or positions
+          flush();
+        }
+        i++;
+        break;
+      case '[':
+        flush();
+        // Skip the class, a leading ] is a member
+        i++;
+        if (i < regex.size() && regex[i] == '^') i++;
+        if (i < regex.size() && regex[i] == ']') i++;
+        while (i < regex.size() && regex[i] != ']') {
+          if (regex[i] == '\\') i++;
+          i++;
+        }
+        break;
+      case '|':
+        // Alternatives at the top level: nothing is required
+        if (depth == 0) return {};
+        break;
+      case '(':
+        flush();
+        depth++;
+        break;
+      case ')':
+        depth = std::max(0, depth - 1);
+        break;
+      case '?':
+      case '*':
+      case '{':
+        if (!run.empty()) run.pop_back();
+        flush();
+        if (ch == '{') {
+          while (i < regex.size() && regex[i] != '}') i++;
+        }
+        break;
+      case '+':
+      case '.':
+      case '^':
+      case '$':
+        flush();
+        break;
+      default:
+        if (depth == 0) {
+          run.push_back(ch);
+        }
+        break;
+    }
+  }
+  flush();
+  return literals;
+}
+
+bool TrigramIndex::Save(const std::string &indexFile) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::string tmpFile = indexFile + ".tmp";
+  {
+    std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+    out.write(indexMagic, sizeof(indexMagic) - 1);
+    writeVarint(out, m_ids.size());
+    for (const auto &entry : m_entries) {
+      if (entry.path.empty()) continue;
+      writeVarint(out, entry.path.size());
+      out.write(entry.path.data(), entry.path.size());
+      writeVarint(out, uint64_t(entry.mtime));
+      writeVarint(out, entry.size);
+      // Sorted, the deltas are small
+      writeVarint(out, entry.trigrams.size());
+      uint32_t previous = 0;
+      for (uint32_t tri : entry.trigrams) {
+        writeVarint(out, tri - previous);
+        previous = tri;
+      }
+    }
+    if (!out.good()) return false;
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmpFile, indexFile, ec);
+  return !ec;
+}
+
+bool TrigramIndex::Load(const std::string &indexFile) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::ifstream in(indexFile, std::ios::binary);
+  char magic[sizeof(indexMagic) - 1];
+  if (!in.read(magic, sizeof(magic)) ||
+      std::string(magic, sizeof(magic)) != indexMagic) {
+    return false;
+  }
+  // Every path byte and trigram takes at least a byte of the file, larger
+  // counts come from a corrupt file and are not allocated
+  in.seekg(0, std::ios::end);
+  uint64_t fileSize = uint64_t(in.tellg());
+  in.seekg(sizeof(magic));
+  auto fits = [&](uint64_t count) {
+    return count <= fileSize - uint64_t(in.tellg());
+  };
+  std::vector<FileEntry> entries;
+  uint64_t count = 0;
+  if (!readVarint(in, count) || !fits(count)) return false;
+  for (uint64_t f = 0; f < count; f++) {
+    FileEntry entry;
+    uint64_t length = 0, mtime = 0, trigrams = 0;
+    if (!readVarint(in, length) || !fits(length)) return false;
+    entry.path.resize(length);
+    if (!in.read(&entry.path[0], length)) return false;
+    if (!readVarint(in, mtime) || !readVarint(in, entry.size) ||
+        !readVarint(in, trigrams) || !fits(trigrams)) {
+      return false;
+    }
+    entry.mtime = int64_t(mtime);
+    entry.trigrams.resize(trigrams);
+    uint64_t previous = 0;
+    for (auto &tri : entry.trigrams) {
+      uint64_t delta = 0;
+      if (!readVarint(in, delta)) return false;
+      previous += delta;
+      tri = uint32_t(previous);
+    }
+    entries.push_back(std::move(entry));
+  }
+
+  m_entries = std::move(entries);
+  m_freeIds.clear();
+  m_ids.clear();
+  m_postings.clear();
+  for (uint32_t id = 0; id < m_entries.size(); id++) {
+    m_ids[m_entries[id].path] = id;
+    addPostings(id);
+  }
+  return true;
+}
+
+size_t TrigramIndex::FileCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_ids.size();
+}
@@ -0,0 +1,79 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FOEDAG {
+
+// Index of the (lower cased) byte trigrams of a set of files. A search only
+// reads the files containing every trigram of the literal parts of the
+// pattern. Files are reindexed when their size or modification time change.
+class TrigramIndex {
+ public:
+  struct Match {
+    std::string file;
+    int line;    // 1 based
+    int column;  // 0 based, in bytes
+    std::string text;
+  };
+  struct Options {
+    bool regex = false;
+    bool caseSensitive = true;
+    size_t maxResults = 10000;
+  };
+
+  // threads == 0 uses ResourceGovernor::MaxThreads()
+  explicit TrigramIndex(unsigned int threads = 0);
+
+  // Indexes new and changed files in parallel, files not in the list are
+  // dropped.
+  void Update(const std::vector<std::string> &files);
+
+  // Files that may contain the pattern, sorted
+  std::vector<std::string> Candidates(const std::string &pattern,
+                                      bool regex) const;
+  // Matches sorted by file and line. False and error set on a bad regex.
+  bool Search(const std::string &pattern, const Options &options,
+              std::vector<Match> &matches, std::string &error) const;
+
+  bool Save(const std::string &indexFile) const;
+  bool Load(const std::string &indexFile);
+
+  size_t FileCount() const;
+  // Files read from disk during the last Update
+  size_t FilesIndexed() const { return m_filesIndexed; }
+
+  // Strings any match of the regex must contain. Empty when nothing can be
+  // required (alternatives, everything optional...).
+  static std::vector<std::string> RequiredLiterals(const std::string &regex);
+
+ private:
+  struct FileEntry {
+    std::string path;  // empty for a free slot
+    int64_t mtime = 0;
+    uint64_t size = 0;
+    std::vector<uint32_t> trigrams;  // sorted
+  };
+
+  unsigned int m_threads;
+  size_t m_filesIndexed = 0;
+  std::vector<FileEntry> m_entries;
+  std::vector<uint32_t> m_freeIds;
+  std::unordered_map<std::string, uint32_t> m_ids;
+  // Trigram -> sorted file ids
+  std::unordered_map<uint32_t, std::vector<uint32_t>> m_postings;
+  mutable std::mutex m_mutex;
+
+  void addPostings(uint32_t id);
+  void removePostings(uint32_t id);
+  std::vector<uint32_t> candidateIds(const std::string &pattern,
+                                     bool regex) const;
+};
+
+}  // namespace FOEDAG
+
+#endif  // TRIGRAM_INDEX_H
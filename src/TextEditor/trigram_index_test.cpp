@@ -0,0 +1,117 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TextEditor/trigram_index.h"
+
+#include <string>
+
+#include "Utils/TestDirectory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+namespace FOEDAG {
+namespace {
+using TrigramIndexTest = TestDirectory;
+
+TEST(TrigramIndex, RequiredLiterals) {
+  EXPECT_THAT(TrigramIndex::RequiredLiterals("always_ff"),
+              ElementsAre("always_ff"));
+  EXPECT_THAT(TrigramIndex::RequiredLiterals("mod\\w+ top"),
+              ElementsAre("mod", " top"));
+  EXPECT_THAT(TrigramIndex::RequiredLiterals("counters?"),
+              ElementsAre("counter"));
+  EXPECT_THAT(TrigramIndex::RequiredLiterals("(abc)?defg"),
+              ElementsAre("defg"));
+  EXPECT_THAT(TrigramIndex::RequiredLiterals("foo|bar"), IsEmpty());
+  EXPECT_THAT(TrigramIndex::RequiredLiterals("[abc]de.f"), IsEmpty());
+}
+
+TEST_F(TrigramIndexTest, Search) {
+  std::string a = WriteFile("a.v", "module top;\n  counter u0();\nendmodule\n");
+  std::string b = WriteFile("b.v", "module counter;\nendmodule\n");
+  std::string c = WriteFile("c.vhd", "entity Counter is\nend;\n");
+
+  TrigramIndex index(2);
+  index.Update({a, b, c});
+  EXPECT_EQ(index.FilesIndexed(), 3u);
+  EXPECT_THAT(index.Candidates("u0()", false), ElementsAre(a));
+  EXPECT_THAT(index.Candidates("counter", false), ElementsAre(a, b, c));
+
+  std::vector<TrigramIndex::Match> matches;
+  std::string error;
+  ASSERT_TRUE(index.Search("counter", {}, matches, error));
+  ASSERT_EQ(matches.size(), 2u);
+  EXPECT_EQ(matches[0].file, a);
+  EXPECT_EQ(matches[0].line, 2);
+  EXPECT_EQ(matches[0].column, 2);
+  EXPECT_EQ(matches[1].file, b);
+
+  TrigramIndex::Options options;
+  options.regex = true;
+  options.caseSensitive = false;
+  ASSERT_TRUE(index.Search("^(entity|module) count", options, matches, error));
+  ASSERT_EQ(matches.size(), 2u);
+  EXPECT_EQ(matches[1].file, c);
+
+  EXPECT_FALSE(index.Search("(", options, matches, error));
+  EXPECT_FALSE(error.empty());
+}
+
+TEST_F(TrigramIndexTest, IncrementalAndPersistent) {
+  std::string a = WriteFile("d.v", "module alpha;\nendmodule\n");
+  std::string b = WriteFile("e.v", "module beta;\nendmodule\n");
+  TrigramIndex index(2);
+  index.Update({a, b});
+
+  std::string cache = Path("index.idx");
+  ASSERT_TRUE(index.Save(cache));
+
+  TrigramIndex loaded(2);
+  ASSERT_TRUE(loaded.Load(cache));
+  loaded.Update({a, b});
+  EXPECT_EQ(loaded.FilesIndexed(), 0u);
+  EXPECT_THAT(loaded.Candidates("beta", false), ElementsAre(b));
+
+  // Rewritten with a different size, the file is indexed again
+  WriteFile("e.v", "module gamma_changed;\nendmodule\n");
+  loaded.Update({a, b});
+  EXPECT_EQ(loaded.FilesIndexed(), 1u);
+  EXPECT_THAT(loaded.Candidates("beta", false), IsEmpty());
+  EXPECT_THAT(loaded.Candidates("gamma", false), ElementsAre(b));
+
+  loaded.Update({a});
+  EXPECT_EQ(loaded.FileCount(), 1u);
+  EXPECT_THAT(loaded.Candidates("endmodule", false), ElementsAre(a));
+}
+
+TEST_F(TrigramIndexTest, CorruptLengthIsRejected) {
+  // One file whose path claims 2^56 bytes
+  std::string cache = WriteFile(
+      "index.idx", "FDTRIGR1\x01\x80\x80\x80\x80\x80\x80\x80\x01" "a");
+  TrigramIndex index(2);
+  EXPECT_FALSE(index.Load(cache));
+  EXPECT_EQ(index.FileCount(), 0u);
+}
+}  // namespace
+}  // namespace FOEDAG
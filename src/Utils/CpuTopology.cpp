@@ -0,0 +1,277 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/CpuTopology.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace FOEDAG;
+
+namespace {
+namespace fs = std::filesystem;
+
+std::string readFirstLine(const fs::path &file) {
+  std::ifstream in(file);
+  std::string line;
+  std::getline(in, line);
+  return line;
+}
+
+// "2048K", "1M"
+uint64_t parseCacheSize(const std::string &text) {
+  uint64_t size = std::strtoull(text.c_str(), nullptr, 10);
+  if (text.find('K') != std::string::npos) size <<= 10;
+  if (text.find('M') != std::string::npos) size <<= 20;
+  return size;
+}
+
+// "Node 0 MemTotal:        4685560 kB"
+uint64_t nodeMemory(const fs::path &meminfo) {
+  std::ifstream in(meminfo);
+  for (std::string line; std::getline(in, line);) {
+    size_t pos = line.find("MemTotal:");
+    if (pos != std::string::npos)
+      return std::strtoull(line.c_str() + pos + 9, nullptr, 10) << 10;
+  }
+  return 0;
+}
+
+std::vector<int> allowedCpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+  }
+#endif
+  return cpus;
+}
+
+bool pinThread(const std::vector<int> &cpus, int node) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus)
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    return false;
+  // MPOL_PREFERRED: pages first touched by the thread come from the node
+  // while it has free memory
+  constexpr int kMpolPreferred = 1;
+  constexpr size_t kBits = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> mask(node / kBits + 1, 0);
+  mask[node / kBits] |= 1ul << (node % kBits);
+  syscall(SYS_set_mempolicy, kMpolPreferred, mask.data(),
+          mask.size() * kBits + 1);
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::string megabytes(uint64_t bytes) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+  return text;
+}
+}  // namespace
+
+CpuTopology::CpuTopology(const CpuTopology &other) { *this = other; }
+
+CpuTopology &CpuTopology::operator=(const CpuTopology &other) {
+  if (this == &other) return *this;
+  std::scoped_lock lock(m_mutex, other.m_mutex);
+  m_nodes = other.m_nodes;
+  m_caches = other.m_caches;
+  return *this;
+}
+
+CpuTopology &CpuTopology::Instance() {
+  static CpuTopology topology = Detect(std::string(), allowedCpus());
+  return topology;
+}
+
+CpuTopology CpuTopology::Detect(const std::string &root,
+                                const std::vector<int> &allowed) {
+  CpuTopology topology;
+  std::set<int> allowedSet(allowed.begin(), allowed.end());
+  auto isAllowed = [&allowedSet](int cpu) {
+    return allowedSet.empty() || allowedSet.count(cpu);
+  };
+
+  fs::path system = fs::path(root + "/sys/devices/system");
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(system / "node", ec)) {
+    std::string name = entry.path().filename().string();
+    if (name.compare(0, 4, "node") != 0 ||
+        name.find_first_not_of("0123456789", 4) != std::string::npos ||
+        name.size() == 4)
+      continue;
+    Node node;
+    node.id = std::stoi(name.substr(4));
+    for (int cpu : ParseCpuList(readFirstLine(entry.path() / "cpulist")))
+      if (isAllowed(cpu)) node.cpus.push_back(cpu);
+    if (node.cpus.empty()) continue;
+    node.memory = nodeMemory(entry.path() / "meminfo");
+    topology.m_nodes.push_back(node);
+  }
+  std::sort(topology.m_nodes.begin(), topology.m_nodes.end(),
+            [](const Node &a, const Node &b) { return a.id < b.id; });
+  // No NUMA information, one node with every CPU
+  if (topology.m_nodes.empty()) {
+    Node node;
+    node.cpus = allowed;
+    if (node.cpus.empty()) {
+      for (unsigned int cpu = 0;
+           cpu < std::max(1u, std::thread::hardware_concurrency()); cpu++)
+        node.cpus.push_back(cpu);
+    }
+    topology.m_nodes.push_back(node);
+  }
+
+  // Each cache once, as seen from the CPUs sharing it
+  std::set<std::tuple<int, std::string, std::string>> seen;
+  for (const Node &node : topology.m_nodes) {
+    for (int cpu : node.cpus) {
+      fs::path cache = system / "cpu" / ("cpu" + std::to_string(cpu)) / "cache";
+      for (const auto &entry : fs::directory_iterator(cache, ec)) {
+        if (entry.path().filename().string().compare(0, 5, "index") != 0)
+          continue;
+        Cache info;
+        info.level = std::atoi(readFirstLine(entry.path() / "level").c_str());
+        info.type = readFirstLine(entry.path() / "type");
+        info.size = parseCacheSize(readFirstLine(entry.path() / "size"));
+        std::string shared = readFirstLine(entry.path() / "shared_cpu_list");
+        if (!seen.insert({info.level, info.type, shared}).second) continue;
+        info.cpus = ParseCpuList(shared);
+        topology.m_caches.push_back(info);
+      }
+    }
+  }
+  std::sort(topology.m_caches.begin(), topology.m_caches.end(),
+            [](const Cache &a, const Cache &b) {
+              if (a.level != b.level) return a.level < b.level;
+              if (a.type != b.type) return a.type < b.type;
+              return a.cpus < b.cpus;
+            });
+  return topology;
+}
+
+std::vector<CpuTopology::Node> CpuTopology::Nodes() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_nodes;
+}
+
+int CpuTopology::PlaceThread() {
+  std::vector<int> cpus;
+  int node = -1;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_nodes.size() < 2) return -1;
+    // Fewest threads per CPU, compared without dividing
+    Node *best = &m_nodes.front();
+    for (Node &candidate : m_nodes) {
+      if (candidate.threads * best->cpus.size() <
+          best->threads * candidate.cpus.size())
+        best = &candidate;
+    }
+    best->threads++;
+    cpus = best->cpus;
+    node = best->id;
+  }
+  pinThread(cpus, node);
+  return node;
+}
+
+void CpuTopology::Unplace(int node) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (Node &candidate : m_nodes) {
+    if (candidate.id == node && candidate.threads > 0) candidate.threads--;
+  }
+}
+
+std::string CpuTopology::Report() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::ostringstream out;
+  char line[160];
+  snprintf(line, sizeof(line), "%-6s %-16s %14s %8s\n", "node", "cpus",
+           "memory", "threads");
+  out << line;
+  for (const Node &node : m_nodes) {
+    snprintf(line, sizeof(line), "%-6d %-16s %14s %8u\n", node.id,
+             FormatCpuList(node.cpus).c_str(), megabytes(node.memory).c_str(),
+             node.threads);
+    out << line;
+  }
+  for (const Cache &cache : m_caches) {
+    snprintf(line, sizeof(line), "L%d %-12s %8llu KB shared by %s\n",
+             cache.level, cache.type.c_str(),
+             (unsigned long long)(cache.size >> 10),
+             FormatCpuList(cache.cpus).c_str());
+    out << line;
+  }
+  return out.str();
+}
+
+std::vector<int> CpuTopology::ParseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+  std::istringstream ranges(list);
+  for (std::string range; std::getline(ranges, range, ',');) {
+    if (range.empty() || !isdigit((unsigned char)range[0])) continue;
+    size_t dash = range.find('-');
+    int first = std::atoi(range.c_str());
+    int last =
+        dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+    for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+std::string CpuTopology::FormatCpuList(const std::vector<int> &cpus) {
+  std::string list;
+  for (size_t i = 0; i < cpus.size();) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+    if (!list.empty()) list += ",";
+    list += std::to_string(cpus[i]);
+    if (j > i) list += "-" + std::to_string(cpus[j]);
+    i = j + 1;
+  }
+  return list;
+}
@@ -0,0 +1,87 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+namespace FOEDAG {
+
+// NUMA nodes and caches of the CPUs the process may run on, read from
+// /sys/devices/system. Compile threads are placed on the least loaded node
+// and pinned to its CPUs, with their memory policy preferring the node, so
+// a run keeps its data on the socket executing it.
+class CpuTopology {
+ public:
+  struct Node {
+    int id = 0;
+    std::vector<int> cpus;
+    uint64_t memory = 0;
+    // Threads placed on the node
+    unsigned int threads = 0;
+  };
+  struct Cache {
+    int level = 0;
+    std::string type;
+    uint64_t size = 0;
+    std::vector<int> cpus;
+  };
+
+  static CpuTopology &Instance();
+
+  // Nodes with at least one of the allowed CPUs, every CPU when allowed is
+  // empty. root prefixes /sys.
+  static CpuTopology Detect(const std::string &root = std::string(),
+                            const std::vector<int> &allowed = {});
+
+  std::vector<Node> Nodes() const;
+  const std::vector<Cache> &Caches() const { return m_caches; }
+
+  // Pins the calling thread to the node with the fewest threads per CPU
+  // and returns the node, -1 and nothing done on a single node machine.
+  // Unplace once the thread is done.
+  int PlaceThread();
+  void Unplace(int node);
+
+  // Nodes, caches and the placed threads
+  std::string Report() const;
+
+  // "0-3,8" <-> {0, 1, 2, 3, 8}
+  static std::vector<int> ParseCpuList(const std::string &list);
+  static std::string FormatCpuList(const std::vector<int> &cpus);
+
+  CpuTopology() = default;
+  CpuTopology(const CpuTopology &other);
+  CpuTopology &operator=(const CpuTopology &other);
+
+ private:
+  std::vector<Node> m_nodes;
+  std::vector<Cache> m_caches;
+  mutable std::mutex m_mutex;
+};
+
+}  // namespace FOEDAG
+
+#endif
@@ -0,0 +1,111 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/CpuTopology.h"
+
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include "Utils/TestDirectory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+namespace FOEDAG {
+namespace {
+namespace fs = std::filesystem;
+
+class CpuTopologyTest : public TestDirectory {
+ protected:
+  // Two nodes of two CPUs, an L2 per node
+  fs::path fakeSystem() {
+    std::string system = "sys/devices/system/";
+    WriteFile(system + "node/node0/cpulist", "0-1\n");
+    WriteFile(system + "node/node0/meminfo", "Node 0 MemTotal: 1024 kB\n");
+    WriteFile(system + "node/node1/cpulist", "2-3\n");
+    WriteFile(system + "node/node1/meminfo", "Node 1 MemTotal: 2048 kB\n");
+    for (int cpu = 0; cpu < 4; cpu++) {
+      std::string cache = system + "cpu/cpu" + std::to_string(cpu) + "/cache/";
+      WriteFile(cache + "index0/level", "1\n");
+      WriteFile(cache + "index0/type", "Data\n");
+      WriteFile(cache + "index0/size", "32K\n");
+      WriteFile(cache + "index0/shared_cpu_list", std::to_string(cpu) + "\n");
+      WriteFile(cache + "index2/level", "2\n");
+      WriteFile(cache + "index2/type", "Unified\n");
+      WriteFile(cache + "index2/size", "1M\n");
+      WriteFile(cache + "index2/shared_cpu_list",
+                cpu < 2 ? "0-1\n" : "2-3\n");
+    }
+    return m_dir;
+  }
+};
+
+TEST(CpuTopology, CpuList) {
+  EXPECT_THAT(CpuTopology::ParseCpuList("0-2,5,7-8\n"),
+              ElementsAre(0, 1, 2, 5, 7, 8));
+  EXPECT_EQ(CpuTopology::FormatCpuList({0, 1, 2, 5, 7, 8}), "0-2,5,7-8");
+  EXPECT_EQ(CpuTopology::FormatCpuList({}), "");
+}
+
+TEST_F(CpuTopologyTest, Detect) {
+  fs::path root = fakeSystem();
+  CpuTopology topology = CpuTopology::Detect(root.string());
+  std::vector<CpuTopology::Node> nodes = topology.Nodes();
+  ASSERT_EQ(nodes.size(), 2u);
+  EXPECT_THAT(nodes[1].cpus, ElementsAre(2, 3));
+  EXPECT_EQ(nodes[1].memory, 2048u * 1024);
+  // 4 L1, 2 L2
+  ASSERT_EQ(topology.Caches().size(), 6u);
+  EXPECT_EQ(topology.Caches().back().level, 2);
+  EXPECT_EQ(topology.Caches().back().size, 1u << 20);
+
+  // Only the allowed CPUs, node 0 is left out
+  CpuTopology allowed = CpuTopology::Detect(root.string(), {3});
+  ASSERT_EQ(allowed.Nodes().size(), 1u);
+  EXPECT_EQ(allowed.Nodes()[0].id, 1);
+  EXPECT_THAT(allowed.Nodes()[0].cpus, ElementsAre(3));
+}
+
+TEST_F(CpuTopologyTest, Placement) {
+  fs::path root = fakeSystem();
+  CpuTopology topology = CpuTopology::Detect(root.string());
+  fs::remove_all(root);
+  // Placing pins, keep it off the test thread
+  std::vector<int> placed;
+  std::thread([&]() {
+    for (int i = 0; i < 3; i++) placed.push_back(topology.PlaceThread());
+  }).join();
+  EXPECT_THAT(placed, ElementsAre(0, 1, 0));
+  topology.Unplace(0);
+  topology.Unplace(0);
+  std::thread([&]() { placed.push_back(topology.PlaceThread()); }).join();
+  EXPECT_EQ(placed.back(), 0);
+  EXPECT_THAT(topology.Report(), HasSubstr("shared by 0-1"));
+
+  CpuTopology single = CpuTopology::Detect(root.string(), {0});
+  EXPECT_EQ(single.PlaceThread(), -1);
+}
+
+}  // namespace
+}  // namespace FOEDAG
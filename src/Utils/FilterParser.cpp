@@ -0,0 +1,84 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/FilterParser.h"
+
+using namespace FOEDAG;
+
+namespace {
+std::string trim(const std::string& text) {
+  size_t first = text.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos) return std::string();
+  size_t last = text.find_last_not_of(" \t\r\n");
+  return text.substr(first, last - first + 1);
+}
+}  // namespace
+
+bool FilterParser::Parse(const std::string& expr,
+                         std::vector<FilterCondition>& filter,
+                         std::string& error) {
+  filter.clear();
+  if (trim(expr).empty()) return true;
+  size_t start = 0;
+  while (start <= expr.size()) {
+    size_t end = expr.find("&&", start);
+    std::string term =
+        trim(expr.substr(start, end == std::string::npos ? std::string::npos
+                                                         : end - start));
+    start = (end == std::string::npos) ? expr.size() + 1 : end + 2;
+    if (term.empty()) {
+      if (end == std::string::npos && filter.size() > 0) break;
+      error = "Empty term in filter: " + expr;
+      return false;
+    }
+
+    size_t opPos = term.find_first_of("=!<>");
+    if (opPos == std::string::npos || opPos == 0) {
+      error = "Expected <field> <op> <value>: " + term;
+      return false;
+    }
+    std::string op(1, term[opPos]);
+    if (opPos + 1 < term.size() &&
+        (term[opPos + 1] == '=' || term[opPos + 1] == '~')) {
+      op += term[opPos + 1];
+    }
+    if (op != "==" && op != "!=" && op != "<" && op != "<=" && op != ">" &&
+        op != ">=" && op != "=~") {
+      error = "Unknown operator " + op + ": " + term;
+      return false;
+    }
+    FilterCondition condition;
+    condition.field = trim(term.substr(0, opPos));
+    condition.op = op;
+    condition.value = trim(term.substr(opPos + op.size()));
+    if (condition.value.size() >= 2 &&
+        ((condition.value.front() == '"' && condition.value.back() == '"') ||
+         (condition.value.front() == '{' && condition.value.back() == '}'))) {
+      condition.value = condition.value.substr(1, condition.value.size() - 2);
+    }
+    if (condition.value.empty()) {
+      error = "Missing value: " + term;
+      return false;
+    }
+    filter.push_back(condition);
+  }
+  return true;
+}
@@ -0,0 +1,50 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+
+#ifndef FILTER_PARSER_H
+#define FILTER_PARSER_H
+
+namespace FOEDAG {
+
+// One term of a filter: <field> <op> <value>. Ops are == != < <= > >= and
+// =~ (glob match).
+struct FilterCondition {
+  std::string field;
+  std::string op;
+  std::string value;
+};
+
+// Filter expressions of the device catalog and the metrics store:
+// "pin_count >= 400 && family == f1". Values may be quoted with "" or {}.
+class FilterParser {
+ public:
+  // Fields are kept as written, the caller matches them to its names. False
+  // and error set on bad syntax.
+  static bool Parse(const std::string& expr,
+                    std::vector<FilterCondition>& filter, std::string& error);
+};
+
+}  // namespace FOEDAG
+
+#endif
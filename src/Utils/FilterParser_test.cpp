@@ -0,0 +1,65 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/FilterParser.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace FOEDAG {
+namespace {
+
+TEST(FilterParserTest, Terms) {
+  std::vector<FilterCondition> filter;
+  std::string error;
+  ASSERT_TRUE(FilterParser::Parse(
+      " Pin_Count >= 400 && family == \"f 1\" && name =~ {dev*} ", filter,
+      error));
+  ASSERT_EQ(filter.size(), 3u);
+  // Fields as written
+  EXPECT_EQ(filter[0].field, "Pin_Count");
+  EXPECT_EQ(filter[0].op, ">=");
+  EXPECT_EQ(filter[0].value, "400");
+  EXPECT_EQ(filter[1].value, "f 1");
+  EXPECT_EQ(filter[2].op, "=~");
+  EXPECT_EQ(filter[2].value, "dev*");
+
+  EXPECT_TRUE(FilterParser::Parse("", filter, error));
+  EXPECT_TRUE(filter.empty());
+}
+
+TEST(FilterParserTest, Errors) {
+  std::vector<FilterCondition> filter;
+  std::string error;
+  EXPECT_FALSE(FilterParser::Parse("pin_count 400", filter, error));
+  EXPECT_EQ(error, "Expected <field> <op> <value>: pin_count 400");
+  EXPECT_FALSE(FilterParser::Parse("a == 1 && && b == 2", filter, error));
+  EXPECT_EQ(error, "Empty term in filter: a == 1 && && b == 2");
+  EXPECT_FALSE(FilterParser::Parse("a =! 1", filter, error));
+  EXPECT_EQ(error, "Unknown operator =: a =! 1");
+  EXPECT_FALSE(FilterParser::Parse("a ==", filter, error));
+  EXPECT_EQ(error, "Missing value: a ==");
+}
+
+}  // namespace
+}  // namespace FOEDAG
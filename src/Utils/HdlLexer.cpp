@@ -0,0 +1,164 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/HdlLexer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace FOEDAG;
+
+namespace {
+
+bool isIdentStart(char c) {
+  return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isIdentChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+}  // namespace
+
+std::vector<HdlToken> HdlLexer::Tokenize(const char* data, size_t size,
+                                         bool vhdl) {
+  using Kind = HdlToken::Kind;
+  std::vector<HdlToken> tokens;
+  int line = 1;
+  size_t lineStart = 0;
+  size_t i = 0;
+  // Skips to the terminator, counting the lines on the way
+  auto skipTo = [&](const char* end) {
+    size_t length = std::strlen(end);
+    while (i < size && (i + length > size ||
+                        std::memcmp(data + i, end, length) != 0)) {
+      if (data[i] == '\n') {
+        line++;
+        lineStart = i + 1;
+      }
+      i++;
+    }
+    i = std::min(size, i + length);
+  };
+  while (i < size) {
+    char c = data[i];
+    int column = int(i - lineStart);
+    if (c == '\n') {
+      line++;
+      lineStart = ++i;
+    } else if (std::isspace(static_cast<unsigned char>(c))) {
+      i++;
+    } else if (vhdl ? (c == '-' && i + 1 < size && data[i + 1] == '-')
+                    : (c == '/' && i + 1 < size && data[i + 1] == '/')) {
+      while (i < size && data[i] != '\n') i++;
+    } else if (c == '/' && i + 1 < size && data[i + 1] == '*') {
+      i += 2;
+      skipTo("*/");
+    } else if (!vhdl && c == '(' && i + 2 < size && data[i + 1] == '*' &&
+               data[i + 2] != ')') {
+      // Attribute (* ... *), but not @(*)
+      i += 2;
+      skipTo("*)");
+    } else if (c == '"') {
+      size_t start = ++i;
+      while (i < size && data[i] != '"' && data[i] != '\n') {
+        if (!vhdl && data[i] == '\\') i++;
+        i++;
+      }
+      i = std::min(i, size);
+      tokens.push_back(
+          {Kind::String, std::string(data + start, i - start), line, column});
+      if (i < size && data[i] == '"') i++;
+    } else if (!vhdl && c == '`') {
+      size_t start = ++i;
+      while (i < size && isIdentChar(data[i])) i++;
+      std::string directive(data + start, i - start);
+      if (directive == "define") {
+        // Macro bodies are not scanned, they may contain anything
+        while (i < size && data[i] != '\n') {
+          if (data[i] == '\\' && i + 1 < size && data[i + 1] == '\n') {
+            i++;
+            line++;
+            lineStart = i + 1;
+          }
+          i++;
+        }
+      } else {
+        tokens.push_back({Kind::Directive, directive, line, column});
+      }
+    } else if (!vhdl && c == '\\') {
+      // Escaped identifier, terminated by white space
+      size_t start = ++i;
+      while (i < size && !std::isspace(static_cast<unsigned char>(data[i]))) {
+        i++;
+      }
+      tokens.push_back({Kind::Identifier, std::string(data + start, i - start),
+                        line, column});
+    } else if (isIdentStart(c)) {
+      size_t start = i;
+      while (i < size && isIdentChar(data[i])) i++;
+      tokens.push_back({Kind::Identifier, std::string(data + start, i - start),
+                        line, column});
+    } else if (vhdl && c == '\'' && i + 2 < size && data[i + 2] == '\'') {
+      // Character literal, a lone ' is an attribute tick
+      i += 3;
+      tokens.push_back({Kind::Literal, std::string(), line, column});
+    } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+               (!vhdl && c == '$') ||
+               (!vhdl && c == '\'' && i + 1 < size &&
+                std::strchr("sSbBoOdDhH01xXzZ", data[i + 1]))) {
+      // Numbers, based literals and system tasks
+      i++;
+      while (i < size &&
+             (isIdentChar(data[i]) || data[i] == '.' ||
+              (vhdl ? data[i] == '#' : (data[i] == '\'' || data[i] == '?')))) {
+        i++;
+      }
+      tokens.push_back({Kind::Literal, std::string(), line, column});
+    } else {
+      tokens.push_back({Kind::Punct, std::string(1, c), line, column});
+      i++;
+    }
+  }
+  return tokens;
+}
+
+bool HdlLexer::IsVhdlFile(const std::string& file) {
+  std::string ext = std::filesystem::path(file).extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char ch) { return std::tolower(ch); });
+  return ext == ".vhd" || ext == ".vhdl";
+}
+
+bool HdlLexer::ReadFile(const std::string& file, std::string& content) {
+  std::ifstream stream(file, std::ios::binary);
+  if (!stream.is_open()) return false;
+  std::error_code ec;
+  auto size = std::filesystem::file_size(file, ec);
+  if (ec) return false;
+  content.assign(size, '\0');
+  stream.read(&content[0], size);
+  content.resize(stream.gcount());
+  return true;
+}
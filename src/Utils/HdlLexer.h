@@ -0,0 +1,62 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifndef HDL_LEXER_H
+#define HDL_LEXER_H
+
+namespace FOEDAG {
+
+struct HdlToken {
+  enum class Kind {
+    Identifier,
+    // `name, the body of `define is skipped
+    Directive,
+    // Text between the quotes
+    String,
+    // Numbers, Verilog based literals and system tasks, VHDL character
+    // literals. The text is left empty.
+    Literal,
+    Punct
+  };
+  Kind kind;
+  std::string text;
+  int line;    // 1 based
+  int column;  // 0 based
+};
+
+// Tokenizer shared by the HDL scanners: comments and Verilog attributes are
+// dropped, identifiers keep their case.
+class HdlLexer {
+ public:
+  static std::vector<HdlToken> Tokenize(const char* data, size_t size,
+                                        bool vhdl);
+  static bool IsVhdlFile(const std::string& file);
+  // Whole file in one read, false if it cannot be opened
+  static bool ReadFile(const std::string& file, std::string& content);
+};
+
+}  // namespace FOEDAG
+
+#endif
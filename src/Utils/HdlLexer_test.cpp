@@ -0,0 +1,98 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/HdlLexer.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace FOEDAG {
+namespace {
+
+using Kind = HdlToken::Kind;
+
+std::vector<HdlToken> tokenize(const std::string &text, bool vhdl) {
+  return HdlLexer::Tokenize(text.data(), text.size(), vhdl);
+}
+
+TEST(HdlLexerTest, VerilogSkipsCommentsAttributesAndMacroBodies) {
+  const std::string text =
+      "// comment\n"
+      "`define W \\\n  8\n"
+      "(* keep *) module /* x\n y */ top;\n"
+      "  always @(*) a = 8'hFF + $clog2(\"s\");\n"
+      "endmodule\n";
+  std::vector<HdlToken> tokens = tokenize(text, false);
+  ASSERT_GE(tokens.size(), 3u);
+  EXPECT_EQ(tokens[0].kind, Kind::Identifier);
+  EXPECT_EQ(tokens[0].text, "module");
+  EXPECT_EQ(tokens[0].line, 4);
+  EXPECT_EQ(tokens[0].column, 11);
+  EXPECT_EQ(tokens[1].text, "top");
+  EXPECT_EQ(tokens[1].line, 5);
+  EXPECT_EQ(tokens[1].column, 6);
+
+  std::string kinds;
+  for (const auto &token : tokens) {
+    switch (token.kind) {
+      case Kind::Identifier:
+        kinds += 'i';
+        break;
+      case Kind::Directive:
+        kinds += 'd';
+        break;
+      case Kind::String:
+        kinds += 's';
+        break;
+      case Kind::Literal:
+        kinds += 'l';
+        break;
+      case Kind::Punct:
+        kinds += token.text;
+        break;
+    }
+  }
+  // @(*) is not an attribute, the literal and the system task are one token
+  EXPECT_EQ(kinds, "ii;i@(*)i=l+l(s);i");
+  EXPECT_EQ(tokens.back().line, 7);
+}
+
+TEST(HdlLexerTest, VhdlLiterals) {
+  std::vector<HdlToken> tokens =
+      tokenize("-- comment\nx <= '1' when s'event else 16#FF#;", true);
+  std::string text;
+  for (const auto &token : tokens) {
+    text += token.kind == Kind::Literal ? std::string("#") : token.text;
+    text += ' ';
+  }
+  EXPECT_EQ(text, "x < = # when s ' event else # ; ");
+  EXPECT_EQ(tokens[0].line, 2);
+}
+
+TEST(HdlLexerTest, VhdlFiles) {
+  EXPECT_TRUE(HdlLexer::IsVhdlFile("a/top.VHD"));
+  EXPECT_TRUE(HdlLexer::IsVhdlFile("top.vhdl"));
+  EXPECT_FALSE(HdlLexer::IsVhdlFile("top.sv"));
+}
+
+}  // namespace
+}  // namespace FOEDAG
@@ -0,0 +1,290 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Utils/MemoryTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define PSAPI_VERSION 2
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+extern "C" {
+#include <tcl.h>
+}
+
+using namespace FOEDAG;
+
+namespace {
+struct Counters {
+  std::atomic<int64_t> bytes{0};
+  std::atomic<int64_t> peakBytes{0};
+  std::atomic<int64_t> objects{0};
+  std::atomic<int64_t> peakObjects{0};
+};
+
+Counters s_counters[MemoryTracker::Count];
+
+std::mutex s_samplerMutex;
+std::condition_variable s_samplerCv;
+std::thread s_sampler;
+bool s_samplerRunning = false;
+// Joins the sampler before its thread object is destroyed at exit
+struct SamplerGuard {
+  ~SamplerGuard() { MemoryTracker::StopSampler(); }
+} s_samplerGuard;
+
+void raise(std::atomic<int64_t> &peak, int64_t value) {
+  int64_t current = peak;
+  while (value > current && !peak.compare_exchange_weak(current, value)) {
+  }
+}
+
+std::string megabytes(int64_t bytes) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+  return text;
+}
+}  // namespace
+
+void MemoryTracker::Allocate(Subsystem subsystem, int64_t bytes,
+                             int64_t objects) {
+  Counters &counters = s_counters[subsystem];
+  raise(counters.peakBytes, counters.bytes += bytes);
+  raise(counters.peakObjects, counters.objects += objects);
+}
+
+void MemoryTracker::Release(Subsystem subsystem, int64_t bytes,
+                            int64_t objects) {
+  Counters &counters = s_counters[subsystem];
+  counters.bytes -= bytes;
+  counters.objects -= objects;
+}
+
+MemoryTracker::Usage MemoryTracker::Get(Subsystem subsystem) {
+  const Counters &counters = s_counters[subsystem];
+  return {counters.bytes, counters.peakBytes, counters.objects,
+          counters.peakObjects};
+}
+
+const char *MemoryTracker::Name(Subsystem subsystem) {
+  switch (subsystem) {
+    case Console:
+      return "console";
+    case Project:
+      return "project";
+    case DeviceDatabase:
+      return "device_db";
+    case Tcl:
+      return "tcl";
+    case TclInterpreters:
+      return "tcl_interps";
+    case Compiler:
+      return "compiler";
+    case Count:
+      break;
+  }
+  return "";
+}
+
+bool MemoryTracker::CountOnly(Subsystem subsystem) {
+  return subsystem == TclInterpreters;
+}
+
+int64_t MemoryTracker::ResidentBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.WorkingSetSize;
+  }
+  return 0;
+#elif defined(__linux__)
+  long pages = 0, resident = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) return 0;
+  if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+  fclose(statm);
+  return int64_t(resident) * sysconf(_SC_PAGESIZE);
+#else
+  // Only the peak is available
+  return PeakResidentBytes();
+#endif
+}
+
+int64_t MemoryTracker::PeakResidentBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+  return usage.ru_maxrss;
+#else
+  return int64_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+std::string MemoryTracker::Report() {
+  std::ostringstream out;
+  char line[160];
+  snprintf(line, sizeof(line), "%-12s %14s %14s %10s %12s\n", "subsystem",
+           "current", "peak", "objects", "peak objects");
+  out << line;
+  for (int i = 0; i < Count; i++) {
+    Subsystem subsystem = static_cast<Subsystem>(i);
+    Usage usage = Get(subsystem);
+    bool countOnly = CountOnly(subsystem);
+    snprintf(line, sizeof(line), "%-12s %14s %14s %10lld %12lld\n",
+             Name(subsystem),
+             countOnly ? "n/a" : megabytes(usage.bytes).c_str(),
+             countOnly ? "n/a" : megabytes(usage.peakBytes).c_str(),
+             (long long)usage.objects, (long long)usage.peakObjects);
+    out << line;
+  }
+  snprintf(line, sizeof(line), "%-12s %14s %14s\n", "process rss",
+           megabytes(ResidentBytes()).c_str(),
+           megabytes(PeakResidentBytes()).c_str());
+  out << line;
+  return out.str();
+}
+
+int MemoryTracker::StartSampler(int periodMs, const std::string &file) {
+  StopSampler();
+  if (periodMs <= 0) return 0;
+  std::ofstream probe(file, std::ios::app);
+  if (!probe) return -1;
+  probe.close();
+
+  s_samplerRunning = true;
+  s_sampler = std::thread([periodMs, file]() {
+    std::ofstream out(file, std::ios::app);
+    std::unique_lock<std::mutex> lock(s_samplerMutex);
+    while (s_samplerRunning) {
+      out << std::time(nullptr) << " rss=" << ResidentBytes();
+      for (int i = 0; i < Count; i++) {
+        Subsystem subsystem = static_cast<Subsystem>(i);
+        if (CountOnly(subsystem)) continue;
+        out << " " << Name(subsystem) << "=" << Get(subsystem).bytes;
+      }
+      out << std::endl;
+      s_samplerCv.wait_for(lock, std::chrono::milliseconds(periodMs),
+                           [] { return !s_samplerRunning; });
+    }
+  });
+  return 0;
+}
+
+void MemoryTracker::StopSampler() {
+  {
+    std::lock_guard<std::mutex> lock(s_samplerMutex);
+    s_samplerRunning = false;
+  }
+  s_samplerCv.notify_all();
+  if (s_sampler.joinable()) s_sampler.join();
+}
+
+ResidentPeakProbe::ResidentPeakProbe(int periodMs)
+    : m_start(MemoryTracker::ResidentBytes()), m_peak(m_start) {
+  m_thread = std::thread([this, periodMs]() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+      sample();
+      m_cv.wait_for(lock, std::chrono::milliseconds(periodMs),
+                    [this] { return m_stop; });
+    }
+  });
+}
+
+ResidentPeakProbe::~ResidentPeakProbe() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  m_thread.join();
+}
+
+void ResidentPeakProbe::sample() {
+  int64_t bytes = MemoryTracker::ResidentBytes();
+  int64_t peak = m_peak;
+  while (bytes > peak && !m_peak.compare_exchange_weak(peak, bytes)) {
+  }
+}
+
+int64_t ResidentPeakProbe::PeakGrowthBytes() {
+  sample();
+  return std::max<int64_t>(m_peak - m_start, 0);
+}
+
+void MemoryTracker::RegisterCommands(Tcl_Interp *interp) {
+  auto report_memory = [](void *clientData, Tcl_Interp *interp, int argc,
+                          const char *argv[]) -> int {
+    int period = -1;
+    std::string file = "memory.log";
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++) {
+      std::string option = argv[i];
+      if (option == "-sample" && i + 1 < argc) {
+        ok = Tcl_GetInt(interp, argv[++i], &period) == TCL_OK && period >= 0;
+      } else if (option == "-file" && i + 1 < argc) {
+        file = argv[++i];
+      } else {
+        ok = false;
+      }
+    }
+    if (!ok) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp,
+                       "Usage: report_memory ?-sample <ms>? ?-file <log>?",
+                       (char *)NULL);
+      return TCL_ERROR;
+    }
+    if (period >= 0) {
+      if (0 != StartSampler(period, file)) {
+        Tcl_AppendResult(interp, "Cannot write ", file.c_str(), (char *)NULL);
+        return TCL_ERROR;
+      }
+      return TCL_OK;
+    }
+    Tcl_AppendResult(interp, Report().c_str(), (char *)NULL);
+    return TCL_OK;
+  };
+  Tcl_CreateCommand(interp, "report_memory", report_memory, nullptr, nullptr);
+}
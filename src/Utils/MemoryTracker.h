@@ -0,0 +1,122 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+struct Tcl_Interp;
+
+namespace FOEDAG {
+
+// Memory accounted per subsystem. Owners report what they allocate and
+// release, the tracker keeps current and peak bytes and object counts. The
+// figures are estimates of the payload (sizeof plus the big buffers), the
+// process RSS is the ground truth.
+class MemoryTracker {
+ public:
+  // TclInterpreters only counts the interpreters, Tcl does not expose the
+  // memory they hold
+  enum Subsystem {
+    Console,
+    Project,
+    DeviceDatabase,
+    Tcl,
+    TclInterpreters,
+    Compiler,
+    Count
+  };
+
+  struct Usage {
+    int64_t bytes;
+    int64_t peakBytes;
+    int64_t objects;
+    int64_t peakObjects;
+  };
+
+  static void Allocate(Subsystem subsystem, int64_t bytes,
+                       int64_t objects = 1);
+  static void Release(Subsystem subsystem, int64_t bytes, int64_t objects = 1);
+
+  static Usage Get(Subsystem subsystem);
+  static const char *Name(Subsystem subsystem);
+  // No byte figure, only objects
+  static bool CountOnly(Subsystem subsystem);
+  static std::string Report();
+
+  // Resident set size of the process, 0 when unknown
+  static int64_t ResidentBytes();
+  static int64_t PeakResidentBytes();
+
+  // Appends "<time> rss=<bytes> <subsystem>=<bytes>..." to the file every
+  // period, until stopped with 0
+  static int StartSampler(int periodMs, const std::string &file);
+  static void StopSampler();
+
+  // report_memory ?-sample <ms>? ?-file <log>?
+  static void RegisterCommands(Tcl_Interp *interp);
+};
+
+// Growth of the process resident set size while the probe lives, sampled
+// every periodMs on its own thread. The peak of a compile run, other runs
+// of the process add to it while they overlap.
+class ResidentPeakProbe {
+ public:
+  explicit ResidentPeakProbe(int periodMs = 20);
+  ~ResidentPeakProbe();
+  ResidentPeakProbe(const ResidentPeakProbe &) = delete;
+  ResidentPeakProbe &operator=(const ResidentPeakProbe &) = delete;
+
+  // Highest resident bytes above the start seen so far, now included
+  int64_t PeakGrowthBytes();
+
+ private:
+  void sample();
+
+  int64_t m_start{0};
+  std::atomic<int64_t> m_peak{0};
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop{false};
+  std::thread m_thread;
+};
+
+// Base class accounting the objects of a type, sizeof(T) bytes each
+template <MemoryTracker::Subsystem S, class T>
+class MemoryTracked {
+ protected:
+  MemoryTracked() { MemoryTracker::Allocate(S, sizeof(T)); }
+  MemoryTracked(const MemoryTracked &) {
+    MemoryTracker::Allocate(S, sizeof(T));
+  }
+  MemoryTracked &operator=(const MemoryTracked &) = default;
+  ~MemoryTracked() { MemoryTracker::Release(S, sizeof(T)); }
+};
+
+}  // namespace FOEDAG
+
+#endif
@@ -0,0 +1,94 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Utils/MemoryTracker.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "Tcl/TclInterpreter.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::HasSubstr;
+
+namespace FOEDAG {
+namespace {
+class Tracked : public MemoryTracked<MemoryTracker::Compiler, Tracked> {
+  char m_payload[1000];
+};
+
+TEST(MemoryTracker, CurrentAndPeak) {
+  MemoryTracker::Usage before = MemoryTracker::Get(MemoryTracker::Compiler);
+  {
+    auto first = std::make_unique<Tracked>();
+    Tracked second(*first);
+    MemoryTracker::Usage during = MemoryTracker::Get(MemoryTracker::Compiler);
+    EXPECT_EQ(during.objects, before.objects + 2);
+    EXPECT_EQ(during.bytes, before.bytes + int64_t(2 * sizeof(Tracked)));
+    EXPECT_GE(during.peakBytes, during.bytes);
+  }
+  MemoryTracker::Usage after = MemoryTracker::Get(MemoryTracker::Compiler);
+  EXPECT_EQ(after.objects, before.objects);
+  EXPECT_EQ(after.bytes, before.bytes);
+  EXPECT_GE(after.peakBytes, before.bytes + int64_t(2 * sizeof(Tracked)));
+  EXPECT_GT(MemoryTracker::PeakResidentBytes(), 0);
+}
+
+TEST(MemoryTracker, ResidentPeakProbe) {
+  const size_t size = 64 << 20;
+  ResidentPeakProbe probe(1);
+  {
+    std::unique_ptr<char[]> buffer(new char[size]);
+    for (size_t i = 0; i < size; i += 4096) buffer[i] = char(i);
+    EXPECT_GE(probe.PeakGrowthBytes(), int64_t(size / 2));
+  }
+  // The peak stays once the memory is freed
+  EXPECT_GE(probe.PeakGrowthBytes(), int64_t(size / 2));
+}
+
+TEST(MemoryTracker, ReportMemory) {
+  TclInterpreter interpreter;
+  std::string report = interpreter.evalCmd("report_memory");
+  EXPECT_THAT(report, HasSubstr("device_db"));
+  EXPECT_THAT(report, HasSubstr("process rss"));
+  EXPECT_THAT(report, HasSubstr("tcl_interps"));
+  EXPECT_GE(MemoryTracker::Get(MemoryTracker::TclInterpreters).objects, 1);
+
+  std::string log = "memory_tracker_test.log";
+  std::remove(log.c_str());
+  EXPECT_EQ(interpreter.evalCmd("report_memory -sample 10 -file " + log), "");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(interpreter.evalCmd("report_memory -sample 0"), "");
+  std::ifstream in(log);
+  std::stringstream content;
+  content << in.rdbuf();
+  EXPECT_THAT(content.str(), HasSubstr(" rss="));
+  EXPECT_THAT(content.str(), HasSubstr(" console="));
+  std::remove(log.c_str());
+}
+
+}  // namespace
+}  // namespace FOEDAG
@@ -0,0 +1,57 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Utils/ResourceGovernor.h"
+
+using namespace FOEDAG;
+
+unsigned int ParallelFor::Threads(unsigned int threads) {
+  return threads ? threads : ResourceGovernor::Instance().MaxThreads();
+}
+
+void ParallelFor::Run(size_t count, unsigned int threads,
+                      const std::function<bool(size_t)>& body) {
+  std::atomic<size_t> next{0};
+  std::atomic<bool> stopped{false};
+  auto worker = [&]() {
+    for (size_t i = next++; i < count && !stopped; i = next++) {
+      if (!body(i)) stopped = true;
+    }
+  };
+
+  size_t workers = std::min<size_t>(std::max(threads, 1u),
+                                    std::max<size_t>(1, count));
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < workers; t++) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : pool) {
+    thread.join();
+  }
+}
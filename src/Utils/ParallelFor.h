@@ -0,0 +1,47 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <functional>
+
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+namespace FOEDAG {
+
+// Loop of the file scanners and indexes over their files. Items are taken
+// one at a time from a shared counter, a thread done with a small file
+// takes the next one while another one parses a large file.
+class ParallelFor {
+ public:
+  // threads, ResourceGovernor::MaxThreads() for 0
+  static unsigned int Threads(unsigned int threads);
+
+  // body(item) for every item below count, on at most threads threads the
+  // calling one included. Once a body returns false no more items are
+  // started. Returns after every body returned.
+  static void Run(size_t count, unsigned int threads,
+                  const std::function<bool(size_t)>& body);
+};
+
+}  // namespace FOEDAG
+
+#endif
@@ -0,0 +1,60 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/ParallelFor.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace FOEDAG {
+namespace {
+
+TEST(ParallelForTest, EveryItemOnce) {
+  std::vector<std::atomic<int>> runs(1000);
+  ParallelFor::Run(runs.size(), 4, [&](size_t i) {
+    runs[i]++;
+    return true;
+  });
+  for (const auto& count : runs) EXPECT_EQ(count, 1);
+
+  // No item, no call
+  ParallelFor::Run(0, 4, [](size_t) {
+    ADD_FAILURE();
+    return true;
+  });
+  EXPECT_GT(ParallelFor::Threads(0), 0u);
+  EXPECT_EQ(ParallelFor::Threads(3), 3u);
+}
+
+TEST(ParallelForTest, StopsHandingOutItems) {
+  std::atomic<size_t> started{0};
+  ParallelFor::Run(10000, 4, [&](size_t i) {
+    started++;
+    return i < 10;
+  });
+  // The items already taken by the other threads still run
+  EXPECT_LT(started, 10000u);
+}
+
+}  // namespace
+}  // namespace FOEDAG
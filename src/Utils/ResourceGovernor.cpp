@@ -0,0 +1,438 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/ResourceGovernor.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "Utils/CpuTopology.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#endif
+
+extern "C" {
+#include <tcl.h>
+}
+
+using namespace FOEDAG;
+
+namespace {
+// cgroup v1 reports "no limit" as a page rounded LONG_MAX
+constexpr uint64_t kUnlimited = 1ull << 60;
+
+bool readFirstLine(const std::string &file, std::string &line) {
+  std::ifstream in(file);
+  if (!in || !std::getline(in, line)) return false;
+  return true;
+}
+
+bool parseNumber(const std::string &text, uint64_t &value) {
+  if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+    return false;
+  errno = 0;
+  value = std::strtoull(text.c_str(), nullptr, 10);
+  return errno != ERANGE;
+}
+
+void boundQuota(double &quota, double cpus) {
+  if (cpus > 0 && (quota == 0 || cpus < quota)) quota = cpus;
+}
+
+void boundMemory(uint64_t &limit, uint64_t bytes) {
+  if (bytes > 0 && bytes < kUnlimited && (limit == 0 || bytes < limit))
+    limit = bytes;
+}
+
+// "max 100000" or "<quota> <period>"
+void readCpuMax(const std::string &dir, double &quota) {
+  std::string line;
+  if (!readFirstLine(dir + "/cpu.max", line)) return;
+  std::istringstream fields(line);
+  std::string max, period;
+  fields >> max >> period;
+  uint64_t q = 0, p = 0;
+  if (parseNumber(max, q) && parseNumber(period, p) && p > 0)
+    boundQuota(quota, double(q) / p);
+}
+
+void readMemoryMax(const std::string &file, uint64_t &limit) {
+  std::string line;
+  uint64_t bytes = 0;
+  if (readFirstLine(file, line) && parseNumber(line, bytes))
+    boundMemory(limit, bytes);
+}
+
+// v1 quota of -1 is unlimited
+bool readCfsQuota(const std::string &dir, double &quota) {
+  std::string quotaLine, periodLine;
+  if (!readFirstLine(dir + "/cpu.cfs_quota_us", quotaLine) ||
+      !readFirstLine(dir + "/cpu.cfs_period_us", periodLine))
+    return false;
+  uint64_t q = 0, p = 0;
+  if (parseNumber(quotaLine, q) && parseNumber(periodLine, p) && p > 0)
+    boundQuota(quota, double(q) / p);
+  return true;
+}
+
+std::string parentOf(const std::string &path) {
+  size_t slash = path.rfind('/');
+  return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+unsigned int affinityCpus() {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    int count = CPU_COUNT(&set);
+    if (count > 0) return count;
+  }
+#endif
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+uint64_t physicalMemory() {
+#if defined(_WIN32)
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (GlobalMemoryStatusEx(&status)) return status.ullTotalPhys;
+  return 0;
+#else
+  long pages = sysconf(_SC_PHYS_PAGES);
+  long pageSize = sysconf(_SC_PAGESIZE);
+  if (pages <= 0 || pageSize <= 0) return 0;
+  return uint64_t(pages) * uint64_t(pageSize);
+#endif
+}
+
+std::string megabytes(uint64_t bytes) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+  return text;
+}
+
+std::string limit(uint64_t bytes) {
+  return bytes ? megabytes(bytes) : "unlimited";
+}
+}  // namespace
+
+ResourceGovernor::Reservation::Reservation(Reservation &&other)
+    : m_governor(other.m_governor),
+      m_threads(other.m_threads),
+      m_bytes(other.m_bytes) {
+  other.m_governor = nullptr;
+}
+
+ResourceGovernor::Reservation &ResourceGovernor::Reservation::operator=(
+    Reservation &&other) {
+  if (this != &other) {
+    Release();
+    m_governor = other.m_governor;
+    m_threads = other.m_threads;
+    m_bytes = other.m_bytes;
+    other.m_governor = nullptr;
+  }
+  return *this;
+}
+
+void ResourceGovernor::Reservation::Release() {
+  if (m_governor) m_governor->release(m_threads, m_bytes);
+  m_governor = nullptr;
+}
+
+ResourceGovernor &ResourceGovernor::Instance() {
+  static ResourceGovernor governor;
+  return governor;
+}
+
+ResourceGovernor::Limits ResourceGovernor::Detect(const std::string &root) {
+  Limits limits;
+  limits.affinityCpus = affinityCpus();
+  limits.physicalMemory = physicalMemory();
+
+  // Lines are "<id>:<controllers>:<path>", v2 has a single "0::<path>"
+  const std::string base = root + "/sys/fs/cgroup";
+  std::ifstream cgroups(root + "/proc/self/cgroup");
+  std::string line;
+  while (std::getline(cgroups, line)) {
+    size_t first = line.find(':');
+    size_t second = line.find(':', first + 1);
+    if (first == std::string::npos || second == std::string::npos) continue;
+    std::string controllers = line.substr(first + 1, second - first - 1);
+    std::string path = line.substr(second + 1);
+    if (path == "/") path.clear();
+
+    if (controllers.empty()) {
+      // Every level of the hierarchy up to the root can limit
+      for (std::string dir = path;; dir = parentOf(dir)) {
+        readCpuMax(base + dir, limits.cpuQuota);
+        readMemoryMax(base + dir + "/memory.max", limits.memoryLimit);
+        if (dir.empty()) break;
+      }
+      continue;
+    }
+    // In a cgroup namespace the path is the host one, the mount root is ours
+    std::vector<std::string> names;
+    std::istringstream list(controllers);
+    for (std::string name; std::getline(list, name, ',');)
+      names.push_back(name);
+    auto has = [&names](const char *name) {
+      return std::find(names.begin(), names.end(), name) != names.end();
+    };
+    if (has("cpu")) {
+      for (const std::string &mount : {base + "/" + controllers, base + "/cpu"})
+        if (readCfsQuota(mount + path, limits.cpuQuota) ||
+            readCfsQuota(mount, limits.cpuQuota))
+          break;
+    }
+    if (has("memory")) {
+      std::string mount = base + "/memory";
+      uint64_t before = limits.memoryLimit;
+      readMemoryMax(mount + path + "/memory.limit_in_bytes",
+                    limits.memoryLimit);
+      if (before == limits.memoryLimit)
+        readMemoryMax(mount + "/memory.limit_in_bytes", limits.memoryLimit);
+    }
+  }
+
+  limits.cpus = limits.affinityCpus;
+  if (limits.cpuQuota > 0) {
+    unsigned int quota = std::max(1u, unsigned(std::ceil(limits.cpuQuota)));
+    limits.cpus = std::min(limits.cpus, quota);
+  }
+  return limits;
+}
+
+ResourceGovernor::ResourceGovernor() : m_limits(Detect()) {}
+
+ResourceGovernor::ResourceGovernor(const Limits &limits) : m_limits(limits) {}
+
+unsigned int ResourceGovernor::MaxThreads() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_maxThreads ? m_maxThreads : m_limits.cpus;
+}
+
+void ResourceGovernor::SetMaxThreads(unsigned int threads) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxThreads = threads;
+  }
+  m_released.notify_all();
+}
+
+uint64_t ResourceGovernor::MemoryBudget() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_memoryBudget) return m_memoryBudget;
+  return m_limits.memoryLimit ? m_limits.memoryLimit : m_limits.physicalMemory;
+}
+
+void ResourceGovernor::SetMemoryBudget(uint64_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_memoryBudget = bytes;
+  }
+  m_released.notify_all();
+}
+
+unsigned int ResourceGovernor::ThreadsInUse() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_threadsInUse;
+}
+
+uint64_t ResourceGovernor::MemoryInUse() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_memoryInUse;
+}
+
+bool ResourceGovernor::fits(unsigned int threads, uint64_t bytes) const {
+  if (m_threadsInUse == 0 && m_memoryInUse == 0) return true;
+  unsigned int maxThreads = m_maxThreads ? m_maxThreads : m_limits.cpus;
+  uint64_t budget = m_memoryBudget;
+  if (!budget)
+    budget =
+        m_limits.memoryLimit ? m_limits.memoryLimit : m_limits.physicalMemory;
+  if (m_threadsInUse + threads > maxThreads) return false;
+  return budget == 0 || m_memoryInUse + bytes <= budget;
+}
+
+void ResourceGovernor::admit(unsigned int threads, uint64_t bytes,
+                             Reservation &reservation) {
+  m_threadsInUse += threads;
+  m_memoryInUse += bytes;
+  reservation.m_governor = this;
+  reservation.m_threads = threads;
+  reservation.m_bytes = bytes;
+}
+
+void ResourceGovernor::release(unsigned int threads, uint64_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threadsInUse -= threads;
+    m_memoryInUse -= bytes;
+  }
+  m_released.notify_all();
+}
+
+ResourceGovernor::Reservation ResourceGovernor::Acquire(
+    unsigned int threads, uint64_t bytes,
+    const std::function<bool()> &cancelled) {
+  Reservation reservation;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  // Cancellation is polled, the owner has no handle on this wait
+  while (!fits(threads, bytes)) {
+    if (cancelled && cancelled()) return reservation;
+    m_released.wait_for(lock, std::chrono::milliseconds(100));
+  }
+  if (cancelled && cancelled()) return reservation;
+  admit(threads, bytes, reservation);
+  return reservation;
+}
+
+bool ResourceGovernor::TryAcquire(unsigned int threads, uint64_t bytes,
+                                  Reservation &reservation) {
+  reservation.Release();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!fits(threads, bytes)) return false;
+  admit(threads, bytes, reservation);
+  return true;
+}
+
+std::string ResourceGovernor::Report() const {
+  std::ostringstream out;
+  char line[160];
+  char quota[32] = "none";
+  if (m_limits.cpuQuota > 0)
+    snprintf(quota, sizeof(quota), "%.2f", m_limits.cpuQuota);
+  snprintf(line, sizeof(line), "%-16s %u (affinity %u, quota %s)\n", "cpus",
+           m_limits.cpus, m_limits.affinityCpus, quota);
+  out << line;
+  snprintf(line, sizeof(line), "%-16s %u\n", "max threads", MaxThreads());
+  out << line;
+  snprintf(line, sizeof(line), "%-16s %u\n", "threads in use",
+           ThreadsInUse());
+  out << line;
+  snprintf(line, sizeof(line), "%-16s %s (physical %s)\n", "memory limit",
+           limit(m_limits.memoryLimit).c_str(),
+           megabytes(m_limits.physicalMemory).c_str());
+  out << line;
+  snprintf(line, sizeof(line), "%-16s %s\n", "memory budget",
+           limit(MemoryBudget()).c_str());
+  out << line;
+  snprintf(line, sizeof(line), "%-16s %s\n", "memory in use",
+           megabytes(MemoryInUse()).c_str());
+  out << line;
+  return out.str();
+}
+
+bool ResourceGovernor::ParseSize(const std::string &text, uint64_t &bytes) {
+  std::string digits = text;
+  uint64_t unit = 1;
+  if (!digits.empty()) {
+    switch (digits.back()) {
+      case 'k':
+      case 'K':
+        unit = 1ull << 10;
+        break;
+      case 'm':
+      case 'M':
+        unit = 1ull << 20;
+        break;
+      case 'g':
+      case 'G':
+        unit = 1ull << 30;
+        break;
+    }
+    if (unit != 1) digits.pop_back();
+  }
+  uint64_t value = 0;
+  if (!parseNumber(digits, value) ||
+      value > std::numeric_limits<uint64_t>::max() / unit)
+    return false;
+  bytes = value * unit;
+  return true;
+}
+
+void ResourceGovernor::RegisterCommands(Tcl_Interp *interp) {
+  auto set_max_threads = [](void *clientData, Tcl_Interp *interp, int argc,
+                            const char *argv[]) -> int {
+    int threads = 0;
+    if (argc > 2 ||
+        (argc == 2 && (Tcl_GetInt(interp, argv[1], &threads) != TCL_OK ||
+                       threads < 0))) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp, "Usage: set_max_threads ?<n>?, 0 for the CPUs",
+                       (char *)NULL);
+      return TCL_ERROR;
+    }
+    ResourceGovernor &governor = Instance();
+    if (argc == 2) governor.SetMaxThreads(threads);
+    Tcl_AppendResult(interp, std::to_string(governor.MaxThreads()).c_str(),
+                     (char *)NULL);
+    return TCL_OK;
+  };
+  Tcl_CreateCommand(interp, "set_max_threads", set_max_threads, nullptr,
+                    nullptr);
+
+  auto set_memory_budget = [](void *clientData, Tcl_Interp *interp, int argc,
+                              const char *argv[]) -> int {
+    uint64_t bytes = 0;
+    if (argc > 2 || (argc == 2 && !ParseSize(argv[1], bytes))) {
+      Tcl_ResetResult(interp);
+      Tcl_AppendResult(interp,
+                       "Usage: set_memory_budget ?<bytes>|<n>K|<n>M|<n>G?, 0 "
+                       "for the limit",
+                       (char *)NULL);
+      return TCL_ERROR;
+    }
+    ResourceGovernor &governor = Instance();
+    if (argc == 2) governor.SetMemoryBudget(bytes);
+    Tcl_AppendResult(interp, std::to_string(governor.MemoryBudget()).c_str(),
+                     (char *)NULL);
+    return TCL_OK;
+  };
+  Tcl_CreateCommand(interp, "set_memory_budget", set_memory_budget, nullptr,
+                    nullptr);
+
+  auto report_resources = [](void *clientData, Tcl_Interp *interp, int argc,
+                             const char *argv[]) -> int {
+    Tcl_AppendResult(interp, Instance().Report().c_str(),
+                     CpuTopology::Instance().Report().c_str(), (char *)NULL);
+    return TCL_OK;
+  };
+  Tcl_CreateCommand(interp, "report_resources", report_resources, nullptr,
+                    nullptr);
+}
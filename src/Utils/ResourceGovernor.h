@@ -0,0 +1,130 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#ifndef RESOURCE_GOVERNOR_H
+#define RESOURCE_GOVERNOR_H
+
+struct Tcl_Interp;
+
+namespace FOEDAG {
+
+// Threads and memory the process may use. The limits are detected from the
+// affinity mask and the cgroup (v1 or v2) CPU quota and memory limit, so a
+// container quota'd to 8 CPUs runs 8 threads whatever the core count.
+// set_max_threads, set_memory_budget and --jobs lower or raise them.
+// Compile jobs reserve their estimated threads and memory and wait until
+// they fit next to the running ones.
+class ResourceGovernor {
+ public:
+  struct Limits {
+    // Usable CPUs: affinity bounded by the quota
+    unsigned int cpus = 1;
+    unsigned int affinityCpus = 1;
+    // CPUs granted by the cgroup quota, 0 when unlimited
+    double cpuQuota = 0;
+    // cgroup memory limit, 0 when unlimited
+    uint64_t memoryLimit = 0;
+    uint64_t physicalMemory = 0;
+  };
+
+  // Released when destroyed
+  class Reservation {
+   public:
+    Reservation() = default;
+    Reservation(Reservation &&other);
+    Reservation &operator=(Reservation &&other);
+    Reservation(const Reservation &) = delete;
+    Reservation &operator=(const Reservation &) = delete;
+    ~Reservation() { Release(); }
+
+    bool Admitted() const { return m_governor != nullptr; }
+    void Release();
+
+   private:
+    friend class ResourceGovernor;
+    ResourceGovernor *m_governor = nullptr;
+    unsigned int m_threads = 0;
+    uint64_t m_bytes = 0;
+  };
+
+  static ResourceGovernor &Instance();
+
+  // Limits of the calling process. root prefixes /proc and /sys/fs/cgroup.
+  static Limits Detect(const std::string &root = std::string());
+
+  // With the detected limits
+  ResourceGovernor();
+  explicit ResourceGovernor(const Limits &limits);
+
+  const Limits &GetLimits() const { return m_limits; }
+
+  // Threads for parallel work, the detected CPUs unless set. 0 restores them.
+  unsigned int MaxThreads() const;
+  void SetMaxThreads(unsigned int threads);
+
+  // Memory of the admitted jobs, 0 when unlimited. Defaults to the cgroup
+  // limit or else the physical memory, 0 restores it.
+  uint64_t MemoryBudget() const;
+  void SetMemoryBudget(uint64_t bytes);
+
+  unsigned int ThreadsInUse() const;
+  uint64_t MemoryInUse() const;
+
+  // Blocks until the job fits. A job larger than the budget is admitted
+  // once nothing else runs. The reservation is not admitted if cancelled()
+  // turned true while waiting.
+  Reservation Acquire(unsigned int threads, uint64_t bytes,
+                      const std::function<bool()> &cancelled = nullptr);
+  bool TryAcquire(unsigned int threads, uint64_t bytes,
+                  Reservation &reservation);
+
+  std::string Report() const;
+
+  // "512M", "8G", bytes otherwise. false on bad syntax.
+  static bool ParseSize(const std::string &text, uint64_t &bytes);
+
+  // set_max_threads ?<n>?, set_memory_budget ?<size>?, report_resources
+  // (limits, then the CpuTopology and its placed threads)
+  static void RegisterCommands(Tcl_Interp *interp);
+
+ private:
+  Limits m_limits;
+  unsigned int m_maxThreads = 0;
+  uint64_t m_memoryBudget = 0;
+  unsigned int m_threadsInUse = 0;
+  uint64_t m_memoryInUse = 0;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_released;
+
+  bool fits(unsigned int threads, uint64_t bytes) const;
+  void admit(unsigned int threads, uint64_t bytes, Reservation &reservation);
+  void release(unsigned int threads, uint64_t bytes);
+};
+
+}  // namespace FOEDAG
+
+#endif
@@ -0,0 +1,137 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/ResourceGovernor.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "Tcl/TclInterpreter.h"
+#include "Utils/TestDirectory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::HasSubstr;
+
+namespace FOEDAG {
+namespace {
+using ResourceGovernorTest = TestDirectory;
+
+TEST_F(ResourceGovernorTest, DetectCgroupV2) {
+  WriteFile("proc/self/cgroup", "0::/job/step\n");
+  WriteFile("sys/fs/cgroup/cpu.max", "max 100000\n");
+  WriteFile("sys/fs/cgroup/job/cpu.max", "250000 100000\n");
+  WriteFile("sys/fs/cgroup/job/step/memory.max", "1073741824\n");
+  WriteFile("sys/fs/cgroup/job/memory.max", "max\n");
+
+  ResourceGovernor::Limits limits = ResourceGovernor::Detect(m_dir.string());
+  EXPECT_DOUBLE_EQ(limits.cpuQuota, 2.5);
+  EXPECT_EQ(limits.cpus, std::min(3u, limits.affinityCpus));
+  EXPECT_EQ(limits.memoryLimit, 1073741824u);
+}
+
+TEST_F(ResourceGovernorTest, DetectCgroupV1) {
+  // Namespaced: the host path does not exist under the mount
+  WriteFile("proc/self/cgroup",
+            "4:memory:/docker/abc\n3:cpu,cpuacct:/docker/abc\n");
+  WriteFile("sys/fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "800000\n");
+  WriteFile("sys/fs/cgroup/cpu,cpuacct/cpu.cfs_period_us", "100000\n");
+  WriteFile("sys/fs/cgroup/memory/memory.limit_in_bytes",
+            "9223372036854771712\n");
+
+  ResourceGovernor::Limits limits = ResourceGovernor::Detect(m_dir.string());
+  EXPECT_DOUBLE_EQ(limits.cpuQuota, 8);
+  EXPECT_EQ(limits.cpus, std::min(8u, limits.affinityCpus));
+  EXPECT_EQ(limits.memoryLimit, 0u);
+}
+
+TEST(ResourceGovernor, Admission) {
+  ResourceGovernor::Limits limits;
+  limits.cpus = 2;
+  limits.memoryLimit = 1000;
+  ResourceGovernor governor(limits);
+
+  ResourceGovernor::Reservation first, second, third;
+  EXPECT_TRUE(governor.TryAcquire(1, 600, first));
+  // Memory does not fit
+  EXPECT_FALSE(governor.TryAcquire(1, 600, second));
+  EXPECT_TRUE(governor.TryAcquire(1, 400, second));
+  // Threads do not fit
+  EXPECT_FALSE(governor.TryAcquire(1, 0, third));
+  EXPECT_EQ(governor.ThreadsInUse(), 2u);
+
+  std::atomic<bool> admitted{false};
+  std::thread waiter([&]() {
+    ResourceGovernor::Reservation reservation = governor.Acquire(1, 500);
+    admitted = reservation.Admitted();
+  });
+  first.Release();
+  waiter.join();
+  EXPECT_TRUE(admitted);
+
+  // Cancelled while waiting
+  governor.SetMaxThreads(1);
+  ResourceGovernor::Reservation cancelled =
+      governor.Acquire(1, 0, []() { return true; });
+  EXPECT_FALSE(cancelled.Admitted());
+
+  // Larger than the budget, runs alone
+  second.Release();
+  ResourceGovernor::Reservation large = governor.Acquire(4, 5000);
+  EXPECT_TRUE(large.Admitted());
+  large.Release();
+  EXPECT_EQ(governor.ThreadsInUse(), 0u);
+  EXPECT_EQ(governor.MemoryInUse(), 0u);
+}
+
+TEST(ResourceGovernor, ParseSize) {
+  uint64_t bytes = 0;
+  EXPECT_TRUE(ResourceGovernor::ParseSize("512M", bytes));
+  EXPECT_EQ(bytes, 512ull << 20);
+  EXPECT_TRUE(ResourceGovernor::ParseSize("18446744073709551615", bytes));
+  EXPECT_EQ(bytes, 18446744073709551615ull);
+  EXPECT_FALSE(ResourceGovernor::ParseSize("18446744073709551616", bytes));
+  EXPECT_FALSE(ResourceGovernor::ParseSize("17179869184G", bytes));
+  EXPECT_FALSE(ResourceGovernor::ParseSize("G", bytes));
+  EXPECT_FALSE(ResourceGovernor::ParseSize("-1", bytes));
+}
+
+TEST(ResourceGovernor, Commands) {
+  TclInterpreter interpreter;
+  ResourceGovernor &governor = ResourceGovernor::Instance();
+  EXPECT_EQ(interpreter.evalCmd("set_max_threads 3"), "3");
+  EXPECT_EQ(governor.MaxThreads(), 3u);
+  EXPECT_EQ(interpreter.evalCmd("set_max_threads 0"),
+            std::to_string(governor.GetLimits().cpus));
+  EXPECT_EQ(interpreter.evalCmd("set_memory_budget 2G"), "2147483648");
+  EXPECT_EQ(governor.MemoryBudget(), 2147483648u);
+  EXPECT_THAT(interpreter.evalCmd("set_memory_budget 2X"), HasSubstr("Usage"));
+  EXPECT_THAT(interpreter.evalCmd("set_memory_budget 99999999999999999999999"),
+              HasSubstr("Usage"));
+  interpreter.evalCmd("set_memory_budget 0");
+  std::string report = interpreter.evalCmd("report_resources");
+  EXPECT_THAT(report, HasSubstr("max threads"));
+  EXPECT_THAT(report, HasSubstr("memory budget"));
+}
+
+}  // namespace
+}  // namespace FOEDAG
@@ -0,0 +1,78 @@
+/*
+Copyright 2021 The Foedag team
+
+GPL License
+
+Copyright (c) 2021 The Open-Source FPGA Foundation
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#ifndef TEST_DIRECTORY_H
+#define TEST_DIRECTORY_H
+
+namespace FOEDAG {
+
+// Fixture of the tests that write files. Every test gets its own empty
+// directory, named after the test and the process so that test binaries
+// run in parallel never share one, and removed after the test.
+class TestDirectory : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::filesystem::remove_all(m_dir);
+    std::filesystem::create_directories(m_dir);
+  }
+  void TearDown() override { std::filesystem::remove_all(m_dir); }
+
+  // Absolute path of name in the directory
+  std::string Path(const std::string& name) const {
+    return (m_dir / name).string();
+  }
+
+  // Writes content to name, creating its parent directories, returns the
+  // absolute path
+  std::string WriteFile(const std::string& name,
+                        const std::string& content) const {
+    std::filesystem::path file = m_dir / name;
+    std::filesystem::create_directories(file.parent_path());
+    std::ofstream(file, std::ios::trunc) << content;
+    return file.string();
+  }
+
+  const std::filesystem::path m_dir{UniqueName()};
+
+ private:
+  static std::filesystem::path UniqueName() {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    std::string name = std::string("foedag_") + info->test_suite_name() + "_" +
+                       info->name() + "_" + std::to_string(getpid());
+    // Parameterized tests are named suite/test/param
+    for (auto& c : name) {
+      if (c == '/') c = '_';
+    }
+    return std::filesystem::temp_directory_path() / name;
+  }
+};
+
+}  // namespace FOEDAG
+
+#endif
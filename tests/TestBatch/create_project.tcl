@@ -0,0 +1,24 @@
+# create_project from an xml description, the project file must be written
+set dir [file normalize create_project_test]
+file delete -force $dir
+file mkdir $dir
+set fh [open $dir/counter.v w]
+puts $fh "module counter(input clk); endmodule"
+close $fh
+set fh [open $dir/project.xml w]
+puts $fh "<project type=\"RTL\" name=\"counter\" path=\"$dir\">
+  <sources>
+    <source file=\"$dir/counter.v\" is_top=\"true\"/>
+  </sources>
+</project>"
+close $fh
+
+create_project --file $dir/project.xml
+if {![file exists $dir/counter/counter.ospr]} {
+  puts "FAILED: $dir/counter/counter.ospr was not written"
+  file delete -force $dir
+  exit 1
+}
+file delete -force $dir
+puts "create_project OK"
+exit
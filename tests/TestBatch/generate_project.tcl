@@ -0,0 +1,13 @@
+# generate_project writes the project file and one design file per module
+set dir [file normalize generate_project_test]
+file delete -force $dir
+set ospr [generate_project -path $dir -name gen -files 20 -filesets 2]
+set files [glob -nocomplain -directory $dir/gen.srcs */*.v]
+if {![file exists $ospr] || [llength $files] != 20} {
+  puts "FAILED: $ospr with [llength $files] design files"
+  file delete -force $dir
+  exit 1
+}
+file delete -force $dir
+puts "generate_project OK"
+exit
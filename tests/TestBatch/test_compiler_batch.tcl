@@ -17,16 +17,14 @@
 #You should have received a copy of the GNU General Public License
 #along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-batch {
+set task [batch {
   synth
   globp
+}]
+set status [wait_for_task -timeout 30000 $task]
+puts "batch: $status"
+if {$status ne "success"} {
+  puts "FAILED: batch ended $status, expected success"
+  exit 1
 }
-
-after 22000 {set CONT 0}
-set CONT 1 
-while {$CONT} {
-  set a 0
-  after 100 set a 1
-  vwait a
-}
-exit
\ No newline at end of file
+exit
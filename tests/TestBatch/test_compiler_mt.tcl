@@ -17,15 +17,20 @@
 #You should have received a copy of the GNU General Public License
 #along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-synthesize
-after 3000 {puts "STOP"; flush stdout ; stop} 
-after 5000 {synthesize}
-after 17000 {global_placement}
-after 28000 {set CONT 0}
-set CONT 1 
-while {$CONT} {
-  set a 0
-  after 100 set a 1
-  vwait a
+proc check_status {name status expected} {
+  puts "$name: $status"
+  if {$status ne $expected} {
+    puts "FAILED: $name ended $status, expected $expected"
+    exit 1
+  }
 }
-exit
\ No newline at end of file
+
+set task [synthesize]
+after 3000
+puts "STOP" ; flush stdout ; stop
+check_status synthesize [wait_for_task $task] stopped
+set task [synthesize]
+check_status synthesize [wait_for_task $task] success
+set task [global_placement]
+check_status global_placement [wait_for_task -timeout 30000 $task] success
+exit